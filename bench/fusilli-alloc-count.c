@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Counts every heap allocation in the process it is preloaded into,
+ * including those made by plugins and libraries. fusilli looks the
+ * counter up by name and reports the allocations of every frame in the
+ * profiler stats, see getHeapAllocationCount.
+ *
+ * glibc exports its allocator under the __libc_* names, so it can be
+ * interposed without dlsym, which allocates itself.
+ */
+
+#include <stdlib.h>
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+unsigned long
+fusilliHeapAllocationCount (void);
+
+static unsigned long nHeapAllocation = 0;
+
+void *
+malloc (size_t size)
+{
+	__atomic_add_fetch (&nHeapAllocation, 1, __ATOMIC_RELAXED);
+
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb,
+        size_t size)
+{
+	__atomic_add_fetch (&nHeapAllocation, 1, __ATOMIC_RELAXED);
+
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void   *ptr,
+         size_t size)
+{
+	__atomic_add_fetch (&nHeapAllocation, 1, __ATOMIC_RELAXED);
+
+	return __libc_realloc (ptr, size);
+}
+
+unsigned long
+fusilliHeapAllocationCount (void)
+{
+	return __atomic_load_n (&nHeapAllocation, __ATOMIC_RELAXED);
+}
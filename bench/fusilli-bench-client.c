@@ -0,0 +1,385 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Synthetic clients for make bench.
+ *
+ * Every scenario maps its windows, waits for the warm up time and then
+ * changes them at a fixed rate for the given number of seconds:
+ *
+ *   terminal  one window scrolled by a line of text 60 times a second
+ *   video     one 1280x720 window fully redrawn 60 times a second
+ *   windows   200 small windows, 10 of them moved and resized per tick
+ *   scale     200 small windows in scale, 10 of them redrawn per tick
+ *   expo      200 small windows in expo, 10 of them redrawn per tick
+ *
+ * scale and expo are started with the key bindings of bench/banana.xml.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+#define TICK_RATE    60
+#define MANY_WINDOWS 200
+#define SMALL_WIDTH  120
+#define SMALL_HEIGHT 90
+#define LINE_HEIGHT  16
+
+typedef struct _BenchWindow {
+	Window id;
+	int    x, y;
+	int    width, height;
+} BenchWindow;
+
+typedef struct _Bench {
+	Display     *display;
+	int         screen;
+	GC          gc;
+	BenchWindow *windows;
+	int         nWindows;
+	XImage      *frame;
+} Bench;
+
+static double
+getTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+sleepUntil (double t)
+{
+	struct timespec ts;
+	double          now = getTime ();
+
+	if (t <= now)
+		return;
+
+	ts.tv_sec  = (time_t) (t - now);
+	ts.tv_nsec = (long) ((t - now - ts.tv_sec) * 1e9);
+
+	nanosleep (&ts, NULL);
+}
+
+static unsigned long
+getColor (int i)
+{
+	static const unsigned long colors[] = {
+		0x204a87, 0x4e9a06, 0xa40000, 0xc4a000, 0x5c3566, 0xce5c00
+	};
+
+	return colors[i % (sizeof (colors) / sizeof (colors[0]))];
+}
+
+static void
+addWindow (Bench *b,
+           int   x,
+           int   y,
+           int   width,
+           int   height)
+{
+	XSetWindowAttributes attr;
+	XSizeHints           hints;
+	BenchWindow          *w = &b->windows[b->nWindows];
+
+	attr.background_pixel = getColor (b->nWindows);
+	attr.event_mask       = ExposureMask | StructureNotifyMask;
+
+	w->id = XCreateWindow (b->display, RootWindow (b->display, b->screen),
+	                       x, y, width, height, 0, CopyFromParent,
+	                       InputOutput, CopyFromParent,
+	                       CWBackPixel | CWEventMask, &attr);
+	w->x      = x;
+	w->y      = y;
+	w->width  = width;
+	w->height = height;
+
+	/* keep the layout independent of the place plugin */
+	hints.flags  = USPosition | USSize;
+	hints.x      = x;
+	hints.y      = y;
+	hints.width  = width;
+	hints.height = height;
+	XSetWMNormalHints (b->display, w->id, &hints);
+
+	XStoreName (b->display, w->id, "fusilli-bench-client");
+	XMapWindow (b->display, w->id);
+
+	b->nWindows++;
+}
+
+static void
+addManyWindows (Bench *b)
+{
+	int width = DisplayWidth (b->display, b->screen);
+	int perRow = width / SMALL_WIDTH;
+	int i;
+
+	for (i = 0; i < MANY_WINDOWS; i++)
+		addWindow (b,
+		           (i % perRow) * SMALL_WIDTH,
+		           ((i / perRow) * SMALL_HEIGHT) / 2,
+		           SMALL_WIDTH - 8, SMALL_HEIGHT - 8);
+}
+
+static void
+processEvents (Bench *b)
+{
+	XEvent event;
+
+	while (XPending (b->display))
+		XNextEvent (b->display, &event);
+}
+
+static void
+pressBinding (Bench  *b,
+              KeySym keysym)
+{
+	KeyCode control = XKeysymToKeycode (b->display, XK_Control_L);
+	KeyCode alt     = XKeysymToKeycode (b->display, XK_Alt_L);
+	KeyCode key     = XKeysymToKeycode (b->display, keysym);
+
+	XTestFakeKeyEvent (b->display, control, True, CurrentTime);
+	XTestFakeKeyEvent (b->display, alt, True, CurrentTime);
+	XTestFakeKeyEvent (b->display, key, True, CurrentTime);
+	XTestFakeKeyEvent (b->display, key, False, CurrentTime);
+	XTestFakeKeyEvent (b->display, alt, False, CurrentTime);
+	XTestFakeKeyEvent (b->display, control, False, CurrentTime);
+	XFlush (b->display);
+}
+
+/* copy the window up by a line and draw a new line of "text" */
+static void
+tickTerminal (Bench *b,
+              int   tick)
+{
+	BenchWindow *w = &b->windows[0];
+	int         x;
+
+	XCopyArea (b->display, w->id, w->id, b->gc,
+	           0, LINE_HEIGHT, w->width, w->height - LINE_HEIGHT, 0, 0);
+
+	XSetForeground (b->display, b->gc, BlackPixel (b->display, b->screen));
+	XFillRectangle (b->display, w->id, b->gc,
+	                0, w->height - LINE_HEIGHT, w->width, LINE_HEIGHT);
+
+	XSetForeground (b->display, b->gc, 0xd3d7cf);
+
+	for (x = 4; x < w->width - 8; x += 8)
+		if ((x * 7 + tick * 13) % 11 > 2)
+			XFillRectangle (b->display, w->id, b->gc,
+			                x, w->height - LINE_HEIGHT + 3,
+			                6, LINE_HEIGHT - 6);
+}
+
+static void
+tickVideo (Bench *b,
+           int   tick)
+{
+	BenchWindow  *w = &b->windows[0];
+	XImage       *image = b->frame;
+	unsigned int *row;
+	int          x, y;
+
+	/* the image is created with 32 bits per pixel */
+	for (y = 0; y < image->height; y++)
+	{
+		row = (unsigned int *) (image->data + y * image->bytes_per_line);
+
+		for (x = 0; x < image->width; x++)
+			row[x] = ((x + tick * 4) & 0xff) << 16 |
+			         ((y + tick * 2) & 0xff) << 8 |
+			         ((x + y) & 0xff);
+	}
+
+	XPutImage (b->display, w->id, b->gc, image, 0, 0, 0, 0,
+	           w->width, w->height);
+}
+
+static void
+tickWindows (Bench *b,
+             int   tick)
+{
+	int i;
+
+	for (i = 0; i < 10; i++)
+	{
+		BenchWindow *w = &b->windows[(tick * 10 + i) % b->nWindows];
+		int         d;
+
+		/* every window grows on one visit and shrinks on the next */
+		d = (tick / (b->nWindows / 10)) % 2 ? -4 : 4;
+
+		w->x      += d;
+		w->y      += d / 2;
+		w->width  += d;
+		w->height += d / 2;
+
+		XMoveResizeWindow (b->display, w->id,
+		                   w->x, w->y, w->width, w->height);
+	}
+}
+
+/* redraw a small part of a few windows, like clocks and spinners do */
+static void
+tickRedraw (Bench *b,
+            int   tick)
+{
+	int i;
+
+	for (i = 0; i < 10; i++)
+	{
+		BenchWindow *w = &b->windows[(tick * 10 + i) % b->nWindows];
+
+		XSetForeground (b->display, b->gc, getColor (tick + i));
+		XFillRectangle (b->display, w->id, b->gc, 8, 8, 32, 16);
+	}
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+	Bench      b;
+	const char *scenario;
+	double     seconds, warmup = 2.0, start;
+	int        tick, nTick;
+	void       (*tickProc) (Bench *b, int tick);
+
+	if (argc < 3)
+	{
+		fprintf (stderr,
+		         "Usage: %s terminal|video|windows|scale|expo SECONDS "
+		         "[WARMUP]\n", argv[0]);
+		return 1;
+	}
+
+	scenario = argv[1];
+	seconds  = atof (argv[2]);
+	if (argc > 3)
+		warmup = atof (argv[3]);
+
+	b.display = XOpenDisplay (NULL);
+	if (!b.display)
+	{
+		fprintf (stderr, "%s: can't open display\n", argv[0]);
+		return 1;
+	}
+
+	b.screen   = DefaultScreen (b.display);
+	b.windows  = calloc (MANY_WINDOWS, sizeof (BenchWindow));
+	b.nWindows = 0;
+	b.frame    = NULL;
+
+	if (!strcmp (scenario, "terminal"))
+	{
+		addWindow (&b, 100, 100, 640, 480);
+		tickProc = tickTerminal;
+	}
+	else if (!strcmp (scenario, "video"))
+	{
+		addWindow (&b, 100, 100, 1280, 720);
+
+		b.frame = XCreateImage (b.display,
+		                        DefaultVisual (b.display, b.screen),
+		                        DefaultDepth (b.display, b.screen),
+		                        ZPixmap, 0, NULL, 1280, 720, 32, 0);
+		b.frame->data = malloc (b.frame->bytes_per_line * 720);
+		tickProc = tickVideo;
+	}
+	else if (!strcmp (scenario, "windows"))
+	{
+		addManyWindows (&b);
+		tickProc = tickWindows;
+	}
+	else if (!strcmp (scenario, "scale") || !strcmp (scenario, "expo"))
+	{
+		addManyWindows (&b);
+		tickProc = tickRedraw;
+	}
+	else
+	{
+		fprintf (stderr, "%s: unknown scenario %s\n", argv[0], scenario);
+		return 1;
+	}
+
+	b.gc = XCreateGC (b.display, b.windows[0].id, 0, NULL);
+
+	XSync (b.display, False);
+
+	/* let the windows get mapped and any animations settle */
+	start = getTime ();
+	while (getTime () < start + warmup / 2)
+	{
+		processEvents (&b);
+		sleepUntil (getTime () + 1.0 / TICK_RATE);
+	}
+
+	if (!strcmp (scenario, "scale"))
+		pressBinding (&b, XK_s);
+	else if (!strcmp (scenario, "expo"))
+		pressBinding (&b, XK_e);
+
+	sleepUntil (start + warmup);
+
+	/* the harness clears the profiler after the warm up */
+	printf ("ready\n");
+	fflush (stdout);
+
+	nTick = seconds * TICK_RATE;
+	start = getTime ();
+
+	for (tick = 0; tick < nTick; tick++)
+	{
+		processEvents (&b);
+
+		(*tickProc) (&b, tick);
+		XFlush (b.display);
+
+		sleepUntil (start + (double) (tick + 1) / TICK_RATE);
+	}
+
+	XSync (b.display, False);
+
+	if (b.frame)
+		XDestroyImage (b.frame);
+
+	XFreeGC (b.display, b.gc);
+	XCloseDisplay (b.display);
+
+	free (b.windows);
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+/*
+ * Throughput of the pixel kernels of src/pixel.c, for make bench-pixel.
+ *
+ * Every kernel runs over a 1920x1080 image with every instruction set
+ * the CPU supports. Results are printed as JSON, one object per kernel
+ * and instruction set. That the output matches the scalar kernels is
+ * checked by tests/fusilli-pixel-test, in make check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <fusilli-core.h>
+
+#define BENCH_WIDTH   1920
+#define BENCH_HEIGHT  1080
+#define BENCH_PIXELS  (BENCH_WIDTH * BENCH_HEIGHT)
+#define BENCH_SECONDS 0.5
+
+typedef enum {
+	KernelPremultiply = 0,
+	KernelRgbToArgb,
+	KernelRgbaToRgb,
+	KernelFlip
+} Kernel;
+
+static const char *kernelNames[] = {
+	"premultiply", "rgb_to_argb", "rgba_to_rgb", "flip"
+};
+
+static const char *kernelsNames[] = {
+	"scalar", "sse2", "ssse3", "avx2"
+};
+
+static double
+getTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+runKernel (Kernel        kernel,
+           unsigned char *src,
+           unsigned char *dst,
+           int           n)
+{
+	switch (kernel) {
+	case KernelPremultiply:
+		memcpy (dst, src, n * 4);
+		premultiplyPixels (dst, n);
+		break;
+	case KernelRgbToArgb:
+		convertRgbToArgb (src, (unsigned int *) dst, n, 0xff);
+		break;
+	case KernelRgbaToRgb:
+		convertRgbaToRgb (src, dst, n);
+		break;
+	case KernelFlip:
+		flipImageRows (dst, src, BENCH_WIDTH * 4, n / BENCH_WIDTH);
+		break;
+	}
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+	unsigned char *src, *dst;
+	PixelKernels  best, kernels;
+	Kernel        kernel;
+	int           i;
+
+	src = malloc (BENCH_PIXELS * 4);
+	dst = malloc (BENCH_PIXELS * 4);
+	if (!src || !dst)
+		return 1;
+
+	srand (1);
+	for (i = 0; i < BENCH_PIXELS * 4; i++)
+		src[i] = rand ();
+
+	best = setPixelKernels (PixelKernelsAVX2);
+
+	for (kernel = KernelPremultiply; kernel <= KernelFlip; kernel++)
+	{
+		for (kernels = PixelKernelsScalar; kernels <= best; kernels++)
+		{
+			double start, elapsed;
+			int    runs = 0;
+
+			/* rows are copied with memcpy whatever the CPU */
+			if (kernel == KernelFlip && kernels > PixelKernelsScalar)
+				break;
+
+			setPixelKernels (kernels);
+
+			start = getTime ();
+			do
+			{
+				runKernel (kernel, src, dst, BENCH_PIXELS);
+				runs++;
+				elapsed = getTime () - start;
+			} while (elapsed < BENCH_SECONDS);
+
+			printf ("{\"kernel\":\"%s\",\"isa\":\"%s\","
+			        "\"mpixels_per_second\":%.1f}\n",
+			        kernelNames[kernel], kernelsNames[kernels],
+			        runs * (double) BENCH_PIXELS / elapsed / 1e6);
+		}
+	}
+
+	free (src);
+	free (dst);
+
+	return 0;
+}
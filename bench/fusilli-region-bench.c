@@ -0,0 +1,548 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Throughput of the region operations of src/region.c against the
+ * Xlib ones they replace, for make bench-region.
+ *
+ * Every operation runs over pairs of random regions of a few sizes,
+ * the way damage is accumulated: into a destination that is kept
+ * between calls. The result of every pair is compared with Xlib's
+ * first; any difference makes the run fail. Results are printed as
+ * JSON, one object per operation, region size and implementation.
+ *
+ * Every file given on the command line is then replayed the way
+ * paintOutputRegion would: the files are written by fusilli
+ * --dump-regions, see src/paint.c, and hold the damage of every frame
+ * followed by the region of every window from the top. Each window
+ * gets a copy of the damage left so far as its clip and opaque ones
+ * are subtracted from it. Their results are printed per frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <fusilli-core.h>
+
+#define BENCH_PAIRS   64
+#define BENCH_AREA    2048
+#define BENCH_SECONDS 0.25
+
+typedef enum {
+	OpUnion = 0,
+	OpIntersect,
+	OpSubtract
+} Op;
+
+static const char *opNames[] = {
+	"union", "intersect", "subtract"
+};
+
+/* rects of each random region before Xlib coalesces them */
+static const int benchSizes[] = { 1, 4, 16, 64, 256 };
+
+static double
+getTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Region
+randomRegion (int n)
+{
+	Region     region;
+	XRectangle rect;
+	int        i;
+
+	region = XCreateRegion ();
+
+	for (i = 0; i < n; i++)
+	{
+		rect.width  = 1 + rand () % (BENCH_AREA / 4);
+		rect.height = 1 + rand () % (BENCH_AREA / 4);
+		rect.x      = rand () % (BENCH_AREA - rect.width);
+		rect.y      = rand () % (BENCH_AREA - rect.height);
+
+		XUnionRectWithRegion (&rect, region, region);
+	}
+
+	return region;
+}
+
+static void
+runCompOp (Op     op,
+           Region a,
+           Region b,
+           Region dst)
+{
+	switch (op) {
+	case OpUnion:
+		compUnionRegion (a, b, dst);
+		break;
+	case OpIntersect:
+		compIntersectRegion (a, b, dst);
+		break;
+	case OpSubtract:
+		compSubtractRegion (a, b, dst);
+		break;
+	}
+}
+
+static void
+runXlibOp (Op     op,
+           Region a,
+           Region b,
+           Region dst)
+{
+	switch (op) {
+	case OpUnion:
+		XUnionRegion (a, b, dst);
+		break;
+	case OpIntersect:
+		XIntersectRegion (a, b, dst);
+		break;
+	case OpSubtract:
+		XSubtractRegion (a, b, dst);
+		break;
+	}
+}
+
+typedef struct _Frame {
+	Region     damage;
+	int        nWindows;
+	Region     *windows;
+	Bool       *opaque;
+	Region     *xlibClips;
+	CompRegion *compClips;
+} Frame;
+
+/* same bands and extents, which XEqualRegion alone does not look at
+   for empty regions */
+static Bool
+regionsIdentical (Region a,
+                  Region b)
+{
+	if (a->numRects != b->numRects)
+		return FALSE;
+
+	if (!a->numRects)
+		return TRUE;
+
+	if (memcmp (&a->extents, &b->extents, sizeof (BOX)))
+		return FALSE;
+
+	return !memcmp (a->rects, b->rects, sizeof (BOX) * a->numRects);
+}
+
+static void
+printResult (Op         op,
+             int        size,
+             const char *impl,
+             int        runs,
+             double     elapsed)
+{
+	printf ("{\"op\":\"%s\",\"rects\":%d,\"impl\":\"%s\","
+	        "\"ns_per_op\":%.1f}\n",
+	        opNames[op], size, impl,
+	        elapsed * 1e9 / (runs * (double) BENCH_PAIRS));
+}
+
+static Region
+readRegion (FILE *fp)
+{
+	Region     region;
+	XRectangle rect;
+	long       i, n;
+	int        x1, y1, x2, y2;
+
+	if (fscanf (fp, "%ld", &n) != 1 || n < 0)
+		return NULL;
+
+	region = XCreateRegion ();
+
+	for (i = 0; i < n; i++)
+	{
+		if (fscanf (fp, "%d %d %d %d", &x1, &y1, &x2, &y2) != 4 ||
+		    x2 <= x1 || y2 <= y1)
+		{
+			XDestroyRegion (region);
+			return NULL;
+		}
+
+		rect.x      = x1;
+		rect.y      = y1;
+		rect.width  = x2 - x1;
+		rect.height = y2 - y1;
+
+		XUnionRectWithRegion (&rect, region, region);
+	}
+
+	return region;
+}
+
+static Bool
+addFrameWindow (Frame  *frame,
+                Region region,
+                Bool   opaque)
+{
+	int n = frame->nWindows + 1;
+
+	frame->windows = realloc (frame->windows, sizeof (Region) * n);
+	frame->opaque  = realloc (frame->opaque, sizeof (Bool) * n);
+	if (!frame->windows || !frame->opaque)
+		return FALSE;
+
+	frame->windows[frame->nWindows] = region;
+	frame->opaque[frame->nWindows]  = opaque;
+	frame->nWindows = n;
+
+	return TRUE;
+}
+
+static void
+freeFrames (Frame *frames,
+            int   nFrames)
+{
+	int i, j;
+
+	for (i = 0; i < nFrames; i++)
+	{
+		for (j = 0; j < frames[i].nWindows; j++)
+		{
+			XDestroyRegion (frames[i].windows[j]);
+
+			if (frames[i].xlibClips)
+				XDestroyRegion (frames[i].xlibClips[j]);
+			if (frames[i].compClips)
+				finiRegion (&frames[i].compClips[j]);
+		}
+
+		XDestroyRegion (frames[i].damage);
+		free (frames[i].windows);
+		free (frames[i].opaque);
+		free (frames[i].xlibClips);
+		free (frames[i].compClips);
+	}
+
+	free (frames);
+}
+
+/* lines starting with # are comments */
+static Frame *
+readFrames (const char *path,
+            int        *nFrames)
+{
+	FILE   *fp;
+	Frame  *frames = NULL, *frame;
+	Region region;
+	char   tag[16];
+	int    i, j, n = 0;
+
+	fp = fopen (path, "r");
+	if (!fp)
+	{
+		perror (path);
+		return NULL;
+	}
+
+	while (fscanf (fp, "%15s", tag) == 1)
+	{
+		if (tag[0] == '#')
+		{
+			if (fscanf (fp, "%*[^\n]") < 0)
+				break;
+
+			continue;
+		}
+
+		region = readRegion (fp);
+		if (!region)
+			break;
+
+		if (!strcmp (tag, "damage"))
+		{
+			frames = realloc (frames, sizeof (Frame) * (n + 1));
+			if (!frames)
+				break;
+
+			memset (&frames[n], 0, sizeof (Frame));
+			frames[n++].damage = region;
+		}
+		else if (n && !strcmp (tag, "opaque"))
+		{
+			if (!addFrameWindow (&frames[n - 1], region, TRUE))
+				break;
+		}
+		else if (n && !strcmp (tag, "window"))
+		{
+			if (!addFrameWindow (&frames[n - 1], region, FALSE))
+				break;
+		}
+		else
+		{
+			XDestroyRegion (region);
+			break;
+		}
+	}
+
+	if (!feof (fp) || !n)
+	{
+		fprintf (stderr, "%s: not a region dump\n", path);
+		fclose (fp);
+		if (frames)
+			freeFrames (frames, n);
+
+		return NULL;
+	}
+
+	fclose (fp);
+
+	for (i = 0; i < n; i++)
+	{
+		frame = &frames[i];
+
+		frame->xlibClips = malloc (sizeof (Region) * (frame->nWindows + 1));
+		frame->compClips = malloc (sizeof (CompRegion) *
+		                           (frame->nWindows + 1));
+
+		for (j = 0; j < frame->nWindows; j++)
+		{
+			frame->xlibClips[j] = XCreateRegion ();
+			initRegion (&frame->compClips[j]);
+		}
+	}
+
+	*nFrames = n;
+
+	return frames;
+}
+
+static void
+replayXlib (Frame  *frame,
+            Region empty,
+            Region tmp)
+{
+	int i;
+
+	XUnionRegion (frame->damage, empty, tmp);
+
+	for (i = 0; i < frame->nWindows; i++)
+	{
+		XUnionRegion (tmp, empty, frame->xlibClips[i]);
+
+		if (frame->opaque[i])
+			XSubtractRegion (tmp, frame->windows[i], tmp);
+	}
+}
+
+static void
+replayComp (Frame  *frame,
+            Region tmp)
+{
+	int i;
+
+	compCopyRegion (frame->damage, tmp);
+
+	for (i = 0; i < frame->nWindows; i++)
+	{
+		compCopyRegion (tmp, &frame->compClips[i].region);
+
+		if (frame->opaque[i])
+			compSubtractRegion (tmp, frame->windows[i], tmp);
+	}
+}
+
+static void
+printReplayResult (const char *path,
+                   const char *impl,
+                   int        runs,
+                   int        nFrames,
+                   double     elapsed)
+{
+	const char *name = strrchr (path, '/');
+
+	printf ("{\"op\":\"occlusion\",\"fixture\":\"%s\",\"impl\":\"%s\","
+	        "\"ns_per_frame\":%.1f}\n",
+	        name ? name + 1 : path, impl,
+	        elapsed * 1e9 / (runs * (double) nFrames));
+}
+
+static Bool
+replayFile (const char *path)
+{
+	Frame      *frames;
+	Region     empty, xlibTmp;
+	CompRegion compTmp;
+	double     start, elapsed;
+	int        i, j, runs, nFrames;
+	Bool       status = TRUE;
+
+	frames = readFrames (path, &nFrames);
+	if (!frames)
+		return FALSE;
+
+	empty   = XCreateRegion ();
+	xlibTmp = XCreateRegion ();
+	initRegion (&compTmp);
+
+	for (i = 0; i < nFrames; i++)
+	{
+		replayXlib (&frames[i], empty, xlibTmp);
+		replayComp (&frames[i], &compTmp.region);
+
+		for (j = 0; j < frames[i].nWindows; j++)
+		{
+			if (!regionsIdentical (&frames[i].compClips[j].region,
+			                       frames[i].xlibClips[j]))
+			{
+				fprintf (stderr, "%s: frame %d: clip of window %d "
+				         "differs from Xlib\n", path, i, j);
+				status = FALSE;
+			}
+		}
+	}
+
+	runs  = 0;
+	start = getTime ();
+	do
+	{
+		for (i = 0; i < nFrames; i++)
+			replayXlib (&frames[i], empty, xlibTmp);
+
+		runs++;
+		elapsed = getTime () - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	printReplayResult (path, "xlib", runs, nFrames, elapsed);
+
+	runs  = 0;
+	start = getTime ();
+	do
+	{
+		for (i = 0; i < nFrames; i++)
+			replayComp (&frames[i], &compTmp.region);
+
+		runs++;
+		elapsed = getTime () - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	printReplayResult (path, "fusilli", runs, nFrames, elapsed);
+
+	finiRegion (&compTmp);
+	XDestroyRegion (xlibTmp);
+	XDestroyRegion (empty);
+	freeFrames (frames, nFrames);
+
+	return status;
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+	Region     a[BENCH_PAIRS], b[BENCH_PAIRS], expected;
+	CompRegion dst;
+	Op         op;
+	int        i, s, status = 0;
+
+	srand (1);
+
+	expected = XCreateRegion ();
+	initRegion (&dst);
+
+	for (s = 0; s < sizeof (benchSizes) / sizeof (benchSizes[0]); s++)
+	{
+		for (i = 0; i < BENCH_PAIRS; i++)
+		{
+			a[i] = randomRegion (benchSizes[s]);
+			b[i] = randomRegion (benchSizes[s]);
+		}
+
+		for (op = OpUnion; op <= OpSubtract; op++)
+		{
+			double start, elapsed;
+			int    runs;
+
+			for (i = 0; i < BENCH_PAIRS; i++)
+			{
+				runXlibOp (op, a[i], b[i], expected);
+				runCompOp (op, a[i], b[i], &dst.region);
+
+				if (!regionsIdentical (&dst.region, expected))
+				{
+					fprintf (stderr, "%s: %d rects: pair %d differs "
+					         "from Xlib\n", opNames[op], benchSizes[s], i);
+					status = 1;
+				}
+			}
+
+			runs  = 0;
+			start = getTime ();
+			do
+			{
+				for (i = 0; i < BENCH_PAIRS; i++)
+					runXlibOp (op, a[i], b[i], expected);
+
+				runs++;
+				elapsed = getTime () - start;
+			} while (elapsed < BENCH_SECONDS);
+
+			printResult (op, benchSizes[s], "xlib", runs, elapsed);
+
+			runs  = 0;
+			start = getTime ();
+			do
+			{
+				for (i = 0; i < BENCH_PAIRS; i++)
+					runCompOp (op, a[i], b[i], &dst.region);
+
+				runs++;
+				elapsed = getTime () - start;
+			} while (elapsed < BENCH_SECONDS);
+
+			printResult (op, benchSizes[s], "fusilli", runs, elapsed);
+		}
+
+		for (i = 0; i < BENCH_PAIRS; i++)
+		{
+			XDestroyRegion (a[i]);
+			XDestroyRegion (b[i]);
+		}
+	}
+
+	for (i = 1; i < argc; i++)
+		if (!replayFile (argv[i]))
+			status = 1;
+
+	finiRegion (&dst);
+	XDestroyRegion (expected);
+
+	return status;
+}
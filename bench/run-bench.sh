@@ -0,0 +1,144 @@
+#!/bin/sh
+#
+# Runs fusilli from the build tree under Xvfb with Mesa llvmpipe, plays
+# the scenarios of fusilli-bench-client against it and writes the frame
+# statistics of the profiler as JSON, one object per run, so results of
+# different commits can be compared. Results are appended to the output
+# file, --truncate empties it first.
+#
+# fusilli-alloc-count.so is preloaded so the stats include the heap
+# allocations per frame. With --max-allocations N the run fails if the
+# median frame of any scenario made more than N.
+#
+# usage: run-bench.sh [--seconds N] [--output FILE] [--truncate]
+#                     [--max-allocations N] [SCENARIO...]
+#
+# top_builddir and srcdir are passed by make bench.
+
+top_builddir=${top_builddir:-..}
+srcdir=${srcdir:-.}
+
+seconds=10
+output=bench-results.json
+max_allocations=
+truncate=
+scenarios=
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+	--seconds) seconds=$2; shift 2 ;;
+	--output)  output=$2; shift 2 ;;
+	--truncate) truncate=1; shift ;;
+	--max-allocations) max_allocations=$2; shift 2 ;;
+	*)         scenarios="$scenarios $1"; shift ;;
+	esac
+done
+
+scenarios=${scenarios:-terminal video windows scale expo}
+
+# fusilli needs a session bus for the profiler
+if [ -z "$FUSILLI_BENCH_BUS" ]; then
+	FUSILLI_BENCH_BUS=1
+	export FUSILLI_BENCH_BUS
+	exec dbus-run-session -- "$0" --seconds "$seconds" --output "$output" \
+	                         ${truncate:+--truncate} \
+	                         ${max_allocations:+--max-allocations} \
+	                         $max_allocations $scenarios
+fi
+
+top_builddir=$(cd "$top_builddir" && pwd)
+srcdir=$(cd "$srcdir" && pwd)
+client=$top_builddir/bench/fusilli-bench-client
+
+tmp=$(mktemp -d)
+xvfb=
+fusilli=
+
+cleanup () {
+	[ -n "$fusilli" ] && kill "$fusilli" 2>/dev/null
+	[ -n "$xvfb" ] && kill "$xvfb" 2>/dev/null
+	wait 2>/dev/null
+	rm -rf "$tmp"
+}
+trap cleanup EXIT INT TERM
+
+profiler () {
+	dbus-send --session --print-reply=literal --dest=org.fusilli \
+	          /org/fusilli/profiler "org.fusilli.$@" | sed 's/^ *//'
+}
+
+# plugins are looked up in $HOME/.fusilli/plugins first
+mkdir -p "$tmp/.fusilli"
+ln -s "$top_builddir/plugins/.libs" "$tmp/.fusilli/plugins"
+cp "$srcdir/banana.xml" "$tmp/banana.xml"
+
+Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp \
+     3>"$tmp/display" 2>"$tmp/xvfb.log" &
+xvfb=$!
+
+for i in $(seq 50); do
+	[ -s "$tmp/display" ] && break
+	sleep 0.1
+done
+
+if [ ! -s "$tmp/display" ]; then
+	echo "run-bench.sh: Xvfb did not start" >&2
+	exit 1
+fi
+
+DISPLAY=:$(cat "$tmp/display")
+LIBGL_ALWAYS_SOFTWARE=1
+GALLIUM_DRIVER=llvmpipe
+export DISPLAY LIBGL_ALWAYS_SOFTWARE GALLIUM_DRIVER
+
+HOME=$tmp LD_PRELOAD=$top_builddir/bench/.libs/fusilli-alloc-count.so \
+	"$top_builddir/src/fusilli" --replace --profile \
+	--metadatadir "$top_builddir/metadata" \
+	--bananafile "$tmp/banana.xml" >"$tmp/fusilli.log" 2>&1 &
+fusilli=$!
+
+for i in $(seq 100); do
+	profiler clear >/dev/null 2>&1 && break
+	sleep 0.1
+done
+
+commit=$(git -C "$srcdir" rev-parse HEAD 2>/dev/null || echo unknown)
+date=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+
+[ -n "$truncate" ] && : >"$output"
+
+for scenario in $scenarios; do
+	"$client" "$scenario" "$seconds" >"$tmp/client.out" &
+	client_pid=$!
+
+	until grep -q ready "$tmp/client.out" 2>/dev/null; do
+		if ! kill -0 "$client_pid" 2>/dev/null; then
+			echo "run-bench.sh: $scenario failed" >&2
+			exit 1
+		fi
+		sleep 0.05
+	done
+
+	profiler clear >/dev/null
+	wait "$client_pid"
+
+	stats=$(profiler dump string:stats)
+	echo "{\"commit\":\"$commit\",\"date\":\"$date\",\"scenario\":\"$scenario\",\"stats\":$stats}" >>"$output"
+	echo "$scenario: $stats"
+
+	if [ -n "$max_allocations" ]; then
+		allocations=$(echo "$stats" |
+		              sed -n 's/.*"allocations":{[^}]*"p50":\([0-9]*\).*/\1/p')
+
+		if [ -z "$allocations" ]; then
+			echo "run-bench.sh: heap allocations were not counted" >&2
+			failed=1
+		elif [ "$allocations" -gt "$max_allocations" ]; then
+			echo "run-bench.sh: $scenario: $allocations heap allocations" \
+			     "in the median frame, more than $max_allocations" >&2
+			failed=1
+		fi
+	fi
+done
+
+exit ${failed:-0}
@@ -29,7 +29,7 @@
 
 #include <fusilli-plugin.h>
 
-#define CORE_ABIVERSION 20141130
+#define CORE_ABIVERSION 20261031
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -82,6 +82,7 @@ typedef struct _CompIcon          CompIcon;
 typedef struct _CompWindowExtents CompWindowExtents;
 typedef struct _CompWindowExtents CompFullscreenMonitorSet;
 typedef struct _CompProgram       CompProgram;
+typedef struct _CompShader        CompShader;
 typedef struct _CompFunction      CompFunction;
 typedef struct _CompFunctionData  CompFunctionData;
 typedef struct _FragmentAttrib    FragmentAttrib;
@@ -89,6 +90,10 @@ typedef struct _CompCursor        CompCursor;
 typedef struct _CompMatch         CompMatch;
 typedef struct _CompOutput        CompOutput;
 typedef struct _CompWalker        CompWalker;
+typedef struct _CompAtlasPage     CompAtlasPage;
+typedef struct _CompAtlasSlot     CompAtlasSlot;
+typedef struct _CompTextCache     CompTextCache;
+typedef struct _CompTextureUpload CompTextureUpload;
 
 #define REAL_MOD_MASK (ShiftMask | ControlMask | Mod1Mask | Mod2Mask | \
 Mod3Mask | Mod4Mask | Mod5Mask | CompNoMask)
@@ -229,7 +234,11 @@ extern Bool       indirectRendering;
 extern Bool       strictBinding;
 extern Bool       useCow;
 extern Bool       useDesktopHints;
+extern Bool       useMetadataCache;
 extern Bool       onlyCurrentScreen;
+extern Bool       debugOutput;
+
+extern char *regionDumpFile;
 
 extern int lastPointerX;
 extern int lastPointerY;
@@ -330,6 +339,9 @@ bananaInit (const char *metaDataDir,
 
 void
 bananaFini (void);
+
+const char *
+bananaGetCacheDir (void);
 //----------------------------------------------------------------------------//
 int
 bananaLoadPlugin (const char *pluginName);
@@ -348,6 +360,25 @@ bananaRemoveChangeNotifyCallBack (int                        bananaIndex,
 void
 bananaUnloadPlugin (int bananaIndex);
 //----------------------------------------------------------------------------//
+/*
+ * An option handle is resolved once from the option name, after
+ * bananaLoadPlugin, and stays valid until bananaUnloadPlugin.
+ * Reading an option through its handle does not compare any strings.
+ */
+typedef struct _BananaOptionHandle {
+	int        bananaIndex;
+	int        optionIndex; //-1 if the option was not found
+	BananaType type;
+} BananaOptionHandle;
+
+BananaOptionHandle
+bananaGetOptionHandle (int        bananaIndex,
+                       const char *optionName);
+
+const BananaValue *
+bananaGetOptionByHandle (BananaOptionHandle handle,
+                         int                screenNum);
+
 const BananaValue *
 bananaGetOption (int        bananaIndex,
                  const char *optionName,
@@ -360,15 +391,141 @@ bananaSetOption (int         bananaIndex,
                  BananaValue *value);
 
 //----------------------------------------------------------------------------//
+/* core options read on every frame */
+extern BananaOptionHandle coreOptionSyncToVBlank;
+extern BananaOptionHandle coreOptionUnredirectFullscreenWindows;
+extern BananaOptionHandle coreOptionForceIndependentOutputPainting;
+extern BananaOptionHandle coreOptionLighting;
+extern BananaOptionHandle coreOptionOverlappingOutputs;
+extern BananaOptionHandle coreOptionFrameScheduler;
+extern BananaOptionHandle coreOptionTextureAtlas;
+//----------------------------------------------------------------------------//
+
+/* profiler.c */
+
+extern Bool profilerEnabled;
+
+void
+profilerEnterHook (const char *hook,
+                   void       *func);
+
+void
+profilerLeaveHook (const char *hook);
+
+void
+profilerDamageScreen (CompScreen *s);
+
+void
+profilerBeginFrame (CompScreen *s);
+
+void
+profilerEndFrame (CompScreen *s);
+
+void
+profilerFlushNameCache (void);
+
+char *
+profilerDump (const char *format);
+
+void
+initProfiler (void);
+
+void
+finiProfiler (void);
+
+/* mark a call to (real)->func, UNWRAP and WRAP do this for plugins */
+#define PROFILER_ENTER(real, func) \
+        ((void) (profilerEnabled && \
+                 (profilerEnterHook (#func, (void *) (real)->func), TRUE)))
+
+#define PROFILER_LEAVE(func) \
+        ((void) (profilerEnabled && (profilerLeaveHook (#func), TRUE)))
+
+/* atlas.c */
+
+/* windows up to this size are put in a texture atlas */
+#define ATLAS_MAX_WINDOW_SIZE 256
+
+/* frames a resized window is kept out of the atlas */
+#define ATLAS_RESIZE_HOLD 30
+
+void
+updateScreenAtlas (CompScreen *s);
+
+CompTexture *
+getWindowAtlasTexture (CompWindow *w);
+
+Bool
+isWindowContentTexture (CompWindow  *w,
+                        CompTexture *texture);
+
+void
+releaseWindowAtlas (CompWindow *w);
+
+void
+finiScreenAtlas (CompScreen *s);
+
+/* text.c */
+
+void
+finiScreenText (CompScreen *s);
+
+/* scheduler.c */
+
+#define FRAME_SCHEDULER_ADAPTIVE       0
+#define FRAME_SCHEDULER_MAX_THROUGHPUT 1
+
+void
+initFrameScheduler (CompScreen *s);
+
+void
+finiFrameScheduler (CompScreen *s);
+
+void
+setFrameSchedulerRate (CompScreen *s,
+                       int        rate);
+
+int
+getTimeToNextRedraw (CompScreen *s);
+
+Bool
+frameSchedulerSyncToVBlank (CompScreen *s);
+
+void
+frameSchedulerBeginFrame (CompScreen *s);
+
+void
+frameSchedulerEndPaint (CompScreen *s);
+
+void
+frameSchedulerEndFrame (CompScreen *s);
+
+/* present.c */
+
+typedef enum {
+	CompPresentNone = 0, /* nothing was painted */
+	CompPresentSwap,
+	CompPresentCopy      /* copy the damaged boxes to the front buffer */
+} CompPresentMode;
+
+CompPresentMode
+getFramePresentMode (CompScreen   *s,
+                     unsigned int mask,
+                     unsigned int age,
+                     Region       damage);
+
+void
+pushFrameDamage (CompScreen *s);
 
 /* privates.c */
 
 #define WRAP(priv, real, func, wrapFunc) \
+        PROFILER_LEAVE (func); \
         (priv)->func = (real)->func; \
         (real)->func = (wrapFunc)
 
 #define UNWRAP(priv, real, func) \
-        (real)->func = (priv)->func
+        ((real)->func = (priv)->func, PROFILER_ENTER (real, func))
 
 typedef union _CompPrivate {
 	void          *ptr;
@@ -518,12 +675,15 @@ typedef struct _CompFileWatch {
 	CompFileWatchHandle   handle;
 } CompFileWatch;
 
+/* minDeadline and maxDeadline are absolute CLOCK_MONOTONIC times in
+   milliseconds, heapIndex is the position in core.timeoutHeap or -1
+   while the callback is running */
 typedef struct _CompTimeout {
-	struct _CompTimeout *next;
 	int                 minTime;
 	int                 maxTime;
-	int                 minLeft;
-	int                 maxLeft;
+	long long           minDeadline;
+	long long           maxDeadline;
+	int                 heapIndex;
 	CallBackProc        callBack;
 	void                *closure;
 	CompTimeoutHandle   handle;
@@ -548,8 +708,11 @@ struct _CompCore {
 	CompFileWatch       *fileWatch;
 	CompFileWatchHandle lastFileWatchHandle;
 
-	CompTimeout       *timeouts;
-	struct timeval    lastTimeout;
+	CompTimeout       **timeoutHeap;  /* min-heap ordered by minDeadline */
+	int               nTimeout;
+	int               timeoutHeapSize;
+	CompTimeout       **timeoutTable; /* indexed by handle */
+	int               timeoutTableSize;
 	CompTimeoutHandle lastTimeoutHandle;
 
 	CompWatchFd       *watchFds;
@@ -854,6 +1017,11 @@ struct _CompDisplay {
 
 	LogMessageProc logMessage;
 
+	/* windows with damage rects buffered by handleEvent */
+	CompWindow    *pendingDamageWindows;
+	unsigned long damageRectsReceived;
+	unsigned long damageRegionsApplied;
+
 	CompKeyBinding close_window_key,
 	               raise_window_key,
 	               lower_window_key,
@@ -1002,6 +1170,12 @@ readImageFromFile (const char  *name,
                    int         *height,
                    void        **data);
 
+Bool
+decodeImageFromFile (const char  *name,
+                     int         *width,
+                     int         *height,
+                     void        **data);
+
 Bool
 writeImageToFile (const char  *path,
                   const char  *name,
@@ -1045,6 +1219,12 @@ handleFusilliEvent (const char      *pluginName,
 void
 handleSyncAlarm (CompWindow *w);
 
+void
+flushPendingDamage (void);
+
+void
+discardPendingWindowDamage (CompWindow *w);
+
 void
 clearTargetOutput (unsigned int mask);
 
@@ -1223,6 +1403,12 @@ struct _CompWalker {
 */
 #define PAINT_WINDOW_BLEND_MASK                 (1 << 19)
 
+/*
+  flag indicate that the window texture is drawn at least
+  at its own size.
+*/
+#define PAINT_WINDOW_UNMINIFIED_MASK            (1 << 20)
+
 
 typedef Bool (*PaintWindowProc) (CompWindow              *window,
                                  const WindowPaintAttrib *attrib,
@@ -1319,6 +1505,20 @@ Bool
 moreWindowIndices (CompWindow *w,
                    int        newSize);
 
+#define QUAD_INDEX_QUADS 16384
+
+Bool
+initQuadIndices (CompScreen *s);
+
+void
+finiQuadIndices (CompScreen *s);
+
+void
+finiWindowVertexBuffers (CompWindow *w);
+
+void
+finiWindowGeometryCache (CompWindow *w);
+
 void
 addWindowGeometry (CompWindow *w,
                    CompMatrix *matrix,
@@ -1352,13 +1552,26 @@ paintCursor (CompCursor          *cursor,
              Region              region,
              unsigned int        mask);
 
+void
+setWindowOcclusionHook (CompWindow *w,
+                        Bool       *hooked,
+                        Bool       hook);
+
+void
+setScreenOcclusionHook (CompScreen *s,
+                        Bool       *hooked,
+                        Bool       hook);
+
 /* texture.c */
 
 #define POWER_OF_TWO(v) ((v & (v - 1)) == 0)
 
 typedef enum {
 	COMP_TEXTURE_FILTER_FAST,
-	COMP_TEXTURE_FILTER_GOOD
+	COMP_TEXTURE_FILTER_GOOD,
+	/* like good for a texture that is not drawn minified, it is
+	   filtered linearly and its mipmaps are not regenerated */
+	COMP_TEXTURE_FILTER_GOOD_UNMINIFIED
 } CompTextureFilter;
 
 struct _CompTexture {
@@ -1449,6 +1662,101 @@ disableTexture (CompScreen  *screen,
                 CompTexture *texture);
 
 
+/* imageload.c */
+
+typedef int CompImageLoadHandle;
+
+/* called from the main loop, width and height are 0 when the image
+   couldn't be loaded and the texture is left as it was */
+typedef void (*ImageLoadedProc) (CompScreen   *screen,
+                                 CompTexture  *texture,
+                                 Bool         status,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 void         *closure);
+
+CompImageLoadHandle
+readImageToTextureAsync (CompScreen      *screen,
+                         CompTexture     *texture,
+                         const char      *imageFileName,
+                         ImageLoadedProc callBack,
+                         void            *closure);
+
+void
+cancelImageLoad (CompImageLoadHandle handle);
+
+void
+finiImageLoader (void);
+
+
+/* pixel.c */
+
+typedef enum {
+	PixelKernelsScalar = 0,
+	PixelKernelsSSE2,
+	PixelKernelsSSSE3,
+	PixelKernelsAVX2
+} PixelKernels;
+
+PixelKernels
+setPixelKernels (PixelKernels kernels);
+
+void
+premultiplyPixels (unsigned char *data,
+                   int           n);
+
+void
+convertRgbToArgb (const unsigned char *src,
+                  unsigned int        *dst,
+                  int                 n,
+                  unsigned char       alpha);
+
+void
+convertRgbaToRgb (const unsigned char *src,
+                  unsigned char       *dst,
+                  int                 n);
+
+void
+flipImageRows (void       *dst,
+               const void *src,
+               int        stride,
+               int        height);
+
+
+/* upload.c */
+
+CompTextureUpload *
+createTextureUpload (CompScreen   *screen,
+                     unsigned int width,
+                     unsigned int height);
+
+void
+destroyTextureUpload (CompScreen        *screen,
+                      CompTextureUpload *upload);
+
+void *
+beginTextureUpload (CompScreen        *screen,
+                    CompTextureUpload *upload);
+
+void
+endTextureUpload (CompScreen        *screen,
+                  CompTextureUpload *upload,
+                  GLenum            target,
+                  GLuint            texture,
+                  int               x,
+                  int               y,
+                  int               width,
+                  int               height);
+
+Bool
+streamImageToTexture (CompScreen        *screen,
+                      CompTexture       *texture,
+                      CompTextureUpload **upload,
+                      const char        *image,
+                      unsigned int      width,
+                      unsigned int      height);
+
+
 /* screen.c */
 
 #define DEFAULT_REFRESH_RATE               50
@@ -1474,6 +1782,17 @@ disableTexture (CompScreen  *screen,
 #define GLX_FRONT_LEFT_EXT                 0x20DE
 #endif
 
+#ifndef GLX_EXT_buffer_age
+#define GLX_BACK_BUFFER_AGE_EXT            0x20F4
+#endif
+
+/* buckets of the fragment program cache, power of two */
+#define FRAGMENT_PROGRAM_HASH_SIZE         64
+
+/* damage of the last swaps, back buffers that are older than this are
+   painted in full */
+#define DAMAGE_HISTORY_SIZE                4
+
 #define OUTPUT_OVERLAP_MODE_SMART          0
 #define OUTPUT_OVERLAP_MODE_PREFER_LARGER  1
 #define OUTPUT_OVERLAP_MODE_PREFER_SMALLER 2
@@ -1569,6 +1888,63 @@ typedef void (*GLFramebufferTexture2DProc) (GLenum target,
                                             GLint  level);
 typedef void (*GLGenerateMipmapProc) (GLenum target);
 
+typedef void (*GLGenBuffersProc) (GLsizei n,
+                                  GLuint  *buffers);
+typedef void (*GLDeleteBuffersProc) (GLsizei      n,
+                                     const GLuint *buffers);
+typedef void (*GLBindBufferProc) (GLenum target,
+                                  GLuint buffer);
+typedef void (*GLBufferDataProc) (GLenum     target,
+                                  GLsizeiptr size,
+                                  const void *data,
+                                  GLenum     usage);
+typedef void *(*GLMapBufferProc) (GLenum target,
+                                  GLenum access);
+typedef GLboolean (*GLUnmapBufferProc) (GLenum target);
+
+#ifndef GL_ARB_sync
+typedef struct __GLsync *GLsync;
+typedef unsigned long long GLuint64;
+
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT    0x00000001
+#define GL_ALREADY_SIGNALED           0x911A
+#define GL_CONDITION_SATISFIED        0x911C
+#endif
+
+#ifndef GL_ARB_timer_query
+typedef long long GLint64;
+
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT           0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+typedef GLsync (*GLFenceSyncProc) (GLenum     condition,
+                                   GLbitfield flags);
+typedef GLenum (*GLClientWaitSyncProc) (GLsync     sync,
+                                        GLbitfield flags,
+                                        GLuint64   timeout);
+typedef void (*GLDeleteSyncProc) (GLsync sync);
+
+typedef void (*GLGenQueriesProc) (GLsizei n,
+                                  GLuint  *ids);
+typedef void (*GLDeleteQueriesProc) (GLsizei      n,
+                                     const GLuint *ids);
+typedef void (*GLQueryCounterProc) (GLuint id,
+                                    GLenum target);
+typedef void (*GLGetQueryObjectivProc) (GLuint id,
+                                        GLenum pname,
+                                        GLint  *params);
+typedef void (*GLGetQueryObjectui64vProc) (GLuint   id,
+                                           GLenum   pname,
+                                           GLuint64 *params);
+typedef void (*GLGetInteger64vProc) (GLenum  pname,
+                                     GLint64 *params);
+
 #define MAX_DEPTH 32
 
 typedef void (*EnterShowDesktopModeProc) (CompScreen *screen);
@@ -1684,6 +2060,54 @@ typedef struct _CompStartupSequence {
 	unsigned int                viewportY;
 } CompStartupSequence;
 
+/* bump allocator, see arena.c */
+typedef struct _CompArena {
+	char                   *data;
+	size_t                 size;
+	size_t                 used;
+	size_t                 total; /* bytes allocated since the last reset */
+	struct _CompArenaChunk *overflow;
+} CompArena;
+
+/* GPU time of a painted frame, read back once the GPU got there */
+#define FRAME_SCHEDULER_QUERIES 4
+
+typedef struct _CompFrameQuery {
+	GLuint    query;    /* GPU clock at the end of the frame */
+	long long gpuStart; /* GPU clock at the start of the frame, ns */
+	long long cpuTime;
+	Bool      pending;
+} CompFrameQuery;
+
+/* paint timing of a screen, see scheduler.c. times are in microseconds
+   of the monotonic clock */
+typedef struct _CompFrameScheduler {
+	long long period;     /* refresh period */
+	long long lastFrame;  /* when the last frame was presented */
+	long long frameStart;
+	long long deadline;   /* when the frame being painted is due */
+	double    cost;       /* average paint cost, CPU and GPU */
+	double    deviation;  /* average difference of cost and prediction */
+	double    predicted;  /* cost predicted for the current frame */
+	double    measured;   /* cost measured for the last timed frame */
+
+	long long      gpuStart;
+	CompFrameQuery queries[FRAME_SCHEDULER_QUERIES];
+	int            nextQuery;
+} CompFrameScheduler;
+
+/* open addressing hash map from an XID to the window that owns it */
+typedef struct _CompWindowHashEntry {
+	XID        id;
+	CompWindow *window;
+} CompWindowHashEntry;
+
+typedef struct _CompWindowHash {
+	CompWindowHashEntry *entries;
+	int                 size; /* power of two */
+	int                 count;
+} CompWindowHash;
+
 typedef struct _CompFBConfig {
 	GLXFBConfig fbConfig;
 	int         yInverted;
@@ -1726,6 +2150,13 @@ struct _CompOutput {
 	XRectangle workArea;
 };
 
+/* windows that overlap an output, bottom to top, see getOutputWindows */
+typedef struct _CompOutputWindows {
+	CompWindow **windows;
+	int        nWindow;
+	int        size;
+} CompOutputWindows;
+
 typedef struct _CompCursorImage {
 	struct _CompCursorImage *next;
 
@@ -1768,6 +2199,12 @@ struct _CompScreen {
 	CompWindow  *windows;
 	CompWindow  *reverseWindows;
 
+	CompArena frameArena; /* reset after donePaintScreen */
+
+	CompWindowHash windowHash;    /* client window id */
+	CompWindowHash frameHash;     /* frame window id */
+	CompWindowHash syncAlarmHash; /* _NET_WM_SYNC_REQUEST alarm */
+
 	char *windowPrivateIndices;
 	int  windowPrivateLen;
 
@@ -1798,7 +2235,12 @@ struct _CompScreen {
 	int                   textureCompression;
 	GLint         maxTextureSize;
 	int                   fbo;
+	int                   vertexBufferObject;
+	int                   pixelBufferObject;
+	int                   syncObject;
+	int                   timerQuery;
 	int                   fragmentProgram;
+	int                   fragmentShader;
 	int                   maxTextureUnits;
 	Cursor        invisibleCursor;
 	XRectangle        *exposeRects;
@@ -1817,9 +2259,17 @@ struct _CompScreen {
 	CompOutput fullscreenOutput;
 	Bool       hasOverlappingOutputs;
 
+	CompOutputWindows *outputWindows;
+	int               nOutputWindows;
+	Bool              outputWindowsDirty;
+
 	int windowOffsetX;
 	int windowOffsetY;
 
+	/* plugins that currently change how any window occludes the ones
+	   below it, see CompWindow::occlusionHooks */
+	int occlusionHooks;
+
 	XRectangle lastViewport;
 
 	CompActiveWindowHistory history[ACTIVE_WINDOW_HISTORY_NUM];
@@ -1867,8 +2317,7 @@ struct _CompScreen {
 	int                nextRedraw;
 	int                redrawTime;
 	int                optimalRedrawTime;
-	int                frameStatus;
-	int                timeMult;
+	CompFrameScheduler frameScheduler;
 	Bool       idle;
 	int                timeLeft;
 	Bool       pendingCommands;
@@ -1876,7 +2325,7 @@ struct _CompScreen {
 	int lastFunctionId;
 
 	CompFunction *fragmentFunctions;
-	CompProgram  *fragmentPrograms;
+	CompProgram  *fragmentPrograms[FRAGMENT_PROGRAM_HASH_SIZE];
 
 	int saturateFunction[2][64];
 
@@ -1884,6 +2333,23 @@ struct _CompScreen {
 
 	Bool clearBuffers;
 
+	/* full mipmap regenerations in the current frame */
+	unsigned int mipmapRebuilds;
+
+	/* GLX_EXT_buffer_age, frameDamage collects what was painted since
+	   the last swap and damageHistory what was painted before each of
+	   the last swaps, most recent first */
+	Bool   bufferAge;
+	Region frameDamage;
+	Region damageHistory[DAMAGE_HISTORY_SIZE];
+
+	/* texture atlas pages of small windows, see atlas.c */
+	CompAtlasPage *atlasPages;
+	GLuint        atlasFbo;
+
+	/* glyph atlas and rendered strings, see text.c */
+	CompTextCache *textCache;
+
 	Bool lighting;
 	Bool slowAnimations;
 
@@ -1928,6 +2394,29 @@ struct _CompScreen {
 	GLFramebufferTexture2DProc   framebufferTexture2D;
 	GLGenerateMipmapProc         generateMipmap;
 
+	GLGenBuffersProc    genBuffers;
+	GLDeleteBuffersProc deleteBuffers;
+	GLBindBufferProc    bindBuffer;
+	GLBufferDataProc    bufferData;
+	GLMapBufferProc     mapBuffer;
+	GLUnmapBufferProc   unmapBuffer;
+
+	GLFenceSyncProc      fenceSync;
+	GLClientWaitSyncProc clientWaitSync;
+	GLDeleteSyncProc     deleteSync;
+
+	GLGenQueriesProc          genQueries;
+	GLDeleteQueriesProc       deleteQueries;
+	GLQueryCounterProc        queryCounter;
+	GLGetQueryObjectivProc    getQueryObjectiv;
+	GLGetQueryObjectui64vProc getQueryObjectui64v;
+	GLGetInteger64vProc       getInteger64v;
+
+	/* two triangles for each of QUAD_INDEX_QUADS quads, quadIndexBuffer
+	   holds the same indices when vertex buffer objects are supported */
+	GLushort *quadIndices;
+	GLuint   quadIndexBuffer;
+
 	GLXContext ctx;
 
 	PreparePaintScreenProc      preparePaintScreen;
@@ -2041,11 +2530,32 @@ void
 unhookWindowFromScreen (CompScreen *s,
                         CompWindow *w);
 
+void
+invalidateOutputWindows (CompScreen *s);
+
+CompOutputWindows *
+getOutputWindows (CompScreen *s,
+                  CompOutput *output);
+
 void
 forEachWindowOnScreen (CompScreen        *screen,
                        ForEachWindowProc proc,
                        void              *closure);
 
+void
+addWindowToHash (CompWindowHash *hash,
+                 XID            id,
+                 CompWindow     *w);
+
+void
+removeWindowFromHash (CompWindowHash *hash,
+                      XID            id,
+                      CompWindow     *w);
+
+CompWindow *
+findWindowInHash (CompWindowHash *hash,
+                  XID            id);
+
 CompWindow *
 findWindowAtScreen (CompScreen *s,
                     Window     id);
@@ -2282,6 +2792,45 @@ struct _CompWindowExtents {
 	int bottom;
 };
 
+/* damage rects buffered per window before they are collapsed to their
+   bounding box */
+#define MAX_PENDING_DAMAGE_RECTS 16
+
+/* geometry uploaded to a vertex buffer object, a window keeps a few of
+   them as the window, its decorations and shadows are drawn from the
+   same vertex array */
+#define WINDOW_VERTEX_BUFFERS 4
+
+typedef struct _CompWindowVertexBuffer {
+	GLuint       name;
+	unsigned int generation; /* geometryGeneration of what was uploaded */
+	int          vCount;
+	int          stride;
+	unsigned int lastUse;
+} CompWindowVertexBuffer;
+
+/* output of addWindowGeometry for one set of arguments, reused while
+   the window region, the clip and the matrices stay the same */
+#define WINDOW_GEOMETRY_CACHE    4
+#define GEOMETRY_CACHE_MATRICES  4
+
+typedef struct _CompWindowGeometry {
+	unsigned int hash;
+	CompMatrix   matrix[GEOMETRY_CACHE_MATRICES];
+	int          nMatrix;
+	BoxPtr       rects;    /* region rects followed by clip rects */
+	int          nRegion;
+	int          nClip;
+	int          rectSize;
+	GLfloat      *vertices;
+	int          vertexSize;
+	int          vertexCapacity;
+	int          vCount;
+	int          vertexStride; /* 0 if the entry is unused */
+	unsigned int generation;
+	unsigned int lastUse;
+} CompWindowGeometry;
+
 typedef struct _CompStruts {
 	XRectangle left;
 	XRectangle right;
@@ -2313,6 +2862,9 @@ struct _CompWindow {
 	XSizeHints            sizeHints;
 	Pixmap         pixmap;
 	CompTexture       *texture;
+	CompAtlasSlot     *atlasSlot;
+	Bool              atlasDamaged;
+	int               atlasHold;
 	CompMatrix        matrix;
 	Damage        damage;
 	Bool         inputHint;
@@ -2412,6 +2964,10 @@ struct _CompWindow {
 	int            sizeDamage;
 	int            nDamage;
 
+	BoxRec     pendingDamage[MAX_PENDING_DAMAGE_RECTS];
+	int        nPendingDamage;
+	CompWindow *nextPendingDamage;
+
 	GLfloat  *vertices;
 	int      vertexSize;
 	int      vertexStride;
@@ -2422,6 +2978,28 @@ struct _CompWindow {
 	int      texCoordSize;
 	int      indexCount;
 
+	/* identifies the contents of vertices, 0 if unknown. It is set by
+	   addWindowGeometry, code that changes vertices in any other way
+	   must reset it to 0 */
+	unsigned int geometryGeneration;
+	unsigned int geometryGenerationClock;
+
+	CompWindowVertexBuffer vertexBuffers[WINDOW_VERTEX_BUFFERS];
+	unsigned int           vertexBufferClock;
+
+	CompWindowGeometry geometryCache[WINDOW_GEOMETRY_CACHE];
+	unsigned int       geometryCacheClock;
+
+	/* plugins that call addWindowGeometry with arguments that change
+	   every frame raise this around the calls to bypass the cache */
+	int noGeometryCache;
+
+	/* plugins that currently change how this window occludes the ones
+	   below it, by its paint attributes, its transform or its offset.
+	   While this and CompScreen::occlusionHooks are zero, occlusion
+	   detection skips the paintWindow chain for the window */
+	int occlusionHooks;
+
 	/* must be set by addWindowGeometry */
 	DrawWindowGeometryProc drawWindowGeometry;
 
@@ -2953,6 +3531,36 @@ void
 disableFragmentAttrib (CompScreen     *s,
                        FragmentAttrib *attrib);
 
+/* shader.c */
+
+#define MAX_FRAGMENT_ENV_PARAMETERS 256
+
+Bool
+initFragmentShaders (CompScreen *s);
+
+void
+storeFragmentEnvParameter (GLuint  index,
+                           GLfloat x,
+                           GLfloat y,
+                           GLfloat z,
+                           GLfloat w);
+
+CompShader *
+createFragmentShader (CompScreen   *s,
+                      const char   *program,
+                      unsigned int signatureHash);
+
+void
+destroyFragmentShader (CompScreen *s,
+                       CompShader *shader);
+
+void
+enableFragmentShader (CompScreen *s,
+                      CompShader *shader);
+
+void
+disableFragmentShader (CompScreen *s);
+
 
 /* matrix.c */
 
@@ -2991,6 +3599,74 @@ matrixTranslate (CompTransform *transform,
 void
 matrixGetIdentity (CompTransform *m);
 
+/* arena.c */
+
+void
+initArena (CompArena *arena);
+
+void
+finiArena (CompArena *arena);
+
+void *
+arenaAlloc (CompArena *arena,
+            size_t    size);
+
+void
+resetArena (CompArena *arena);
+
+/* memory that is valid until the current frame of s is done */
+void *
+allocFrameMemory (CompScreen *s,
+                  size_t     size);
+
+Bool
+getHeapAllocationCount (unsigned long *count);
+
+/* region.c */
+
+#define COMP_REGION_INLINE_RECTS 8
+
+/* a region with inline storage for a few rects, &region is a valid
+   Region for reading but must only be modified with the functions
+   below */
+typedef struct _CompRegion {
+	REGION region;
+	BOX    inlineRects[COMP_REGION_INLINE_RECTS];
+} CompRegion;
+
+void
+initRegion (CompRegion *r);
+
+void
+finiRegion (CompRegion *r);
+
+void
+compEmptyRegion (Region r);
+
+Bool
+compCopyRegion (Region src,
+                Region dst);
+
+Bool
+compUnionRegion (Region a,
+                 Region b,
+                 Region dst);
+
+Bool
+compUnionRectWithRegion (const BoxRec *box,
+                         Region       src,
+                         Region       dst);
+
+Bool
+compIntersectRegion (Region a,
+                     Region b,
+                     Region dst);
+
+Bool
+compSubtractRegion (Region a,
+                    Region b,
+                    Region dst);
+
 /* cursor.c */
 
 void
@@ -3067,6 +3743,15 @@ pngImageToFile (const char  *path,
                 int         stride,
                 void        *data);
 
+Bool
+pngImageToFileWithCompression (const char  *path,
+                               const char  *name,
+                               int         width,
+                               int         height,
+                               int         stride,
+                               void        *data,
+                               int         level);
+
 Bool
 pngFileToImage (const char  *path,
                 const char  *name,
@@ -33,7 +33,7 @@
 extern "C" {
 #endif
 
-#define CUBE_ABIVERSION 20080424
+#define CUBE_ABIVERSION 20261027
 
 #define CUBE_MOMODE_AUTO  0
 #define CUBE_MOMODE_MULTI 1
@@ -151,6 +151,9 @@ typedef struct _CubeScreen {
 	unsigned int skyW, skyH;
 	CompTexture  texture, sky;
 
+	/* cap and skydome images that are still being loaded */
+	CompImageLoadHandle capLoad, skyLoad;
+
 	int nOutput;
 	int output[64];
 	int outputMask[64];
@@ -170,6 +173,8 @@ typedef struct _CubeScreen {
 	float toOpacity;
 	float lastOpacity;
 
+	Bool occlusionHook;
+
 	int  moMode;
 	Bool recalcOutput;
 } CubeScreen;
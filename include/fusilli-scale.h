@@ -33,7 +33,7 @@
 extern "C" {
 #endif
 
-#define SCALE_ABIVERSION 20081007
+#define SCALE_ABIVERSION 20261020
 
 #define SCALE_STATE_NONE 0
 #define SCALE_STATE_OUT  1
@@ -111,6 +111,8 @@ typedef struct _ScaleScreen {
 	int state;
 	int moreAdjust;
 
+	Bool occlusionHook;
+
 	Cursor cursor;
 
 	ScaleSlot *slots;
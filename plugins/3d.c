@@ -76,6 +76,7 @@ typedef struct _tdScreen
 
 	Bool  active;
 	Bool  painting3D;
+	Bool  occlusionHook;
 	float currentScale;
 
 	float basicScale;
@@ -196,6 +197,9 @@ tdPreparePaintScreen (CompScreen *s,
 	tds->active       = (fabs (tds->basicScale - 1.0f) > 1e-4);
 	tds->currentScale = tds->basicScale;
 
+	setScreenOcclusionHook (s, &tds->occlusionHook,
+	                        tds->active || cs->rotationState != RotationNone);
+
 	UNWRAP (tds, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (tds, s, preparePaintScreen, tdPreparePaintScreen);
@@ -809,8 +813,9 @@ tdInitScreen (CompPlugin *p,
 	tds->basicScale     = 1.0f;
 	tds->currentScale   = 1.0f;
 
-	tds->active     = FALSE;
-	tds->painting3D = FALSE;
+	tds->active        = FALSE;
+	tds->painting3D    = FALSE;
+	tds->occlusionHook = FALSE;
 
 	const BananaValue *
 	option_window_match = bananaGetOption (bananaIndex,
@@ -851,6 +856,8 @@ tdFiniScreen (CompPlugin *p,
 	UNWRAP (tds, cs, paintViewport);
 	UNWRAP (tds, cs, shouldPaintViewport);
 
+	setScreenOcclusionHook (s, &tds->occlusionHook, FALSE);
+
 	freeWindowPrivateIndex (s, tds->windowPrivateIndex);
 
 	free (tds);
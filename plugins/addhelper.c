@@ -80,6 +80,7 @@ typedef struct _AddHelperScreen
 typedef struct _AddHelperWindow
 {
 	Bool dim;
+	Bool occlusionHook;
 } AddHelperWindow;
 
 /* Walk through all windows of the screen and adjust them if they
@@ -118,6 +119,13 @@ walkWindows (void)
 			aw->dim = TRUE;
 		}
 
+		for (w = s->windows; w; w = w->next)
+		{
+			ADD_WINDOW (w);
+
+			setWindowOcclusionHook (w, &aw->occlusionHook, aw->dim);
+		}
+
 		damageScreen (s);
 	}
 }
@@ -217,6 +225,9 @@ addhelperInitWindow (CompPlugin *p,
 	else
 		aw->dim = FALSE;
 
+	aw->occlusionHook = FALSE;
+	setWindowOcclusionHook (w, &aw->occlusionHook, aw->dim);
+
 	return TRUE;
 }
 
@@ -226,6 +237,8 @@ addhelperFiniWindow (CompPlugin *p,
 {
 	ADD_WINDOW (w);
 
+	setWindowOcclusionHook (w, &aw->occlusionHook, FALSE);
+
 	free (aw);
 }
 
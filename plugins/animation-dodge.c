@@ -45,32 +45,32 @@ fxDodgeProcessSubject (CompWindow *wCur,
                        Region     dodgeRegion,
                        Bool       alwaysInclude)
 {
-	XRectangle rect;
-	rect.x = WIN_X (wCur);
-	rect.y = WIN_Y (wCur);
-	rect.width = WIN_W (wCur);
-	rect.height = WIN_H (wCur);
-	Region wCurRegion = XCreateRegion ();
-	if (!wCurRegion)
-		return;
-
-	XUnionRectWithRegion (&rect, &emptyRegion, wCurRegion);
+	BoxRec box;
+	box.x1 = WIN_X (wCur);
+	box.y1 = WIN_Y (wCur);
+	box.x2 = box.x1 + WIN_W (wCur);
+	box.y2 = box.y1 + WIN_H (wCur);
+
+	// the window is a single rect, so it intersects wRegion
+	// if any rect of wRegion overlaps it
 	if (!alwaysInclude)
 	{
-		Region intersectionRegion = XCreateRegion ();
-		if (intersectionRegion)
+		int i;
+
+		for (i = 0; i < wRegion->numRects; i++)
 		{
-			XIntersectRegion (wRegion, wCurRegion,
-			                  intersectionRegion);
-			if (!XEmptyRegion (intersectionRegion))
-				XUnionRegion (dodgeRegion, wCurRegion, dodgeRegion);
-			XDestroyRegion (intersectionRegion);
+			BoxPtr r = &wRegion->rects[i];
+
+			if (r->x1 < box.x2 && box.x1 < r->x2 &&
+			    r->y1 < box.y2 && box.y1 < r->y2)
+				break;
 		}
+
+		if (i == wRegion->numRects)
+			return;
 	}
-	else
-		XUnionRegion (dodgeRegion, wCurRegion, dodgeRegion);
 
-	XDestroyRegion (wCurRegion);
+	compUnionRectWithRegion (&box, dodgeRegion, dodgeRegion);
 }
 
 // Returns FALSE if the subject is destroyed or if there was an error when
@@ -90,16 +90,8 @@ fxDodgeFindDodgeBox (CompWindow *w,
 	// (stacked in the moreToBePaintedNext chain)
 	// Then this would be a bounding box of the subject windows
 	// intersecting with dodger.
-	Region wRegion = XCreateRegion ();
-	if (!wRegion)
-		return FALSE;
-
-	Region dodgeRegion = XCreateRegion ();
-	if (!dodgeRegion)
-	{
-		XDestroyRegion (wRegion);
-		return FALSE;
-	}
+	CompRegion wRegion;
+	CompRegion dodgeRegion;
 
 	XRectangle rect;
 	rect.x = WIN_X (w);
@@ -130,13 +122,22 @@ fxDodgeFindDodgeBox (CompWindow *w,
 		rect.width += dodgeMaxAmount;
 		break;
 	}
-	XUnionRectWithRegion (&rect, &emptyRegion, wRegion);
+	BoxRec box;
+	box.x1 = rect.x;
+	box.y1 = rect.y;
+	box.x2 = rect.x + rect.width;
+	box.y2 = rect.y + rect.height;
+
+	initRegion (&wRegion);
+	initRegion (&dodgeRegion);
+
+	compUnionRectWithRegion (&box, &emptyRegion, &wRegion.region);
 
 	AnimWindow *awCur;
 	CompWindow *wCur = aw->dodgeSubjectWin;
 	for (; wCur; wCur = awCur->moreToBePaintedNext)
 	{
-		fxDodgeProcessSubject (wCur, wRegion, dodgeRegion,
+		fxDodgeProcessSubject (wCur, &wRegion.region, &dodgeRegion.region,
 		                       wCur == aw->dodgeSubjectWin);
 		awCur = GET_ANIM_WINDOW (wCur, as);
 		if (!awCur)
@@ -147,16 +148,17 @@ fxDodgeFindDodgeBox (CompWindow *w,
 	wCur = awSubj->moreToBePaintedPrev;
 	for (; wCur; wCur = awCur->moreToBePaintedPrev)
 	{
-		fxDodgeProcessSubject (wCur, wRegion, dodgeRegion, FALSE);
+		fxDodgeProcessSubject (wCur, &wRegion.region, &dodgeRegion.region,
+		                       FALSE);
 		awCur = GET_ANIM_WINDOW (wCur, as);
 		if (!awCur)
 			break;
 	}
 
-	XClipBox (dodgeRegion, dodgeBox);
+	XClipBox (&dodgeRegion.region, dodgeBox);
 
-	XDestroyRegion (wRegion);
-	XDestroyRegion (dodgeRegion);
+	finiRegion (&wRegion);
+	finiRegion (&dodgeRegion);
 
 	return TRUE;
 }
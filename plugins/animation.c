@@ -832,31 +832,32 @@ damageBoundingBox (CompWindow * w)
 		return;
 
 	// Find union of BB and lastBB
-	Region regionToDamage = XCreateRegion ();
-	if (!regionToDamage)
-		return;
-
-	XRectangle rect;
+	CompRegion regionToDamage;
+	BoxRec box;
 
 	BoxPtr BB = &aw->BB;
 	BoxPtr lastBB = &aw->lastBB;
 
-	// Have a 1 pixel margin to prevent occasional 1 pixel line artifact
-	rect.x = BB->x1 - 1;
-	rect.y = BB->y1 - 1;
-	rect.width  = BB->x2 - BB->x1 + 2;
-	rect.height = BB->y2 - BB->y1 + 2;
-	XUnionRectWithRegion (&rect, &emptyRegion, regionToDamage);
-
-	rect.x = lastBB->x1 - 1;
-	rect.y = lastBB->y1 - 1;
-	rect.width  = lastBB->x2 - lastBB->x1 + 2;
-	rect.height = lastBB->y2 - lastBB->y1 + 2;
-	XUnionRectWithRegion (&rect, regionToDamage, regionToDamage);
-
-	damageScreenRegion (w->screen, regionToDamage);
+	initRegion (&regionToDamage);
 
-	XDestroyRegion (regionToDamage);
+	// Have a 1 pixel margin to prevent occasional 1 pixel line artifact
+	box.x1 = BB->x1 - 1;
+	box.y1 = BB->y1 - 1;
+	box.x2 = BB->x2 + 1;
+	box.y2 = BB->y2 + 1;
+	compUnionRectWithRegion (&box, &regionToDamage.region,
+	                         &regionToDamage.region);
+
+	box.x1 = lastBB->x1 - 1;
+	box.y1 = lastBB->y1 - 1;
+	box.x2 = lastBB->x2 + 1;
+	box.y2 = lastBB->y2 + 1;
+	compUnionRectWithRegion (&box, &regionToDamage.region,
+	                         &regionToDamage.region);
+
+	damageScreenRegion (w->screen, &regionToDamage.region);
+
+	finiRegion (&regionToDamage);
 }
 
 Bool
@@ -1570,20 +1571,26 @@ initiateFocusAnimation (CompWindow *w)
 			// faded through by w. If the region is empty, don't
 			// run focus fade effect.
 
-			Region fadeRegion = XCreateRegion ();
-			Region thisAndSubjectIntersection = XCreateRegion ();
-			Region thisWinRegion = XCreateRegion ();
-			Region subjectWinRegion = XCreateRegion ();
-			XRectangle rect;
+			CompRegion fadeRegion;
+			CompRegion thisAndSubjectIntersection;
+			CompRegion thisWinRegion;
+			CompRegion subjectWinRegion;
+			BoxRec box;
 
 			int numDodgingWins = 0;
 
+			initRegion (&fadeRegion);
+			initRegion (&thisAndSubjectIntersection);
+			initRegion (&thisWinRegion);
+			initRegion (&subjectWinRegion);
+
 			// Compute subject win. region
-			rect.x = BORDER_X (w);
-			rect.y = BORDER_Y (w);
-			rect.width = BORDER_W (w);
-			rect.height = BORDER_H (w);
-			XUnionRectWithRegion (&rect, &emptyRegion, subjectWinRegion);
+			box.x1 = BORDER_X (w);
+			box.y1 = BORDER_Y (w);
+			box.x2 = box.x1 + BORDER_W (w);
+			box.y2 = box.y1 + BORDER_H (w);
+			compUnionRectWithRegion (&box, &emptyRegion,
+			                         &subjectWinRegion.region);
 
 			CompWindow *dw; // Dodge or Focus fade candidate window
 			for (dw = wStart; dw && dw != wEnd->next; dw = dw->next)
@@ -1609,22 +1616,25 @@ initiateFocusAnimation (CompWindow *w)
 					nonMatching = TRUE;
 
 				// Compute intersection of this (dw) with subject
-				rect.x = BORDER_X (dw);
-				rect.y = BORDER_Y (dw);
-				rect.width = BORDER_W (dw);
-				rect.height = BORDER_H (dw);
-				XUnionRectWithRegion (&rect, &emptyRegion, thisWinRegion);
-				XIntersectRegion (subjectWinRegion, thisWinRegion,
-				                  thisAndSubjectIntersection);
-				XUnionRegion (fadeRegion, thisAndSubjectIntersection,
-				              fadeRegion);
+				box.x1 = BORDER_X (dw);
+				box.y1 = BORDER_Y (dw);
+				box.x2 = box.x1 + BORDER_W (dw);
+				box.y2 = box.y1 + BORDER_H (dw);
+				compUnionRectWithRegion (&box, &emptyRegion,
+				                         &thisWinRegion.region);
+				compIntersectRegion (&subjectWinRegion.region,
+				                     &thisWinRegion.region,
+				                     &thisAndSubjectIntersection.region);
+				compUnionRegion (&fadeRegion.region,
+				                 &thisAndSubjectIntersection.region,
+				                 &fadeRegion.region);
 
 				if (chosenEffect == AnimEffectFocusFade)
 				{
 					adw->winPassingThrough = w;
 				}
 				else if (chosenEffect == AnimEffectDodge &&
-				         !XEmptyRegion (thisAndSubjectIntersection) &&
+				         thisAndSubjectIntersection.region.numRects &&
 				         (adw->com.curAnimEffect == AnimEffectNone ||
 				          (adw->com.curAnimEffect == AnimEffectDodge)) &&
 				         dw->id != w->id) // don't let the subject dodge itself
@@ -1638,7 +1648,7 @@ initiateFocusAnimation (CompWindow *w)
 				}
 			}
 
-			if (XEmptyRegion (fadeRegion))
+			if (!fadeRegion.region.numRects)
 			{
 				// empty intersection -> won't be drawn (will end prematurely)
 				duration = 0;
@@ -1797,10 +1807,10 @@ initiateFocusAnimation (CompWindow *w)
 				        maxTransformTotalProgress * duration;
 			}
 
-			XDestroyRegion (fadeRegion);
-			XDestroyRegion (thisAndSubjectIntersection);
-			XDestroyRegion (thisWinRegion);
-			XDestroyRegion (subjectWinRegion);
+			finiRegion (&fadeRegion);
+			finiRegion (&thisAndSubjectIntersection);
+			finiRegion (&thisWinRegion);
+			finiRegion (&subjectWinRegion);
 		}
 
 		if (!animEnsureModel (w))
@@ -2271,7 +2281,6 @@ animAddWindowGeometry (CompWindow *w,
 		Bool rect = TRUE;
 		Bool useTextureQ = FALSE;
 		Model *model = aw->com.model;
-		Region awRegion = NULL;
 
 		Bool notUsing3dCoords =
 		        !aw->com.curAnimEffect->properties.modelAnimIs3D;
@@ -2283,10 +2292,21 @@ animAddWindowGeometry (CompWindow *w,
 
 		if (aw->com.useDrawRegion)
 		{
-			awRegion = XCreateRegion ();
-			XIntersectRegion (region, aw->com.drawRegion, awRegion);
-			nClip = awRegion->numRects;
-			pClip = awRegion->rects;
+			// the clips only have to last for this frame
+			CompRegion awRegion;
+
+			initRegion (&awRegion);
+			compIntersectRegion (region, aw->com.drawRegion,
+			                     &awRegion.region);
+
+			nClip = awRegion.region.numRects;
+			pClip = allocFrameMemory (w->screen, sizeof (BOX) * nClip);
+			if (pClip)
+				memcpy (pClip, awRegion.region.rects, sizeof (BOX) * nClip);
+			else
+				nClip = 0;
+
+			finiRegion (&awRegion);
 		}
 		else
 		{
@@ -2295,11 +2315,7 @@ animAddWindowGeometry (CompWindow *w,
 		}
 
 		if (nClip == 0)         // nothing to do
-		{
-			if (awRegion)
-				XDestroyRegion (awRegion);
 			return;
-		}
 
 		for (it = 0; it < nMatrix; it++)
 		{
@@ -2311,6 +2327,7 @@ animAddWindowGeometry (CompWindow *w,
 		}
 
 		w->drawWindowGeometry = animDrawWindowGeometry;
+		w->geometryGeneration = 0;
 
 		if (aw->com.curAnimEffect->properties.addCustomGeometryFunc)
 		{
@@ -2688,11 +2705,6 @@ animAddWindowGeometry (CompWindow *w,
 		}
 		w->vCount = nVertices;
 		w->indexCount = nIndices;
-		if (awRegion)
-		{
-			XDestroyRegion (awRegion);
-			awRegion = NULL;
-		}
 	}
 	else
 	{
@@ -4732,6 +4744,8 @@ animInitScreen (CompPlugin *p,
 	WRAP (as, s, windowUngrabNotify, animWindowUngrabNotify);
 	WRAP (as, s, initWindowWalker, animInitWindowWalker);
 
+	s->occlusionHooks++;
+
 	as->startCountdown = 20; // start the countdown
 
 	for (i = 0; i < NUM_WATCHED_PLUGINS; i++)
@@ -4854,6 +4868,8 @@ animFiniScreen (CompPlugin *p,
 	UNWRAP (as, s, windowUngrabNotify);
 	UNWRAP (as, s, initWindowWalker);
 
+	s->occlusionHooks--;
+
 	free (as);
 }
 
@@ -363,7 +363,7 @@ regionFromBoxes (BlurBox *box,
 		r.extents.y2 = y;
 
 		if (r.extents.x2 > r.extents.x1 && r.extents.y2 > r.extents.y1)
-			XUnionRegion (region, &r, region);
+			compUnionRegion (region, &r, region);
 
 		box++;
 	}
@@ -393,14 +393,14 @@ blurWindowUpdateRegion (CompWindow *w)
 		r.extents.x2 = w->width + w->output.right;
 		r.extents.y2 = w->height + w->output.bottom;
 
-		XUnionRegion (&r, region, region);
+		compUnionRegion (&r, region, region);
 
 		r.extents.x1 = 0;
 		r.extents.y1 = 0;
 		r.extents.x2 = w->width;
 		r.extents.y2 = w->height;
 
-		XSubtractRegion (region, &r, region);
+		compSubtractRegion (region, &r, region);
 
 		bw->state[BLUR_STATE_DECOR].clipped = FALSE;
 
@@ -411,10 +411,10 @@ blurWindowUpdateRegion (CompWindow *w)
 			                     w->width, w->height);
 			if (q)
 			{
-				XIntersectRegion (q, region, q);
+				compIntersectRegion (q, region, q);
 				if (!XEqualRegion (q, region))
 				{
-					XSubtractRegion (q, &emptyRegion, region);
+					compCopyRegion (q, region);
 					bw->state[BLUR_STATE_DECOR].clipped = TRUE;
 				}
 
@@ -439,17 +439,17 @@ blurWindowUpdateRegion (CompWindow *w)
 			                     w->width, w->height);
 			if (q)
 			{
-				XIntersectRegion (q, &r, q);
+				compIntersectRegion (q, &r, q);
 				if (!XEqualRegion (q, &r))
 					bw->state[BLUR_STATE_CLIENT].clipped = TRUE;
 
-				XUnionRegion (q, region, region);
+				compUnionRegion (q, region, region);
 				XDestroyRegion (q);
 			}
 		}
 		else
 		{
-			XUnionRegion (&r, region, region);
+			compUnionRegion (&r, region, region);
 		}
 	}
 
@@ -857,7 +857,7 @@ blurPaintOutput (CompScreen              *s,
 	if (bs->alphaBlur)
 	{
 		bs->stencilBox = region->extents;
-		XSubtractRegion (region, &emptyRegion, bs->region);
+		compCopyRegion (region, bs->region);
 
 		if (mask & PAINT_SCREEN_REGION_MASK)
 		{
@@ -867,7 +867,7 @@ blurPaintOutput (CompScreen              *s,
 				XShrinkRegion (bs->region,
 				               -bs->filterRadius * 2,
 				               -bs->filterRadius * 2);
-				XIntersectRegion (bs->region, &s->region, bs->region);
+				compIntersectRegion (bs->region, &s->region, bs->region);
 
 				region = bs->region;
 			}
@@ -878,11 +878,10 @@ blurPaintOutput (CompScreen              *s,
 	{
 		CompWindow *w;
 
-		XSubtractRegion (&emptyRegion, &emptyRegion, bs->occlusion);
+		compEmptyRegion (bs->occlusion);
 
 		for (w = s->windows; w; w = w->next)
-			XSubtractRegion (&emptyRegion, &emptyRegion,
-			                 GET_BLUR_WINDOW (w, bs)->clip);
+			compEmptyRegion (GET_BLUR_WINDOW (w, bs)->clip);
 	}
 
 	bs->output = output;
@@ -908,11 +907,10 @@ blurPaintTransformedOutput (CompScreen              *s,
 	{
 		CompWindow *w;
 
-		XSubtractRegion (&emptyRegion, &emptyRegion, bs->occlusion);
+		compEmptyRegion (bs->occlusion);
 
 		for (w = s->windows; w; w = w->next)
-			XSubtractRegion (&emptyRegion, &emptyRegion,
-			                 GET_BLUR_WINDOW (w, bs)->clip);
+			compEmptyRegion (GET_BLUR_WINDOW (w, bs)->clip);
 	}
 
 	UNWRAP (bs, s, paintTransformedOutput);
@@ -963,11 +961,11 @@ blurPaintWindow (CompWindow              *w,
 
 	if (!bs->blurOcclusion && (mask & PAINT_WINDOW_OCCLUSION_DETECTION_MASK))
 	{
-		XSubtractRegion (bs->occlusion, &emptyRegion, bw->clip);
+		compCopyRegion (bs->occlusion, bw->clip);
 
 		if (!(w->lastMask & PAINT_WINDOW_NO_CORE_INSTANCE_MASK) &&
 		    !(w->lastMask & PAINT_WINDOW_TRANSFORMED_MASK) && bw->region)
-		    XUnionRegion (bs->occlusion, bw->region, bs->occlusion);
+		    compUnionRegion (bs->occlusion, bw->region, bs->occlusion);
 	}
 
 	return status;
@@ -1843,7 +1841,7 @@ blurProjectRegion (CompWindow          *w,
 		region.extents.x2 = maxX + bs->filterRadius + 0.5f;
 		region.extents.y2 = (s->height - minY + bs->filterRadius + 0.5f);
 
-		XUnionRegion (&region, bs->tmpRegion3, bs->tmpRegion3);
+		compUnionRegion (&region, bs->tmpRegion3, bs->tmpRegion3);
 	}
 }
 
@@ -1868,7 +1866,7 @@ blurUpdateDstTexture (CompWindow          *w,
 	filter = b_filter->i;
 
 	/* create empty region */
-	XSubtractRegion (&emptyRegion, &emptyRegion, bs->tmpRegion3);
+	compEmptyRegion (bs->tmpRegion3);
 
 	if (filter == BLUR_FILTER_GAUSSIAN)
 	{
@@ -1885,7 +1883,7 @@ blurUpdateDstTexture (CompWindow          *w,
 			region.extents.x2 = w->attrib.x + w->width + w->output.right;
 			region.extents.y2 = w->attrib.y;
 
-			XIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
+			compIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
 			if (bs->tmpRegion2->numRects)
 				blurProjectRegion (w, bs->output, transform);
 
@@ -1895,7 +1893,7 @@ blurUpdateDstTexture (CompWindow          *w,
 			region.extents.x2 = w->attrib.x + w->width + w->output.right;
 			region.extents.y2 = w->attrib.y + w->height + w->output.bottom;
 
-			XIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
+			compIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
 			if (bs->tmpRegion2->numRects)
 				blurProjectRegion (w, bs->output, transform);
 
@@ -1905,7 +1903,7 @@ blurUpdateDstTexture (CompWindow          *w,
 			region.extents.x2 = w->attrib.x;
 			region.extents.y2 = w->attrib.y + w->height;
 
-			XIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
+			compIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
 			if (bs->tmpRegion2->numRects)
 				blurProjectRegion (w, bs->output, transform);
 
@@ -1915,7 +1913,7 @@ blurUpdateDstTexture (CompWindow          *w,
 			region.extents.x2 = w->attrib.x + w->width + w->output.right;
 			region.extents.y2 = w->attrib.y + w->height;
 
-			XIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
+			compIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
 			if (bs->tmpRegion2->numRects)
 				blurProjectRegion (w, bs->output, transform);
 		}
@@ -1928,7 +1926,7 @@ blurUpdateDstTexture (CompWindow          *w,
 			region.extents.x2 = w->attrib.x + w->width;
 			region.extents.y2 = w->attrib.y + w->height;
 
-			XIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
+			compIntersectRegion (bs->tmpRegion, &region, bs->tmpRegion2);
 			if (bs->tmpRegion2->numRects)
 				blurProjectRegion (w, bs->output, transform);
 		}
@@ -1936,13 +1934,13 @@ blurUpdateDstTexture (CompWindow          *w,
 	else
 	{
 		/* get region that needs blur */
-		XSubtractRegion (bs->tmpRegion, &emptyRegion, bs->tmpRegion2);
+		compCopyRegion (bs->tmpRegion, bs->tmpRegion2);
 
 		if (bs->tmpRegion2->numRects)
 			blurProjectRegion (w, bs->output, transform);
 	}
 
-	XIntersectRegion (bs->tmpRegion3, bs->region, bs->tmpRegion);
+	compIntersectRegion (bs->tmpRegion3, bs->region, bs->tmpRegion);
 
 	if (XEmptyRegion (bs->tmpRegion))
 		return FALSE;
@@ -2114,9 +2112,9 @@ blurDrawWindow (CompWindow           *w,
 			else
 				reg = region;
 
-			XIntersectRegion (bw->region, reg, bs->tmpRegion);
+			compIntersectRegion (bw->region, reg, bs->tmpRegion);
 			if (!bs->blurOcclusion && !(mask & PAINT_WINDOW_TRANSFORMED_MASK))
-				XSubtractRegion(bs->tmpRegion, bw->clip, bs->tmpRegion);
+				compSubtractRegion (bs->tmpRegion, bw->clip, bs->tmpRegion);
 
 			if (blurUpdateDstTexture (w, transform, &box, clientThreshold))
 			{
@@ -2157,9 +2155,9 @@ blurDrawWindow (CompWindow           *w,
 			}
 
 			if (!bs->blurOcclusion)
-				XSubtractRegion (bw->region, bw->clip, bs->tmpRegion);
+				compSubtractRegion (bw->region, bw->clip, bs->tmpRegion);
 			else
-				XSubtractRegion (bw->region, &emptyRegion, bs->tmpRegion);
+				compCopyRegion (bw->region, bs->tmpRegion);
 
 			if (!clientThreshold)
 			{
@@ -2170,7 +2168,7 @@ blurDrawWindow (CompWindow           *w,
 				wRegion.extents.y1 = w->attrib.y;
 				wRegion.extents.x2 = w->attrib.x + w->width;
 				wRegion.extents.y2 = w->attrib.y + w->height;
-				XSubtractRegion (bs->tmpRegion, &wRegion, bs->tmpRegion);
+				compSubtractRegion (bs->tmpRegion, &wRegion, bs->tmpRegion);
 			}
 
 			if (clipped)
@@ -2234,7 +2232,7 @@ blurDrawWindowTexture (CompWindow           *w,
 	BLUR_SCREEN (s);
 	BLUR_WINDOW (w);
 
-	if (texture == w->texture)
+	if (texture == w->texture || texture == getWindowAtlasTexture (w))
 		state = BLUR_STATE_CLIENT;
 	else
 		state = BLUR_STATE_DECOR;
@@ -2908,6 +2906,9 @@ blurInitScreen (CompPlugin *p,
 	WRAP (bs, s, windowResizeNotify, blurWindowResizeNotify);
 	WRAP (bs, s, windowMoveNotify, blurWindowMoveNotify);
 
+	/* blur tracks the occlusion of every window */
+	s->occlusionHooks++;
+
 	s->privates[bd->screenPrivateIndex].ptr = bs;
 
 	blurUpdateFilterRadius (s);
@@ -2954,6 +2955,8 @@ blurFiniScreen (CompPlugin *p,
 	UNWRAP (bs, s, windowResizeNotify);
 	UNWRAP (bs, s, windowMoveNotify);
 
+	s->occlusionHooks--;
+
 	free (bs);
 }
 
@@ -52,11 +52,13 @@ typedef struct _ColorFilterScreen {
 	                                  0 < c <= count : single mode */
 
 	/* The plugin can not immediately load the filters because it needs to
-	 * know what texture target it will use : when required, this boolean
-	 * is set to TRUE and filters will be loaded on next filtered window
-	 * texture painting */
+	 * know what texture target it will use : filters are loaded for each
+	 * target on the first window texture painting that uses it. Windows
+	 * in the atlas use a different target than their own texture. When
+	 * the filter list changes, this boolean is set to FALSE and all
+	 * targets are reloaded */
 	Bool            filtersLoaded;
-	int             *filtersFunctions;
+	int             *filtersFunctions[COMP_FETCH_TARGET_NUM];
 	int             filtersCount;
 
 	CompMatch filter_match, exclude_match;
@@ -125,6 +127,26 @@ findFragmentFunction (CompScreen *s,
 	return NULL;
 }
 
+/*
+ * Fragment function of a filter for any texture target it was loaded for
+ */
+static int
+getFilterFunction (CompScreen *s,
+                   int        filter)
+{
+	int target;
+
+	FILTER_SCREEN (s);
+
+	for (target = 0; target < COMP_FETCH_TARGET_NUM; target++)
+	{
+		if (cfs->filtersFunctions[target])
+			return cfs->filtersFunctions[target][filter];
+	}
+
+	return 0;
+}
+
 /* Actions handling functions ----------------------------------------------- */
 
 /*
@@ -188,7 +210,7 @@ colorFilterSwitchFilter (CompScreen *s)
 		                "Cumulative filters mode");
 	else
 	{
-		id = cfs->filtersFunctions[cfs->currentFilter - 1];
+		id = getFilterFunction (s, cfs->currentFilter - 1);
 
 		if (id)
 		{
@@ -222,43 +244,47 @@ colorFilterSwitchFilter (CompScreen *s)
 static void
 unloadFilters (CompScreen *s)
 {
-	int i;
+	int i, target;
 
 	FILTER_SCREEN (s);
 
-	if (cfs->filtersFunctions)
+	for (target = 0; target < COMP_FETCH_TARGET_NUM; target++)
 	{
+		if (!cfs->filtersFunctions[target])
+			continue;
+
 		/* Destroy loaded filters one by one */
 		for (i = 0; i < cfs->filtersCount; i++)
 		{
-			if (cfs->filtersFunctions[i])
-				destroyFragmentFunction (s, cfs->filtersFunctions[i]);
+			if (cfs->filtersFunctions[target][i])
+				destroyFragmentFunction (s,
+				                         cfs->filtersFunctions[target][i]);
 		}
 
-		free (cfs->filtersFunctions);
-		cfs->filtersFunctions = NULL;
-		cfs->filtersCount = 0;
+		free (cfs->filtersFunctions[target]);
+		cfs->filtersFunctions[target] = NULL;
 
 		/* Reset current filter */
 		cfs->currentFilter = 0;
 	}
+
+	cfs->filtersCount = 0;
 }
 
 /*
- * Load filters from a list of files for current screen
+ * Load filters from a list of files for current screen and a texture target
  */
 static int
-loadFilters (CompScreen  *s,
-             CompTexture *texture)
+loadFilters (CompScreen *s,
+             int        target)
 {
-	int i, target, loaded, function, count;
+	int i, loaded, function, count;
+	int *functions;
 	char *name;
 	CompWindow *w;
 
 	FILTER_SCREEN (s);
 
-	cfs->filtersLoaded = TRUE;
-
 	/* Fetch filters filenames */
 	const BananaValue *
 	option_filters = bananaGetOption (bananaIndex,
@@ -267,19 +293,11 @@ loadFilters (CompScreen  *s,
 
 	count = option_filters->list.nItem;
 
-	/* The texture target that will be used for some ops */
-	if (texture->target == GL_TEXTURE_2D)
-		target = COMP_FETCH_TARGET_2D;
-	else
-		target = COMP_FETCH_TARGET_RECT;
-
-	/* Free previously loaded filters and malloc */
-	unloadFilters (s);
-	cfs->filtersFunctions = malloc (sizeof (int) * count);
-
-	if (!cfs->filtersFunctions)
+	functions = malloc (sizeof (int) * count);
+	if (!functions)
 		return 0;
 
+	cfs->filtersFunctions[target] = functions;
 	cfs->filtersCount = count;
 
 	/* Load each filter one by one */
@@ -293,7 +311,7 @@ loadFilters (CompScreen  *s,
 			if (name)
 				free (name);
 
-			cfs->filtersFunctions[i] = 0;
+			functions[i] = 0;
 			continue;
 		}
 
@@ -304,7 +322,7 @@ loadFilters (CompScreen  *s,
 		function = loadFragmentProgram (option_filters->list.item[i].s, name, s, target);
 		free (name);
 
-		cfs->filtersFunctions[i] = function;
+		functions[i] = function;
 
 		if (function)
 			loaded++;
@@ -316,9 +334,6 @@ loadFilters (CompScreen  *s,
 		                "Tried to load %d filter(s), %d succeeded.",
 		                count, loaded);
 
-	if (!loaded)
-		cfs->filtersCount = 0;
-
 	/* Damage currently filtered windows */
 	for (w = s->windows; w; w = w->next)
 	{
@@ -340,31 +355,43 @@ colorFilterDrawWindowTexture (CompWindow           *w,
                               const FragmentAttrib *attrib,
                               unsigned int         mask)
 {
-	int i, function;
+	int i, target, function;
 
 	FILTER_SCREEN (w->screen);
 	FILTER_WINDOW (w);
 
+	/* The texture target that will be used for some ops */
+	if (texture->target == GL_TEXTURE_2D)
+		target = COMP_FETCH_TARGET_2D;
+	else
+		target = COMP_FETCH_TARGET_RECT;
+
 	/* Check if filters have to be loaded and load them if so
 	 * Maybe should this check be done only if a filter is going to be applied
 	 * for this texture? */
 	if (!cfs->filtersLoaded)
-		loadFilters (w->screen, texture);
+	{
+		unloadFilters (w->screen);
+		cfs->filtersLoaded = TRUE;
+	}
+
+	if (!cfs->filtersFunctions[target])
+		loadFilters (w->screen, target);
 
 	/* Filter texture if :
 	 *   o GL_ARB_fragment_program available
 	 *   o Filters are loaded
 	 *   o Texture's window is filtered */
-	/* Note : if required, filter window contents only and not decorations
-	 * (use that w->texture->name != texture->name for decorations) */
+	/* Note : if required, filter window contents only and not decorations */
 	const BananaValue *
 	option_filter_decorations = bananaGetOption (bananaIndex,
 	                                             "filter_decorations",
 	                                             w->screen->screenNum);
 
-	if (cfs->filtersCount && cfw->isFiltered &&
+	if (cfs->filtersFunctions[target] && cfs->filtersCount &&
+	    cfw->isFiltered &&
 	       (option_filter_decorations->b ||
-	        (texture->name == w->texture->name)))
+	        isWindowContentTexture (w, texture)))
 	{
 		FragmentAttrib fa = *attrib;
 		if (cfs->currentFilter == 0) /* Cumulative filters mode */
@@ -372,7 +399,7 @@ colorFilterDrawWindowTexture (CompWindow           *w,
 			/* Enable each filter one by one */
 			for (i = 0; i < cfs->filtersCount; i++)
 			{
-				function = cfs->filtersFunctions[i];
+				function = cfs->filtersFunctions[target][i];
 
 				if (function)
 					addFragmentFunction (&fa, function);
@@ -383,7 +410,7 @@ colorFilterDrawWindowTexture (CompWindow           *w,
 		{
 			/* Enable the currently selected filter if possible (i.e. if it
 			 * was successfully loaded) */
-			function = cfs->filtersFunctions[cfs->currentFilter - 1];
+			function = cfs->filtersFunctions[target][cfs->currentFilter - 1];
 
 			if (function)
 				addFragmentFunction (&fa, function);
@@ -524,7 +551,7 @@ colorFilterChangeNotify (const char        *optionName,
 		FILTER_SCREEN (s);
 
 		/* Just set the filtersLoaded boolean to FALSE, unloadFilters will be
-		 * called in loadFilters */
+		 * called on next window texture painting */
 
 		cfs->filtersLoaded = FALSE;
 	}
@@ -625,8 +652,9 @@ colorFilterInitScreen (CompPlugin *p,
 	cfs->currentFilter = 0;
 
 	cfs->filtersLoaded = FALSE;
-	cfs->filtersFunctions = NULL;
-	cfs->filtersCount = 0;	
+	cfs->filtersCount = 0;
+
+	memset (cfs->filtersFunctions, 0, sizeof (cfs->filtersFunctions));
 
 	WRAP (cfs, s, drawWindowTexture, colorFilterDrawWindowTexture);
 	WRAP (cfs, s, windowAddNotify, colorFilterWindowAddNotify);
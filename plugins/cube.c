@@ -39,11 +39,13 @@ int cubeDisplayPrivateIndex;
 
 static CompKeyBinding unfold_key;
 
+/* texture coordinates of the cap image */
 static void
-cubeLoadImg (CompScreen *s)
+cubeUpdateCapCoords (CompScreen   *s,
+                     unsigned int width,
+                     unsigned int height)
 {
-	unsigned int    width, height;
-	int             pw, ph;
+	int pw, ph;
 
 	CUBE_SCREEN (s);
 
@@ -67,28 +69,6 @@ cubeLoadImg (CompScreen *s)
 	//		return;
 	//}
 
-	const BananaValue *
-	option_cubecap_image = bananaGetOption (bananaIndex,
-	                                        "cubecap_image",
-	                                        s->screenNum);
-
-	if (strlen(option_cubecap_image->s) > 0)
-	{
-		if (!readImageToTexture (s, &cs->texture,
-		                        option_cubecap_image->s,
-		                        &width, &height))
-		{
-			compLogMessage ("cube", CompLogLevelWarn,
-			                "Failed to load cubecap: %s",
-			                option_cubecap_image->s);
-
-			finiTexture (s, &cs->texture);
-			initTexture (s, &cs->texture);
-
-			return;
-		}
-	}
-
 	cs->tc[0] = COMP_TEX_COORD_X (&cs->texture.matrix, width / 2.0f);
 	cs->tc[1] = COMP_TEX_COORD_Y (&cs->texture.matrix, height / 2.0f);
 
@@ -138,6 +118,59 @@ cubeLoadImg (CompScreen *s)
 	}
 }
 
+static void
+cubeCapLoaded (CompScreen   *s,
+               CompTexture  *texture,
+               Bool         status,
+               unsigned int width,
+               unsigned int height,
+               void         *closure)
+{
+	CUBE_SCREEN (s);
+
+	cs->capLoad = 0;
+
+	if (!status)
+	{
+		const BananaValue *
+		option_cubecap_image = bananaGetOption (bananaIndex,
+		                                        "cubecap_image",
+		                                        s->screenNum);
+
+		compLogMessage ("cube", CompLogLevelWarn,
+		                "Failed to load cubecap: %s",
+		                option_cubecap_image->s);
+
+		finiTexture (s, &cs->texture);
+		initTexture (s, &cs->texture);
+
+		return;
+	}
+
+	cubeUpdateCapCoords (s, width, height);
+	damageScreen (s);
+}
+
+/* the caps are painted in the cube color until the image is loaded */
+static void
+cubeLoadImg (CompScreen *s)
+{
+	CUBE_SCREEN (s);
+
+	cancelImageLoad (cs->capLoad);
+	cs->capLoad = 0;
+
+	const BananaValue *
+	option_cubecap_image = bananaGetOption (bananaIndex,
+	                                        "cubecap_image",
+	                                        s->screenNum);
+
+	if (strlen (option_cubecap_image->s) > 0)
+		cs->capLoad = readImageToTextureAsync (s, &cs->texture,
+		                                       option_cubecap_image->s,
+		                                       cubeCapLoaded, NULL);
+}
+
 static Bool
 cubeUpdateGeometry (CompScreen *s,
                     int        sides,
@@ -298,113 +331,90 @@ cubeUpdateOutputs (CompScreen *s)
 	}
 }
 
+/* the skydome without an image, and until the image is loaded */
 static void
-cubeUpdateSkyDomeTexture (CompScreen *screen)
+cubeUpdateSkyDomeGradient (CompScreen *screen)
 {
 	CUBE_SCREEN (screen);
 
-	finiTexture (screen, &cs->sky);
-	initTexture (screen, &cs->sky);
-
 	const BananaValue *
-	option_skydome = bananaGetOption (bananaIndex,
-	                                  "skydome",
-	                                  screen->screenNum);
-
-	if (!option_skydome->b)
-		return;
+	option_skydome_gradient_start_color = bananaGetOption (
+	       bananaIndex, "skydome_gradient_start_color", screen->screenNum);
 
 	const BananaValue *
-	option_skydome_image = bananaGetOption (bananaIndex,
-	                                        "skydome_image",
-	                                        screen->screenNum);
-
-	if (strlen (option_skydome_image->s) == 0 ||
-		!readImageToTexture (screen,
-		                     &cs->sky,
-		                     option_skydome_image->s,
-		                     &cs->skyW,
-		                     &cs->skyH))
-	{
-		const BananaValue *
-		option_skydome_gradient_start_color = bananaGetOption (
-		       bananaIndex, "skydome_gradient_start_color", screen->screenNum);
-
-		const BananaValue *
-		option_skydome_gradient_end_color = bananaGetOption (
-		       bananaIndex, "skydome_gradient_end_color", screen->screenNum);
-
-		unsigned short int gradStartColor[4];
-		unsigned short int gradEndColor[4];
-
-		stringToColor (option_skydome_gradient_start_color->s, gradStartColor);
-		stringToColor (option_skydome_gradient_end_color->s, gradEndColor);
-
-		GLfloat aaafTextureData[128][128][3];
-		GLfloat fRStart = (GLfloat) gradStartColor[0] / 0xffff;
-		GLfloat fGStart = (GLfloat) gradStartColor[1] / 0xffff;
-		GLfloat fBStart = (GLfloat) gradStartColor[2] / 0xffff;
-		GLfloat fREnd = (GLfloat) gradEndColor[0] / 0xffff;
-		GLfloat fGEnd = (GLfloat) gradEndColor[1] / 0xffff;
-		GLfloat fBEnd = (GLfloat) gradEndColor[2] / 0xffff;
-		GLfloat fRStep = (fREnd - fRStart) / 128.0f;
-		GLfloat fGStep = (fGEnd - fGStart) / 128.0f;
-		GLfloat fBStep = (fBStart - fBEnd) / 128.0f;
-		GLfloat fR = fRStart;
-		GLfloat fG = fGStart;
-		GLfloat fB = fBStart;
-
-		int	iX, iY;
-
-		for (iX = 127; iX >= 0; iX--)
+	option_skydome_gradient_end_color = bananaGetOption (
+	       bananaIndex, "skydome_gradient_end_color", screen->screenNum);
+
+	unsigned short int gradStartColor[4];
+	unsigned short int gradEndColor[4];
+
+	stringToColor (option_skydome_gradient_start_color->s, gradStartColor);
+	stringToColor (option_skydome_gradient_end_color->s, gradEndColor);
+
+	GLfloat aaafTextureData[128][128][3];
+	GLfloat fRStart = (GLfloat) gradStartColor[0] / 0xffff;
+	GLfloat fGStart = (GLfloat) gradStartColor[1] / 0xffff;
+	GLfloat fBStart = (GLfloat) gradStartColor[2] / 0xffff;
+	GLfloat fREnd = (GLfloat) gradEndColor[0] / 0xffff;
+	GLfloat fGEnd = (GLfloat) gradEndColor[1] / 0xffff;
+	GLfloat fBEnd = (GLfloat) gradEndColor[2] / 0xffff;
+	GLfloat fRStep = (fREnd - fRStart) / 128.0f;
+	GLfloat fGStep = (fGEnd - fGStart) / 128.0f;
+	GLfloat fBStep = (fBStart - fBEnd) / 128.0f;
+	GLfloat fR = fRStart;
+	GLfloat fG = fGStart;
+	GLfloat fB = fBStart;
+
+	int	iX, iY;
+
+	for (iX = 127; iX >= 0; iX--)
+	{
+		fR += fRStep;
+		fG += fGStep;
+		fB -= fBStep;
+
+		for (iY = 0; iY < 128; iY++)
 		{
-			fR += fRStep;
-			fG += fGStep;
-			fB -= fBStep;
-
-			for (iY = 0; iY < 128; iY++)
-			{
-				aaafTextureData[iX][iY][0] = fR;
-				aaafTextureData[iX][iY][1] = fG;
-				aaafTextureData[iX][iY][2] = fB;
-			}
+			aaafTextureData[iX][iY][0] = fR;
+			aaafTextureData[iX][iY][1] = fG;
+			aaafTextureData[iX][iY][2] = fB;
 		}
+	}
 
-		cs->sky.target = GL_TEXTURE_2D;
-		cs->sky.filter = GL_LINEAR;
-		cs->sky.wrap   = GL_CLAMP_TO_EDGE;
+	cs->sky.target = GL_TEXTURE_2D;
+	cs->sky.filter = GL_LINEAR;
+	cs->sky.wrap   = GL_CLAMP_TO_EDGE;
 
-		cs->sky.matrix.xx = 1.0 / 128.0;
-		cs->sky.matrix.yy = -1.0 / 128.0;
-		cs->sky.matrix.xy = 0;
-		cs->sky.matrix.yx = 0;
-		cs->sky.matrix.x0 = 0;
-		cs->sky.matrix.y0 = 1.0;
+	cs->sky.matrix.xx = 1.0 / 128.0;
+	cs->sky.matrix.yy = -1.0 / 128.0;
+	cs->sky.matrix.xy = 0;
+	cs->sky.matrix.yx = 0;
+	cs->sky.matrix.x0 = 0;
+	cs->sky.matrix.y0 = 1.0;
 
-		cs->skyW = 128;
-		cs->skyH = 128;
+	cs->skyW = 128;
+	cs->skyH = 128;
 
-		glGenTextures (1, &cs->sky.name);
-		glBindTexture (cs->sky.target, cs->sky.name);
+	glGenTextures (1, &cs->sky.name);
+	glBindTexture (cs->sky.target, cs->sky.name);
 
-		glTexParameteri (cs->sky.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri (cs->sky.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri (cs->sky.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri (cs->sky.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-		glTexParameteri (cs->sky.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri (cs->sky.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri (cs->sky.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri (cs->sky.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-		glTexImage2D (cs->sky.target,
-		              0,
-		              GL_RGB,
-		              128,
-		              128,
-		              0,
-		              GL_RGB,
-		              GL_FLOAT,
-		              aaafTextureData);
+	glTexImage2D (cs->sky.target,
+	              0,
+	              GL_RGB,
+	              128,
+	              128,
+	              0,
+	              GL_RGB,
+	              GL_FLOAT,
+	              aaafTextureData);
 
-		glBindTexture (cs->sky.target, 0);
-	}
+	glBindTexture (cs->sky.target, 0);
 }
 
 static Bool
@@ -597,6 +607,61 @@ cubeUpdateSkyDomeList (CompScreen *s,
 	free (cost2);
 }
 
+static void
+cubeSkyDomeLoaded (CompScreen   *screen,
+                   CompTexture  *texture,
+                   Bool         status,
+                   unsigned int width,
+                   unsigned int height,
+                   void         *closure)
+{
+	CUBE_SCREEN (screen);
+
+	cs->skyLoad = 0;
+
+	/* keep the gradient */
+	if (!status)
+		return;
+
+	cs->skyW = width;
+	cs->skyH = height;
+
+	cubeUpdateSkyDomeList (screen, 1.0f);
+	damageScreen (screen);
+}
+
+static void
+cubeUpdateSkyDomeTexture (CompScreen *screen)
+{
+	CUBE_SCREEN (screen);
+
+	cancelImageLoad (cs->skyLoad);
+	cs->skyLoad = 0;
+
+	finiTexture (screen, &cs->sky);
+	initTexture (screen, &cs->sky);
+
+	const BananaValue *
+	option_skydome = bananaGetOption (bananaIndex,
+	                                  "skydome",
+	                                  screen->screenNum);
+
+	if (!option_skydome->b)
+		return;
+
+	const BananaValue *
+	option_skydome_image = bananaGetOption (bananaIndex,
+	                                        "skydome_image",
+	                                        screen->screenNum);
+
+	cubeUpdateSkyDomeGradient (screen);
+
+	if (strlen (option_skydome_image->s) > 0)
+		cs->skyLoad = readImageToTextureAsync (screen, &cs->sky,
+		                                       option_skydome_image->s,
+		                                       cubeSkyDomeLoaded, NULL);
+}
+
 static void
 cubeChangeNotify (const char        *optionName,
                   BananaType        optionType,
@@ -828,6 +893,10 @@ cubePreparePaintScreen (CompScreen *s,
 
 	cs->paintAllViewports = (cs->desktopOpacity != OPAQUE);
 
+	/* desktop windows get the opacity of the cube */
+	setScreenOcclusionHook (s, &cs->occlusionHook,
+	                        cs->desktopOpacity != OPAQUE);
+
 	UNWRAP (cs, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (cs, s, preparePaintScreen, cubePreparePaintScreen);
@@ -1923,6 +1992,9 @@ cubeInitScreen (CompPlugin *p,
 
 	cs->skyListId = 0;
 
+	cs->capLoad = 0;
+	cs->skyLoad = 0;
+
 	cs->getRotation         = cubeGetRotation;
 	cs->clearTargetOutput   = cubeClearTargetOutput;
 	cs->paintTop            = cubePaintTop;
@@ -1953,6 +2025,7 @@ cubeInitScreen (CompPlugin *p,
 	cs->rotationState = RotationNone;
 
 	cs->desktopOpacity = OPAQUE;
+	cs->occlusionHook  = FALSE;
 
 	const BananaValue *
 	option_inactive_opacity = bananaGetOption (bananaIndex,
@@ -2017,6 +2090,9 @@ cubeFiniScreen (CompPlugin *p,
 	if (cs->skyListId)
 		glDeleteLists (cs->skyListId, 1);
 
+	cancelImageLoad (cs->capLoad);
+	cancelImageLoad (cs->skyLoad);
+
 	UNWRAP (cs, s, preparePaintScreen);
 	UNWRAP (cs, s, donePaintScreen);
 	UNWRAP (cs, s, paintScreen);
@@ -2028,6 +2104,8 @@ cubeFiniScreen (CompPlugin *p,
 	UNWRAP (cs, s, outputChangeNotify);
 	UNWRAP (cs, s, initWindowWalker);
 
+	setScreenOcclusionHook (s, &cs->occlusionHook, FALSE);
+
 	finiTexture (s, &cs->texture);
 	finiTexture (s, &cs->sky);
 
@@ -46,6 +46,26 @@
 
 static int bananaIndex;
 
+static BananaOptionHandle doubleClickTimeOption;
+static BananaOptionHandle deformOption;
+static BananaOptionHandle multioutputModeOption;
+static BananaOptionHandle zoomTimeOption;
+static BananaOptionHandle vpDistanceOption;
+static BananaOptionHandle reflectionOption;
+static BananaOptionHandle distanceOption;
+static BananaOptionHandle aspectRatioOption;
+static BananaOptionHandle expoAnimationOption;
+static BananaOptionHandle mipmapsOption;
+static BananaOptionHandle scaleFactorOption;
+static BananaOptionHandle curveOption;
+static BananaOptionHandle vpBrightnessOption;
+static BananaOptionHandle vpSaturationOption;
+static BananaOptionHandle groundSizeOption;
+static BananaOptionHandle groundColor1Option;
+static BananaOptionHandle groundColor2Option;
+static BananaOptionHandle hideDocksOption;
+static BananaOptionHandle expoImmediateMoveOption;
+
 static int displayPrivateIndex;
 
 typedef enum {
@@ -94,6 +114,8 @@ typedef struct _ExpoScreen {
 	/* In expo mode? */
 	Bool expoMode;
 
+	Bool occlusionHook;
+
 	/* For expo grab */
 	int grabIndex;
 
@@ -412,9 +434,8 @@ expoHandleEvent (XEvent *event)
 				else if (event->xbutton.button == Button1)
 				{
 					const BananaValue *
-					option_double_click_time = bananaGetOption (bananaIndex,
-					                                            "double_click_time",
-					                                            -1);
+					option_double_click_time =
+					    bananaGetOptionByHandle (doubleClickTimeOption, -1);
 
 					es->anyClick = TRUE;
 
@@ -509,9 +530,8 @@ expoHandleEvent (XEvent *event)
 					expoDnDFini (event->xbutton.root);
 
 					const BananaValue *
-					option_double_click_time = bananaGetOption (bananaIndex,
-					                                            "double_click_time",
-					                                            -1);
+					option_double_click_time =
+					    bananaGetOptionByHandle (doubleClickTimeOption, -1);
 
 					if (event->xbutton.time - es->clickTime >
 					    option_double_click_time->i)
@@ -575,9 +595,7 @@ invertTransformedVertex (CompScreen              *s,
 	alpha = -p1[2] / v[2];
 
 	const BananaValue *
-	option_deform = bananaGetOption (bananaIndex,
-	                                 "deform",
-	                                 -1);
+	option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 	if (option_deform->i == 2 && s->desktopWindowCount) //2 = curve
 	{
@@ -644,9 +662,8 @@ expoPaintScreen (CompScreen   *s,
 	EXPO_SCREEN (s);
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           -1);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   -1);
 
 	if (es->expoCam > 0.0 && numOutputs > 1 &&
 	    option_multioutput_mode->i == 0) //one big wall
@@ -689,9 +706,7 @@ expoPreparePaintScreen (CompScreen *s,
 	EXPO_SCREEN (s);
 
 	const BananaValue *
-	option_zoom_time = bananaGetOption (bananaIndex,
-	                                    "zoom_time",
-	                                    -1);
+	option_zoom_time = bananaGetOptionByHandle (zoomTimeOption, -1);
 
 	float val = ((float) ms / 1000.0) / option_zoom_time->f;
 
@@ -744,6 +759,8 @@ expoPreparePaintScreen (CompScreen *s,
 		es->vpActivitySize = 0;
 	}
 
+	setScreenOcclusionHook (s, &es->occlusionHook, es->expoCam > 0.0);
+
 	UNWRAP (es, s, preparePaintScreen);
 	(*s->preparePaintScreen)(s, ms);
 	WRAP (es, s, preparePaintScreen, expoPreparePaintScreen);
@@ -773,9 +790,7 @@ expoPaintWall (CompScreen              *s,
 
 	/* amount of gap between viewports */
 	const BananaValue *
-	option_vp_distance = bananaGetOption (bananaIndex,
-	                                      "vp_distance",
-	                                      -1);
+	option_vp_distance = bananaGetOptionByHandle (vpDistanceOption, -1);
 
 	const float gapY = option_vp_distance->f * 0.1f * es->expoCam;
 	const float gapX = option_vp_distance->f * 0.1f * s->height /
@@ -789,9 +804,7 @@ expoPaintWall (CompScreen              *s,
 	Point3d expoCamPos = { 0, 0, 0 };
 
 	const BananaValue *
-	option_deform = bananaGetOption (bananaIndex,
-	                                 "deform",
-	                                 -1);
+	option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 	if (option_deform->i == 2) //curve
 	{
@@ -810,14 +823,10 @@ expoPaintWall (CompScreen              *s,
 	vpCamPos.z = 0;
 
 	const BananaValue *
-	option_reflection = bananaGetOption (bananaIndex,
-	                                     "reflection",
-	                                     -1);
+	option_reflection = bananaGetOptionByHandle (reflectionOption, -1);
 
 	const BananaValue *
-	option_distance = bananaGetOption (bananaIndex,
-	                                   "distance",
-	                                   -1);
+	option_distance = bananaGetOptionByHandle (distanceOption, -1);
 
 	if (option_deform->i == 1 || // 1=tilt
 	    option_reflection->b)
@@ -849,9 +858,7 @@ expoPaintWall (CompScreen              *s,
 	camZ = vpCamPos.z * (1 - progress) + expoCamPos.z * progress;
 
 	const BananaValue *
-	option_aspect_ratio = bananaGetOption (bananaIndex,
-	                                       "aspect_ratio",
-	                                       -1);
+	option_aspect_ratio = bananaGetOptionByHandle (aspectRatioOption, -1);
 
 	if (s->hsize > s->vsize)
 	{
@@ -874,9 +881,8 @@ expoPaintWall (CompScreen              *s,
 	if (option_deform->i == 1) // 1 = tilt
 	{
 		const BananaValue *
-		option_expo_animation = bananaGetOption (bananaIndex,
-		                                         "expo_animation",
-		                                         -1);
+		option_expo_animation = bananaGetOptionByHandle (expoAnimationOption,
+		                                                 -1);
 
 		if (option_expo_animation == 0) //0 = zoom
 			rotation = 10.0 * sigmoidProgress (es->expoCam);
@@ -885,9 +891,7 @@ expoPaintWall (CompScreen              *s,
 	}
 
 	const BananaValue *
-	option_mipmaps = bananaGetOption (bananaIndex,
-	                                  "mipmaps",
-	                                  -1);
+	option_mipmaps = bananaGetOptionByHandle (mipmapsOption, -1);
 
 	if (option_mipmaps->b)
 		display.textureFilter = GL_LINEAR_MIPMAP_LINEAR;
@@ -907,9 +911,7 @@ expoPaintWall (CompScreen              *s,
 	if (reflection)
 	{
 		const BananaValue *
-		option_scale_factor = bananaGetOption (bananaIndex,
-		                                       "scale_factor",
-		                                       -1);
+		option_scale_factor = bananaGetOptionByHandle (scaleFactorOption, -1);
 
 		float scaleFactor = option_scale_factor->f;
 
@@ -944,9 +946,7 @@ expoPaintWall (CompScreen              *s,
 	matrixTranslate (&sTransform, 0.5f, -0.5f, DEFAULT_Z_CAMERA);
 
 	const BananaValue *
-	option_curve = bananaGetOption (bananaIndex,
-	                                "curve",
-	                                -1);
+	option_curve = bananaGetOptionByHandle (curveOption, -1);
 
 	if (s->hsize > 2)
 	{
@@ -970,9 +970,7 @@ expoPaintWall (CompScreen              *s,
 	for (j = 0; j < s->vsize; j++)
 	{
 		const BananaValue *
-		option_animation = bananaGetOption (bananaIndex,
-		                                    "expo_animation",
-		                                    -1);
+		option_animation = bananaGetOptionByHandle (expoAnimationOption, -1);
 
 		CompTransform sTransform2 = sTransform;
 		CompTransform sTransform3;
@@ -996,14 +994,12 @@ expoPaintWall (CompScreen              *s,
 			if (vp < es->vpActivitySize)
 			{
 				const BananaValue *
-				option_vp_brightness = bananaGetOption (bananaIndex,
-				                                        "vp_brightness",
-				                                        -1);
+				option_vp_brightness =
+				    bananaGetOptionByHandle (vpBrightnessOption, -1);
 
 				const BananaValue *
-				option_vp_saturation = bananaGetOption (bananaIndex,
-				                                        "vp_saturation",
-				                                        -1);
+				option_vp_saturation =
+				    bananaGetOptionByHandle (vpSaturationOption, -1);
 
 				vpp = (es->expoCam * es->vpActivity[vp]) + (1 - es->expoCam);
 				vpp = sigmoidProgress (vpp);
@@ -1023,9 +1019,7 @@ expoPaintWall (CompScreen              *s,
 			es->paintingVY = j;
 
 			const BananaValue *
-			option_deform = bananaGetOption (bananaIndex,
-			                                 "deform",
-			                                 -1);
+			option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 			if (option_deform->i == 2) //curve
 			{
@@ -1085,9 +1079,7 @@ expoPaintWall (CompScreen              *s,
 		glPushMatrix ();
 
 		const BananaValue *
-		option_deform = bananaGetOption (bananaIndex,
-		                                 "deform",
-		                                 -1);
+		option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 		if (option_deform->i != 2) //not curve
 		{
@@ -1131,19 +1123,13 @@ expoPaintWall (CompScreen              *s,
 		glTranslatef (0.0, 0.0, -DEFAULT_Z_CAMERA);
 
 		const BananaValue *
-		option_ground_size = bananaGetOption (bananaIndex,
-		                                      "ground_size",
-		                                      -1);
+		option_ground_size = bananaGetOptionByHandle (groundSizeOption, -1);
 
 		const BananaValue *
-		option_ground_color1 = bananaGetOption (bananaIndex,
-		                                        "ground_color1",
-		                                        -1);
+		option_ground_color1 = bananaGetOptionByHandle (groundColor1Option, -1);
 
 		const BananaValue *
-		option_ground_color2 = bananaGetOption (bananaIndex,
-		                                        "ground_color2",
-		                                        -1);
+		option_ground_color2 = bananaGetOptionByHandle (groundColor2Option, -1);
 
 		unsigned short color1[] = { 0, 0, 0, 0 };
 		unsigned short color2[] = { 0, 0, 0, 0 };
@@ -1196,9 +1182,7 @@ expoPaintTransformedOutput (CompScreen              *s,
 		mask |= PAINT_SCREEN_CLEAR_MASK;
 
 	const BananaValue *
-	option_expo_animation = bananaGetOption (bananaIndex,
-	                                         "expo_animation",
-	                                         -1);
+	option_expo_animation = bananaGetOptionByHandle (expoAnimationOption, -1);
 
 	if (es->expoCam <= 0 || (es->expoCam < 1.0 && es->expoCam > 0.0 &&
 	                         option_expo_animation != 0)) //0 = zoom
@@ -1214,9 +1198,7 @@ expoPaintTransformedOutput (CompScreen              *s,
 	if (es->expoCam > 0.0)
 	{
 		const BananaValue *
-		option_reflection = bananaGetOption (bananaIndex,
-		                                     "reflection",
-		                                     -1);
+		option_reflection = bananaGetOptionByHandle (reflectionOption, -1);
 
 		if (option_reflection->b)
 			expoPaintWall (s, sAttrib, transform, region, output, mask, TRUE);
@@ -1245,9 +1227,8 @@ expoDrawWindow (CompWindow           *w,
 		FragmentAttrib fA = *fragment;
 
 		const BananaValue *
-		option_expo_animation = bananaGetOption (bananaIndex,
-		                                         "expo_animation",
-		                                         -1);
+		option_expo_animation = bananaGetOptionByHandle (expoAnimationOption,
+		                                                 -1);
 
 		if (es->expoActive)
 		{
@@ -1255,9 +1236,7 @@ expoDrawWindow (CompWindow           *w,
 				fA.opacity = fragment->opacity * es->expoCam;
 
 			const BananaValue *
-			option_hide_docks = bananaGetOption (bananaIndex,
-			                                     "hide_docks",
-			                                     -1);
+			option_hide_docks = bananaGetOptionByHandle (hideDocksOption, -1);
 
 			if (w->wmType & CompWindowTypeDockMask &&
 			    option_hide_docks->b)
@@ -1313,9 +1292,7 @@ expoAddWindowGeometry (CompWindow *w,
 	EXPO_SCREEN (s);
 
 	const BananaValue *
-	option_deform = bananaGetOption (bananaIndex,
-	                                 "deform",
-	                                 -1);
+	option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 	if (es->expoCam > 0.0 && option_deform->i == 2 && //2 = curve
 	    s->desktopWindowCount)
@@ -1340,6 +1317,9 @@ expoAddWindowGeometry (CompWindow *w,
 
 		UNWRAP (es, s, addWindowGeometry);
 
+		/* one call per grid strip would only thrash the geometry cache */
+		w->noGeometryCache++;
+
 		if (region->numRects > 1)
 		{
 			while (x1 < region->extents.x2)
@@ -1347,7 +1327,7 @@ expoAddWindowGeometry (CompWindow *w,
 				reg.extents.x1 = x1;
 				reg.extents.x2 = x2;
 
-				XIntersectRegion (region, &reg, es->tmpRegion);
+				compIntersectRegion (region, &reg, es->tmpRegion);
 
 				if (!XEmptyRegion (es->tmpRegion))
 				{
@@ -1374,6 +1354,8 @@ expoAddWindowGeometry (CompWindow *w,
 			}
 		}
 
+		w->noGeometryCache--;
+
 		WRAP (es, s, addWindowGeometry, expoAddWindowGeometry);
 
 		v  = w->vertices + (w->vertexStride - 3);
@@ -1410,6 +1392,9 @@ expoAddWindowGeometry (CompWindow *w,
 
 			v += w->vertexStride;
 		}
+
+		/* the curve changed the vertices behind addWindowGeometry */
+		w->geometryGeneration = 0;
 	}
 	else
 	{
@@ -1430,9 +1415,7 @@ expoDrawWindowTexture (CompWindow           *w,
 	EXPO_SCREEN (s);
 
 	const BananaValue *
-	option_deform = bananaGetOption (bananaIndex,
-	                                 "deform",
-	                                 -1);
+	option_deform = bananaGetOptionByHandle (deformOption, -1);
 
 	if (es->expoCam > 0.0 && option_deform->i == 2 && //2 = curve
 	    s->desktopWindowCount && s->lighting)
@@ -1518,14 +1501,11 @@ expoPaintWindow (CompWindow              *w,
 		float opacity = 1.0;
 
 		const BananaValue *
-		option_expo_animation = bananaGetOption (bananaIndex,
-		                                         "expo_animation",
-		                                         -1);
+		option_expo_animation = bananaGetOptionByHandle (expoAnimationOption,
+		                                                 -1);
 
 		const BananaValue *
-		option_hide_docks = bananaGetOption (bananaIndex,
-		                                     "hide_docks",
-		                                     -1);
+		option_hide_docks = bananaGetOptionByHandle (hideDocksOption, -1);
 
 		if (es->expoCam > 0.0 && es->expoCam < 1.0 &&
 		    option_expo_animation->i != 0) // 0 = zoom
@@ -1613,9 +1593,8 @@ expoDonePaintScreen (CompScreen *s)
 		int dy = es->newCursorY - es->prevCursorY;
 
 		const BananaValue *
-		option_expo_immediate_move = bananaGetOption (bananaIndex,
-		                                              "expo_immediate_move",
-		                                              -1);
+		option_expo_immediate_move =
+		    bananaGetOptionByHandle (expoImmediateMoveOption, -1);
 
 		if (es->dndWindow)
 			moveWindow (es->dndWindow, dx, dy, TRUE,
@@ -1814,6 +1793,8 @@ expoInitScreen (CompPlugin *p,
 	es->expoCam    = 0.0f;
 	es->expoMode   = 0;
 
+	es->occlusionHook = FALSE;
+
 	es->dndState  = DnDNone;
 	es->dndWindow = NULL;
 
@@ -1877,6 +1858,8 @@ expoFiniScreen (CompPlugin *p,
 	UNWRAP (es, s, addWindowGeometry);
 	UNWRAP (es, s, drawWindowTexture);
 
+	setScreenOcclusionHook (s, &es->occlusionHook, FALSE);
+
 	free (es);
 }
 
@@ -1921,6 +1904,29 @@ expoInit (CompPlugin *p)
 
 	bananaAddChangeNotifyCallBack (bananaIndex, expoChangeNotify);
 
+	doubleClickTimeOption =
+	    bananaGetOptionHandle (bananaIndex, "double_click_time");
+	deformOption = bananaGetOptionHandle (bananaIndex, "deform");
+	multioutputModeOption =
+	    bananaGetOptionHandle (bananaIndex, "multioutput_mode");
+	zoomTimeOption = bananaGetOptionHandle (bananaIndex, "zoom_time");
+	vpDistanceOption = bananaGetOptionHandle (bananaIndex, "vp_distance");
+	reflectionOption = bananaGetOptionHandle (bananaIndex, "reflection");
+	distanceOption = bananaGetOptionHandle (bananaIndex, "distance");
+	aspectRatioOption = bananaGetOptionHandle (bananaIndex, "aspect_ratio");
+	expoAnimationOption = bananaGetOptionHandle (bananaIndex, "expo_animation");
+	mipmapsOption = bananaGetOptionHandle (bananaIndex, "mipmaps");
+	scaleFactorOption = bananaGetOptionHandle (bananaIndex, "scale_factor");
+	curveOption = bananaGetOptionHandle (bananaIndex, "curve");
+	vpBrightnessOption = bananaGetOptionHandle (bananaIndex, "vp_brightness");
+	vpSaturationOption = bananaGetOptionHandle (bananaIndex, "vp_saturation");
+	groundSizeOption = bananaGetOptionHandle (bananaIndex, "ground_size");
+	groundColor1Option = bananaGetOptionHandle (bananaIndex, "ground_color1");
+	groundColor2Option = bananaGetOptionHandle (bananaIndex, "ground_color2");
+	hideDocksOption = bananaGetOptionHandle (bananaIndex, "hide_docks");
+	expoImmediateMoveOption =
+	    bananaGetOptionHandle (bananaIndex, "expo_immediate_move");
+
 	return TRUE;
 }
 
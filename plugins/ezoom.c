@@ -81,6 +81,30 @@
 
 static int bananaIndex;
 
+static BananaOptionHandle speedOption;
+static BananaOptionHandle timestepOption;
+static BananaOptionHandle syncMouseOption;
+static BananaOptionHandle filterLinearOption;
+static BananaOptionHandle mousePanOption;
+static BananaOptionHandle panFactorOption;
+static BananaOptionHandle minimumZoomOption;
+static BananaOptionHandle restrainMarginOption;
+static BananaOptionHandle restrainMouseOption;
+static BananaOptionHandle scaleMouseDynamicOption;
+static BananaOptionHandle scaleMouseStaticOption;
+static BananaOptionHandle scaleMouseOption;
+static BananaOptionHandle hideOriginalMouseOption;
+static BananaOptionHandle followFocusOption;
+static BananaOptionHandle followFocusDelayOption;
+static BananaOptionHandle alwaysFocusFitWindowOption;
+static BananaOptionHandle focusFitWindowOption;
+static BananaOptionHandle autoscaleMinOption;
+static BananaOptionHandle zoomFactorOption;
+static BananaOptionHandle specTargetFocusOption;
+static BananaOptionHandle zoomSpec1Option;
+static BananaOptionHandle zoomSpec2Option;
+static BananaOptionHandle zoomSpec3Option;
+
 static int displayPrivateIndex;
 
 typedef enum {
@@ -481,14 +505,11 @@ zoomPreparePaintScreen (CompScreen *s,
 		float amount, chunk;
 
 		const BananaValue *
-		option_speed = bananaGetOption (bananaIndex,
-		                                "speed",
-		                                s->screenNum);
+		option_speed = bananaGetOptionByHandle (speedOption, s->screenNum);
 
 		const BananaValue *
-		option_timestep = bananaGetOption (bananaIndex,
-		                                   "timestep",
-		                                   s->screenNum);
+		option_timestep = bananaGetOptionByHandle (timestepOption,
+		                                           s->screenNum);
 
 		amount = msSinceLastPaint * 0.05f * option_speed->f;
 		steps  = amount / (0.5f * option_timestep->f);
@@ -521,9 +542,8 @@ zoomPreparePaintScreen (CompScreen *s,
 		}
 
 		const BananaValue *
-		option_sync_mouse = bananaGetOption (bananaIndex,
-		                                     "sync_mouse",
-		                                     s->screenNum);
+		option_sync_mouse = bananaGetOptionByHandle (syncMouseOption,
+		                                             s->screenNum);
 
 		if (option_sync_mouse->b)
 			syncCenterToMouse (s);
@@ -636,9 +656,8 @@ zoomPaintOutput (CompScreen              *s,
 		saveFilter = s->filter[SCREEN_TRANS_FILTER];
 
 		const BananaValue *
-		option_filter_linear = bananaGetOption (bananaIndex,
-		                                        "filter_linear",
-		                                        s->screenNum);
+		option_filter_linear = bananaGetOptionByHandle (filterLinearOption,
+		                                                s->screenNum);
 
 		if (option_filter_linear->b)
 			s->filter[SCREEN_TRANS_FILTER] = COMP_TEXTURE_FILTER_GOOD;
@@ -737,9 +756,7 @@ setCenter (CompScreen *s,
 	}
 
 	const BananaValue *
-	option_mouse_pan = bananaGetOption (bananaIndex,
-	                                    "mouse_pan",
-	                                    s->screenNum);
+	option_mouse_pan = bananaGetOptionByHandle (mousePanOption, s->screenNum);
 
 	if (option_mouse_pan->b)
 		restrainCursor (s, out);
@@ -785,9 +802,7 @@ setZoomArea (CompScreen *s,
 	}
 
 	const BananaValue *
-	option_mouse_pan = bananaGetOption (bananaIndex,
-	                                    "mouse_pan",
-	                                    s->screenNum);
+	option_mouse_pan = bananaGetOptionByHandle (mousePanOption, s->screenNum);
 
 	if (option_mouse_pan->b)
 		restrainCursor (s, out);
@@ -816,9 +831,7 @@ panZoom (CompScreen *s,
 	ZOOM_SCREEN (s);
 
 	const BananaValue *
-	option_pan_factor = bananaGetOption (bananaIndex,
-	                                     "pan_factor",
-	                                     s->screenNum);
+	option_pan_factor = bananaGetOptionByHandle (panFactorOption, s->screenNum);
 
 	for (out = 0; out < zs->nZooms; out++)
 	{
@@ -881,9 +894,8 @@ setScale (CompScreen *s,
 	}
 
 	const BananaValue *
-	option_minimum_zoom = bananaGetOption (bananaIndex,
-	                                       "minimum_zoom",
-	                                       s->screenNum);
+	option_minimum_zoom = bananaGetOptionByHandle (minimumZoomOption,
+	                                               s->screenNum);
 
 	if (value < option_minimum_zoom->f)
 		value = option_minimum_zoom->f;
@@ -1191,9 +1203,8 @@ restrainCursor (CompScreen *s,
 	z = zs->zooms[out].newZoom;
 
 	const BananaValue *
-	option_restrain_margin = bananaGetOption (bananaIndex,
-	                                          "restrain_margin",
-	                                          s->screenNum);
+	option_restrain_margin = bananaGetOptionByHandle (restrainMarginOption,
+	                                                  s->screenNum);
 
 	margin = option_restrain_margin->i;
 	north = distanceToEdge (s, out, NORTH);
@@ -1252,22 +1263,19 @@ cursorMoved (CompScreen *s)
 	if (isActive (s, out))
 	{
 		const BananaValue *
-		option_restrain_mouse = bananaGetOption (bananaIndex,
-		                                         "restrain_mouse",
-		                                         s->screenNum);
+		option_restrain_mouse = bananaGetOptionByHandle (restrainMouseOption,
+		                                                 s->screenNum);
 
 		if (option_restrain_mouse->b)
 			restrainCursor (s, out);
 
 		const BananaValue *
-		option_mouse_pan = bananaGetOption (bananaIndex,
-		                                    "mouse_pan",
-		                                    s->screenNum);
+		option_mouse_pan = bananaGetOptionByHandle (mousePanOption,
+		                                            s->screenNum);
 
 		const BananaValue *
-		option_restrain_margin = bananaGetOption (bananaIndex,
-		                                          "restrain_margin",
-		                                          s->screenNum);
+		option_restrain_margin = bananaGetOptionByHandle (restrainMarginOption,
+		                                                  s->screenNum);
 
 		if (option_mouse_pan->b)
 		{
@@ -1308,9 +1316,7 @@ updateMousePosition (CompScreen *s,
 	zs->lastChange = time (NULL);
 
 	const BananaValue *
-	option_sync_mouse = bananaGetOption (bananaIndex,
-	                                     "sync_mouse",
-	                                     s->screenNum);
+	option_sync_mouse = bananaGetOptionByHandle (syncMouseOption, s->screenNum);
 
 	if (option_sync_mouse->b && !isInMovement (s, out))
 		setCenter (s, zs->mouseX, zs->mouseY, TRUE);
@@ -1387,14 +1393,12 @@ drawCursor (CompScreen          *s,
 		glTranslatef ((float) ax, (float) ay, 0.0f);
 
 		const BananaValue *
-		option_scale_mouse_dynamic = bananaGetOption (bananaIndex,
-		                                              "scale_mouse_dynamic",
-		                                              s->screenNum);
+		option_scale_mouse_dynamic =
+		    bananaGetOptionByHandle (scaleMouseDynamicOption, s->screenNum);
 
 		const BananaValue *
-		option_scale_mouse_static = bananaGetOption (bananaIndex,
-		                                             "scale_mouse_static",
-		                                             s->screenNum);
+		option_scale_mouse_static =
+		    bananaGetOptionByHandle (scaleMouseStaticOption, s->screenNum);
 
 		if (option_scale_mouse_dynamic->b)
 			scaleFactor = 1.0f / zs->zooms[out].currentZoom;
@@ -1448,9 +1452,8 @@ zoomUpdateCursor (CompScreen    *s,
 		glBindTexture (GL_TEXTURE_RECTANGLE_ARB, cursor->texture);
 
 		const BananaValue *
-		option_filter_linear = bananaGetOption (bananaIndex,
-		                                        "filter_linear",
-		                                        s->screenNum);
+		option_filter_linear = bananaGetOptionByHandle (filterLinearOption,
+		                                                s->screenNum);
 
 		if (option_filter_linear->b &&
 		    display.textureFilter != GL_NEAREST)
@@ -1561,9 +1564,8 @@ cursorZoomActive (CompScreen *s)
 		return;
 
 	const BananaValue *
-	option_scale_mouse = bananaGetOption (bananaIndex,
-	                                      "scale_mouse",
-	                                      s->screenNum);
+	option_scale_mouse = bananaGetOptionByHandle (scaleMouseOption,
+	                                              s->screenNum);
 
 	if (!option_scale_mouse->b)
 		return;
@@ -1579,9 +1581,8 @@ cursorZoomActive (CompScreen *s)
 	}
 
 	const BananaValue *
-	option_hide_original_mouse = bananaGetOption (bananaIndex,
-	                                              "hide_original_mouse",
-	                                              s->screenNum);
+	option_hide_original_mouse =
+	    bananaGetOptionByHandle (hideOriginalMouseOption, s->screenNum);
 
 	if (zd->canHideCursor && !zs->cursorHidden &&
 	    option_hide_original_mouse->b)
@@ -1629,24 +1630,21 @@ focusTrack (XEvent      *event)
 	zs = GET_ZOOM_SCREEN (w->screen, GET_ZOOM_DISPLAY (&display));
 
 	const BananaValue *
-	option_follow_focus = bananaGetOption (bananaIndex,
-	                                       "follow_focus",
-	                                       w->screen->screenNum);
+	option_follow_focus = bananaGetOptionByHandle (followFocusOption,
+	                                               w->screen->screenNum);
 
 	const BananaValue *
-	option_follow_focus_delay = bananaGetOption (bananaIndex,
-	                                             "follow_focus_delay",
-	                                             w->screen->screenNum);
+	option_follow_focus_delay = bananaGetOptionByHandle (followFocusDelayOption,
+	                                                     w->screen->screenNum);
 
 	const BananaValue *
-	option_always_focus_fit_window = bananaGetOption (bananaIndex,
-	                                                  "always_focus_fit_window",
-	                                                  w->screen->screenNum);
+	option_always_focus_fit_window =
+	    bananaGetOptionByHandle (alwaysFocusFitWindowOption,
+	                             w->screen->screenNum);
 
 	const BananaValue *
-	option_focus_fit_window = bananaGetOption (bananaIndex,
-	                                           "focus_fit_window",
-	                                           w->screen->screenNum);
+	option_focus_fit_window = bananaGetOptionByHandle (focusFitWindowOption,
+	                                                   w->screen->screenNum);
 
 	if (time (NULL) - zs->lastChange < option_follow_focus_delay->i ||
 	    !option_follow_focus->b)
@@ -1666,9 +1664,8 @@ focusTrack (XEvent      *event)
 		                   (float) height/w->screen->outputDev[out].height);
 
 		const BananaValue *
-		option_autoscale_min = bananaGetOption (bananaIndex,
-		                                        "autoscale_min",
-		                                        w->screen->screenNum);
+		option_autoscale_min = bananaGetOptionByHandle (autoscaleMinOption,
+		                                                w->screen->screenNum);
 
 		if (scale > option_autoscale_min->f)
 			setScale (w->screen, out, scale);
@@ -1688,17 +1685,15 @@ zoomIn (CompScreen *s)
 		ZOOM_SCREEN (s);
 
 		const BananaValue *
-		option_sync_mouse = bananaGetOption (bananaIndex,
-		                                     "sync_mouse",
-		                                     s->screenNum);
+		option_sync_mouse = bananaGetOptionByHandle (syncMouseOption,
+		                                             s->screenNum);
 
 		if (option_sync_mouse->b && !isInMovement (s, out))
 			setCenter (s, pointerX, pointerY, TRUE);
 
 		const BananaValue *
-		option_zoom_factor = bananaGetOption (bananaIndex,
-		                                      "zoom_factor",
-		                                      s->screenNum);
+		option_zoom_factor = bananaGetOptionByHandle (zoomFactorOption,
+		                                              s->screenNum);
 
 		setScale (s, out,
 		          zs->zooms[out].newZoom /
@@ -1715,9 +1710,8 @@ zoomOut (CompScreen *s)
 		ZOOM_SCREEN (s);
 
 		const BananaValue *
-		option_zoom_factor = bananaGetOption (bananaIndex,
-		                                      "zoom_factor",
-		                                      s->screenNum);
+		option_zoom_factor = bananaGetOptionByHandle (zoomFactorOption,
+		                                              s->screenNum);
 
 		setScale (s, out,
 		          zs->zooms[out].newZoom *
@@ -1757,9 +1751,8 @@ zoomSpecific (CompScreen *s,
 		w = findWindowAtDisplay (display.activeWindow);
 
 		const BananaValue *
-		option_spec_target_focus = bananaGetOption (bananaIndex,
-		                                            "spec_target_focus",
-		                                            -1);
+		option_spec_target_focus =
+		    bananaGetOptionByHandle (specTargetFocusOption, -1);
 
 		if (option_spec_target_focus->b
 		    && w && w->screen->root == s->root)
@@ -2027,9 +2020,7 @@ zoomHandleEvent (XEvent      *event)
 				break;
 
 			const BananaValue *
-			option_zoom_spec1 = bananaGetOption (bananaIndex,
-			                                     "zoom_spec1",
-			                                     -1);
+			option_zoom_spec1 = bananaGetOptionByHandle (zoomSpec1Option, -1);
 
 			zoomSpecific (s, event->xkey.x_root,
 			                 event->xkey.y_root,
@@ -2043,9 +2034,7 @@ zoomHandleEvent (XEvent      *event)
 				break;
 
 			const BananaValue *
-			option_zoom_spec2 = bananaGetOption (bananaIndex,
-			                                     "zoom_spec2",
-			                                     -1);
+			option_zoom_spec2 = bananaGetOptionByHandle (zoomSpec2Option, -1);
 
 			zoomSpecific (s, event->xkey.x_root,
 			                 event->xkey.y_root,
@@ -2059,9 +2048,7 @@ zoomHandleEvent (XEvent      *event)
 				break;
 
 			const BananaValue *
-			option_zoom_spec3 = bananaGetOption (bananaIndex,
-			                                     "zoom_spec3",
-			                                     -1);
+			option_zoom_spec3 = bananaGetOptionByHandle (zoomSpec3Option, -1);
 
 			zoomSpecific (s, event->xkey.x_root,
 			                 event->xkey.y_root,
@@ -2441,6 +2428,38 @@ zoomInit (CompPlugin *p)
 
 	bananaAddChangeNotifyCallBack (bananaIndex, ezoomChangeNotify);
 
+	speedOption = bananaGetOptionHandle (bananaIndex, "speed");
+	timestepOption = bananaGetOptionHandle (bananaIndex, "timestep");
+	syncMouseOption = bananaGetOptionHandle (bananaIndex, "sync_mouse");
+	filterLinearOption = bananaGetOptionHandle (bananaIndex, "filter_linear");
+	mousePanOption = bananaGetOptionHandle (bananaIndex, "mouse_pan");
+	panFactorOption = bananaGetOptionHandle (bananaIndex, "pan_factor");
+	minimumZoomOption = bananaGetOptionHandle (bananaIndex, "minimum_zoom");
+	restrainMarginOption =
+	    bananaGetOptionHandle (bananaIndex, "restrain_margin");
+	restrainMouseOption = bananaGetOptionHandle (bananaIndex, "restrain_mouse");
+	scaleMouseDynamicOption =
+	    bananaGetOptionHandle (bananaIndex, "scale_mouse_dynamic");
+	scaleMouseStaticOption =
+	    bananaGetOptionHandle (bananaIndex, "scale_mouse_static");
+	scaleMouseOption = bananaGetOptionHandle (bananaIndex, "scale_mouse");
+	hideOriginalMouseOption =
+	    bananaGetOptionHandle (bananaIndex, "hide_original_mouse");
+	followFocusOption = bananaGetOptionHandle (bananaIndex, "follow_focus");
+	followFocusDelayOption =
+	    bananaGetOptionHandle (bananaIndex, "follow_focus_delay");
+	alwaysFocusFitWindowOption =
+	    bananaGetOptionHandle (bananaIndex, "always_focus_fit_window");
+	focusFitWindowOption =
+	    bananaGetOptionHandle (bananaIndex, "focus_fit_window");
+	autoscaleMinOption = bananaGetOptionHandle (bananaIndex, "autoscale_min");
+	zoomFactorOption = bananaGetOptionHandle (bananaIndex, "zoom_factor");
+	specTargetFocusOption =
+	    bananaGetOptionHandle (bananaIndex, "spec_target_focus");
+	zoomSpec1Option = bananaGetOptionHandle (bananaIndex, "zoom_spec1");
+	zoomSpec2Option = bananaGetOptionHandle (bananaIndex, "zoom_spec2");
+	zoomSpec3Option = bananaGetOptionHandle (bananaIndex, "zoom_spec3");
+
 	return TRUE;
 }
 
@@ -72,6 +72,8 @@ typedef struct _FadeWindow {
 	Bool alive;
 	Bool fadeOut;
 
+	Bool occlusionHook;
+
 	int steps;
 
 	int fadeTime;
@@ -178,6 +180,15 @@ fadePreparePaintScreen (CompScreen *s,
 		break;
 	}
 
+	/* only the opacity of a window changes what it occludes */
+	for (w = s->windows; w; w = w->next)
+	{
+		FadeWindow *fw = GET_FADE_WINDOW (w, fs);
+
+		setWindowOcclusionHook (w, &fw->occlusionHook,
+		                        fw->fadeOut ||
+		                        fw->opacity != w->paint.opacity);
+	}
 
 	UNWRAP (fs, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
@@ -863,6 +874,8 @@ fadeInitWindow (CompPlugin *p,
 	fw->fadeOut    = FALSE;
 	fw->alive      = w->alive;
 
+	fw->occlusionHook = FALSE;
+
 	fw->steps      = 0;
 	fw->fadeTime   = 0;
 
@@ -886,6 +899,8 @@ fadeFiniWindow (CompPlugin *p,
 	fadeRemoveDisplayModal (&display, w);
 	fadeWindowStop (w);
 
+	setWindowOcclusionHook (w, &fw->occlusionHook, FALSE);
+
 	free (fw);
 }
 
@@ -61,6 +61,8 @@ typedef struct _FadeDesktopScreen
 	FadeDesktopState state;
 	int fadeTime;
 
+	Bool occlusionHook;
+
 	CompMatch window_match;
 } FadeDesktopScreen;
 
@@ -174,6 +176,8 @@ fadeDesktopPreparePaintScreen (CompScreen *s,
 		}
 	}
 
+	setScreenOcclusionHook (s, &fs->occlusionHook, fs->state != FD_STATE_OFF);
+
 	UNWRAP (fs, s, preparePaintScreen);
 	(*s->preparePaintScreen)(s, msSinceLastPaint);
 	WRAP (fs, s, preparePaintScreen, fadeDesktopPreparePaintScreen);
@@ -402,6 +406,8 @@ fadeDesktopInitScreen (CompPlugin *p,
 	fs->state = FD_STATE_OFF;
 	fs->fadeTime = 0;
 
+	fs->occlusionHook = FALSE;
+
 	WRAP (fs, s, paintWindow, fadeDesktopPaintWindow);
 	WRAP (fs, s, preparePaintScreen, fadeDesktopPreparePaintScreen);
 	WRAP (fs, s, donePaintScreen, fadeDesktopDonePaintScreen);
@@ -437,6 +443,8 @@ fadeDesktopFiniScreen (CompPlugin *p,
 	UNWRAP (fs, s, enterShowDesktopMode);
 	UNWRAP (fs, s, leaveShowDesktopMode);
 
+	setScreenOcclusionHook (s, &fs->occlusionHook, FALSE);
+
 	freeWindowPrivateIndex (s, fs->windowPrivateIndex);
 
 	free (fs);
@@ -81,6 +81,7 @@ groupDestroyCairoLayer (CompScreen      *s,
 	if (layer->surface)
 		cairo_surface_destroy (layer->surface);
 
+	destroyTextureUpload (s, layer->upload);
 	finiTexture (s, &layer->texture);
 
 	if (layer->pixmap)
@@ -111,6 +112,7 @@ groupCreateCairoLayer (CompScreen *s,
 	layer->surface = NULL;
 	layer->cairo   = NULL;
 	layer->buffer  = NULL;
+	layer->upload  = NULL;
 	layer->pixmap  = None;
 
 	layer->animationTime = 0;
@@ -209,8 +211,8 @@ groupRenderTopTabHighlight (GroupSelection *group)
 	                       (group->color[3] / 65535.0f));
 	cairo_stroke (cr);
 
-	imageBufferToTexture (group->screen,
-	                      &layer->texture, (char*) layer->buffer,
+	streamImageToTexture (group->screen, &layer->texture, &layer->upload,
+	                      (char*) layer->buffer,
 	                      layer->texWidth, layer->texHeight);
 }
 
@@ -689,7 +691,8 @@ groupRenderTabBarBackground (GroupSelection *group)
 	cairo_stroke (cr);
 
 	cairo_restore (cr);
-	imageBufferToTexture (s, &layer->texture, (char*) layer->buffer,
+	streamImageToTexture (s, &layer->texture, &layer->upload,
+	                      (char*) layer->buffer,
 	                      layer->texWidth, layer->texHeight);
 }
 
@@ -2178,22 +2178,22 @@ groupDamageWindowRect (CompWindow *w,
 	if (gw->slot)
 	{
 		int vx, vy;
-		Region reg;
 
 		groupGetDrawOffsetForSlot (gw->slot, &vx, &vy);
 		if (vx || vy)
 		{
-			reg = XCreateRegion ();
-			XUnionRegion (reg, gw->slot->region, reg);
-			XOffsetRegion (reg, vx, vy);
-		}
-		else
-			reg = gw->slot->region;
+			CompRegion reg;
 
-		damageScreenRegion (s, reg);
+			initRegion (&reg);
+			compCopyRegion (gw->slot->region, &reg.region);
+			XOffsetRegion (&reg.region, vx, vy);
 
-		if (vx || vy)
-			XDestroyRegion (reg);
+			damageScreenRegion (s, &reg.region);
+
+			finiRegion (&reg);
+		}
+		else
+			damageScreenRegion (s, gw->slot->region);
 	}
 
 	return status;
@@ -282,6 +282,8 @@ groupInitScreen (CompPlugin *p,
 	WRAP (gs, s, windowStateChangeNotify, groupWindowStateChangeNotify);
 	WRAP (gs, s, activateWindow, groupActivateWindow);
 
+	s->occlusionHooks++;
+
 	s->privates[gd->screenPrivateIndex].ptr = gs;
 
 	gs->groups = NULL;
@@ -448,6 +450,8 @@ groupFiniScreen (CompPlugin *p,
 	UNWRAP (gs, s, windowStateChangeNotify);
 	UNWRAP (gs, s, activateWindow);
 
+	s->occlusionHooks--;
+
 	finiTexture (s, &gs->glowTexture);
 	free (gs);
 }
@@ -235,9 +235,10 @@ typedef struct _GroupCairoLayer {
 	CompTexture texture;
 
 	/* used if layer is used for cairo drawing */
-	unsigned char   *buffer;
-	cairo_surface_t *surface;
-	cairo_t         *cairo;
+	unsigned char     *buffer;
+	cairo_surface_t   *surface;
+	cairo_t           *cairo;
+	CompTextureUpload *upload;
 
 	/* used if layer is used for text drawing */
 	Pixmap pixmap;
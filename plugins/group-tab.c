@@ -65,7 +65,7 @@ groupGetCurrentMousePosition (CompScreen *s,
  * in the tab bar or Drag'n'Drop. It creates the clipping region
  * with getting the region of every window above the given window
  * and then adds this region to the clipping region using
- * XUnionRectWithRegion. w->region won't work since it doesn't include
+ * compUnionRectWithRegion. w->region won't work since it doesn't include
  * the window decoration.
  *
  */
@@ -83,24 +83,14 @@ groupGetClippingRegion (CompWindow *w)
 	{
 		if (!cw->invisible && !(cw->state & CompWindowStateHiddenMask))
 		{
-			XRectangle rect;
-			Region buf;
+			BoxRec box;
 
-			buf = XCreateRegion ();
-			if (!buf)
-			{
-				XDestroyRegion (clip);
-				return NULL;
-			}
-
-			rect.x      = WIN_REAL_X (cw);
-			rect.y      = WIN_REAL_Y (cw);
-			rect.width  = WIN_REAL_WIDTH (cw);
-			rect.height = WIN_REAL_HEIGHT (cw);
-			XUnionRectWithRegion (&rect, buf, buf);
+			box.x1 = WIN_REAL_X (cw);
+			box.y1 = WIN_REAL_Y (cw);
+			box.x2 = box.x1 + WIN_REAL_WIDTH (cw);
+			box.y2 = box.y1 + WIN_REAL_HEIGHT (cw);
 
-			XUnionRegion (clip, buf, clip);
-			XDestroyRegion (buf);
+			compUnionRectWithRegion (&box, clip, clip);
 		}
 	}
 
@@ -835,6 +835,8 @@ minInitScreen (CompPlugin *p,
 	WRAP (ms, s, damageWindowRect, minDamageWindowRect);
 	WRAP (ms, s, focusWindow, minFocusWindow);
 
+	s->occlusionHooks++;
+
 	s->privates[md->screenPrivateIndex].ptr = ms;
 
 	return TRUE;
@@ -856,6 +858,8 @@ minFiniScreen (CompPlugin *p,
 	UNWRAP (ms, s, damageWindowRect);
 	UNWRAP (ms, s, focusWindow);
 
+	s->occlusionHooks--;
+
 	free (ms);
 }
 
@@ -87,6 +87,8 @@ typedef struct _MoveScreen {
 
 	int	snapOffY;
 	int	snapBackY;
+
+	Bool occlusionHook;
 } MoveScreen;
 
 #define GET_MOVE_DISPLAY(d) \
@@ -132,6 +134,8 @@ moveTerminate (Bool cancel)
 			ms->grabIndex = 0;
 		}
 
+		setScreenOcclusionHook (md->w->screen, &ms->occlusionHook, FALSE);
+
 		if (md->moveOpacity != OPAQUE)
 			addWindowDamage (md->w);
 
@@ -221,6 +225,9 @@ moveInitiate (Window       xid,
 
 			md->w = w;
 
+			/* the moved window is painted with the move opacity */
+			setScreenOcclusionHook (w->screen, &ms->occlusionHook, TRUE);
+
 			md->releaseButton = button;
 
 			(w->screen->windowGrabNotify) (w, x, y, mods, grabMask);
@@ -859,6 +866,8 @@ moveInitScreen (CompPlugin *p,
 
 	ms->grabIndex = 0;
 
+	ms->occlusionHook = FALSE;
+
 	ms->moveCursor = XCreateFontCursor (display.display, XC_fleur);
 
 	WRAP (ms, s, paintWindow, movePaintWindow);
@@ -876,6 +885,8 @@ moveFiniScreen (CompPlugin *p,
 
 	UNWRAP (ms, s, paintWindow);
 
+	setScreenOcclusionHook (s, &ms->occlusionHook, FALSE);
+
 	if (ms->moveCursor)
 		XFreeCursor (display.display, ms->moveCursor);
 
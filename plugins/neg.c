@@ -51,8 +51,9 @@ typedef struct _NegScreen {
 
 	Bool isNeg; /* negative screen flag */
 
-	int negFunction;
-	int negAlphaFunction;
+	/* by fetch target, window contents can come from an atlas page */
+	int negFunction[COMP_FETCH_TARGET_NUM];
+	int negAlphaFunction[COMP_FETCH_TARGET_NUM];
 } NegScreen;
 
 typedef struct _NegWindow {
@@ -160,13 +161,13 @@ getNegFragmentFunction (CompScreen  *s,
 
 	if (alpha)
 	{
-		if (ns->negAlphaFunction)
-			return ns->negAlphaFunction;
+		if (ns->negAlphaFunction[target])
+			return ns->negAlphaFunction[target];
 	}
 	else
 	{
-		if (ns->negFunction)
-			return ns->negFunction;
+		if (ns->negFunction[target])
+			return ns->negFunction[target];
 	}
 
 	data = createFunctionData ();
@@ -203,9 +204,9 @@ getNegFragmentFunction (CompScreen  *s,
 		handle = createFragmentFunction (s, "neg", data);
 
 		if (alpha)
-			ns->negAlphaFunction = handle;
+			ns->negAlphaFunction[target] = handle;
 		else
-			ns->negFunction = handle;
+			ns->negFunction[target] = handle;
 
 		destroyFunctionData (data);
 
@@ -226,9 +227,8 @@ negDrawWindowTexture (CompWindow           *w,
 	NEG_SCREEN (w->screen);
 	NEG_WINDOW (w);
 
-	/* only negate window contents; that's the only case
-	   where w->texture->name == texture->name */
-	if (nw->isNeg && (texture->name == w->texture->name))
+	/* only negate window contents */
+	if (nw->isNeg && isWindowContentTexture (w, texture))
 	{
 		if (w->screen->fragmentProgram)
 		{
@@ -727,8 +727,8 @@ negInitScreen (CompPlugin *p,
 	*/
 	ns->isNeg = FALSE;
 
-	ns->negFunction      = 0;
-	ns->negAlphaFunction = 0;
+	memset (ns->negFunction, 0, sizeof (ns->negFunction));
+	memset (ns->negAlphaFunction, 0, sizeof (ns->negAlphaFunction));
 
 	WRAP (ns, s, drawWindowTexture, negDrawWindowTexture);
 	WRAP (ns, s, windowAddNotify, negWindowAddNotify);
@@ -760,6 +760,8 @@ static void
 negFiniScreen (CompPlugin *p,
                CompScreen *s)
 {
+	int i;
+
 	NEG_SCREEN (s);
 
 	matchFini (&ns->neg_match);
@@ -770,11 +772,14 @@ negFiniScreen (CompPlugin *p,
 	UNWRAP (ns, s, drawWindowTexture);
 	UNWRAP (ns, s, windowAddNotify);
 
-	if (ns->negFunction)
-		destroyFragmentFunction (s, ns->negFunction);
+	for (i = 0; i < COMP_FETCH_TARGET_NUM; i++)
+	{
+		if (ns->negFunction[i])
+			destroyFragmentFunction (s, ns->negFunction[i]);
 
-	if (ns->negAlphaFunction)
-		destroyFragmentFunction (s, ns->negAlphaFunction);
+		if (ns->negAlphaFunction[i])
+			destroyFragmentFunction (s, ns->negAlphaFunction[i]);
+	}
 
 	free (ns);
 }
@@ -74,6 +74,8 @@ typedef struct _ObsWindow
 	int customFactor[MODIFIER_COUNT];
 	int matchFactor[MODIFIER_COUNT];
 
+	Bool occlusionHook;
+
 	CompTimeoutHandle updateHandle;
 } ObsWindow;
 
@@ -124,6 +126,9 @@ changePaintModifier (CompWindow *w,
 		ow->customFactor[modifier] = value;
 		addWindowDamage (w);
 	}
+
+	setWindowOcclusionHook (w, &ow->occlusionHook,
+	                        ow->customFactor[MODIFIER_OPACITY] != 100);
 }
 
 
@@ -165,6 +170,9 @@ updatePaintModifier (CompWindow *w,
 
 	if (ow->customFactor[modifier] != lastFactor)
 		addWindowDamage (w);
+
+	setWindowOcclusionHook (w, &ow->occlusionHook,
+	                        ow->customFactor[MODIFIER_OPACITY] != 100);
 }
 
 static Bool
@@ -550,6 +558,8 @@ obsInitWindow (CompPlugin *p,
 		ow->matchFactor[i]  = 100;
 	}
 
+	ow->occlusionHook = FALSE;
+
 	/* defer initializing the factors from window matches as match evalution
 	   means wrapped function calls */
 	ow->updateHandle = compAddTimeout (0, 0, obsUpdateWindow, w);
@@ -568,6 +578,8 @@ obsFiniWindow (CompPlugin *p,
 	if (ow->updateHandle)
 		compRemoveTimeout (ow->updateHandle);
 
+	setWindowOcclusionHook (w, &ow->occlusionHook, FALSE);
+
 	free (ow);
 }
 
@@ -85,6 +85,8 @@ typedef struct _OpacifyScreen {
 typedef struct _OpacifyWindow {
 	Bool opacified;
 	int opacity;
+
+	Bool occlusionHook;
 } OpacifyWindow;
 
 /* Core opacify functions. These do the real work. ---------------------*/
@@ -102,6 +104,8 @@ setOpacity (CompWindow *w,
 
 	ow->opacified = TRUE;
 	ow->opacity = opacity;
+
+	setWindowOcclusionHook (w, &ow->occlusionHook, TRUE);
 }
 
 /* Resets the Window to the original opacity if it still exists.
@@ -120,6 +124,8 @@ resetOpacity (CompScreen *s,
 
 	ow->opacified = FALSE;
 
+	setWindowOcclusionHook (w, &ow->occlusionHook, FALSE);
+
 	addWindowDamage (w);
 }
 
@@ -533,6 +539,7 @@ opacifyInitWindow (CompPlugin *p,
 		return FALSE;
 
 	ow->opacified = FALSE;
+	ow->occlusionHook = FALSE;
 
 	w->privates[os->windowPrivateIndex].ptr = ow;
 
@@ -545,6 +552,8 @@ opacifyFiniWindow (CompPlugin *p,
 {
 	OPACIFY_WINDOW (w);
 
+	setWindowOcclusionHook (w, &ow->occlusionHook, FALSE);
+
 	free (ow);
 }
 
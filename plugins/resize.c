@@ -112,6 +112,8 @@ typedef struct _ResizeScreen {
 	Cursor downRightCursor;
 	Cursor middleCursor;
 	Cursor cursor[NUM_KEYS];
+
+	Bool occlusionHook;
 } ResizeScreen;
 
 #define GET_RESIZE_DISPLAY(d) \
@@ -284,18 +286,36 @@ resizeUpdateWindowProperty (CompDisplay *d)
 	                 (unsigned char*) data, 4);
 }
 
+/* a stretched window is painted transformed */
+static void
+resizeUpdateOcclusionHook (CompScreen *s)
+{
+	RESIZE_DISPLAY (&display);
+	RESIZE_SCREEN (s);
+
+	setScreenOcclusionHook (s, &rs->occlusionHook,
+	                        rd->w && rd->w->screen == s &&
+	                        rd->mode == RESIZE_MODE_STRETCH);
+}
+
 static void
 resizeFinishResizing (CompDisplay *d)
 {
+	CompScreen *s;
+
 	RESIZE_DISPLAY (d);
 
-	(*rd->w->screen->windowUngrabNotify) (rd->w);
+	s = rd->w->screen;
+
+	(*s->windowUngrabNotify) (rd->w);
 
 	XDeleteProperty (d->display,
 	                 rd->w->id,
 	                 rd->resizeInformationAtom);
 
 	rd->w = NULL;
+
+	resizeUpdateOcclusionHook (s);
 }
 
 static Region
@@ -553,6 +573,8 @@ resizeInitiate (BananaArgument   *arg,
 			rd->mode = option_mode->i;
 		}
 
+		resizeUpdateOcclusionHook (w->screen);
+
 		if (!rs->grabIndex)
 		{
 			Cursor cursor;
@@ -1621,6 +1643,8 @@ resizeInitScreen (CompPlugin *p,
 
 	rs->grabIndex = 0;
 
+	rs->occlusionHook = FALSE;
+
 	Display *dpy = display.display;
 
 	rs->leftCursor      = XCreateFontCursor (dpy, XC_left_side);
@@ -1680,6 +1704,8 @@ resizeFiniScreen (CompPlugin *p,
 	UNWRAP (rs, s, paintWindow);
 	UNWRAP (rs, s, damageWindowRect);
 
+	setScreenOcclusionHook (s, &rs->occlusionHook, FALSE);
+
 	free (rs);
 }
 
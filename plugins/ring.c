@@ -87,6 +87,7 @@ typedef struct _RingScreen {
 	RingType  type;
 	Bool      moreAdjust;
 	Bool      rotateAdjust;
+	Bool      occlusionHook;
 
 	Bool paintingSwitcher;
 
@@ -1128,6 +1129,9 @@ ringPreparePaintScreen (CompScreen *s,
 		}
 	}
 
+	setScreenOcclusionHook (s, &rs->occlusionHook,
+	                        rs->state != RingStateNone);
+
 	UNWRAP (rs, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (rs, s, preparePaintScreen, ringPreparePaintScreen);
@@ -1656,6 +1660,8 @@ ringInitScreen (CompPlugin *p,
 
 	rs->state = RingStateNone;
 
+	rs->occlusionHook = FALSE;
+
 	rs->windows     = NULL;
 	rs->drawSlots   = NULL;
 	rs->windowsSize = 0;
@@ -1706,6 +1712,8 @@ ringFiniScreen (CompPlugin *p,
 	UNWRAP (rs, s, paintWindow);
 	UNWRAP (rs, s, damageWindowRect);
 
+	setScreenOcclusionHook (s, &rs->occlusionHook, FALSE);
+
 	matchFini (&rs->window_match);
 
 	ringFreeWindowTitle (s);
@@ -886,6 +886,10 @@ scalePreparePaintScreen (CompScreen *s,
 		}
 	}
 
+	/* scaled windows don't occlude what they used to */
+	setScreenOcclusionHook (s, &ss->occlusionHook,
+	                        ss->state != SCALE_STATE_NONE);
+
 	UNWRAP (ss, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (ss, s, preparePaintScreen, scalePreparePaintScreen);
@@ -1678,6 +1682,8 @@ scaleInitScreen (CompPlugin *p,
 
 	ss->state = SCALE_STATE_NONE;
 
+	ss->occlusionHook = FALSE;
+
 	ss->slots = 0;
 	ss->slotsSize = 0;
 
@@ -1728,6 +1734,8 @@ scaleFiniScreen (CompPlugin *p,
 	UNWRAP (ss, s, paintWindow);
 	UNWRAP (ss, s, damageWindowRect);
 
+	setScreenOcclusionHook (s, &ss->occlusionHook, FALSE);
+
 	matchFini (&ss->window_match);
 
 	if (ss->cursor)
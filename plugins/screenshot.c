@@ -28,6 +28,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <dirent.h>
 
 #include <fusilli-core.h>
@@ -36,10 +41,100 @@ static int bananaIndex;
 
 static CompButtonBinding initiate_button;
 
+static BananaOptionHandle directoryOption;
+static BananaOptionHandle launchAppOption;
+static BananaOptionHandle burstFramesOption;
+
 static int displayPrivateIndex;
 
 #define MAX_LINE_LENGTH 1024
 
+/*
+ * Screenshots are read back and written without stalling painting.
+ *
+ * With pixel buffer objects and fences glReadPixels only starts a copy
+ * of the selection into a buffer object, and a fence placed after it
+ * is polled from a timeout. Once the copy is done the pixels are taken
+ * out of the buffer and handed to a worker thread, which finds the next
+ * free file name and encodes the png. The worker wakes up the main loop
+ * through a pipe to report the result and to launch the application.
+ * Without pixel buffer objects the pixels are read back right away and
+ * only the encoding is done by the worker.
+ *
+ * A burst captures burst_frames consecutive frames of the selection,
+ * each into a file of its own. The selection is damaged every frame so
+ * that every frame of the burst is painted. Compressing a full screen
+ * png takes longer than a frame, so the frames of a burst are written
+ * uncompressed, and there is a worker for every CPU, up to
+ * SHOT_MAX_WORKERS. File names are taken in the order the frames were
+ * captured.
+ *
+ * Encoding is a lot slower than painting, so the memory in flight is
+ * bounded. Jobs and their image memory are kept for reuse, up to
+ * SHOT_MAX_JOB_BYTES of images, and a finished readback stays in its
+ * buffer object until a job is free. When all SHOT_MAX_READBACKS buffer
+ * objects are taken as well, the burst is stopped. Once nothing is
+ * captured, read back or written anymore, the memory is freed.
+ */
+
+#define SHOT_POLL_TIME 4
+
+#define SHOT_MAX_JOB_BYTES (128 * 1024 * 1024)
+#define SHOT_MAX_READBACKS 4
+#define SHOT_MAX_WORKERS   4
+
+typedef struct _ShotJob {
+	struct _ShotJob *next;
+
+	int     screenNum;
+	char    *dir;     /* the directory option */
+	char    *app;     /* launched with the file once written, or NULL */
+	int     width, height;
+	GLubyte *data;
+	size_t  size;     /* of data */
+	int     level;    /* zlib compression level, -1 for the default */
+
+	/* set by the worker, fileName is NULL if dir couldn't be read */
+	char *fileName;
+	Bool status;
+} ShotJob;
+
+static pthread_mutex_t jobMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  jobCond = PTHREAD_COND_INITIALIZER;
+static pthread_t       jobThreads[SHOT_MAX_WORKERS];
+static int             nJobThread = 0;
+static Bool            jobThreadRunning = FALSE;
+static Bool            jobThreadQuit = FALSE;
+
+/* jobs in the order they were captured, protected by jobMutex */
+static ShotJob *pendingJobs = NULL;
+static ShotJob *doneJobs = NULL;
+static int     writingJobs = 0;
+
+/* jobs that are done with, only used on the main loop */
+static ShotJob *freeJobs = NULL;
+static size_t  jobBytes = 0;
+
+static int               jobPipe[2] = { -1, -1 };
+static CompWatchFdHandle jobWatchFdHandle = 0;
+
+/* taken by a worker before it lets go of jobMutex, so that the file
+   names follow the order of the jobs; protects lastDir and lastNumber */
+static pthread_mutex_t nameMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char *lastDir = NULL;
+static int  lastNumber = 0;
+
+typedef struct _ShotReadback {
+	struct _ShotReadback *next;
+
+	GLuint     buffer;
+	GLsizeiptr size;
+	GLsync     fence;
+	int        width, height;
+	Bool       launch;
+} ShotReadback;
+
 typedef struct _ShotDisplay {
 	int             screenPrivateIndex;
 	HandleEventProc handleEvent;
@@ -52,6 +147,15 @@ typedef struct _ShotScreen {
 
 	int  x1, y1, x2, y2;
 	Bool grab;
+
+	/* frames of the burst left to capture */
+	int burst;
+
+	/* started readbacks, oldest first, and idle buffers */
+	ShotReadback      *readbacks;
+	ShotReadback      *freeReadbacks;
+	int               nReadback;
+	CompTimeoutHandle readbackHandle;
 } ShotScreen;
 
 #define GET_SHOT_DISPLAY(d) \
@@ -96,7 +200,8 @@ shotInitiate (BananaArgument     *arg,
 		ss->x1 = ss->x2 = pointerX;
 		ss->y1 = ss->y2 = pointerY;
 
-		ss->grab = TRUE;
+		ss->grab  = TRUE;
+		ss->burst = 0;
 	}
 
 	return TRUE;
@@ -285,6 +390,685 @@ shotGetXDGDesktopDir (void)
 	return NULL;
 }
 
+static void
+appendShotJob (ShotJob **list,
+               ShotJob *job)
+{
+	job->next = NULL;
+
+	while (*list)
+		list = &(*list)->next;
+
+	*list = job;
+}
+
+static void
+freeShotJob (ShotJob *job)
+{
+	if (job->data)
+		free (job->data);
+
+	free (job);
+}
+
+/* a job with room for size bytes of image, or NULL if the images in
+   flight take too much memory already. The limit is ignored if force
+   is TRUE */
+static ShotJob *
+allocShotJob (size_t size,
+              Bool   force)
+{
+	ShotJob *job = freeJobs;
+	GLubyte *data;
+
+	if (job && job->size >= size)
+	{
+		freeJobs = job->next;
+
+		return job;
+	}
+
+	if (!force && jobBytes && jobBytes + size > SHOT_MAX_JOB_BYTES)
+		return NULL;
+
+	if (job)
+	{
+		data = realloc (job->data, size);
+		if (!data)
+			return NULL;
+
+		freeJobs = job->next;
+	}
+	else
+	{
+		job = calloc (1, sizeof (ShotJob));
+		if (!job)
+			return NULL;
+
+		data = malloc (size);
+		if (!data)
+		{
+			free (job);
+			return NULL;
+		}
+	}
+
+	jobBytes += size - job->size;
+
+	job->data = data;
+	job->size = size;
+
+	return job;
+}
+
+/* keeps the image memory of job for the next one */
+static void
+releaseShotJob (ShotJob *job)
+{
+	if (job->fileName)
+		free (job->fileName);
+
+	if (job->app)
+		free (job->app);
+
+	if (job->dir)
+		free (job->dir);
+
+	job->fileName = NULL;
+	job->app      = NULL;
+	job->dir      = NULL;
+	job->status   = FALSE;
+
+	job->next = freeJobs;
+	freeJobs  = job;
+}
+
+static void
+freeShotJobs (void)
+{
+	while (freeJobs)
+	{
+		ShotJob *job = freeJobs;
+
+		freeJobs = job->next;
+		freeShotJob (job);
+	}
+
+	jobBytes = 0;
+}
+
+/* the number of the next screenshot in dir, or -1 if it can't be read */
+static int
+shotGetNextNumber (const char *dir)
+{
+	struct dirent **namelist;
+	int           n, number = 0;
+
+	n = scandir (dir, &namelist, shotFilter, shotSort);
+	if (n < 0)
+		return -1;
+
+	if (n > 0)
+		sscanf (namelist[n - 1]->d_name, "screenshot%d.png", &number);
+
+	while (n--)
+		free (namelist[n]);
+	free (namelist);
+
+	return number + 1;
+}
+
+/* creates the file of job and sets its fileName, with nameMutex held.
+   Returns FALSE if there is no file to write */
+static Bool
+shotCreateImageFile (ShotJob *job)
+{
+	char *dir, name[256];
+	int  number, fd;
+
+	dir = job->dir;
+	if (!*dir)
+	{
+		/* if dir is empty, use the user's desktop directory instead */
+		dir = shotGetXDGDesktopDir ();
+		if (!dir)
+			dir = strdup ("");
+		if (!dir)
+			return FALSE;
+
+		free (job->dir);
+		job->dir = dir;
+	}
+
+	/* the directory is only read again when it changes, the frames of
+	   a burst follow each other. Files are created with O_EXCL, so the
+	   names of files that were created since are skipped */
+	if (lastDir && !strcmp (lastDir, dir))
+	{
+		number = lastNumber + 1;
+	}
+	else
+	{
+		number = shotGetNextNumber (dir);
+		if (number < 0)
+			return FALSE;
+
+		if (lastDir)
+			free (lastDir);
+
+		lastDir = strdup (dir);
+	}
+
+	for (;;)
+	{
+		sprintf (name, "screenshot%d.png", number);
+
+		if (asprintf (&job->fileName, "%s/%s", dir, name) < 0)
+		{
+			job->fileName = NULL;
+			return FALSE;
+		}
+
+		fd = open (job->fileName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+		           0666);
+		if (fd >= 0 || errno != EEXIST)
+			break;
+
+		free (job->fileName);
+		job->fileName = NULL;
+
+		number++;
+	}
+
+	lastNumber = number;
+
+	if (fd < 0)
+		return FALSE;
+
+	close (fd);
+
+	return TRUE;
+}
+
+/* encodes job into the file shotCreateImageFile made for it */
+static void
+shotWriteImage (ShotJob *job)
+{
+	job->status = pngImageToFileWithCompression (NULL, job->fileName,
+	                                             job->width, job->height,
+	                                             job->width * 4, job->data,
+	                                             job->level);
+
+	/* don't leave an empty file behind */
+	if (!job->status)
+		unlink (job->fileName);
+}
+
+/* back on the main loop */
+static void
+shotFinishJob (ShotJob *job)
+{
+	CompScreen *s;
+
+	if (!job->fileName)
+	{
+		compLogMessage ("screenshot", CompLogLevelError,
+		                "can't read directory %s", job->dir);
+	}
+	else if (!job->status)
+	{
+		compLogMessage ("screenshot", CompLogLevelError,
+		                "failed to write screenshot image");
+	}
+	else if (job->app)
+	{
+		char *command;
+
+		for (s = display.screens; s; s = s->next)
+			if (s->screenNum == job->screenNum)
+				break;
+
+		if (s && asprintf (&command, "%s %s", job->app, job->fileName) >= 0)
+		{
+			runCommand (s, command);
+
+			free (command);
+		}
+	}
+
+	releaseShotJob (job);
+}
+
+static void *
+shotJobThread (void *closure)
+{
+	ShotJob *job;
+	Bool    created;
+	char    c = 0;
+
+	pthread_mutex_lock (&jobMutex);
+
+	for (;;)
+	{
+		while (!pendingJobs && !jobThreadQuit)
+			pthread_cond_wait (&jobCond, &jobMutex);
+
+		/* the captured images are written before quitting */
+		if (!pendingJobs)
+			break;
+
+		job         = pendingJobs;
+		pendingJobs = job->next;
+
+		writingJobs++;
+
+		pthread_mutex_lock (&nameMutex);
+		pthread_mutex_unlock (&jobMutex);
+
+		created = shotCreateImageFile (job);
+
+		pthread_mutex_unlock (&nameMutex);
+
+		if (created)
+			shotWriteImage (job);
+
+		pthread_mutex_lock (&jobMutex);
+
+		writingJobs--;
+
+		appendShotJob (&doneJobs, job);
+
+		/* when the pipe is full the main loop is woken up anyway */
+		while (write (jobPipe[1], &c, 1) < 0 && errno == EINTR);
+	}
+
+	pthread_mutex_unlock (&jobMutex);
+
+	return NULL;
+}
+
+static void
+freeShotReadbacks (CompScreen *s)
+{
+	ShotReadback *rb;
+
+	SHOT_SCREEN (s);
+
+	while (ss->freeReadbacks)
+	{
+		rb = ss->freeReadbacks;
+		ss->freeReadbacks = rb->next;
+
+		(*s->deleteBuffers) (1, &rb->buffer);
+		free (rb);
+
+		ss->nReadback--;
+	}
+}
+
+/* frees the job memory and buffer objects that are kept for the next
+   frames, once nothing is captured or written anymore */
+static void
+shotFreeIdleMemory (void)
+{
+	CompScreen *s;
+	Bool       busy;
+
+	pthread_mutex_lock (&jobMutex);
+	busy = pendingJobs || doneJobs || writingJobs;
+	pthread_mutex_unlock (&jobMutex);
+
+	if (busy)
+		return;
+
+	for (s = display.screens; s; s = s->next)
+	{
+		SHOT_SCREEN (s);
+
+		if (ss->readbacks || ss->grab)
+			return;
+	}
+
+	freeShotJobs ();
+
+	for (s = display.screens; s; s = s->next)
+	{
+		SHOT_SCREEN (s);
+
+		if (!ss->freeReadbacks)
+			continue;
+
+		makeScreenCurrent (s);
+		freeShotReadbacks (s);
+	}
+}
+
+static Bool
+shotJobWatch (void *closure)
+{
+	ShotJob *job;
+	char    buf[64];
+
+	while (read (jobPipe[0], buf, sizeof (buf)) > 0);
+
+	for (;;)
+	{
+		pthread_mutex_lock (&jobMutex);
+
+		job = doneJobs;
+		if (job)
+			doneJobs = job->next;
+
+		pthread_mutex_unlock (&jobMutex);
+
+		if (!job)
+			break;
+
+		shotFinishJob (job);
+	}
+
+	shotFreeIdleMemory ();
+
+	return TRUE;
+}
+
+static void
+startShotJobThread (void)
+{
+	long nCpu;
+	int  n;
+
+	if (pipe (jobPipe) < 0)
+		return;
+
+	fcntl (jobPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl (jobPipe[1], F_SETFL, O_NONBLOCK);
+	fcntl (jobPipe[0], F_SETFD, FD_CLOEXEC);
+	fcntl (jobPipe[1], F_SETFD, FD_CLOEXEC);
+
+	jobThreadQuit = FALSE;
+
+	nCpu = sysconf (_SC_NPROCESSORS_ONLN);
+	n    = nCpu < 1 ? 1 : MIN (nCpu, SHOT_MAX_WORKERS);
+
+	for (nJobThread = 0; nJobThread < n; nJobThread++)
+		if (pthread_create (&jobThreads[nJobThread], NULL,
+		                    shotJobThread, NULL))
+			break;
+
+	if (!nJobThread)
+	{
+		compLogMessage ("screenshot", CompLogLevelWarn,
+		                "Couldn't start a thread, screenshots are "
+		                "written while painting.");
+
+		close (jobPipe[0]);
+		close (jobPipe[1]);
+		jobPipe[0] = jobPipe[1] = -1;
+
+		return;
+	}
+
+	jobWatchFdHandle = compAddWatchFd (jobPipe[0], POLLIN,
+	                                   shotJobWatch, NULL);
+
+	jobThreadRunning = TRUE;
+}
+
+static void
+stopShotJobThread (void)
+{
+	if (!jobThreadRunning)
+		return;
+
+	pthread_mutex_lock (&jobMutex);
+
+	jobThreadQuit = TRUE;
+	pthread_cond_broadcast (&jobCond);
+
+	pthread_mutex_unlock (&jobMutex);
+
+	/* waits until all captured images are written, there are only as
+	   many as SHOT_MAX_JOB_BYTES allows */
+	while (nJobThread)
+		pthread_join (jobThreads[--nJobThread], NULL);
+
+	while (doneJobs)
+	{
+		ShotJob *job = doneJobs;
+
+		doneJobs = job->next;
+		releaseShotJob (job);
+	}
+
+	compRemoveWatchFd (jobWatchFdHandle);
+
+	close (jobPipe[0]);
+	close (jobPipe[1]);
+	jobPipe[0] = jobPipe[1] = -1;
+
+	jobThreadRunning = FALSE;
+
+	if (lastDir)
+		free (lastDir);
+	lastDir = NULL;
+}
+
+
+/* takes job, with w * h pixels read back from s in its data */
+static void
+shotQueueImage (CompScreen *s,
+                ShotJob    *job,
+                int        w,
+                int        h,
+                Bool       launch)
+{
+	const BananaValue *
+	option_dir = bananaGetOptionByHandle (directoryOption, -1);
+
+	const BananaValue *
+	option_launch_app = bananaGetOptionByHandle (launchAppOption, -1);
+
+	const BananaValue *
+	option_burst_frames = bananaGetOptionByHandle (burstFramesOption, -1);
+
+	job->screenNum = s->screenNum;
+	job->level     = option_burst_frames->i > 1 ? 0 : -1;
+	job->width     = w;
+	job->height    = h;
+	job->dir       = strdup (option_dir->s);
+
+	if (launch && *option_launch_app->s)
+		job->app = strdup (option_launch_app->s);
+
+	if (!job->dir)
+	{
+		releaseShotJob (job);
+		return;
+	}
+
+	if (!jobThreadRunning)
+		startShotJobThread ();
+
+	if (!jobThreadRunning)
+	{
+		if (shotCreateImageFile (job))
+			shotWriteImage (job);
+
+		shotFinishJob (job);
+		return;
+	}
+
+	pthread_mutex_lock (&jobMutex);
+
+	appendShotJob (&pendingJobs, job);
+	pthread_cond_signal (&jobCond);
+
+	pthread_mutex_unlock (&jobMutex);
+}
+
+/* takes the pixels of finished readbacks, oldest first, and waits for
+   them if wait is TRUE. Without wait, readbacks stay in their buffer
+   until there is a free job */
+static void
+shotFinishReadbacks (CompScreen *s,
+                     Bool       wait)
+{
+	ShotReadback *rb;
+	ShotJob      *job;
+	GLenum       status;
+	GLubyte      *pixels;
+	GLsizeiptr   size;
+
+	SHOT_SCREEN (s);
+
+	while (ss->readbacks)
+	{
+		rb = ss->readbacks;
+
+		if (rb->fence)
+		{
+			status = (*s->clientWaitSync) (rb->fence,
+			                               GL_SYNC_FLUSH_COMMANDS_BIT,
+			                               wait ? 1000000000ULL : 0);
+			if (!wait &&
+			    status != GL_ALREADY_SIGNALED &&
+			    status != GL_CONDITION_SATISFIED)
+				break;
+
+			(*s->deleteSync) (rb->fence);
+			rb->fence = NULL;
+		}
+
+		size = (GLsizeiptr) rb->width * rb->height * 4;
+
+		job = allocShotJob (size, wait);
+		if (!job)
+			break;
+
+		(*s->bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, rb->buffer);
+
+		pixels = (*s->mapBuffer) (GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+		if (pixels)
+		{
+			memcpy (job->data, pixels, size);
+			shotQueueImage (s, job, rb->width, rb->height, rb->launch);
+
+			(*s->unmapBuffer) (GL_PIXEL_PACK_BUFFER_ARB);
+		}
+		else
+		{
+			releaseShotJob (job);
+		}
+
+		(*s->bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+		ss->readbacks = rb->next;
+
+		rb->next = ss->freeReadbacks;
+		ss->freeReadbacks = rb;
+	}
+}
+
+static Bool
+shotReadbackTimeout (void *closure)
+{
+	CompScreen *s = closure;
+
+	SHOT_SCREEN (s);
+
+	makeScreenCurrent (s);
+
+	shotFinishReadbacks (s, FALSE);
+
+	if (ss->readbacks)
+		return TRUE;
+
+	ss->readbackHandle = 0;
+
+	shotFreeIdleMemory ();
+
+	return FALSE;
+}
+
+/* starts reading back the rectangle x, y, w, h of the frame painted,
+   returns FALSE if there is no memory left for it */
+static Bool
+shotStartReadback (CompScreen *s,
+                   int        x,
+                   int        y,
+                   int        w,
+                   int        h,
+                   Bool       launch)
+{
+	ShotReadback *rb, **tail;
+	ShotJob      *job;
+	GLsizeiptr   size = (GLsizeiptr) w * h * 4;
+
+	SHOT_SCREEN (s);
+
+	if (!s->pixelBufferObject || !s->syncObject)
+	{
+		job = allocShotJob (size, FALSE);
+		if (!job)
+			return FALSE;
+
+		glReadPixels (x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+		              (GLvoid *) job->data);
+		shotQueueImage (s, job, w, h, launch);
+
+		return TRUE;
+	}
+
+	rb = ss->freeReadbacks;
+	if (rb)
+	{
+		ss->freeReadbacks = rb->next;
+	}
+	else
+	{
+		if (ss->nReadback >= SHOT_MAX_READBACKS)
+			return FALSE;
+
+		rb = calloc (1, sizeof (ShotReadback));
+		if (!rb)
+			return FALSE;
+
+		(*s->genBuffers) (1, &rb->buffer);
+
+		ss->nReadback++;
+	}
+
+	(*s->bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, rb->buffer);
+
+	if (rb->size < size)
+	{
+		(*s->bufferData) (GL_PIXEL_PACK_BUFFER_ARB, size, NULL,
+		                  GL_STREAM_READ_ARB);
+		rb->size = size;
+	}
+
+	glReadPixels (x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	(*s->bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+	rb->fence  = (*s->fenceSync) (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	rb->width  = w;
+	rb->height = h;
+	rb->launch = launch;
+	rb->next   = NULL;
+
+	for (tail = &ss->readbacks; *tail; tail = &(*tail)->next);
+	*tail = rb;
+
+	if (!ss->readbackHandle)
+		ss->readbackHandle = compAddTimeout (SHOT_POLL_TIME / 2,
+		                                     SHOT_POLL_TIME,
+		                                     shotReadbackTimeout, s);
+
+	return TRUE;
+}
+
 static void
 shotPaintScreen (CompScreen   *s,
                  CompOutput   *outputs,
@@ -305,7 +1089,7 @@ shotPaintScreen (CompScreen   *s,
 		y1 = MIN (ss->y1, ss->y2);
 		x2 = MAX (ss->x1, ss->x2);
 		y2 = MAX (ss->y1, ss->y2);
-		
+
 		if (!ss->grabIndex)
 		{
 			int w = x2 - x1;
@@ -313,93 +1097,55 @@ shotPaintScreen (CompScreen   *s,
 
 			if (w && h)
 			{
-				GLubyte *buffer;
-
 				const BananaValue *
-				option_dir = bananaGetOption (bananaIndex, "directory", -1);
+				option_burst_frames =
+				    bananaGetOptionByHandle (burstFramesOption, -1);
 
-				char    *dir = option_dir->s;
-				Bool    allocatedDir = FALSE;
+				/* the first frame of the selection */
+				if (!ss->burst)
+					ss->burst = option_burst_frames->i;
 
-				if (strlen (dir) == 0)
+				/* the application is only launched for a single frame */
+				if (shotStartReadback (s, x1, s->height - y2, w, h,
+				                       option_burst_frames->i == 1))
 				{
-					// If dir is empty, use user's desktop directory instead
-					dir = shotGetXDGDesktopDir ();
-					if (dir)
-						allocatedDir = TRUE;
-					else
-						dir = "";
+					ss->burst--;
 				}
-				buffer = malloc (sizeof (GLubyte) * w * h * 4);
-				if (buffer)
+				else
 				{
-					struct dirent **namelist;
-					int           n;
-
-					glReadPixels (x1, s->height - y2, w, h,
-					           GL_RGBA, GL_UNSIGNED_BYTE,
-					           (GLvoid *) buffer);
-
-					n = scandir (dir, &namelist, shotFilter, shotSort);
-					if (n >= 0)
-					{
-						char name[256];
-						char *app;
-						int  number = 0;
-
-						if (n > 0)
-							sscanf (namelist[n - 1]->d_name,
-							        "screenshot%d.png",
-							        &number);
-
-						number++;
-
-						if (n)
-							free (namelist);
-
-						sprintf (name, "screenshot%d.png", number);
-
-						const BananaValue *
-						option_launch_app = bananaGetOption (
-						       bananaIndex, "launch_app", -1);
-
-						app = option_launch_app->s;
-
-						if (!writeImageToFile (dir, name, "png",
-						                       w, h, buffer))
-						{
-							compLogMessage ("screenshot", CompLogLevelError,
-							              "failed to write screenshot image");
-						}
-						else if (*app != '\0')
-						{
-							char *command;
-
-							command = malloc (strlen (app) +
-							          strlen (dir) +
-							          strlen (name) + 3);
-							if (command)
-							{
-								sprintf (command, "%s %s/%s", app, dir, name);
-
-								runCommand (s, command);
-
-								free (command);
-							}
-						}
-					}
-					else
-					{
-						perror (dir);
-					}
-
-					free (buffer);
+					compLogMessage ("screenshot", CompLogLevelWarn,
+					                "images aren't written fast enough, "
+					                "dropped the last %d frames",
+					                ss->burst);
+
+					ss->burst = 0;
 				}
-				if (allocatedDir)
-					free (dir);
 			}
+			else
+			{
+				ss->burst = 0;
+			}
+
+			if (ss->burst > 0)
+			{
+				REGION reg;
+
+				reg.rects    = &reg.extents;
+				reg.numRects = 1;
+
+				reg.extents.x1 = x1;
+				reg.extents.y1 = y1;
+				reg.extents.x2 = x2;
+				reg.extents.y2 = y2;
+
+				damageScreenRegion (s, &reg);
+			}
+			else
+			{
+				ss->grab = FALSE;
 
-			ss->grab = FALSE;
+				shotFreeIdleMemory ();
+			}
 		}
 	}
 }
@@ -574,6 +1320,9 @@ shotFiniDisplay (CompPlugin  *p,
 {
 	SHOT_DISPLAY (d);
 
+	stopShotJobThread ();
+	freeShotJobs ();
+
 	freeScreenPrivateIndex (sd->screenPrivateIndex);
 
 	UNWRAP (sd, d, handleEvent);
@@ -595,6 +1344,12 @@ shotInitScreen (CompPlugin *p,
 
 	ss->grabIndex = 0;
 	ss->grab      = FALSE;
+	ss->burst     = 0;
+
+	ss->readbacks      = NULL;
+	ss->freeReadbacks  = NULL;
+	ss->nReadback      = 0;
+	ss->readbackHandle = 0;
 
 	WRAP (ss, s, paintScreen, shotPaintScreen);
 	WRAP (ss, s, paintOutput, shotPaintOutput);
@@ -610,6 +1365,14 @@ shotFiniScreen (CompPlugin *p,
 {
 	SHOT_SCREEN (s);
 
+	if (ss->readbackHandle)
+		compRemoveTimeout (ss->readbackHandle);
+
+	/* the frames captured so far are still written */
+	makeScreenCurrent (s);
+	shotFinishReadbacks (s, TRUE);
+	freeShotReadbacks (s);
+
 	UNWRAP (ss, s, paintScreen);
 	UNWRAP (ss, s, paintOutput);
 
@@ -652,6 +1415,10 @@ shotInit (CompPlugin *p)
 
 	bananaAddChangeNotifyCallBack (bananaIndex, shotChangeNotify);
 
+	directoryOption   = bananaGetOptionHandle (bananaIndex, "directory");
+	launchAppOption   = bananaGetOptionHandle (bananaIndex, "launch_app");
+	burstFramesOption = bananaGetOptionHandle (bananaIndex, "burst_frames");
+
 	const BananaValue *
 	option_initiate_button = bananaGetOption (bananaIndex,
 	                                          "initiate_button",
@@ -63,6 +63,34 @@ typedef enum {
 
 static int bananaIndex;
 
+static BananaOptionHandle minimizedOption;
+static BananaOptionHandle windowTitleOption;
+static BananaOptionHandle multioutputModeOption;
+static BananaOptionHandle titleFontSizeOption;
+static BananaOptionHandle titleFontColorOption;
+static BananaOptionHandle titleBackColorOption;
+static BananaOptionHandle titleFontFamilyOption;
+static BananaOptionHandle titleFontBoldOption;
+static BananaOptionHandle titleTextPlacementOption;
+static BananaOptionHandle overlayIconOption;
+static BananaOptionHandle sizeOption;
+static BananaOptionHandle coverOffsetOption;
+static BananaOptionHandle flipRotationOption;
+static BananaOptionHandle modeOption;
+static BananaOptionHandle hideAllOption;
+static BananaOptionHandle backgroundIntensityOption;
+static BananaOptionHandle reflectionOption;
+static BananaOptionHandle mipmapsOption;
+static BananaOptionHandle intensityOption;
+static BananaOptionHandle groundSizeOption;
+static BananaOptionHandle groundColor1Option;
+static BananaOptionHandle groundColor2Option;
+static BananaOptionHandle shiftSpeedOption;
+static BananaOptionHandle timestepOption;
+static BananaOptionHandle speedOption;
+static BananaOptionHandle clickDurationOption;
+static BananaOptionHandle mouseSpeedOption;
+
 static int displayPrivateIndex;
 
 typedef struct _ShiftSlot {
@@ -115,6 +143,8 @@ typedef struct _ShiftScreen {
 	ShiftState state;
 	ShiftType type;
 
+	Bool occlusionHook;
+
 	Bool moreAdjust;
 	Bool moveAdjust;
 
@@ -218,9 +248,8 @@ isShiftWin (CompWindow *w)
 		return FALSE;
 
 	const BananaValue *
-	option_minimized = bananaGetOption (bananaIndex,
-	                                    "minimized",
-	                                    w->screen->screenNum);
+	option_minimized = bananaGetOptionByHandle (minimizedOption,
+	                                            w->screen->screenNum);
 
 	if (!w->mapNum || w->attrib.map_state != IsViewable)
 	{
@@ -282,17 +311,15 @@ shiftRenderWindowTitle (CompScreen *s)
 	shiftFreeWindowTitle (s);
 
 	const BananaValue *
-	option_window_title = bananaGetOption (bananaIndex,
-	                                       "window_title",
-	                                       s->screenNum);
+	option_window_title = bananaGetOptionByHandle (windowTitleOption,
+	                                               s->screenNum);
 
 	if (!option_window_title->b)
 		return;
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           s->screenNum);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   s->screenNum);
 
 	if (option_multioutput_mode->i == 2) //one big switcher
 	{
@@ -304,27 +331,23 @@ shiftRenderWindowTitle (CompScreen *s)
 		getCurrentOutputExtents (s, &ox1, &oy1, &ox2, &oy2);
 
 	const BananaValue *
-	option_title_font_size = bananaGetOption (bananaIndex,
-	                                          "title_font_size",
-	                                          s->screenNum);
+	option_title_font_size = bananaGetOptionByHandle (titleFontSizeOption,
+	                                                  s->screenNum);
 
 	const BananaValue *
-	option_title_font_color = bananaGetOption (bananaIndex,
-	                                           "title_font_color",
-	                                           s->screenNum);
+	option_title_font_color = bananaGetOptionByHandle (titleFontColorOption,
+	                                                   s->screenNum);
 
 	unsigned short font_color[] = { 0, 0, 0, 0 };
 
 	stringToColor (option_title_font_color->s, font_color);
 
 	const BananaValue *
-	option_title_back_color = bananaGetOption (bananaIndex,
-	                                           "title_back_color",
-	                                           s->screenNum);
+	option_title_back_color = bananaGetOptionByHandle (titleBackColorOption,
+	                                                   s->screenNum);
 	const BananaValue *
-	option_title_font_family = bananaGetOption (bananaIndex,
-	                                          "title_font_family",
-	                                          s->screenNum);
+	option_title_font_family = bananaGetOptionByHandle (titleFontFamilyOption,
+	                                                    s->screenNum);
 
 	unsigned short back_color[] = { 0, 0, 0, 0 };
 
@@ -342,9 +365,8 @@ shiftRenderWindowTitle (CompScreen *s)
 	tA.color[3] = font_color[3];
 
 	const BananaValue *
-	option_title_font_bold = bananaGetOption (bananaIndex,
-	                                          "title_font_bold",
-	                                          s->screenNum);
+	option_title_font_bold = bananaGetOptionByHandle (titleFontBoldOption,
+	                                                  s->screenNum);
 
 	tA.flags = CompTextFlagWithBackground | CompTextFlagEllipsized;
 	if (option_title_font_bold->b)
@@ -375,9 +397,8 @@ shiftDrawWindowTitle (CompScreen *s)
 	height = ss->textData->height;
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           s->screenNum);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   s->screenNum);
 
 	if (option_multioutput_mode->i == 2) //one big switcher
 	{
@@ -397,9 +418,8 @@ shiftDrawWindowTitle (CompScreen *s)
 	float y;
 
 	const BananaValue *
-	option_title_text_placement = bananaGetOption (bananaIndex,
-	                                               "title_text_placement",
-	                                               s->screenNum);
+	option_title_text_placement =
+	    bananaGetOptionByHandle (titleTextPlacementOption, s->screenNum);
 
 	/* assign y (for the lower corner!) according to the setting */
 	switch (option_title_text_placement->i)
@@ -541,9 +561,8 @@ shiftPaintWindow (CompWindow             *w,
 		}
 
 		const BananaValue *
-		option_overlay_icon = bananaGetOption (bananaIndex,
-		                                       "overlay_icon",
-		                                       s->screenNum);
+		option_overlay_icon = bananaGetOptionByHandle (overlayIconOption,
+		                                               s->screenNum);
 
 		if (scaled && ((option_overlay_icon->i != 0) || //overlay icon none
 		               !w->texture->pixmap))
@@ -789,9 +808,8 @@ layoutThumbsCover (CompScreen *s)
 	int ox1, ox2, oy1, oy2;
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           s->screenNum);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   s->screenNum);
 
 	if (option_multioutput_mode->i == 2) //one big switcher
 	{
@@ -813,9 +831,7 @@ layoutThumbsCover (CompScreen *s)
 	int centerY = oy1 + (oy2 - oy1) / 2;
 
 	const BananaValue *
-	option_size = bananaGetOption (bananaIndex,
-	                               "size",
-	                               s->screenNum);
+	option_size = bananaGetOptionByHandle (sizeOption, s->screenNum);
 
 	ss->maxThumbWidth  = (ox2 - ox1) * option_size->i / 100;
 	ss->maxThumbHeight = (oy2 - oy1) * option_size->i / 100;
@@ -850,9 +866,8 @@ layoutThumbsCover (CompScreen *s)
 		for (i = 0; i < 2; i++)
 		{
 			const BananaValue *
-			option_cover_offset = bananaGetOption (bananaIndex,
-			                                       "cover_offset",
-			                                       s->screenNum);
+			option_cover_offset = bananaGetOptionByHandle (coverOffsetOption,
+			                                               s->screenNum);
 
 			if (ss->invert ^ (i == 0))
 			{
@@ -949,9 +964,8 @@ layoutThumbsFlip (CompScreen *s)
 	int ox1, ox2, oy1, oy2;
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           s->screenNum);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   s->screenNum);
 
 	if (option_multioutput_mode->i == 2) //one big switcher
 	{
@@ -973,9 +987,7 @@ layoutThumbsFlip (CompScreen *s)
 	int centerY = oy1 + (oy2 - oy1) / 2;
 
 	const BananaValue *
-	option_size = bananaGetOption (bananaIndex,
-	                               "size",
-	                               s->screenNum);
+	option_size = bananaGetOptionByHandle (sizeOption, s->screenNum);
 
 	ss->maxThumbWidth  = (ox2 - ox1) * option_size->i / 100;
 	ss->maxThumbHeight = (oy2 - oy1) * option_size->i / 100;
@@ -1001,9 +1013,8 @@ layoutThumbsFlip (CompScreen *s)
 			yScale = 1.0f;
 
 		const BananaValue *
-		option_flip_rotation = bananaGetOption (bananaIndex,
-		                                        "flip_rotation",
-		                                        s->screenNum);
+		option_flip_rotation = bananaGetOptionByHandle (flipRotationOption,
+		                                                s->screenNum);
 
 		angle = option_flip_rotation->i * PI / 180.0;
 
@@ -1052,9 +1063,8 @@ layoutThumbsFlip (CompScreen *s)
 			sw->slots[i].z *= (ss->maxThumbWidth / (2.0 * (ox2 - ox1)));
 
 			const BananaValue *
-			option_flip_rotation = bananaGetOption (bananaIndex,
-			                                        "flip_rotation",
-			                                        s->screenNum);
+			option_flip_rotation = bananaGetOptionByHandle (flipRotationOption,
+			                                                s->screenNum);
 
 			sw->slots[i].rotation = option_flip_rotation->i;
 
@@ -1088,9 +1098,7 @@ layoutThumbs (CompScreen *s)
 		return FALSE;
 
 	const BananaValue *
-	option_mode = bananaGetOption (bananaIndex,
-	                               "mode",
-	                               s->screenNum);
+	option_mode = bananaGetOptionByHandle (modeOption, s->screenNum);
 
 	switch (option_mode->i)
 	{
@@ -1166,9 +1174,7 @@ shiftUpdateWindowList (CompScreen *s)
 	/* create spetial window order to create a good animation
 	   A,B,C,D,E --> A,B,D,E,C to get B,D,E,C,(A),B,D,E,C as initial state */
 	const BananaValue *
-	option_mode = bananaGetOption (bananaIndex,
-	                               "mode",
-	                               s->screenNum);
+	option_mode = bananaGetOptionByHandle (modeOption, s->screenNum);
 
 	if (option_mode->i == 0) //mode cover
 	{
@@ -1345,9 +1351,8 @@ adjustShiftWindowAttribs (CompWindow *w,
 	SHIFT_SCREEN (w->screen);
 
 	const BananaValue *
-	option_hide_all = bananaGetOption (bananaIndex,
-	                                   "hide_all",
-	                                   w->screen->screenNum);
+	option_hide_all = bananaGetOptionByHandle (hideAllOption,
+	                                           w->screen->screenNum);
 
 	if ((sw->active && ss->state != ShiftStateIn &&
 	     ss->state != ShiftStateNone) ||
@@ -1359,9 +1364,9 @@ adjustShiftWindowAttribs (CompWindow *w,
 		opacity = 1.0;
 
 	const BananaValue *
-	option_background_intensity = bananaGetOption (bananaIndex,
-	                                               "background_intensity",
-	                                               w->screen->screenNum);
+	option_background_intensity =
+	    bananaGetOptionByHandle (backgroundIntensityOption,
+	                             w->screen->screenNum);
 
 	if (ss->state == ShiftStateIn || ss->state == ShiftStateNone)
 		brightness = 1.0;
@@ -1468,19 +1473,15 @@ shiftPaintOutput (CompScreen              *s,
 	    (output->id == ss->usedOutput || output->id == ~0))
 	{
 		const BananaValue *
-		option_size = bananaGetOption (bananaIndex,
-		                               "size",
-		                               s->screenNum);
+		option_size = bananaGetOptionByHandle (sizeOption, s->screenNum);
 
 		const BananaValue *
-		option_multioutput_mode = bananaGetOption (bananaIndex,
-		                                           "multioutput_mode",
-		                                           s->screenNum);
+		option_multioutput_mode =
+		    bananaGetOptionByHandle (multioutputModeOption, s->screenNum);
 
 		const BananaValue *
-		option_reflection = bananaGetOption (bananaIndex,
-		                                     "reflection",
-		                                     s->screenNum);
+		option_reflection = bananaGetOptionByHandle (reflectionOption,
+		                                             s->screenNum);
 
 		CompWindow    *w;
 		CompTransform sTransform = *transform;
@@ -1520,9 +1521,8 @@ shiftPaintOutput (CompScreen              *s,
 			glCullFace (cullInv);
 
 			const BananaValue *
-			option_mipmaps = bananaGetOption (bananaIndex,
-			                                  "mipmaps",
-			                                  s->screenNum);
+			option_mipmaps = bananaGetOptionByHandle (mipmapsOption,
+			                                          s->screenNum);
 
 			if (option_mipmaps->b)
 				display.textureFilter = GL_LINEAR_MIPMAP_LINEAR;
@@ -1534,9 +1534,8 @@ shiftPaintOutput (CompScreen              *s,
 			}
 
 			const BananaValue *
-			option_intensity = bananaGetOption (bananaIndex,
-			                                    "intensity",
-			                                    s->screenNum);
+			option_intensity = bananaGetOptionByHandle (intensityOption,
+			                                            s->screenNum);
 
 			ss->reflectActive = TRUE;
 			ss->reflectBrightness = option_intensity->f;
@@ -1572,25 +1571,22 @@ shiftPaintOutput (CompScreen              *s,
 			glEnd();
 
 			const BananaValue *
-			option_ground_size = bananaGetOption (bananaIndex,
-			                                      "ground_size",
-			                                      s->screenNum);
+			option_ground_size = bananaGetOptionByHandle (groundSizeOption,
+			                                              s->screenNum);
 
 			if (option_ground_size->f > 0.0)
 			{
 				const BananaValue *
-				option_ground_color1 = bananaGetOption (bananaIndex,
-				                                        "ground_color1",
-				                                        s->screenNum);
+				option_ground_color1 =
+				    bananaGetOptionByHandle (groundColor1Option, s->screenNum);
 
 				unsigned short ground_color1[] = { 0, 0, 0, 0 };
 
 				stringToColor (option_ground_color1->s, ground_color1);
 
 				const BananaValue *
-				option_ground_color2 = bananaGetOption (bananaIndex,
-				                                        "ground_color2",
-				                                        s->screenNum);
+				option_ground_color2 =
+				    bananaGetOptionByHandle (groundColor2Option, s->screenNum);
 
 				unsigned short ground_color2[] = { 0, 0, 0, 0 };
 
@@ -1695,9 +1691,8 @@ shiftPaintScreen (CompScreen   *s,
 	SHIFT_SCREEN (s);
 
 	const BananaValue *
-	option_multioutput_mode = bananaGetOption (bananaIndex,
-	                                           "multioutput_mode",
-	                                           s->screenNum);
+	option_multioutput_mode = bananaGetOptionByHandle (multioutputModeOption,
+	                                                   s->screenNum);
 
 	if (ss->state != ShiftStateNone && numOutputs > 0 &&
 	    option_multioutput_mode->i != 0) //multioutput mode disabled
@@ -1726,14 +1721,12 @@ shiftPreparePaintScreen (CompScreen *s,
 		int i;
 
 		const BananaValue *
-		option_shift_speed = bananaGetOption (bananaIndex,
-		                                      "shift_speed",
-		                                      s->screenNum);
+		option_shift_speed = bananaGetOptionByHandle (shiftSpeedOption,
+		                                              s->screenNum);
 
 		const BananaValue *
-		option_timestep = bananaGetOption (bananaIndex,
-		                                   "timestep",
-		                                   s->screenNum);
+		option_timestep = bananaGetOptionByHandle (timestepOption,
+		                                           s->screenNum);
 
 		amount = msSinceLastPaint * 0.05f * option_shift_speed->f;
 		steps  = amount / (0.5f * option_timestep->f);
@@ -1750,9 +1743,7 @@ shiftPreparePaintScreen (CompScreen *s,
 		}
 
 		const BananaValue *
-		option_speed = bananaGetOption (bananaIndex,
-		                                "speed",
-		                                s->screenNum);
+		option_speed = bananaGetOptionByHandle (speedOption, s->screenNum);
 
 		amount = msSinceLastPaint * 0.05f * option_speed->f;
 		steps  = amount / (0.5f * option_timestep->f);
@@ -1785,6 +1776,9 @@ shiftPreparePaintScreen (CompScreen *s,
 		}
 	}
 
+	setScreenOcclusionHook (s, &ss->occlusionHook,
+	                        ss->state != ShiftStateNone);
+
 	UNWRAP (ss, s, preparePaintScreen);
 	(*s->preparePaintScreen)(s, msSinceLastPaint);
 	WRAP (ss, s, preparePaintScreen, shiftPreparePaintScreen);
@@ -2256,9 +2250,9 @@ shiftHandleEvent (XEvent *event)
 				if (event->xbutton.button == Button1 && ss->buttonPressed)
 				{
 					const BananaValue *
-					option_click_duration = bananaGetOption (bananaIndex,
-					                                         "click_duration",
-					                                         s->screenNum);
+					option_click_duration =
+					    bananaGetOptionByHandle (clickDurationOption,
+					                             s->screenNum);
 
 					int new;
 
@@ -2316,14 +2310,13 @@ shiftHandleEvent (XEvent *event)
 					int new;
 
 					const BananaValue *
-					option_mode = bananaGetOption (bananaIndex,
-					                               "mode",
-					                               s->screenNum);
+					option_mode = bananaGetOptionByHandle (modeOption,
+					                                       s->screenNum);
 
 					const BananaValue *
-					option_mouse_speed = bananaGetOption (bananaIndex,
-					                                      "mouse_speed",
-					                                      s->screenNum);
+					option_mouse_speed =
+					    bananaGetOptionByHandle (mouseSpeedOption,
+					                             s->screenNum);
 
 					switch (option_mode->i)
 					{
@@ -2561,6 +2554,8 @@ shiftInitScreen (CompPlugin *p,
 
 	ss->state = ShiftStateNone;
 
+	ss->occlusionHook = FALSE;
+
 	ss->windows = NULL;
 	ss->windowsSize = 0;
 
@@ -2625,6 +2620,8 @@ shiftFiniScreen (CompPlugin *p,
 	UNWRAP (ss, s, paintWindow);
 	UNWRAP (ss, s, damageWindowRect);
 
+	setScreenOcclusionHook (s, &ss->occlusionHook, FALSE);
+
 	matchFini (&ss->window_match);
 
 	shiftFreeWindowTitle (s);
@@ -2744,6 +2741,42 @@ shiftInit (CompPlugin *p)
 
 	bananaAddChangeNotifyCallBack (bananaIndex, shiftChangeNotify);
 
+	minimizedOption = bananaGetOptionHandle (bananaIndex, "minimized");
+	windowTitleOption = bananaGetOptionHandle (bananaIndex, "window_title");
+	multioutputModeOption =
+	    bananaGetOptionHandle (bananaIndex, "multioutput_mode");
+	titleFontSizeOption =
+	    bananaGetOptionHandle (bananaIndex, "title_font_size");
+	titleFontColorOption =
+	    bananaGetOptionHandle (bananaIndex, "title_font_color");
+	titleBackColorOption =
+	    bananaGetOptionHandle (bananaIndex, "title_back_color");
+	titleFontFamilyOption =
+	    bananaGetOptionHandle (bananaIndex, "title_font_family");
+	titleFontBoldOption =
+	    bananaGetOptionHandle (bananaIndex, "title_font_bold");
+	titleTextPlacementOption =
+	    bananaGetOptionHandle (bananaIndex, "title_text_placement");
+	overlayIconOption = bananaGetOptionHandle (bananaIndex, "overlay_icon");
+	sizeOption = bananaGetOptionHandle (bananaIndex, "size");
+	coverOffsetOption = bananaGetOptionHandle (bananaIndex, "cover_offset");
+	flipRotationOption = bananaGetOptionHandle (bananaIndex, "flip_rotation");
+	modeOption = bananaGetOptionHandle (bananaIndex, "mode");
+	hideAllOption = bananaGetOptionHandle (bananaIndex, "hide_all");
+	backgroundIntensityOption =
+	    bananaGetOptionHandle (bananaIndex, "background_intensity");
+	reflectionOption = bananaGetOptionHandle (bananaIndex, "reflection");
+	mipmapsOption = bananaGetOptionHandle (bananaIndex, "mipmaps");
+	intensityOption = bananaGetOptionHandle (bananaIndex, "intensity");
+	groundSizeOption = bananaGetOptionHandle (bananaIndex, "ground_size");
+	groundColor1Option = bananaGetOptionHandle (bananaIndex, "ground_color1");
+	groundColor2Option = bananaGetOptionHandle (bananaIndex, "ground_color2");
+	shiftSpeedOption = bananaGetOptionHandle (bananaIndex, "shift_speed");
+	timestepOption = bananaGetOptionHandle (bananaIndex, "timestep");
+	speedOption = bananaGetOptionHandle (bananaIndex, "speed");
+	clickDurationOption = bananaGetOptionHandle (bananaIndex, "click_duration");
+	mouseSpeedOption = bananaGetOptionHandle (bananaIndex, "mouse_speed");
+
 	return TRUE;
 }
 
@@ -2053,6 +2053,8 @@ switchInitScreen (CompPlugin *p,
 	WRAP (ss, s, paintWindow, switchPaintWindow);
 	WRAP (ss, s, damageWindowRect, switchDamageWindowRect);
 
+	s->occlusionHooks++;
+
 	s->privates[sd->screenPrivateIndex].ptr = ss;
 
 	return TRUE;
@@ -2070,6 +2072,8 @@ switchFiniScreen (CompPlugin *p,
 	UNWRAP (ss, s, paintWindow);
 	UNWRAP (ss, s, damageWindowRect);
 
+	s->occlusionHooks--;
+
 	if (ss->popupDelayHandle)
 		compRemoveTimeout (ss->popupDelayHandle);
 
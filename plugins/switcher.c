@@ -1907,6 +1907,8 @@ switchInitScreen (CompPlugin *p,
 	WRAP (ss, s, paintWindow, switchPaintWindow);
 	WRAP (ss, s, damageWindowRect, switchDamageWindowRect);
 
+	s->occlusionHooks++;
+
 	s->privates[sd->screenPrivateIndex].ptr = ss;
 
 	return TRUE;
@@ -1924,6 +1926,8 @@ switchFiniScreen (CompPlugin *p,
 	UNWRAP (ss, s, paintWindow);
 	UNWRAP (ss, s, damageWindowRect);
 
+	s->occlusionHooks--;
+
 	if (ss->popupWindow)
 		XDestroyWindow (display.display, ss->popupWindow);
 
@@ -63,6 +63,8 @@ typedef struct _TrailfocusWindow
 {
 	Bool isTfWindow;
 	TfAttrib attribs;
+
+	Bool occlusionHook;
 } TrailfocusWindow;
 
 #define GET_TRAILFOCUS_DISPLAY(d) \
@@ -162,6 +164,10 @@ setWindows (CompScreen *s)
 
 			tw->attribs = ts->inc[i];
 		}
+
+		setWindowOcclusionHook (w, &tw->occlusionHook,
+		                        tw->isTfWindow &&
+		                        tw->attribs.opacity != OPAQUE);
 	}
 }
 
@@ -567,7 +573,8 @@ trailfocusInitWindow (CompPlugin *p,
 
 	w->privates[ts->windowPrivateIndex].ptr = tw;
 
-	tw->isTfWindow = FALSE;
+	tw->isTfWindow    = FALSE;
+	tw->occlusionHook = FALSE;
 
 	return TRUE;
 }
@@ -578,6 +585,8 @@ trailfocusFiniWindow (CompPlugin *p,
 {
 	TRAILFOCUS_WINDOW (w);
 
+	setWindowOcclusionHook (w, &tw->occlusionHook, FALSE);
+
 	free (tw);
 }
 
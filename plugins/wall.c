@@ -50,6 +50,16 @@
 
 static int bananaIndex;
 
+static BananaOptionHandle edgeRadiusOption;
+static BananaOptionHandle slideDurationOption;
+static BananaOptionHandle showSwitcherOption;
+static BananaOptionHandle previewTimeoutOption;
+static BananaOptionHandle allowWraparoundOption;
+static BananaOptionHandle miniscreenOption;
+static BananaOptionHandle mmmodeOption;
+static BananaOptionHandle previewScaleOption;
+static BananaOptionHandle borderWidthOption;
+
 static int displayPrivateIndex;
 
 /* Enums */
@@ -149,6 +159,8 @@ typedef struct _WallScreen
 	ScreenTransformation transform;
 	CompOutput           *currOutput;
 
+	Bool occlusionHook;
+
 	WindowPaintAttrib mSAttribs;
 	float             mSzCamera;
 
@@ -262,9 +274,7 @@ wallDrawSwitcherBackground (CompScreen *s)
 
 	/* draw the border's shape */
 	const BananaValue *
-	option_edge_radius = bananaGetOption (bananaIndex,
-	                                      "edge_radius",
-	                                      -1);
+	option_edge_radius = bananaGetOptionByHandle (edgeRadiusOption, -1);
 
 	radius = option_edge_radius->i;
 	if (radius)
@@ -544,9 +554,7 @@ wallComputeTranslation (CompScreen *s,
 	WALL_SCREEN (s);
 
 	const BananaValue *
-	option_slide_duration = bananaGetOption (bananaIndex,
-	                                         "slide_duration",
-	                                         -1);
+	option_slide_duration = bananaGetOptionByHandle (slideDurationOption, -1);
 
 	duration = option_slide_duration->f * 1000.0;
 	if (duration != 0.0)
@@ -600,9 +608,7 @@ wallInitiate (CompScreen *s)
 	WALL_SCREEN (s);
 
 	const BananaValue *
-	option_show_switcher = bananaGetOption (bananaIndex,
-	                                        "show_switcher",
-	                                        -1);
+	option_show_switcher = bananaGetOptionByHandle (showSwitcherOption, -1);
 
 	ws->showPreview = option_show_switcher->b;
 }
@@ -683,19 +689,13 @@ wallMoveViewport (CompScreen *s,
 	ws->boxOutputDevice = outputDeviceForPoint (s, pointerX, pointerY);
 
 	const BananaValue *
-	option_show_switcher = bananaGetOption (bananaIndex,
-	                                        "show_switcher",
-	                                        -1);
+	option_show_switcher = bananaGetOptionByHandle (showSwitcherOption, -1);
 
 	const BananaValue *
-	option_preview_timeout = bananaGetOption (bananaIndex,
-	                                          "preview_timeout",
-	                                          -1);
+	option_preview_timeout = bananaGetOptionByHandle (previewTimeoutOption, -1);
 
 	const BananaValue *
-	option_slide_duration = bananaGetOption (bananaIndex,
-	                                         "slide_duration",
-	                                         -1);
+	option_slide_duration = bananaGetOptionByHandle (slideDurationOption, -1);
 
 	if (option_show_switcher->b)
 		ws->boxTimeout = option_preview_timeout->f * 1000;
@@ -720,9 +720,8 @@ wallCheckAmount (CompScreen *s,
 	*amountY = -dy;
 
 	const BananaValue *
-	option_allow_wraparound = bananaGetOption (bananaIndex,
-	                                           "allow_wraparound",
-	                                           -1);
+	option_allow_wraparound = bananaGetOptionByHandle (allowWraparoundOption,
+	                                                   -1);
 
 	if (option_allow_wraparound->b)
 	{
@@ -1039,9 +1038,8 @@ wallDrawCairoTextureOnScreen (CompScreen *s)
 		double left, timeout;
 
 		const BananaValue *
-		option_preview_timeout = bananaGetOption (bananaIndex,
-		                                          "preview_timeout",
-		                                          -1);
+		option_preview_timeout = bananaGetOptionByHandle (previewTimeoutOption,
+		                                                  -1);
 
 		timeout = option_preview_timeout->f * 1000.0f;
 		left    = (timeout > 0) ? (float) ws->boxTimeout / timeout : 1.0f;
@@ -1144,9 +1142,7 @@ wallDrawCairoTextureOnScreen (CompScreen *s)
 			   arrow outside the switcher */
 
 			const BananaValue *
-			option_miniscreen = bananaGetOption (bananaIndex,
-			                                     "miniscreen",
-			                                     -1);
+			option_miniscreen = bananaGetOptionByHandle (miniscreenOption, -1);
 
 			if (option_miniscreen->b)
 			{
@@ -1241,9 +1237,7 @@ wallPaintScreen (CompScreen   *s,
 	WALL_SCREEN (s);
 
 	const BananaValue *
-	option_mmmode = bananaGetOption (bananaIndex,
-	                                 "mmmode",
-	                                 s->screenNum);
+	option_mmmode = bananaGetOptionByHandle (mmmodeOption, s->screenNum);
 
 	if (ws->moving && numOutputs > 1 && option_mmmode == MMMODE_SWITCH_ALL)
 	{
@@ -1278,9 +1272,7 @@ wallPaintOutput (CompScreen              *s,
 	WRAP (ws, s, paintOutput, wallPaintOutput);
 
 	const BananaValue *
-	option_show_switcher = bananaGetOption (bananaIndex,
-	                                        "show_switcher",
-	                                        -1);
+	option_show_switcher = bananaGetOptionByHandle (showSwitcherOption, -1);
 
 	if (option_show_switcher->b &&
 	      (ws->moving || ws->showPreview || ws->boxTimeout) &&
@@ -1298,9 +1290,7 @@ wallPaintOutput (CompScreen              *s,
 		glPopMatrix ();
 
 		const BananaValue *
-		option_miniscreen = bananaGetOption (bananaIndex,
-		                                     "miniscreen",
-		                                     -1);
+		option_miniscreen = bananaGetOptionByHandle (miniscreenOption, -1);
 
 		if (option_miniscreen->b)
 		{
@@ -1417,6 +1407,11 @@ wallPreparePaintScreen (CompScreen *s,
 		}
 	}
 
+	/* sliding viewports and the mini screens of the switcher paint
+	   windows transformed */
+	setScreenOcclusionHook (s, &ws->occlusionHook,
+	                        ws->moving || ws->showPreview || ws->boxTimeout);
+
 	UNWRAP (ws, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (ws, s, preparePaintScreen, wallPreparePaintScreen);
@@ -1670,14 +1665,10 @@ wallCreateCairoContexts (CompScreen *s,
 	WALL_SCREEN (s);
 
 	const BananaValue *
-	option_preview_scale = bananaGetOption (bananaIndex,
-	                                        "preview_scale",
-	                                        -1);
+	option_preview_scale = bananaGetOptionByHandle (previewScaleOption, -1);
 
 	const BananaValue *
-	option_border_width = bananaGetOption (bananaIndex,
-	                                       "border_width",
-	                                       -1);
+	option_border_width = bananaGetOptionByHandle (borderWidthOption, -1);
 
 	ws->viewportWidth = VIEWPORT_SWITCHER_SIZE *
 	                    (float) option_preview_scale->i / 100.0f;
@@ -2116,6 +2107,8 @@ wallInitScreen (CompPlugin *p,
 	ws->transform  = NoTransformation;
 	ws->direction  = -1;
 
+	ws->occlusionHook = FALSE;
+
 	memset (&ws->switcherContext, 0, sizeof (WallCairoContext));
 	memset (&ws->thumbContext, 0, sizeof (WallCairoContext));
 	memset (&ws->highlightContext, 0, sizeof (WallCairoContext));
@@ -2164,6 +2157,8 @@ wallFiniScreen (CompPlugin *p,
 	UNWRAP (ws, s, windowUngrabNotify);
 	UNWRAP (ws, s, activateWindow);
 
+	setScreenOcclusionHook (s, &ws->occlusionHook, FALSE);
+
 	freeWindowPrivateIndex (s, ws->windowPrivateIndex);
 
 	free (ws);
@@ -2226,6 +2221,18 @@ wallInit (CompPlugin *p)
 
 	bananaAddChangeNotifyCallBack (bananaIndex, wallChangeNotify);
 
+	edgeRadiusOption = bananaGetOptionHandle (bananaIndex, "edge_radius");
+	slideDurationOption = bananaGetOptionHandle (bananaIndex, "slide_duration");
+	showSwitcherOption = bananaGetOptionHandle (bananaIndex, "show_switcher");
+	previewTimeoutOption =
+	    bananaGetOptionHandle (bananaIndex, "preview_timeout");
+	allowWraparoundOption =
+	    bananaGetOptionHandle (bananaIndex, "allow_wraparound");
+	miniscreenOption = bananaGetOptionHandle (bananaIndex, "miniscreen");
+	mmmodeOption = bananaGetOptionHandle (bananaIndex, "mmmode");
+	previewScaleOption = bananaGetOptionHandle (bananaIndex, "preview_scale");
+	borderWidthOption = bananaGetOptionHandle (bananaIndex, "border_width");
+
 	bananaAddChangeNotifyCallBack (coreBananaIndex, coreChangeNotify);
 
 	return TRUE;
@@ -57,6 +57,7 @@ typedef struct _WallpaperBackground {
 	CompTexture    imgTex;
 	unsigned int   width;
 	unsigned int   height;
+	CompImageLoadHandle imageLoad;
 
 	CompTexture    fillTex;
 } WallpaperBackground;
@@ -229,6 +230,31 @@ updateProperty(CompScreen *s)
 	}
 }
 
+static void
+imageLoaded (CompScreen   *s,
+             CompTexture  *texture,
+             Bool         status,
+             unsigned int width,
+             unsigned int height,
+             void         *closure)
+{
+	WallpaperBackground *back = closure;
+
+	back->imageLoad = 0;
+
+	if (!status)
+	{
+		compLogMessage ("wallpaper", CompLogLevelWarn,
+		                "Failed to load image: %s", back->image);
+		return;
+	}
+
+	back->width  = width;
+	back->height = height;
+
+	damageScreen (s);
+}
+
 static void
 initBackground (WallpaperBackground *back,
                 CompScreen          *s)
@@ -242,21 +268,12 @@ initBackground (WallpaperBackground *back,
 	back->width = 0;
 	back->height = 0;
 
+	/* only the fill is painted until the image is loaded */
+	back->imageLoad = 0;
 	if (back->image && strlen (back->image))
-	{
-		if (!readImageToTexture (s, &back->imgTex, back->image,
-		                         &back->width, &back->height))
-		{
-			compLogMessage ("wallpaper", CompLogLevelWarn,
-			                "Failed to load image: %s", back->image);
-
-			back->width  = 0;
-			back->height = 0;
-
-			finiTexture (s, &back->imgTex);
-			initTexture (s, &back->imgTex);
-		}
-	}
+		back->imageLoad = readImageToTextureAsync (s, &back->imgTex,
+		                                           back->image,
+		                                           imageLoaded, back);
 
 	color = back->color1;
 	c[0] = ((color[3] << 16) & 0xff000000) |
@@ -292,6 +309,8 @@ static void
 finiBackground (WallpaperBackground *back,
                 CompScreen          *s)
 {
+	cancelImageLoad (back->imageLoad);
+
 	finiTexture (s, &back->imgTex);
 	finiTexture (s, &back->fillTex);
 }
@@ -104,6 +104,8 @@ typedef struct _WaterScreen {
 	float         *d1;
 	unsigned char *t0;
 
+	CompTextureUpload *upload;
+
 	CompTimeoutHandle rainHandle;
 	CompTimeoutHandle wiperHandle;
 
@@ -606,7 +608,7 @@ softwareUpdate (CompScreen *s,
 	int        i, j;
 	float      v0, v1, inv;
 	float      accel, value;
-	unsigned char *t0, *t;
+	unsigned char *t0, *t, *normalMap;
 	int        dWidth, dHeight;
 	float      *d01, *d10, *d11, *d12;
 
@@ -670,7 +672,18 @@ softwareUpdate (CompScreen *s,
 	d11 = d10 + dWidth;
 	d12 = d11 + dWidth;
 
-	t0 = ws->t0;
+	/* every pixel of the normal map is written below, straight into
+	   the memory that it is uploaded from */
+	if (!ws->upload)
+		ws->upload = createTextureUpload (s, ws->width, ws->height);
+
+	normalMap = NULL;
+	if (ws->upload)
+		normalMap = beginTextureUpload (s, ws->upload);
+	if (!normalMap)
+		normalMap = ws->t0;
+
+	t0 = normalMap;
 
 	/* update texture */
 	for (i = 0; i < ws->height; i++)
@@ -713,22 +726,31 @@ softwareUpdate (CompScreen *s,
 
 	if (ws->texture[TINDEX (ws, 0)])
 	{
+		if (normalMap != ws->t0)
+		{
+			endTextureUpload (s, ws->upload,
+			                  ws->target, ws->texture[TINDEX (ws, 0)],
+			                  0, 0, ws->width, ws->height);
+			return;
+		}
+
 		glBindTexture (ws->target, ws->texture[TINDEX (ws, 0)]);
-		glTexImage2D (ws->target,
-		              0,
-		              GL_RGBA,
-		              ws->width,
-		              ws->height,
-		              0,
-		              GL_BGRA,
+		glTexSubImage2D (ws->target,
+		                 0,
+		                 0,
+		                 0,
+		                 ws->width,
+		                 ws->height,
+		                 GL_BGRA,
 
 #if IMAGE_BYTE_ORDER == MSBFirst
-		              GL_UNSIGNED_INT_8_8_8_8_REV,
+		                 GL_UNSIGNED_INT_8_8_8_8_REV,
 #else
-		              GL_UNSIGNED_BYTE,
+		                 GL_UNSIGNED_BYTE,
 #endif
 
-		              ws->t0);
+		                 ws->t0);
+		glBindTexture (ws->target, 0);
 	}
 }
 
@@ -994,6 +1016,9 @@ waterReset (CompScreen *s)
 		}
 	}
 
+	destroyTextureUpload (s, ws->upload);
+	ws->upload = NULL;
+
 	if (ws->data)
 		free (ws->data);
 
@@ -1023,9 +1048,24 @@ waterDrawWindowTexture (CompWindow           *w,
                         const FragmentAttrib *attrib,
                         unsigned int         mask)
 {
+	Bool ripple;
+
 	WATER_SCREEN (w->screen);
 
-	if (ws->count)
+	ripple = ws->count != 0;
+
+	/* the ripples move texture coordinates further than the padding of
+	   an atlas slot reaches, keep the window out of the atlas while they
+	   last and draw its slot without them until then */
+	if (ripple && isWindowContentTexture (w, texture))
+	{
+		w->atlasHold = ATLAS_RESIZE_HOLD;
+
+		if (texture != w->texture)
+			ripple = FALSE;
+	}
+
+	if (ripple)
 	{
 		FragmentAttrib fa = *attrib;
 		Bool           lighting = w->screen->lighting;
@@ -1641,6 +1681,8 @@ waterFiniScreen (CompPlugin *p,
 	if (ws->program)
 		(*s->deletePrograms) (1, &ws->program);
 
+	destroyTextureUpload (s, ws->upload);
+
 	if (ws->data)
 		free (ws->data);
 
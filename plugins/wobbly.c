@@ -140,6 +140,7 @@ typedef struct _WobblyScreen {
 	WindowUngrabNotifyProc windowUngrabNotify;
 
 	Bool wobblyWindows;
+	Bool occlusionHook;
 
 	unsigned int grabMask;
 	CompWindow   *grabWindow;
@@ -1759,6 +1760,8 @@ wobblyPreparePaintScreen (CompScreen *s,
 			ws->grabWindowWorkArea = NULL;
 	}
 
+	setScreenOcclusionHook (s, &ws->occlusionHook, ws->wobblyWindows);
+
 	UNWRAP (ws, s, preparePaintScreen);
 	(*s->preparePaintScreen) (s, msSinceLastPaint);
 	WRAP (ws, s, preparePaintScreen, wobblyPreparePaintScreen);
@@ -1876,7 +1879,8 @@ wobblyAddWindowGeometry (CompWindow *w,
 		nClip = region->numRects;
 		pClip = region->rects;
 
-		w->texUnits = nMatrix;
+		w->texUnits           = nMatrix;
+		w->geometryGeneration = 0;
 
 		vSize = 3 + nMatrix * 2;
 
@@ -2842,6 +2846,7 @@ wobblyInitScreen (CompPlugin *p,
 	}
 
 	ws->wobblyWindows = FALSE;
+	ws->occlusionHook = FALSE;
 
 	ws->grabMask   = 0;
 	ws->grabWindow = NULL;
@@ -2920,6 +2925,8 @@ wobblyFiniScreen (CompPlugin *p,
 	UNWRAP (ws, s, windowGrabNotify);
 	UNWRAP (ws, s, windowUngrabNotify);
 
+	setScreenOcclusionHook (s, &ws->occlusionHook, FALSE);
+
 	matchFini (&ws->map_window_match);
 	matchFini (&ws->focus_window_match);
 	matchFini (&ws->grab_window_match);
@@ -176,6 +176,10 @@ workaroundsProgramEnvParameter4f (GLenum target,
 	data[2] = z;
 	data[3] = w;
 
+	/* GLSL fragment functions read their parameters from core */
+	if (target == GL_FRAGMENT_PROGRAM_ARB)
+		storeFragmentEnvParameter (index, x, y, z, w);
+
 	(*ws->programEnvParameter4dv) (target, index, data);
 }
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <dlfcn.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Bump allocator for memory that only lives until the end of a frame.
+ *
+ * Allocations are served from a single block. When the block is full,
+ * the allocation gets its own heap chunk instead, and the next reset
+ * grows the block to the total size used in that frame. After a few
+ * frames the block fits the whole frame and no heap allocations are
+ * made at all.
+ */
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_SIZE 4096
+
+/* the allocation follows the header at the next ARENA_ALIGN boundary */
+typedef struct _CompArenaChunk {
+	struct _CompArenaChunk *next;
+} CompArenaChunk;
+
+void
+initArena (CompArena *arena)
+{
+	arena->data     = NULL;
+	arena->size     = 0;
+	arena->used     = 0;
+	arena->total    = 0;
+	arena->overflow = NULL;
+}
+
+static void
+freeArenaOverflow (CompArena *arena)
+{
+	CompArenaChunk *chunk, *next;
+
+	for (chunk = arena->overflow; chunk; chunk = next)
+	{
+		next = chunk->next;
+		free (chunk);
+	}
+
+	arena->overflow = NULL;
+}
+
+void
+finiArena (CompArena *arena)
+{
+	freeArenaOverflow (arena);
+
+	if (arena->data)
+		free (arena->data);
+
+	initArena (arena);
+}
+
+void *
+arenaAlloc (CompArena *arena,
+            size_t    size)
+{
+	CompArenaChunk *chunk;
+	void           *data;
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+
+	arena->total += size;
+
+	if (arena->used + size <= arena->size)
+	{
+		data = arena->data + arena->used;
+		arena->used += size;
+
+		return data;
+	}
+
+	chunk = malloc (ARENA_ALIGN + size);
+	if (!chunk)
+		return NULL;
+
+	chunk->next     = arena->overflow;
+	arena->overflow = chunk;
+
+	return (char *) chunk + ARENA_ALIGN;
+}
+
+void
+resetArena (CompArena *arena)
+{
+	if (arena->overflow)
+	{
+		size_t size = arena->size ? arena->size : ARENA_MIN_SIZE;
+		char   *data;
+
+		freeArenaOverflow (arena);
+
+		while (size < arena->total)
+			size *= 2;
+
+		/* nothing allocated from the old block is alive anymore */
+		data = malloc (size);
+		if (data)
+		{
+			if (arena->data)
+				free (arena->data);
+
+			arena->data = data;
+			arena->size = size;
+		}
+	}
+
+	arena->used  = 0;
+	arena->total = 0;
+}
+
+void *
+allocFrameMemory (CompScreen *s,
+                  size_t     size)
+{
+	return arenaAlloc (&s->frameArena, size);
+}
+
+/* Heap allocations are counted by bench/fusilli-alloc-count.so when it
+   is preloaded, as make bench does. Returns FALSE if nothing counts
+   them. */
+Bool
+getHeapAllocationCount (unsigned long *count)
+{
+	static unsigned long (*counter) (void) = NULL;
+	static Bool          checked = FALSE;
+
+	if (!checked)
+	{
+		counter = (unsigned long (*) (void))
+			dlsym (RTLD_DEFAULT, "fusilliHeapAllocationCount");
+		checked = TRUE;
+	}
+
+	if (!counter)
+		return FALSE;
+
+	*count = (*counter) ();
+
+	return TRUE;
+}
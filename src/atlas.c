@@ -0,0 +1,514 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Texture atlas for small windows.
+ *
+ * Menus, tooltips and notifications are drawn from their own texture
+ * from pixmap, and with strict binding every one of them is bound and
+ * released again for every frame. With the texture_atlas option small
+ * windows are copied into a few shared textures instead, with an FBO at
+ * the start of a frame, and drawn from there until they are damaged.
+ * A whole window is copied, which is cheap at this size and saves
+ * keeping track of damage regions.
+ *
+ * A page is split into shelves. Every shelf has one cell size, the
+ * power of two sizes of the window plus a pixel of padding on every
+ * side, so the padding repeats the edges of a window and filtering
+ * doesn't pick up the neighbours. Cells are freed when the window
+ * pixmap is released and a page when it is empty.
+ *
+ * Windows that are larger than ATLAS_MAX_WINDOW_SIZE, that were just
+ * resized or that are drawn transformed with mipmaps keep using their
+ * texture from pixmap.
+ */
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_MIN_CELL  16
+#define ATLAS_MAX_PAGES 4
+#define ATLAS_MAX_CELLS (ATLAS_PAGE_SIZE / ATLAS_MIN_CELL)
+
+typedef struct _CompAtlasShelf {
+	int           y;
+	int           height;
+	int           cellWidth;
+	unsigned char used[ATLAS_MAX_CELLS];
+} CompAtlasShelf;
+
+struct _CompAtlasPage {
+	struct _CompAtlasPage *next;
+
+	CompTexture    texture;
+	int            size;
+	CompAtlasShelf shelf[ATLAS_MAX_CELLS];
+	int            nShelf;
+	int            top;
+	int            nSlot;
+};
+
+struct _CompAtlasSlot {
+	CompAtlasPage *page;
+	int           shelf;
+	int           cell;
+	int           x, y; /* of the window pixels inside the padding */
+	int           width, height;
+	CompTexture   texture;
+};
+
+static int
+atlasCellSize (int size)
+{
+	int cell = ATLAS_MIN_CELL;
+
+	while (cell < size)
+		cell <<= 1;
+
+	return cell;
+}
+
+static CompAtlasPage *
+createAtlasPage (CompScreen *s)
+{
+	CompAtlasPage *page;
+
+	page = malloc (sizeof (CompAtlasPage));
+	if (!page)
+		return NULL;
+
+	page->size   = MIN (ATLAS_PAGE_SIZE, s->maxTextureSize);
+	page->nShelf = 0;
+	page->top    = 0;
+	page->nSlot  = 0;
+
+	initTexture (s, &page->texture);
+
+	page->texture.target    = GL_TEXTURE_2D;
+	page->texture.matrix.xx = 1.0f / page->size;
+	page->texture.matrix.yy = 1.0f / page->size;
+	page->texture.mipmap    = FALSE;
+
+	glGenTextures (1, &page->texture.name);
+	glBindTexture (GL_TEXTURE_2D, page->texture.name);
+
+	glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, page->size, page->size, 0,
+	              GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture (GL_TEXTURE_2D, 0);
+
+	page->texture.filter = GL_NEAREST;
+	page->texture.wrap   = GL_CLAMP_TO_EDGE;
+
+	return page;
+}
+
+static void
+destroyAtlasPage (CompScreen    *s,
+                  CompAtlasPage *page)
+{
+	CompAtlasPage **prev;
+
+	for (prev = &s->atlasPages; *prev; prev = &(*prev)->next)
+	{
+		if (*prev == page)
+		{
+			*prev = page->next;
+			break;
+		}
+	}
+
+	finiTexture (s, &page->texture);
+	free (page);
+}
+
+static Bool
+allocAtlasCell (CompAtlasPage *page,
+                int           cellWidth,
+                int           cellHeight,
+                int           *shelf,
+                int           *cell)
+{
+	CompAtlasShelf *sh;
+	int            i, j;
+
+	for (i = 0; i < page->nShelf; i++)
+	{
+		sh = &page->shelf[i];
+
+		if (sh->height != cellHeight || sh->cellWidth != cellWidth)
+			continue;
+
+		for (j = 0; j < page->size / cellWidth; j++)
+		{
+			if (!sh->used[j])
+			{
+				*shelf = i;
+				*cell  = j;
+
+				return TRUE;
+			}
+		}
+	}
+
+	if (page->nShelf == ATLAS_MAX_CELLS ||
+	    page->top + cellHeight > page->size)
+		return FALSE;
+
+	sh = &page->shelf[page->nShelf];
+
+	sh->y         = page->top;
+	sh->height    = cellHeight;
+	sh->cellWidth = cellWidth;
+	memset (sh->used, 0, sizeof (sh->used));
+
+	page->top += cellHeight;
+
+	*shelf = page->nShelf++;
+	*cell  = 0;
+
+	return TRUE;
+}
+
+static Bool
+allocWindowAtlas (CompWindow *w)
+{
+	CompScreen    *s = w->screen;
+	CompAtlasPage *page;
+	CompAtlasSlot *slot;
+	int           cellWidth, cellHeight, shelf, cell, nPage = 0;
+
+	cellWidth  = atlasCellSize (w->width + 2);
+	cellHeight = atlasCellSize (w->height + 2);
+
+	for (page = s->atlasPages; page; page = page->next, nPage++)
+		if (allocAtlasCell (page, cellWidth, cellHeight, &shelf, &cell))
+			break;
+
+	if (!page)
+	{
+		if (nPage == ATLAS_MAX_PAGES)
+			return FALSE;
+
+		page = createAtlasPage (s);
+		if (!page)
+			return FALSE;
+
+		page->next    = s->atlasPages;
+		s->atlasPages = page;
+
+		if (!allocAtlasCell (page, cellWidth, cellHeight, &shelf, &cell))
+		{
+			destroyAtlasPage (s, page);
+			return FALSE;
+		}
+	}
+
+	slot = malloc (sizeof (CompAtlasSlot));
+	if (!slot)
+	{
+		if (!page->nSlot)
+			destroyAtlasPage (s, page);
+
+		return FALSE;
+	}
+
+	page->shelf[shelf].used[cell] = TRUE;
+	page->nSlot++;
+
+	slot->page   = page;
+	slot->shelf  = shelf;
+	slot->cell   = cell;
+	slot->x      = cell * cellWidth + 1;
+	slot->y      = page->shelf[shelf].y + 1;
+	slot->width  = w->width;
+	slot->height = w->height;
+
+	/* the page with a matrix that maps the window pixmap to the slot */
+	slot->texture           = page->texture;
+	slot->texture.matrix.x0 = (float) slot->x / page->size;
+	slot->texture.matrix.y0 = (float) slot->y / page->size;
+
+	w->atlasSlot    = slot;
+	w->atlasDamaged = TRUE;
+
+	return TRUE;
+}
+
+void
+releaseWindowAtlas (CompWindow *w)
+{
+	CompAtlasSlot *slot = w->atlasSlot;
+
+	if (!slot)
+		return;
+
+	slot->page->shelf[slot->shelf].used[slot->cell] = FALSE;
+
+	if (!--slot->page->nSlot)
+	{
+		makeScreenCurrent (w->screen);
+		destroyAtlasPage (w->screen, slot->page);
+	}
+
+	free (slot);
+
+	w->atlasSlot = NULL;
+}
+
+static Bool
+windowFitsAtlas (CompWindow *w)
+{
+	if (w->attrib.map_state != IsViewable || w->destroyed || w->invisible)
+		return FALSE;
+
+	if (!w->redirected || !w->damaged || !w->texture->pixmap || w->atlasHold)
+		return FALSE;
+
+	if (w->width > ATLAS_MAX_WINDOW_SIZE || w->height > ATLAS_MAX_WINDOW_SIZE)
+		return FALSE;
+
+	if (w->atlasSlot && (w->atlasSlot->width  != w->width ||
+	                     w->atlasSlot->height != w->height))
+		return FALSE;
+
+	return TRUE;
+}
+
+static Bool
+beginAtlasCopy (CompScreen *s)
+{
+	if (!s->atlasFbo)
+		(*s->genFramebuffers) (1, &s->atlasFbo);
+
+	if (!s->atlasFbo)
+		return FALSE;
+
+	glPushAttrib (GL_VIEWPORT_BIT | GL_ENABLE_BIT);
+
+	glDisable (GL_BLEND);
+	glDisable (GL_SCISSOR_TEST);
+	glDisable (GL_STENCIL_TEST);
+	glDisable (GL_DEPTH_TEST);
+
+	(*s->bindFramebuffer) (GL_FRAMEBUFFER_EXT, s->atlasFbo);
+
+	glMatrixMode (GL_PROJECTION);
+	glPushMatrix ();
+	glLoadIdentity ();
+	glMatrixMode (GL_MODELVIEW);
+	glPushMatrix ();
+	glLoadIdentity ();
+
+	return TRUE;
+}
+
+static void
+endAtlasCopy (CompScreen *s)
+{
+	glMatrixMode (GL_PROJECTION);
+	glPopMatrix ();
+	glMatrixMode (GL_MODELVIEW);
+	glPopMatrix ();
+
+	(*s->bindFramebuffer) (GL_FRAMEBUFFER_EXT, 0);
+
+	glPopAttrib ();
+}
+
+static Bool
+bindAtlasPage (CompScreen    *s,
+               CompAtlasPage *page)
+{
+	(*s->framebufferTexture2D) (GL_FRAMEBUFFER_EXT,
+	                            GL_COLOR_ATTACHMENT0_EXT,
+	                            GL_TEXTURE_2D, page->texture.name, 0);
+
+	if ((*s->checkFramebufferStatus) (GL_FRAMEBUFFER_EXT) !=
+	    GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		compLogMessage ("core", CompLogLevelWarn,
+		                "texture atlas framebuffer incomplete");
+		return FALSE;
+	}
+
+	glViewport (0, 0, page->size, page->size);
+
+	glMatrixMode (GL_PROJECTION);
+	glLoadIdentity ();
+	glOrtho (0.0, page->size, 0.0, page->size, -1.0, 1.0);
+	glMatrixMode (GL_MODELVIEW);
+
+	return TRUE;
+}
+
+/* draws the pixmap with a pixel more on every side, clamping to the
+   edge fills the padding */
+static void
+copyWindowToAtlas (CompWindow *w)
+{
+	CompAtlasSlot *slot = w->atlasSlot;
+	CompMatrix    *m = &w->texture->matrix;
+	int           x1 = -1, y1 = -1;
+	int           x2 = slot->width + 1, y2 = slot->height + 1;
+
+	enableTexture (w->screen, w->texture, COMP_TEXTURE_FILTER_FAST);
+
+	glBegin (GL_QUADS);
+
+	glTexCoord2f (COMP_TEX_COORD_X (m, x1), COMP_TEX_COORD_Y (m, y1));
+	glVertex2i (slot->x + x1, slot->y + y1);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x2), COMP_TEX_COORD_Y (m, y1));
+	glVertex2i (slot->x + x2, slot->y + y1);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x2), COMP_TEX_COORD_Y (m, y2));
+	glVertex2i (slot->x + x2, slot->y + y2);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x1), COMP_TEX_COORD_Y (m, y2));
+	glVertex2i (slot->x + x1, slot->y + y2);
+
+	glEnd ();
+
+	disableTexture (w->screen, w->texture);
+
+	w->atlasDamaged = FALSE;
+}
+
+/* called at the start of a frame, before anything is painted */
+void
+updateScreenAtlas (CompScreen *s)
+{
+	CompAtlasPage *page = NULL;
+	CompWindow    *w;
+	Bool          copying = FALSE;
+
+	const BananaValue *
+	option_texture_atlas = bananaGetOptionByHandle (coreOptionTextureAtlas,
+	                                                s->screenNum);
+
+	if (!option_texture_atlas->b || !s->fbo)
+	{
+		if (s->atlasPages)
+			for (w = s->windows; w; w = w->next)
+				releaseWindowAtlas (w);
+
+		return;
+	}
+
+	for (w = s->windows; w; w = w->next)
+	{
+		if (w->atlasHold)
+			w->atlasHold--;
+
+		if (!windowFitsAtlas (w))
+		{
+			releaseWindowAtlas (w);
+			continue;
+		}
+
+		if (!w->atlasSlot && !allocWindowAtlas (w))
+			continue;
+
+		if (!w->atlasDamaged)
+			continue;
+
+		if (!copying)
+		{
+			if (!beginAtlasCopy (s))
+				return;
+
+			copying = TRUE;
+		}
+
+		if (w->atlasSlot->page != page)
+		{
+			page = w->atlasSlot->page;
+
+			if (!bindAtlasPage (s, page))
+			{
+				page = NULL;
+				releaseWindowAtlas (w);
+				continue;
+			}
+		}
+
+		copyWindowToAtlas (w);
+	}
+
+	if (copying)
+		endAtlasCopy (s);
+}
+
+/* the texture to draw the window from, or NULL if it isn't in an atlas
+   or its copy is out of date */
+CompTexture *
+getWindowAtlasTexture (CompWindow *w)
+{
+	if (!w->atlasSlot || w->atlasDamaged)
+		return NULL;
+
+	/* slots share the GL texture, so the filter that is cached in the
+	   slot isn't necessarily the filter of the texture */
+	w->atlasSlot->texture.filter = GL_NONE;
+
+	return &w->atlasSlot->texture;
+}
+
+/* whether texture holds the contents of w, its own texture or its atlas
+   slot. Slots share the texture name of their page, so plugins can't
+   tell by the name */
+Bool
+isWindowContentTexture (CompWindow  *w,
+                        CompTexture *texture)
+{
+	if (texture->name == w->texture->name)
+		return TRUE;
+
+	return w->atlasSlot && texture == &w->atlasSlot->texture;
+}
+
+void
+finiScreenAtlas (CompScreen *s)
+{
+	CompWindow *w;
+
+	for (w = s->windows; w; w = w->next)
+		releaseWindowAtlas (w);
+
+	while (s->atlasPages)
+		destroyAtlasPage (s, s->atlasPages);
+
+	if (s->atlasFbo)
+		(*s->deleteFramebuffers) (1, &s->atlasFbo);
+}
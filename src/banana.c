@@ -23,16 +23,26 @@
  */
 
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
 #include <string.h>
 #include <libxml/parser.h>
 
 #define EXTENSION ".xml"
 #define MAX_NUM_PLUGINS        256
 #define MAX_NUM_SCREENS        9
+#define RELOAD_DELAY           100 //ms
 
 #include <fusilli-core.h>
 
 static CompFileWatchHandle directoryWatch;
+static CompTimeoutHandle   reloadHandle;
+
+static xmlDocPtr   configurationDoc;
+static struct stat configurationStat;
 
 static char *bananaMetaDataDir;
 static char *bananaConfigurationDir;
@@ -47,6 +57,7 @@ struct _BananaChangeNotifyCallBackNode {
 
 typedef struct _BananaOption {
 	char                    *name;
+	unsigned int            nameHash;
 	BananaType              type;
 	Bool                    isPerScreen;
 
@@ -346,6 +357,33 @@ stringToBananaValue (const char        *s,
 	}
 }
 
+static unsigned int
+bananaHashString (const char *s)
+{
+	unsigned int hash = 5381;
+
+	while (*s)
+		hash = (hash * 33) ^ (unsigned char) *s++;
+
+	return hash;
+}
+
+//returns the position of optionName in p->option, or -1
+static int
+findBananaOption (BananaPlugin *p,
+                  const char   *optionName)
+{
+	unsigned int hash = bananaHashString (optionName);
+	int i;
+
+	for (i = 0; i <= p->nOption - 1; i++)
+		if (p->option[i].nameHash == hash &&
+		    strcmp (p->option[i].name, optionName) == 0)
+			return i;
+
+	return -1;
+}
+
 static BananaPlugin *
 bananaIndexToBananaPlugin (int bananaIndex)
 {
@@ -387,6 +425,35 @@ finiBananaOption (BananaOption *o)
 		finiBananaValue (&o->value, o->type);
 }
 
+static BananaOption *
+newBananaOption (BananaPlugin *p)
+{
+	if (p->bytes <= p->nOption * sizeof (BananaOption))
+	{
+		p->bytes *= 2;
+		p->option = realloc (p->option, p->bytes);
+	}
+	p->nOption++;
+
+	return &p->option[p->nOption - 1];
+}
+
+//set the value of a newly loaded option to its default
+static void
+initBananaOptionValue (BananaOption *o)
+{
+	int i;
+
+	if (o->isPerScreen)
+		for (i = 0; i <= MAX_NUM_SCREENS - 1; i++)
+			copyBananaValue (&(o->valuePerScreen[i]),
+			                 &(o->defaultValue),
+			                 o->type);
+	else
+		copyBananaValue (&(o->value), &(o->defaultValue),
+		                 o->type);
+}
+
 //<default></default>
 static void
 processDefaultNode (xmlDocPtr    doc,
@@ -438,19 +505,11 @@ processOptionNode (xmlDocPtr  doc,
                    xmlNodePtr optionNode,
                    int        bananaIndex)
 {
-	BananaPlugin *p = &bananaTree[bananaIndex];
-	BananaOption *o;
-
-	if (p->bytes <= p->nOption * sizeof (BananaOption))
-	{
-		p->bytes *= 2;
-		p->option = realloc (p->option, p->bytes);
-	}
-	p->nOption++;
-	o = &p->option[p->nOption - 1];
+	BananaOption *o = newBananaOption (&bananaTree[bananaIndex]);
 
 	xmlChar *optionName = xmlGetProp (optionNode, BAD_CAST "name");
 	o->name = strdup ((char *)optionName);
+	o->nameHash = bananaHashString (o->name);
 	xmlFree (optionName);
 
 	xmlChar *optionType = xmlGetProp (optionNode, BAD_CAST "type");
@@ -489,15 +548,7 @@ processOptionNode (xmlDocPtr  doc,
 		if (xmlStrcmp (child->name, BAD_CAST "default") == 0)
 			processDefaultNode (doc, child, o);
 
-	int j;
-	if (o->isPerScreen)
-		for (j = 0; j <= MAX_NUM_SCREENS - 1; j++)
-			copyBananaValue (&(o->valuePerScreen[j]),
-			                 &(o->defaultValue),
-			                 o->type);
-	else
-		copyBananaValue (&(o->value), &(o->defaultValue),
-		                 o->type);
+	initBananaOptionValue (o);
 }
 
 //<plugin></plugin> -- parse <group>s, <subgroup>s
@@ -570,15 +621,13 @@ processPluginNodeInConfigFile (xmlDocPtr    doc,
 		if (!name)
 			continue; //ignore <option> tags without name= attribute
 
-		for(i = 0; i <= p->nOption - 1; i++)
-			if (xmlStrcmp (BAD_CAST p->option[i].name, name) == 0)
-				break;
-
-		if (i == p->nOption)
-			continue; //option not found in plugin
+		i = findBananaOption (p, (char *) name);
 
 		xmlFree (name);
 
+		if (i == -1)
+			continue; //option not found in plugin
+
 		BananaValue *v = NULL;
 		if (!screen && !p->option[i].isPerScreen)
 			v = &p->option[i].value;
@@ -670,6 +719,39 @@ processPluginNodeInConfigFile (xmlDocPtr    doc,
 	}
 }
 
+//parse banana.xml only if it changed since the last parse
+static xmlDocPtr
+getConfigurationDoc (void)
+{
+	struct stat buf;
+
+	if (stat (bananaConfigurationFile, &buf) != 0)
+	{
+		if (configurationDoc)
+		{
+			xmlFreeDoc (configurationDoc);
+			configurationDoc = NULL;
+		}
+
+		return NULL;
+	}
+
+	if (configurationDoc &&
+	    buf.st_ino == configurationStat.st_ino &&
+	    buf.st_size == configurationStat.st_size &&
+	    buf.st_mtim.tv_sec == configurationStat.st_mtim.tv_sec &&
+	    buf.st_mtim.tv_nsec == configurationStat.st_mtim.tv_nsec)
+		return configurationDoc;
+
+	if (configurationDoc)
+		xmlFreeDoc (configurationDoc);
+
+	configurationDoc = xmlParseFile (bananaConfigurationFile);
+	configurationStat = buf;
+
+	return configurationDoc;
+}
+
 static void
 loadOptionsForPlugin (int       bananaIndex,
                       Bool      FIRST)
@@ -680,11 +762,7 @@ loadOptionsForPlugin (int       bananaIndex,
 
 	p = bananaIndexToBananaPlugin (bananaIndex);
 
-	struct stat buf;
-	if (stat (bananaConfigurationFile, &buf) == 0)
-		doc = xmlParseFile (bananaConfigurationFile);
-	else
-		return;
+	doc = getConfigurationDoc ();
 
 	if (!doc)
 		return;
@@ -708,16 +786,454 @@ loadOptionsForPlugin (int       bananaIndex,
 				xmlFree (pluginName);
 
 		}
+}
+
+//apply banana.xml to all loaded plugins, parsing it once
+//change notify callbacks are only called for options whose value changed
+static void
+reloadConfigurationFile (void)
+{
+	xmlDocPtr doc;
+	xmlNodePtr root, node;
+	int bananaIndex;
+
+	//file timestamps can be too coarse to notice a quick rewrite,
+	//inotify already told us that the file changed
+	if (configurationDoc)
+	{
+		xmlFreeDoc (configurationDoc);
+		configurationDoc = NULL;
+	}
+
+	doc = getConfigurationDoc ();
+
+	if (!doc)
+		return;
+
+	root = xmlDocGetRootElement (doc);
+
+	for (node = root->xmlChildrenNode; node; node = node->next)
+		if (xmlStrcmp (node->name, BAD_CAST "plugin") == 0)
+		{
+			xmlChar *pluginName = xmlGetProp (node, BAD_CAST "name");
+
+			if (!pluginName)
+				continue;
+
+			bananaIndex = bananaGetPluginIndex ((char *) pluginName);
+
+			if (bananaIndex != -1)
+				processPluginNodeInConfigFile (doc, node,
+				                               &bananaTree[bananaIndex],
+				                               FALSE);
+
+			xmlFree (pluginName);
+		}
+}
+
+/*
+ * Metadata cache
+ *
+ * The option schema of every plugin (names, types, per screen flags and
+ * defaults) is kept in $XDG_CACHE_HOME/fusilli/<plugin>.cache, so that
+ * the metadata xml files only need to be parsed when they change.
+ *
+ * Layout, in host byte order:
+ *   BananaCacheHeader
+ *   BananaCacheOption[nOption]
+ *   uint32_t          item[nItem]       list items of all options
+ *   char              string[nString]   NUL terminated strings
+ *
+ * A scalar value or list item holds the bool, the int, the bits of the
+ * float, or the offset of a string in the string table.
+ */
+
+#define CACHE_MAGIC   0x4e414e42 /* "BNAN" */
+#define CACHE_VERSION 1
 
-	xmlFreeDoc (doc);
+typedef struct _BananaCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+
+	//the metadata file the cache was built from
+	uint64_t dev;
+	uint64_t ino;
+	int64_t  size;
+	int64_t  mtimeSec;
+	int64_t  mtimeNsec;
+
+	uint32_t nOption;
+	uint32_t nItem;
+	uint32_t nString;
+	uint32_t pad;
+} BananaCacheHeader;
+
+typedef struct _BananaCacheOption {
+	uint32_t name;
+	uint32_t type;
+	uint32_t isPerScreen;
+	uint32_t value; //first item for lists
+	uint32_t nItem; //lists only
+} BananaCacheOption;
+
+typedef struct _BananaCacheWriter {
+	uint32_t *item;
+	int      nItem, itemSize;
+
+	char     *string;
+	int      nString, stringSize;
+} BananaCacheWriter;
+
+static char *bananaCacheDir;
+
+static unsigned long metadataLoadTime; //us, for --debug
+
+static void
+stampCacheHeader (BananaCacheHeader *h,
+                  const struct stat *buf)
+{
+	memset (h, 0, sizeof (BananaCacheHeader));
+
+	h->magic     = CACHE_MAGIC;
+	h->version   = CACHE_VERSION;
+	h->dev       = buf->st_dev;
+	h->ino       = buf->st_ino;
+	h->size      = buf->st_size;
+	h->mtimeSec  = buf->st_mtim.tv_sec;
+	h->mtimeNsec = buf->st_mtim.tv_nsec;
+}
+
+/* $XDG_CACHE_HOME/fusilli, or NULL if it couldn't be created */
+const char *
+bananaGetCacheDir (void)
+{
+	return bananaCacheDir;
+}
+
+static char *
+getMetadataCachePath (const char *pluginName)
+{
+	char *path;
+
+	if (!bananaCacheDir)
+		return NULL;
+
+	path = malloc (strlen (bananaCacheDir) + strlen (pluginName) + 8);
+	sprintf (path, "%s/%s.cache", bananaCacheDir, pluginName);
+
+	return path;
+}
+
+static uint32_t
+addStringToCache (BananaCacheWriter *cw,
+                  const char        *str)
+{
+	int      len = strlen (str) + 1;
+	uint32_t offset = cw->nString;
+
+	if (cw->nString + len > cw->stringSize)
+	{
+		cw->stringSize = (cw->nString + len) * 2;
+		cw->string = realloc (cw->string, cw->stringSize);
+	}
+
+	memcpy (cw->string + cw->nString, str, len);
+	cw->nString += len;
+
+	return offset;
+}
+
+static uint32_t
+scalarToCache (BananaCacheWriter *cw,
+               const BananaValue *v,
+               BananaType        type)
+{
+	uint32_t bits = 0;
+
+	switch (type)
+	{
+	case BananaBool:
+	case BananaListBool:
+		bits = v->b ? 1 : 0;
+		break;
+	case BananaInt:
+	case BananaListInt:
+		bits = (uint32_t) v->i;
+		break;
+	case BananaFloat:
+	case BananaListFloat:
+		memcpy (&bits, &v->f, sizeof (bits));
+		break;
+	case BananaString:
+	case BananaListString:
+		bits = addStringToCache (cw, v->s);
+		break;
+	}
+
+	return bits;
+}
+
+static void
+cacheToScalar (const uint32_t *bits,
+               const char     *string,
+               BananaType     type,
+               BananaValue    *v)
+{
+	switch (type)
+	{
+	case BananaBool:
+	case BananaListBool:
+		v->b = *bits ? TRUE : FALSE;
+		break;
+	case BananaInt:
+	case BananaListInt:
+		v->i = (int) *bits;
+		break;
+	case BananaFloat:
+	case BananaListFloat:
+		memcpy (&v->f, bits, sizeof (*bits));
+		break;
+	case BananaString:
+	case BananaListString:
+		v->s = strdup (string + *bits);
+		break;
+	}
+}
+
+static void
+writeMetadataCache (BananaPlugin      *p,
+                    const struct stat *buf)
+{
+	BananaCacheWriter cw;
+	BananaCacheHeader h;
+	BananaCacheOption *co;
+	char              *path, *tmpPath;
+	FILE              *fp;
+	int               i, j;
+
+	path = getMetadataCachePath (p->name);
+	if (!path)
+		return;
+
+	memset (&cw, 0, sizeof (cw));
+
+	co = calloc (p->nOption ? p->nOption : 1, sizeof (BananaCacheOption));
+	if (!co)
+	{
+		free (path);
+		return;
+	}
+
+	for (i = 0; i <= p->nOption - 1; i++)
+	{
+		BananaOption *o = &p->option[i];
+
+		co[i].name        = addStringToCache (&cw, o->name);
+		co[i].type        = o->type;
+		co[i].isPerScreen = o->isPerScreen;
+
+		if (o->type == BananaListBool || o->type == BananaListInt ||
+		    o->type == BananaListFloat || o->type == BananaListString)
+		{
+			BananaList *l = &o->defaultValue.list;
+
+			if (cw.nItem + l->nItem > cw.itemSize)
+			{
+				cw.itemSize = (cw.nItem + l->nItem) * 2;
+				cw.item = realloc (cw.item, cw.itemSize * sizeof (uint32_t));
+			}
+
+			co[i].value = cw.nItem;
+			co[i].nItem = l->nItem;
+
+			for (j = 0; j <= l->nItem - 1; j++)
+				cw.item[cw.nItem++] = scalarToCache (&cw, &l->item[j],
+				                                     o->type);
+		}
+		else
+			co[i].value = scalarToCache (&cw, &o->defaultValue, o->type);
+	}
+
+	stampCacheHeader (&h, buf);
+	h.nOption = p->nOption;
+	h.nItem   = cw.nItem;
+	h.nString = cw.nString;
+
+	//write to a temporary file and rename, so that a concurrently
+	//starting fusilli never maps a half written cache
+	tmpPath = malloc (strlen (path) + 16);
+	sprintf (tmpPath, "%s.%d", path, (int) getpid ());
+
+	fp = fopen (tmpPath, "wb");
+	if (fp)
+	{
+		Bool ok;
+
+		ok = fwrite (&h, sizeof (h), 1, fp) == 1;
+		ok = ok && fwrite (co, sizeof (BananaCacheOption),
+		                   h.nOption, fp) == h.nOption;
+		ok = ok && fwrite (cw.item, sizeof (uint32_t),
+		                   h.nItem, fp) == h.nItem;
+		ok = ok && fwrite (cw.string, 1, h.nString, fp) == h.nString;
+		ok = (fclose (fp) == 0) && ok;
+
+		if (!ok || rename (tmpPath, path) != 0)
+			unlink (tmpPath);
+	}
+
+	free (tmpPath);
+	free (path);
+	free (co);
+	free (cw.item);
+	free (cw.string);
+}
+
+//returns FALSE if there is no valid cache for this metadata file
+static Bool
+readMetadataCache (BananaPlugin      *p,
+                   const struct stat *buf)
+{
+	BananaCacheHeader       stamp;
+	const BananaCacheHeader *h;
+	const BananaCacheOption *co;
+	const uint32_t          *item;
+	const char              *string;
+	struct stat             cacheBuf;
+	char                    *path;
+	void                    *map;
+	size_t                  expected;
+	int                     fd, i, j;
+	Bool                    valid;
+
+	path = getMetadataCachePath (p->name);
+	if (!path)
+		return FALSE;
+
+	fd = open (path, O_RDONLY);
+	free (path);
+
+	if (fd < 0)
+		return FALSE;
+
+	if (fstat (fd, &cacheBuf) != 0 ||
+	    cacheBuf.st_size < (off_t) sizeof (BananaCacheHeader))
+	{
+		close (fd);
+		return FALSE;
+	}
+
+	map = mmap (NULL, cacheBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+
+	if (map == MAP_FAILED)
+		return FALSE;
+
+	h = map;
+
+	stampCacheHeader (&stamp, buf);
+
+	valid = h->magic     == stamp.magic     &&
+	        h->version   == stamp.version   &&
+	        h->dev       == stamp.dev       &&
+	        h->ino       == stamp.ino       &&
+	        h->size      == stamp.size      &&
+	        h->mtimeSec  == stamp.mtimeSec  &&
+	        h->mtimeNsec == stamp.mtimeNsec;
+
+	expected = sizeof (BananaCacheHeader) +
+	           (size_t) h->nOption * sizeof (BananaCacheOption) +
+	           (size_t) h->nItem * sizeof (uint32_t) +
+	           h->nString;
+
+	co     = (const BananaCacheOption *) (h + 1);
+	item   = (const uint32_t *) (co + h->nOption);
+	string = (const char *) (item + h->nItem);
+
+	valid = valid && expected == (size_t) cacheBuf.st_size &&
+	        (h->nString == 0 || string[h->nString - 1] == '\0');
+
+	//check all offsets before touching bananaTree
+	for (i = 0; valid && i <= (int) h->nOption - 1; i++)
+	{
+		BananaType type = co[i].type;
+
+		if (co[i].name >= h->nString || type > BananaListString)
+			valid = FALSE;
+		else if (type == BananaListBool || type == BananaListInt ||
+		         type == BananaListFloat || type == BananaListString)
+		{
+			if (co[i].value > h->nItem || co[i].nItem > h->nItem - co[i].value)
+				valid = FALSE;
+			else if (type == BananaListString)
+				for (j = 0; j <= (int) co[i].nItem - 1; j++)
+					if (item[co[i].value + j] >= h->nString)
+						valid = FALSE;
+		}
+		else if (type == BananaString && co[i].value >= h->nString)
+			valid = FALSE;
+	}
+
+	if (!valid)
+	{
+		munmap (map, cacheBuf.st_size);
+		return FALSE;
+	}
+
+	for (i = 0; i <= (int) h->nOption - 1; i++)
+	{
+		BananaOption *o = newBananaOption (p);
+
+		o->name        = strdup (string + co[i].name);
+		o->nameHash    = bananaHashString (o->name);
+		o->type        = co[i].type;
+		o->isPerScreen = co[i].isPerScreen ? TRUE : FALSE;
+
+		initBananaValue (&o->defaultValue, o->type);
+
+		if (o->type == BananaListBool || o->type == BananaListInt ||
+		    o->type == BananaListFloat || o->type == BananaListString)
+		{
+			BananaValue *l = &o->defaultValue;
+
+			for (j = 0; j <= (int) co[i].nItem - 1; j++)
+			{
+				if (l->list.bytes <= l->list.nItem * sizeof (BananaValue))
+				{
+					l->list.bytes *= 2;
+					l->list.item = realloc (l->list.item, l->list.bytes);
+				}
+
+				cacheToScalar (&item[co[i].value + j], string, o->type,
+				               &l->list.item[l->list.nItem++]);
+			}
+		}
+		else
+		{
+			if (o->type == BananaString)
+				free (o->defaultValue.s);
+
+			cacheToScalar (&co[i].value, string, o->type, &o->defaultValue);
+		}
+
+		initBananaOptionValue (o);
+	}
+
+	munmap (map, cacheBuf.st_size);
+
+	return TRUE;
 }
 
 static int
 loadMetadataForPlugin (const char* pluginName)
 {
 	xmlDocPtr doc;
+	struct stat buf;
+	struct timeval start, end;
 	char *path;
 	int bananaIndex = -1, i;
+	Bool cached;
+
+	gettimeofday (&start, 0);
 
 	path = malloc (sizeof (char) * 
 	                                  (strlen (bananaMetaDataDir) + 1 +
@@ -726,11 +1242,11 @@ loadMetadataForPlugin (const char* pluginName)
 
 	sprintf (path, "%s/%s%s", bananaMetaDataDir, pluginName, EXTENSION);
 
-	doc = xmlParseFile (path);
-
-	free (path);
-	if (!doc)
+	if (stat (path, &buf) != 0)
+	{
+		free (path);
 		return -1;
+	}
 
 	//find an empty slot in bananaTree
 	for (i = 0; i <= MAX_NUM_PLUGINS - 1; i++)
@@ -751,29 +1267,76 @@ loadMetadataForPlugin (const char* pluginName)
 
 	if (bananaIndex == -1) //bananaTree is full
 	{
-		xmlFreeDoc (doc);
+		free (path);
 		return -1;
 	}
 
-	processFusilliNode (doc, bananaIndex);
+	cached = useMetadataCache &&
+	         readMetadataCache (&bananaTree[bananaIndex], &buf);
+
+	if (!cached)
+	{
+		doc = xmlParseFile (path);
+
+		if (!doc)
+		{
+			free (path);
+			free (bananaTree[bananaIndex].name);
+			free (bananaTree[bananaIndex].option);
+			bananaTree[bananaIndex].name   = NULL;
+			bananaTree[bananaIndex].option = NULL;
+			bananaTree[bananaIndex].bytes  = 0;
+			return -1;
+		}
+
+		processFusilliNode (doc, bananaIndex);
+
+		xmlFreeDoc (doc);
+
+		if (useMetadataCache)
+			writeMetadataCache (&bananaTree[bananaIndex], &buf);
+	}
+
+	free (path);
+
+	gettimeofday (&end, 0);
 
-	xmlFreeDoc (doc);
+	metadataLoadTime += (end.tv_sec - start.tv_sec) * 1000000 +
+	                    (end.tv_usec - start.tv_usec);
+
+	compLogMessage ("core", CompLogLevelDebug,
+	                "Loaded metadata for %s from %s, %lu us spent "
+	                "loading metadata so far",
+	                pluginName, cached ? "cache" : "xml", metadataLoadTime);
 
 	return bananaIndex;
 }
 
+static Bool
+reloadTimeout (void *closure)
+{
+	reloadHandle = 0;
+
+	reloadConfigurationFile ();
+
+	return FALSE;
+}
+
+//an editor or fsm saving banana.xml produces a burst of inotify events,
+//reload once after the burst is over
 static void
 confFileChanged (const char *name,
                  void       *closure)
 {
-	int i;
-
 	if (name != NULL &&
 	    strcmp(name, strrchr(bananaConfigurationFile, '/') + 1) == 0)
-		for (i = 0; i <= MAX_NUM_PLUGINS - 1; i++)
-			if (bananaTree[i].name)
-				loadOptionsForPlugin (i, FALSE);
+	{
+		if (reloadHandle)
+			compRemoveTimeout (reloadHandle);
 
+		reloadHandle = compAddTimeout (RELOAD_DELAY, RELOAD_DELAY + 50,
+		                               reloadTimeout, NULL);
+	}
 }
 /********************************************************************
 *********************************************************************
@@ -821,6 +1384,35 @@ bananaInit (const char *metaDataDir,
 
 	bananaConfigurationFile = strdup (configurationFile);
 
+	const char *cacheHome = getenv ("XDG_CACHE_HOME");
+	const char *home = getenv ("HOME");
+
+	bananaCacheDir = NULL;
+
+	if (cacheHome && *cacheHome)
+	{
+		bananaCacheDir = malloc (strlen (cacheHome) + 9);
+		strcpy (bananaCacheDir, cacheHome);
+	}
+	else if (home && *home)
+	{
+		bananaCacheDir = malloc (strlen (home) + 16);
+		sprintf (bananaCacheDir, "%s/.cache", home);
+	}
+
+	if (bananaCacheDir)
+	{
+		mkdir (bananaCacheDir, 0700);
+		strcat (bananaCacheDir, "/fusilli");
+	}
+
+	if (bananaCacheDir && mkdir (bananaCacheDir, 0700) != 0 &&
+	    errno != EEXIST)
+	{
+		free (bananaCacheDir);
+		bananaCacheDir = NULL;
+	}
+
 	//watch the directory, not the file
 	//if the file gets deleted, the inode changes and the inotify handle is lost
 	directoryWatch = addFileWatch (bananaConfigurationDir,
@@ -849,6 +1441,15 @@ bananaFini (void)
 	if (directoryWatch)
 		removeFileWatch (directoryWatch);
 
+	if (reloadHandle)
+		compRemoveTimeout (reloadHandle);
+
+	if (configurationDoc)
+		xmlFreeDoc (configurationDoc);
+
+	if (bananaCacheDir)
+		free (bananaCacheDir);
+
 	xmlCleanupParser ();
 }
 
@@ -983,31 +1584,66 @@ bananaUnloadPlugin (const int bananaIndex)
 
 }
 
-const BananaValue *
-bananaGetOption (const int  bananaIndex,
-                 const char *optionName,
-                 const int  screenNum)
+BananaOptionHandle
+bananaGetOptionHandle (int        bananaIndex,
+                       const char *optionName)
 {
-	BananaPlugin *p = bananaIndexToBananaPlugin (bananaIndex);
+	BananaOptionHandle handle;
+	BananaPlugin       *p;
+	int                i;
+
+	handle.bananaIndex = bananaIndex;
+	handle.optionIndex = -1;
+	handle.type        = BananaBool;
+
+	p = bananaIndexToBananaPlugin (bananaIndex);
 
 	if (!p)
-		return NULL;
+		return handle;
 
-	BananaValue  *v = NULL;
+	i = findBananaOption (p, optionName);
 
-	int i;
-	for (i = 0; i <= p->nOption - 1; i++)
+	if (i == -1)
 	{
-		if (strcmp (p->option[i].name, optionName) == 0)
-		{
-			if (screenNum == -1)
-				v = &p->option[i].value;
-			else
-				v = &(p->option[i].valuePerScreen[screenNum]);
-		}
+		compLogMessage ("core", CompLogLevelError,
+		                "Option %s not found in plugin %s\n",
+		                optionName, p->name);
+		return handle;
 	}
 
-	return v;
+	handle.optionIndex = i;
+	handle.type        = p->option[i].type;
+
+	return handle;
+}
+
+const BananaValue *
+bananaGetOptionByHandle (BananaOptionHandle handle,
+                         int                screenNum)
+{
+	BananaOption *o;
+
+	if (handle.optionIndex < 0)
+		return NULL;
+
+	o = &bananaTree[handle.bananaIndex].option[handle.optionIndex];
+
+	if (screenNum == -1)
+		return &o->value;
+	else
+		return &o->valuePerScreen[screenNum];
+}
+
+const BananaValue *
+bananaGetOption (const int  bananaIndex,
+                 const char *optionName,
+                 const int  screenNum)
+{
+	BananaOptionHandle handle;
+
+	handle = bananaGetOptionHandle (bananaIndex, optionName);
+
+	return bananaGetOptionByHandle (handle, screenNum);
 }
 
 void
@@ -1023,18 +1659,15 @@ bananaSetOption (int         bananaIndex,
 
 	BananaValue  *v = NULL;
 
-	int i;
-	for (i = 0; i <= p->nOption - 1; i++)
-	{
-		if (strcmp (p->option[i].name, optionName) == 0)
-		{
-			if (screenNum == -1)
-				v = &p->option[i].value;
-			else
-				v = &(p->option[i].valuePerScreen[screenNum]);
-			break;
-		}
-	}
+	int i = findBananaOption (p, optionName);
+
+	if (i == -1)
+		return;
+
+	if (screenNum == -1)
+		v = &p->option[i].value;
+	else
+		v = &(p->option[i].valuePerScreen[screenNum]);
 
 	if (!isEqualBananaValue(v, value, p->option[i].type))
 	{
@@ -270,7 +270,11 @@ initCore (void)
 	core.fileWatch = NULL;
 	core.lastFileWatchHandle = 1;
 
-	core.timeouts = NULL;
+	core.timeoutHeap = NULL;
+	core.nTimeout = 0;
+	core.timeoutHeapSize = 0;
+	core.timeoutTable = NULL;
+	core.timeoutTableSize = 0;
 	core.lastTimeoutHandle = 1;
 
 	core.watchFds = NULL;
@@ -278,8 +282,6 @@ initCore (void)
 	core.watchPollFds = NULL;
 	core.nWatchFds = 0;
 
-	gettimeofday (&core.lastTimeout, 0);
-
 	core.sessionEvent = sessionEvent;
 	core.logMessage   = logMessage;
 
@@ -303,6 +305,8 @@ initCore (void)
 
 	initDbus ();
 
+	initProfiler ();
+
 	return TRUE;
 }
 
@@ -327,18 +331,31 @@ finiCore (void)
 
 	compRemoveWatchFd (core.dbusWatchFdHandle);
 
+	finiImageLoader ();
+
 	if (core.watchPollFds)
 		free (core.watchPollFds);
 
 	while ((p = popPlugin ()))
 		unloadPlugin (p);
 
+	finiProfiler ();
+
 	dbus_bus_release_name (core.dbusConnection, "org.fusilli", NULL);
 
 	XDestroyRegion (core.outputRegion);
 	XDestroyRegion (core.tmpRegion);
 
 	removeDisplay ();
+
+	while (core.nTimeout)
+		compRemoveTimeout (core.timeoutHeap[0]->handle);
+
+	if (core.timeoutHeap)
+		free (core.timeoutHeap);
+
+	if (core.timeoutTable)
+		free (core.timeoutTable);
 }
 
 CompFileWatchHandle
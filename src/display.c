@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/poll.h>
+#include <time.h>
 #include <assert.h>
 
 #define XK_MISCELLANY
@@ -363,27 +364,158 @@ updatePlugins (void)
 	display.dirtyPluginList = FALSE;
 }
 
+static long long
+getMonotonicTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+setTimeoutHeapEntry (int         index,
+                     CompTimeout *timeout)
+{
+	core.timeoutHeap[index] = timeout;
+	timeout->heapIndex = index;
+}
+
+static void
+siftTimeoutUp (int index)
+{
+	CompTimeout *timeout = core.timeoutHeap[index];
+
+	while (index > 0)
+	{
+		int parent = (index - 1) / 2;
+
+		if (core.timeoutHeap[parent]->minDeadline <= timeout->minDeadline)
+			break;
+
+		setTimeoutHeapEntry (index, core.timeoutHeap[parent]);
+		index = parent;
+	}
+
+	setTimeoutHeapEntry (index, timeout);
+}
+
 static void
-addTimeout (CompTimeout *timeout)
+siftTimeoutDown (int index)
 {
-	CompTimeout *p = 0, *t;
+	CompTimeout *timeout = core.timeoutHeap[index];
 
-	for (t = core.timeouts; t; t = t->next)
+	for (;;)
 	{
-		if (timeout->minTime < t->minLeft)
+		int child = 2 * index + 1;
+
+		if (child >= core.nTimeout)
+			break;
+
+		if (child + 1 < core.nTimeout &&
+		    core.timeoutHeap[child + 1]->minDeadline <
+		    core.timeoutHeap[child]->minDeadline)
+			child++;
+
+		if (timeout->minDeadline <= core.timeoutHeap[child]->minDeadline)
 			break;
 
-		p = t;
+		setTimeoutHeapEntry (index, core.timeoutHeap[child]);
+		index = child;
 	}
 
-	timeout->next = t;
-	timeout->minLeft = timeout->minTime;
-	timeout->maxLeft = timeout->maxTime;
+	setTimeoutHeapEntry (index, timeout);
+}
+
+/* compAddTimeout keeps a spare slot in the heap, so rescheduling the
+   timeout that handleTimeouts is running cannot fail */
+static void
+addTimeout (CompTimeout *timeout,
+            long long   now)
+{
+	timeout->minDeadline = now + timeout->minTime;
+	timeout->maxDeadline = now + timeout->maxTime;
 
-	if (p)
-		p->next = timeout;
+	setTimeoutHeapEntry (core.nTimeout++, timeout);
+	siftTimeoutUp (timeout->heapIndex);
+}
+
+static void
+removeTimeoutFromHeap (CompTimeout *timeout)
+{
+	int index = timeout->heapIndex;
+
+	timeout->heapIndex = -1;
+
+	if (--core.nTimeout == index)
+		return;
+
+	setTimeoutHeapEntry (index, core.timeoutHeap[core.nTimeout]);
+
+	if (index > 0 &&
+	    core.timeoutHeap[(index - 1) / 2]->minDeadline >
+	    core.timeoutHeap[index]->minDeadline)
+		siftTimeoutUp (index);
 	else
-		core.timeouts = timeout;
+		siftTimeoutDown (index);
+}
+
+static CompTimeout *
+findTimeout (CompTimeoutHandle handle)
+{
+	if (handle <= 0 || handle >= core.timeoutTableSize)
+		return NULL;
+
+	return core.timeoutTable[handle];
+}
+
+static CompTimeoutHandle
+allocateTimeoutHandle (void)
+{
+	CompTimeoutHandle handle;
+	int               i;
+
+	/* skip handles still owned by long-lived timeouts after the
+	   counter has wrapped around */
+	for (i = 1; i < MAXSHORT; i++)
+	{
+		handle = core.lastTimeoutHandle++;
+
+		if (core.lastTimeoutHandle == MAXSHORT)
+			core.lastTimeoutHandle = 1;
+
+		if (!findTimeout (handle))
+			break;
+	}
+
+	if (i == MAXSHORT)
+		return 0;
+
+	if (handle >= core.timeoutTableSize)
+	{
+		CompTimeout **table;
+		int         size, j;
+
+		size = core.timeoutTableSize ? core.timeoutTableSize * 2 : 64;
+		while (size <= handle)
+			size *= 2;
+
+		if (size > MAXSHORT)
+			size = MAXSHORT;
+
+		table = realloc (core.timeoutTable, sizeof (CompTimeout *) * size);
+		if (!table)
+			return 0;
+
+		for (j = core.timeoutTableSize; j < size; j++)
+			table[j] = NULL;
+
+		core.timeoutTable     = table;
+		core.timeoutTableSize = size;
+	}
+
+	return handle;
 }
 
 CompTimeoutHandle
@@ -394,20 +526,40 @@ compAddTimeout (int          minTime,
 {
 	CompTimeout *timeout;
 
+	if (core.nTimeout + 1 >= core.timeoutHeapSize)
+	{
+		CompTimeout **heap;
+		int         size;
+
+		size = core.timeoutHeapSize ? core.timeoutHeapSize * 2 : 32;
+
+		heap = realloc (core.timeoutHeap, sizeof (CompTimeout *) * size);
+		if (!heap)
+			return 0;
+
+		core.timeoutHeap     = heap;
+		core.timeoutHeapSize = size;
+	}
+
 	timeout = malloc (sizeof (CompTimeout));
 	if (!timeout)
 		return 0;
 
+	timeout->handle = allocateTimeoutHandle ();
+	if (!timeout->handle)
+	{
+		free (timeout);
+		return 0;
+	}
+
 	timeout->minTime  = minTime;
 	timeout->maxTime  = (maxTime >= minTime) ? maxTime : minTime;
 	timeout->callBack = callBack;
 	timeout->closure  = closure;
-	timeout->handle   = core.lastTimeoutHandle++;
 
-	if (core.lastTimeoutHandle == MAXSHORT)
-		core.lastTimeoutHandle = 1;
+	core.timeoutTable[timeout->handle] = timeout;
 
-	addTimeout (timeout);
+	addTimeout (timeout, getMonotonicTime ());
 
 	return timeout->handle;
 }
@@ -415,29 +567,28 @@ compAddTimeout (int          minTime,
 void *
 compRemoveTimeout (CompTimeoutHandle handle)
 {
-	CompTimeout *p = 0, *t;
-	void        *closure = NULL;
-
-	for (t = core.timeouts; t; t = t->next)
-	{
-		if (t->handle == handle)
-			break;
+	CompTimeout *t;
+	void        *closure;
 
-		p = t;
-	}
+	t = findTimeout (handle);
+	if (!t)
+		return NULL;
 
-	if (t)
-	{
-		if (p)
-			p->next = t->next;
-		else
-			core.timeouts = t->next;
+	core.timeoutTable[handle] = NULL;
 
-		closure = t->closure;
+	closure = t->closure;
 
-		free (t);
+	/* a timeout removed from its own callback is freed by
+	   handleTimeouts once the callback returns */
+	if (t->heapIndex < 0)
+	{
+		t->handle = 0;
+		return closure;
 	}
 
+	removeTimeoutFromHeap (t);
+	free (t);
+
 	return closure;
 }
 
@@ -526,80 +677,6 @@ compWatchFdEvents (CompWatchFdHandle handle)
         ((((tv1)->tv_sec - 1 - (tv2)->tv_sec) * 1000000) +                     \
         (1000000 + (tv1)->tv_usec - (tv2)->tv_usec)) / 1000
 
-static int
-getTimeToNextRedraw (CompScreen     *s,
-                     struct timeval *tv,
-                     struct timeval *lastTv,
-                     Bool           idle)
-{
-	int diff, next;
-
-	diff = TIMEVALDIFF (tv, lastTv);
-
-	/* handle clock rollback */
-	if (diff < 0)
-		diff = 0;
-
-	const BananaValue *
-	option_sync_to_vblank = bananaGetOption (coreBananaIndex,
-	                                         "sync_to_vblank",
-	                                         s->screenNum);
-
-	if (idle ||
-		(s->getVideoSync && option_sync_to_vblank->b))
-	{
-		if (s->timeMult > 1)
-		{
-			s->frameStatus = -1;
-			s->redrawTime = s->optimalRedrawTime;
-			s->timeMult--;
-		}
-	}
-	else
-	{
-		if (diff > s->redrawTime)
-		{
-			if (s->frameStatus > 0)
-				s->frameStatus = 0;
-
-			next = s->optimalRedrawTime * (s->timeMult + 1);
-			if (diff > next)
-			{
-				s->frameStatus--;
-				if (s->frameStatus < -1)
-				{
-					s->timeMult++;
-					s->redrawTime = diff = next;
-				}
-			}
-		}
-		else if (diff < s->redrawTime)
-		{
-			if (s->frameStatus < 0)
-				s->frameStatus = 0;
-
-			if (s->timeMult > 1)
-			{
-				next = s->optimalRedrawTime * (s->timeMult - 1);
-				if (diff < next)
-				{
-					s->frameStatus++;
-					if (s->frameStatus > 4)
-					{
-						s->timeMult--;
-						s->redrawTime = next;
-					}
-				}
-			}
-		}
-	}
-
-	if (diff > s->redrawTime)
-		return 0;
-
-	return s->redrawTime - diff;
-}
-
 static const int maskTable[] = {
 	ShiftMask, LockMask, ControlMask, Mod1Mask,
 	Mod2Mask, Mod3Mask, Mod4Mask, Mod5Mask
@@ -769,39 +846,73 @@ doPoll (int timeout)
 }
 
 static void
-handleTimeouts (struct timeval *tv)
+handleTimeouts (void)
 {
 	CompTimeout *t;
-	int         timeDiff;
+	long long   now = getMonotonicTime ();
 
-	timeDiff = TIMEVALDIFF (tv, &core.lastTimeout);
-
-	/* handle clock rollback */
-	if (timeDiff < 0)
-		timeDiff = 0;
-
-	for (t = core.timeouts; t; t = t->next)
+	while (core.nTimeout && core.timeoutHeap[0]->minDeadline <= now)
 	{
-		t->minLeft -= timeDiff;
-		t->maxLeft -= timeDiff;
-	}
+		t = core.timeoutHeap[0];
+		removeTimeoutFromHeap (t);
 
-	while (core.timeouts && core.timeouts->minLeft <= 0)
-	{
-		t = core.timeouts;
-		if ((*t->callBack) (t->closure))
+		if ((*t->callBack) (t->closure) && t->handle)
 		{
-			core.timeouts = t->next;
-			addTimeout (t);
+			addTimeout (t, now);
 		}
 		else
 		{
-			core.timeouts = t->next;
+			if (t->handle)
+				core.timeoutTable[t->handle] = NULL;
+
 			free (t);
 		}
 	}
+}
+
+/* children in the heap are never due before their parent, so only the
+   subtrees rooted at timeouts due within the current bound are visited */
+static void
+coalesceTimeouts (int       index,
+                  long long *time)
+{
+	CompTimeout *t;
+
+	if (index >= core.nTimeout)
+		return;
+
+	t = core.timeoutHeap[index];
+	if (t->minDeadline > *time)
+		return;
+
+	if (t->maxDeadline < *time)
+		*time = t->maxDeadline;
 
-	core.lastTimeout = *tv;
+	coalesceTimeouts (2 * index + 1, time);
+	coalesceTimeouts (2 * index + 2, time);
+}
+
+/* Time until the next batch of timeouts should run. Timeouts are not
+   due before their minimum time, so waiting until the earliest maximum
+   time among all timeouts that have become due by then lets them run
+   together. */
+static int
+getTimeToNextTimeout (void)
+{
+	long long now, time;
+
+	now  = getMonotonicTime ();
+	time = core.timeoutHeap[0]->maxDeadline;
+
+	coalesceTimeouts (0, &time);
+
+	time -= now;
+	if (time < 0)
+		time = 0;
+	else if (time > MAXSHORT)
+		time = MAXSHORT;
+
+	return time;
 }
 
 static void
@@ -809,21 +920,13 @@ waitForVideoSync (CompScreen *s)
 {
 	unsigned int sync;
 
-	const BananaValue *
-	option_sync_to_vblank = bananaGetOption (coreBananaIndex,
-	                                         "sync_to_vblank",
-	                                         s->screenNum);
-
-	if (!option_sync_to_vblank->b)
+	if (!frameSchedulerSyncToVBlank (s))
 		return;
 
-	if (s->getVideoSync)
-	{
-		glFlush ();
+	glFlush ();
 
-		(*s->getVideoSync) (&sync);
-		(*s->waitVideoSync) (2, (sync + 1) % 2, &sync);
-	}
+	(*s->getVideoSync) (&sync);
+	(*s->waitVideoSync) (2, (sync + 1) % 2, &sync);
 }
 
 
@@ -838,6 +941,19 @@ paintScreen (CompScreen   *s,
 
 	for (i = 0; i < numOutput; i++)
 	{
+		if (!(mask & COMP_SCREEN_DAMAGE_ALL_MASK) &&
+		    (mask & COMP_SCREEN_DAMAGE_REGION_MASK))
+		{
+			compIntersectRegion (core.tmpRegion,
+			                     &outputs[i].region,
+			                     core.outputRegion);
+
+			/* nothing changed on this output or all of it is covered
+			   by an unredirected fullscreen window */
+			if (!REGION_NOT_EMPTY (core.outputRegion))
+				continue;
+		}
+
 		targetScreen = s;
 		targetOutput = &outputs[i];
 
@@ -855,6 +971,8 @@ paintScreen (CompScreen   *s,
 			s->lastViewport = r;
 		}
 
+		PROFILER_ENTER (s, paintOutput);
+
 		if (mask & COMP_SCREEN_DAMAGE_ALL_MASK)
 		{
 			(*s->paintOutput) (s,
@@ -866,10 +984,6 @@ paintScreen (CompScreen   *s,
 		}
 		else if (mask & COMP_SCREEN_DAMAGE_REGION_MASK)
 		{
-			XIntersectRegion (core.tmpRegion,
-			                  &outputs[i].region,
-			                  core.outputRegion);
-
 			if (!(*s->paintOutput) (s,
 			                        &defaultScreenPaintAttrib,
 			                        &identity,
@@ -882,15 +996,47 @@ paintScreen (CompScreen   *s,
 				                   &outputs[i].region, &outputs[i],
 				                   PAINT_SCREEN_FULL_MASK);
 
-				XUnionRegion (core.tmpRegion,
-				              &outputs[i].region,
-				              core.tmpRegion);
+				compUnionRegion (core.tmpRegion,
+				                 &outputs[i].region,
+				                 core.tmpRegion);
+
+				if (s->bufferAge)
+					compUnionRegion (s->frameDamage,
+					                 &outputs[i].region,
+					                 s->frameDamage);
 
 			}
 		}
+
+		PROFILER_LEAVE (paintOutput);
 	}
 }
 
+#define ALLOCATION_STATS_FRAMES 600
+
+static void
+updateAllocationStats (unsigned long nAllocation)
+{
+	static unsigned long total = 0, max = 0;
+	static int           nFrame = 0;
+
+	total += nAllocation;
+	if (nAllocation > max)
+		max = nAllocation;
+
+	if (++nFrame < ALLOCATION_STATS_FRAMES)
+		return;
+
+	compLogMessage ("core", CompLogLevelDebug,
+	                "%.1f heap allocations per frame on average, "
+	                "%lu at most, over the last %d frames",
+	                (double) total / nFrame, max, nFrame);
+
+	total  = 0;
+	max    = 0;
+	nFrame = 0;
+}
+
 void
 eventLoop (void)
 {
@@ -900,9 +1046,11 @@ eventLoop (void)
 	CompDisplay    *d;
 	CompScreen     *s;
 	CompWindow     *w;
-	CompTimeout    *t;
 	int            time, timeToNextRedraw = 0;
-	unsigned int   damageMask, mask;
+	unsigned int   damageMask, mask, age;
+	CompPresentMode present;
+	unsigned long  nAllocation, nAllocationDone;
+	Bool           countAllocations;
 
 	d = &display;
 
@@ -962,6 +1110,8 @@ eventLoop (void)
 			lastPointerY = pointerY;
 		}
 
+		flushPendingDamage ();
+
 		for (s = d->screens; s; s = s->next)
 		{
 			if (s->damageMask)
@@ -988,8 +1138,7 @@ eventLoop (void)
 				damageMask |= s->damageMask;
 			}
 
-			s->timeLeft = getTimeToNextRedraw (s, &tv, &s->lastRedraw,
-			                                   s->idle);
+			s->timeLeft = getTimeToNextRedraw (s);
 			if (s->timeLeft < timeToNextRedraw)
 				timeToNextRedraw = s->timeLeft;
 		}
@@ -1004,8 +1153,8 @@ eventLoop (void)
 			{
 				gettimeofday (&tv, 0);
 
-				if (core.timeouts)
-					handleTimeouts (&tv);
+				if (core.nTimeout)
+					handleTimeouts ();
 
 				for (s = d->screens; s; s = s->next)
 				{
@@ -1014,6 +1163,8 @@ eventLoop (void)
 
 					targetScreen = s;
 
+					s->mipmapRebuilds = 0;
+
 					timeDiff = TIMEVALDIFF (&tv, &s->lastRedraw);
 
 					/* handle clock rollback */
@@ -1022,9 +1173,17 @@ eventLoop (void)
 
 					makeScreenCurrent (s);
 
+					frameSchedulerBeginFrame (s);
+
+					countAllocations = getHeapAllocationCount (&nAllocation);
+
 					/* make sure X is ready for us to draw */
 					glXWaitX ();
 
+					profilerBeginFrame (s);
+
+					PROFILER_ENTER (s, preparePaintScreen);
+
 					if (s->slowAnimations)
 					{
 						(*s->preparePaintScreen) (s,
@@ -1037,6 +1196,8 @@ eventLoop (void)
 						                          s->idle ? s->redrawTime :
 						                          timeDiff);
 
+					PROFILER_LEAVE (preparePaintScreen);
+
 					/* substract top most overlay window region */
 					if (s->overlayWindowCount)
 					{
@@ -1046,8 +1207,8 @@ eventLoop (void)
 								continue;
 
 							if (!w->redirected)
-								XSubtractRegion (s->damage, w->region,
-								                 s->damage);
+								compSubtractRegion (s->damage, w->region,
+								                    s->damage);
 
 							break;
 						}
@@ -1061,8 +1222,8 @@ eventLoop (void)
 
 					if (s->damageMask & COMP_SCREEN_DAMAGE_REGION_MASK)
 					{
-						XIntersectRegion (s->damage, &s->region,
-						                  core.tmpRegion);
+						compIntersectRegion (s->damage, &s->region,
+						                     core.tmpRegion);
 
 						if (core.tmpRegion->numRects  == 1        &&
 						    core.tmpRegion->rects->x1 == 0        &&
@@ -1077,6 +1238,16 @@ eventLoop (void)
 					mask = s->damageMask;
 					s->damageMask = 0;
 
+					age = 0;
+					if (s->bufferAge &&
+					    (mask & COMP_SCREEN_DAMAGE_REGION_MASK) &&
+					    !(mask & COMP_SCREEN_DAMAGE_ALL_MASK))
+						(*s->queryDrawable) (d->display, s->output,
+						                     GLX_BACK_BUFFER_AGE_EXT, &age);
+
+					present = getFramePresentMode (s, mask, age,
+					                               core.tmpRegion);
+
 					if (s->clearBuffers)
 					{
 						if (mask & COMP_SCREEN_DAMAGE_ALL_MASK)
@@ -1085,8 +1256,12 @@ eventLoop (void)
 
 					const BananaValue *
 					option_force_independent_output_painting =
-					  bananaGetOption (coreBananaIndex, 
-					  "force_independent_output_painting", s->screenNum);
+					  bananaGetOptionByHandle (
+					  coreOptionForceIndependentOutputPainting, s->screenNum);
+
+					updateScreenAtlas (s);
+
+					PROFILER_ENTER (s, paintScreen);
 
 					if (option_force_independent_output_painting->b
 					    || !s->hasOverlappingOutputs)
@@ -1096,16 +1271,23 @@ eventLoop (void)
 					else
 						(*s->paintScreen) (s, &s->fullscreenOutput, 1, mask);
 
+					PROFILER_LEAVE (paintScreen);
+
 					targetScreen = NULL;
 					targetOutput = &s->outputDev[0];
 
+					frameSchedulerEndPaint (s);
+
 					waitForVideoSync (s);
 
-					if (mask & COMP_SCREEN_DAMAGE_ALL_MASK)
+					if (present == CompPresentSwap)
 					{
 						glXSwapBuffers (d->display, s->output);
+
+						if (s->bufferAge)
+							pushFrameDamage (s);
 					}
-					else
+					else if (present == CompPresentCopy)
 					{
 						BoxPtr pBox;
 						int    nBox, y;
@@ -1165,7 +1347,19 @@ eventLoop (void)
 
 					s->lastRedraw = tv;
 
+					frameSchedulerEndFrame (s);
+
+					PROFILER_ENTER (s, donePaintScreen);
 					(*s->donePaintScreen) (s);
+					PROFILER_LEAVE (donePaintScreen);
+
+					profilerEndFrame (s);
+
+					resetArena (&s->frameArena);
+
+					if (countAllocations &&
+					    getHeapAllocationCount (&nAllocationDone))
+						updateAllocationStats (nAllocationDone - nAllocation);
 
 					/* remove destroyed windows */
 					while (s->pendingDestroys)
@@ -1191,24 +1385,13 @@ eventLoop (void)
 		}
 		else
 		{
-			if (core.timeouts)
+			if (core.nTimeout)
 			{
-				if (core.timeouts->minLeft > 0)
-				{
-					t = core.timeouts;
-					time = t->maxLeft;
-					while (t && t->minLeft <= time)
-					{
-						if (t->maxLeft < time)
-							time = t->maxLeft;
-						t = t->next;
-					}
+				time = getTimeToNextTimeout ();
+				if (time)
 					doPoll (time);
-				}
 
-				gettimeofday (&tv, 0);
-
-				handleTimeouts (&tv);
+				handleTimeouts ();
 			}
 			else
 			{
@@ -1395,6 +1578,10 @@ addDisplay (const char *name)
 	d->textureFilter = GL_LINEAR;
 	d->below         = None;
 
+	d->pendingDamageWindows = NULL;
+	d->damageRectsReceived  = 0;
+	d->damageRegionsApplied = 0;
+
 	d->activeWindow = 0;
 
 	d->autoRaiseHandle = 0;
@@ -2098,6 +2285,11 @@ removeDisplay (void)
 
 	compRemoveTimeout (display.pingHandle);
 
+	compLogMessage ("core", CompLogLevelDebug,
+	                "%lu damage rects received, %lu damage regions applied",
+	                display.damageRectsReceived,
+	                display.damageRegionsApplied);
+
 	if (display.snDisplay)
 		sn_display_unref (display.snDisplay);
 
@@ -2599,17 +2791,18 @@ clearTargetOutput (unsigned int mask)
 
 #define HOME_IMAGEDIR ".fusilli/images"
 
-Bool
-readImageFromFile (const char  *name,
-                   int         *width,
-                   int	       *height,
-                   void	       **data)
+static Bool
+readImageFromPaths (FileToImageProc fileToImageFunc,
+                    const char      *name,
+                    int             *width,
+                    int             *height,
+                    void            **data)
 {
 	Bool status;
 	int  stride;
 
-	status = (*display.fileToImage) (NULL, name, width, height,
-	                                  &stride, data);
+	status = (*fileToImageFunc) (NULL, name, width, height,
+	                             &stride, data);
 	if (!status)
 	{
 		char *home;
@@ -2623,9 +2816,9 @@ readImageFromFile (const char  *name,
 			if (path)
 			{
 				sprintf (path, "%s/%s", home, HOME_IMAGEDIR);
-				status = (*display.fileToImage) (path, name,
-				                                  width, height, &stride,
-				                                  data);
+				status = (*fileToImageFunc) (path, name,
+				                             width, height, &stride,
+				                             data);
 
 				free (path);
 
@@ -2634,13 +2827,34 @@ readImageFromFile (const char  *name,
 			}
 		}
 
-		status = (*display.fileToImage) (IMAGEDIR, name,
-		                                  width, height, &stride, data);
+		status = (*fileToImageFunc) (IMAGEDIR, name,
+		                             width, height, &stride, data);
 	}
 
 	return status;
 }
 
+Bool
+readImageFromFile (const char  *name,
+                   int         *width,
+                   int	       *height,
+                   void	       **data)
+{
+	return readImageFromPaths (display.fileToImage, name, width, height, data);
+}
+
+/* the same with only the png and jpeg loaders of core, it doesn't go
+   through the fileToImage wrappers of plugins and can be called from
+   any thread */
+Bool
+decodeImageFromFile (const char  *name,
+                     int         *width,
+                     int         *height,
+                     void        **data)
+{
+	return readImageFromPaths (fileToImage, name, width, height, data);
+}
+
 Bool
 writeImageToFile (const char  *path,
                   const char  *name,
@@ -76,6 +76,167 @@ handleWindowDamageRect (CompWindow *w,
 		damageWindowOutputExtents (w);
 }
 
+/* Damage rects are buffered per window while the event queue is
+   drained and applied once per event loop pass by flushPendingDamage.
+   Overlapping rects are merged there, and a window that gets more than
+   MAX_PENDING_DAMAGE_RECTS rects in one pass is reduced to the bounding
+   box of its damage. */
+static void
+addPendingWindowDamage (CompWindow *w,
+                        XRectangle *rect)
+{
+	BoxPtr box;
+	int    i;
+
+	display.damageRectsReceived++;
+
+	if (!rect->width || !rect->height)
+		return;
+
+	for (i = 0; i < w->nPendingDamage; i++)
+	{
+		box = &w->pendingDamage[i];
+
+		if (rect->x >= box->x1 && rect->x + rect->width <= box->x2 &&
+		    rect->y >= box->y1 && rect->y + rect->height <= box->y2)
+			return;
+	}
+
+	if (!w->nPendingDamage)
+	{
+		w->nextPendingDamage = display.pendingDamageWindows;
+		display.pendingDamageWindows = w;
+	}
+	else if (w->nPendingDamage == MAX_PENDING_DAMAGE_RECTS)
+	{
+		box = &w->pendingDamage[0];
+
+		for (i = 1; i < w->nPendingDamage; i++)
+		{
+			box->x1 = MIN (box->x1, w->pendingDamage[i].x1);
+			box->y1 = MIN (box->y1, w->pendingDamage[i].y1);
+			box->x2 = MAX (box->x2, w->pendingDamage[i].x2);
+			box->y2 = MAX (box->y2, w->pendingDamage[i].y2);
+		}
+
+		w->nPendingDamage = 1;
+	}
+
+	box = &w->pendingDamage[w->nPendingDamage++];
+
+	box->x1 = rect->x;
+	box->y1 = rect->y;
+	box->x2 = rect->x + rect->width;
+	box->y2 = rect->y + rect->height;
+}
+
+static void
+flushWindowDamage (CompWindow *w,
+                   Region     damage,
+                   Region     screenDamage)
+{
+	REGION region;
+	Bool   initial = FALSE, initialDamage;
+	int    i;
+
+	if (!w->redirected || w->bindFailed)
+		return;
+
+	if (!w->damaged)
+	{
+		w->damaged   = initial = TRUE;
+		w->invisible = WINDOW_INVISIBLE (w);
+	}
+
+	initialDamage = initial;
+
+	region.rects    = &region.extents;
+	region.numRects = region.size = 1;
+
+	compEmptyRegion (damage);
+
+	for (i = 0; i < w->nPendingDamage; i++)
+	{
+		region.extents = w->pendingDamage[i];
+		compUnionRegion (&region, damage, damage);
+	}
+
+	compEmptyRegion (screenDamage);
+
+	for (i = 0; i < damage->numRects; i++)
+	{
+		region.extents = damage->rects[i];
+
+		if (!(*w->screen->damageWindowRect) (w, initial, &region.extents))
+		{
+			region.extents.x1 += w->attrib.x + w->attrib.border_width;
+			region.extents.y1 += w->attrib.y + w->attrib.border_width;
+			region.extents.x2 += w->attrib.x + w->attrib.border_width;
+			region.extents.y2 += w->attrib.y + w->attrib.border_width;
+
+			compUnionRegion (&region, screenDamage, screenDamage);
+		}
+
+		initial = FALSE;
+	}
+
+	if (REGION_NOT_EMPTY (screenDamage))
+	{
+		damageScreenRegion (w->screen, screenDamage);
+		display.damageRegionsApplied++;
+	}
+
+	if (initialDamage)
+		damageWindowOutputExtents (w);
+}
+
+void
+flushPendingDamage (void)
+{
+	CompWindow *w;
+	CompRegion damage, screenDamage;
+
+	if (!display.pendingDamageWindows)
+		return;
+
+	initRegion (&damage);
+	initRegion (&screenDamage);
+
+	while ((w = display.pendingDamageWindows))
+	{
+		display.pendingDamageWindows = w->nextPendingDamage;
+
+		flushWindowDamage (w, &damage.region, &screenDamage.region);
+
+		w->nPendingDamage    = 0;
+		w->nextPendingDamage = NULL;
+	}
+
+	finiRegion (&damage);
+	finiRegion (&screenDamage);
+}
+
+void
+discardPendingWindowDamage (CompWindow *w)
+{
+	CompWindow **p;
+
+	if (!w->nPendingDamage)
+		return;
+
+	for (p = &display.pendingDamageWindows; *p; p = &(*p)->nextPendingDamage)
+	{
+		if (*p == w)
+		{
+			*p = w->nextPendingDamage;
+			break;
+		}
+	}
+
+	w->nPendingDamage    = 0;
+	w->nextPendingDamage = NULL;
+}
+
 void
 handleSyncAlarm (CompWindow *w)
 {
@@ -2003,6 +2164,7 @@ handleEvent (XEvent      *event)
 			if (w)
 			{
 				w->texture->oldMipmaps = TRUE;
+				w->atlasDamaged        = TRUE;
 
 				if (w->syncWait)
 				{
@@ -2022,11 +2184,7 @@ handleEvent (XEvent      *event)
 				}
 				else
 				{
-					handleWindowDamageRect (w,
-					                        de->area.x,
-					                        de->area.y,
-					                        de->area.width,
-					                        de->area.height);
+					addPendingWindowDamage (w, &de->area);
 				}
 			}
 		}
@@ -2063,12 +2221,7 @@ handleEvent (XEvent      *event)
 
 			for (s = display.screens; s; s = s->next)
 			{
-				for (w = s->windows; w; w = w->next)
-				{
-					if (w->syncAlarm == sa->alarm)
-						break;
-				}
-
+				w = findWindowInHash (&s->syncAlarmHash, sa->alarm);
 				if (w)
 				{
 					handleSyncAlarm (w);
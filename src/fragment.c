@@ -36,13 +36,17 @@
 #define COMP_FUNCTION_MASK     (COMP_FUNCTION_ARB_MASK)
 
 struct _CompProgram {
-	struct _CompProgram *next;
+	struct _CompProgram *next; /* in the same bucket */
 
-	int *signature;
-	int nSignature;
+	int          *signature;
+	int          nSignature;
+	unsigned int hash;
 
 	Bool blending;
 
+	/* GLSL translation, used instead of the ARB program if not NULL */
+	CompShader *shader;
+
 	GLuint name;
 	GLenum type;
 };
@@ -121,8 +125,10 @@ struct _CompFunction {
 };
 
 typedef struct _FetchInfo {
-	int  indices[MAX_FRAGMENT_FUNCTIONS];
-	char *data;
+	int    indices[MAX_FRAGMENT_FUNCTIONS];
+	char   *data;
+	size_t length;
+	size_t size;
 } FetchInfo;
 
 typedef void (*DataOpCallBackProc) (CompDataOp *op,
@@ -185,26 +191,40 @@ findFragmentFunctionWithName (CompScreen *s,
 	return NULL;
 }
 
+/* FNV-1a over the function ids */
+static unsigned int
+hashSignature (const int *signature,
+               int       nSignature)
+{
+	const unsigned char *data = (const unsigned char *) signature;
+	unsigned int        hash = 2166136261u;
+	size_t              i;
+
+	for (i = 0; i < nSignature * sizeof (int); i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
 static CompProgram *
-findFragmentProgram (CompScreen *s,
-                     int        *signature,
-                     int        nSignature)
+findFragmentProgram (CompScreen   *s,
+                     int          *signature,
+                     int          nSignature,
+                     unsigned int hash)
 {
 	CompProgram *program;
-	int i;
 
-	for (program = s->fragmentPrograms; program; program = program->next)
+	program = s->fragmentPrograms[hash & (FRAGMENT_PROGRAM_HASH_SIZE - 1)];
+	for (; program; program = program->next)
 	{
-		if (nSignature != program->nSignature)
+		if (program->hash != hash || program->nSignature != nSignature)
 			continue;
 
-		for (i = 0; i < nSignature; i++)
-		{
-			if (program->signature[i] != signature[i])
-				break;
-		}
-
-		if (i == nSignature)
+		if (!memcmp (program->signature, signature,
+		             nSignature * sizeof (int)))
 			return program;
 	}
 
@@ -497,6 +517,32 @@ forEachDataOp (CompFunction       **list,
 	return blendDone;
 }
 
+static void
+appendProgramData (FetchInfo  *info,
+                   const char *data)
+{
+	size_t length = strlen (data);
+
+	if (info->length + length + 1 > info->size)
+	{
+		char   *str;
+		size_t size = info->size ? info->size : 1024;
+
+		while (info->length + length + 1 > size)
+			size *= 2;
+
+		str = realloc (info->data, size);
+		if (!str)
+			return;
+
+		info->data = str;
+		info->size = size;
+	}
+
+	memcpy (info->data + info->length, data, length + 1);
+	info->length += length;
+}
+
 static void
 addFetchOffsetVariables (CompDataOp *op,
                          int        index,
@@ -508,21 +554,11 @@ addFetchOffsetVariables (CompDataOp *op,
 
 		if (!info->indices[index])
 		{
-			char *str;
-			int      oldSize = strlen (info->data);
-			int      newSize;
 			char data[256];
 
 			snprintf (data, 256, "TEMP __tmp_texcoord%d;", index);
 
-			newSize = oldSize + strlen (data);
-
-			str = realloc (info->data, newSize + 1);
-			if (str)
-			{
-				strcpy (str + oldSize, data);
-				info->data = str;
-			}
+			appendProgramData (info, data);
 
 			info->indices[index] = TRUE;
 		}
@@ -534,19 +570,11 @@ addData (CompDataOp *op,
          int        index,
          void       *closure)
 {
-	FetchInfo *info = (FetchInfo *) closure;
-	char      *str;
-	int       oldSize = strlen (info->data);
-	int       newSize = oldSize + strlen (op->data);
-
-	str = realloc (info->data, newSize + 1);
-	if (str)
-	{
-		strcpy (str + oldSize, op->data);
-		info->data = str;
-	}
+	appendProgramData ((FetchInfo *) closure, op->data);
 }
 
+/* programs whose functions can't be linked are kept too, without a
+   shader or program name, so they are not rebuilt on every frame */
 static CompProgram *
 buildFragmentProgram (CompScreen     *s,
                       FragmentAttrib *attrib)
@@ -560,18 +588,34 @@ buildFragmentProgram (CompScreen     *s,
 	FetchInfo    info;
 	int          i;
 
+	functionList = allocFrameMemory (s, (attrib->nFunction + 1) *
+	                                 sizeof (void *));
+	if (!functionList)
+		return NULL;
+
 	program = malloc (sizeof (CompProgram));
 	if (!program)
 		return NULL;
 
-	functionList = malloc ((attrib->nFunction + 1) * sizeof (void *));
-	if (!functionList)
+	program->signature = malloc (attrib->nFunction * sizeof (int));
+	if (!program->signature)
 	{
 		free (program);
 
 		return NULL;
 	}
 
+	for (i = 0; i < attrib->nFunction; i++)
+		program->signature[i] = attrib->function[i];
+
+	program->nSignature = attrib->nFunction;
+	program->hash       = hashSignature (program->signature,
+	                                     program->nSignature);
+	program->blending   = FALSE;
+	program->shader     = NULL;
+	program->name       = 0;
+	program->type       = 0;
+
 	functionList[0] = &initialLoadFunction;
 	nFunctionList   = 1;
 
@@ -594,31 +638,23 @@ buildFragmentProgram (CompScreen     *s,
 	}
 
 	if (!mask || nFunctionList == 1)
-	{
-		free (program);
-		free (functionList);
+		return program;
 
-		return NULL;
-	}
+	type = functionMaskToType (mask);
 
-	program->signature = malloc (attrib->nFunction * sizeof (int));
-	if (!program->signature)
+	info.data   = NULL;
+	info.length = 0;
+	info.size   = 0;
+
+	appendProgramData (&info, "!!ARBfp1.0");
+	if (!info.data)
 	{
+		free (program->signature);
 		free (program);
-		free (functionList);
 
 		return NULL;
 	}
 
-	for (i = 0; i < attrib->nFunction; i++)
-		program->signature[i] = attrib->function[i];
-
-	program->nSignature = attrib->nFunction;
-
-	type = functionMaskToType (mask);
-
-	info.data = strdup ("!!ARBfp1.0");
-
 	memset (info.indices, 0, sizeof (info.indices));
 
 	forEachDataOp (functionList, nFunctionList, type,
@@ -627,6 +663,14 @@ buildFragmentProgram (CompScreen     *s,
 	program->blending = forEachDataOp (functionList, nFunctionList, type,
 	                                   addData, (void *) &info);
 
+	program->shader = createFragmentShader (s, info.data, program->hash);
+	if (program->shader)
+	{
+		free (info.data);
+
+		return program;
+	}
+
 	program->type = GL_FRAGMENT_PROGRAM_ARB;
 
 	glGetError ();
@@ -635,7 +679,7 @@ buildFragmentProgram (CompScreen     *s,
 	(*s->bindProgram) (GL_FRAGMENT_PROGRAM_ARB, program->name);
 	(*s->programString) (GL_FRAGMENT_PROGRAM_ARB,
 	                     GL_PROGRAM_FORMAT_ASCII_ARB,
-	                     strlen (info.data), info.data);
+	                     info.length, info.data);
 
 	glGetIntegerv (GL_PROGRAM_ERROR_POSITION_ARB, &errorPos);
 	if (glGetError () != GL_NO_ERROR || errorPos != -1)
@@ -650,42 +694,40 @@ buildFragmentProgram (CompScreen     *s,
 	}
 
 	free (info.data);
-	free (functionList);
 
 	return program;
 }
 
-static GLuint
+static CompProgram *
 getFragmentProgram (CompScreen     *s,
-                    FragmentAttrib *attrib,
-                    GLenum        *type,
-                    Bool          *blending)
+                    FragmentAttrib *attrib)
 {
-	CompProgram *program;
+	CompProgram  *program, **bucket;
+	unsigned int hash;
 
 	if (!attrib->nFunction)
-		return 0;
+		return NULL;
 
-	program = findFragmentProgram (s, attrib->function, attrib->nFunction);
+	hash    = hashSignature (attrib->function, attrib->nFunction);
+	program = findFragmentProgram (s, attrib->function, attrib->nFunction,
+	                               hash);
 	if (!program)
 	{
 		program = buildFragmentProgram (s, attrib);
 		if (program)
 		{
-			program->next = s->fragmentPrograms;
-			s->fragmentPrograms = program;
+			bucket = &s->fragmentPrograms[hash &
+			                              (FRAGMENT_PROGRAM_HASH_SIZE - 1)];
+
+			program->next = *bucket;
+			*bucket = program;
 		}
 	}
 
-	if (program)
-	{
-		*type     = program->type;
-		*blending = program->blending;
-
-		return program->name;
-	}
+	if (program && (program->shader || program->name))
+		return program;
 
-	return 0;
+	return NULL;
 }
 
 CompFunctionData *
@@ -1205,8 +1247,8 @@ destroyFragmentFunction (CompScreen *s,
                          int        id)
 {
 	CompFunction *function, *prevFunction = NULL;
-	CompProgram  *program, *prevProgram = NULL;
-	int i;
+	CompProgram  *program, *prevProgram;
+	int i, j;
 
 	for (function = s->fragmentFunctions; function; function = function->next)
 	{
@@ -1219,35 +1261,43 @@ destroyFragmentFunction (CompScreen *s,
 	if (!function)
 		return;
 
-	program = s->fragmentPrograms;
-	while (program)
+	for (j = 0; j < FRAGMENT_PROGRAM_HASH_SIZE; j++)
 	{
-		for (i = 0; i < program->nSignature; i++)
-		{
-			if (program->signature[i] == id)
-				break;
-		}
+		prevProgram = NULL;
 
-		if (i < program->nSignature)
+		program = s->fragmentPrograms[j];
+		while (program)
 		{
-			CompProgram *tmp = program;
+			for (i = 0; i < program->nSignature; i++)
+			{
+				if (program->signature[i] == id)
+					break;
+			}
 
-			if (prevProgram)
-				prevProgram->next = program->next;
-			else
-				s->fragmentPrograms = program->next;
+			if (i < program->nSignature)
+			{
+				CompProgram *tmp = program;
 
-			program = program->next;
+				if (prevProgram)
+					prevProgram->next = program->next;
+				else
+					s->fragmentPrograms[j] = program->next;
 
-			(*s->deletePrograms) (1, &tmp->name);
+				program = program->next;
 
-			free (tmp->signature);
-			free (tmp);
-		}
-		else
-		{
-			prevProgram = program;
-			program = program->next;
+				if (tmp->shader)
+					destroyFragmentShader (s, tmp->shader);
+				else if (tmp->name)
+					(*s->deletePrograms) (1, &tmp->name);
+
+				free (tmp->signature);
+				free (tmp);
+			}
+			else
+			{
+				prevProgram = program;
+				program = program->next;
+			}
 		}
 	}
 
@@ -1375,22 +1425,27 @@ enableFragmentAttrib (CompScreen     *s,
                       FragmentAttrib *attrib,
                       Bool           *blending)
 {
-	GLuint name;
-	GLenum type;
-	Bool   programBlending;
+	CompProgram *program;
 
 	if (!s->fragmentProgram)
 		return FALSE;
 
-	name = getFragmentProgram (s, attrib, &type, &programBlending);
-	if (!name)
+	program = getFragmentProgram (s, attrib);
+	if (!program)
 		return FALSE;
 
-	*blending = !programBlending;
+	*blending = !program->blending;
+
+	if (program->shader)
+	{
+		enableFragmentShader (s, program->shader);
+
+		return TRUE;
+	}
 
 	glEnable (GL_FRAGMENT_PROGRAM_ARB);
 
-	(*s->bindProgram) (type, name);
+	(*s->bindProgram) (program->type, program->name);
 
 	return TRUE;
 }
@@ -1399,5 +1454,8 @@ void
 disableFragmentAttrib (CompScreen     *s,
                        FragmentAttrib *attrib)
 {
+	if (s->fragmentShader)
+		disableFragmentShader (s);
+
 	glDisable (GL_FRAGMENT_PROGRAM_ARB);
 }
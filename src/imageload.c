@@ -0,0 +1,395 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Asynchronous image loading.
+ *
+ * Decoding a large png or jpeg file takes long enough to stall the
+ * compositor, so readImageToTextureAsync hands the file to a worker
+ * thread. The worker decodes it, with premultiplied alpha, using the
+ * image loaders of core, and wakes up the main loop through a pipe.
+ * The image is uploaded to the texture and the callback is called from
+ * the main loop, in the order the loads were started.
+ *
+ * Formats that only a plugin can read through the fileToImage hook,
+ * like svg, are not safe to decode on the worker. When core can't read
+ * a file it is loaded with readImageFromFile on the main loop instead.
+ *
+ * The texture and the closure have to stay valid until the callback is
+ * called or the load is cancelled. When there is no worker the image is
+ * loaded before readImageToTextureAsync returns, with the callback, and
+ * the handle is 0.
+ */
+
+typedef struct _CompImageLoad {
+	struct _CompImageLoad *next;
+
+	CompImageLoadHandle handle;
+	CompScreen          *screen;
+	CompTexture         *texture;
+	char                *name;
+	ImageLoadedProc     callBack;
+	void                *closure;
+
+	/* set by the worker */
+	Bool status;
+	int  width, height;
+	void *data;
+
+	/* cancelled while the worker decodes it */
+	Bool cancelled;
+} CompImageLoad;
+
+static pthread_mutex_t loadMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  loadCond = PTHREAD_COND_INITIALIZER;
+static pthread_t       loadThread;
+static Bool            loadThreadRunning = FALSE;
+static Bool            loadThreadQuit = FALSE;
+
+/* loads in the order they were started, protected by loadMutex */
+static CompImageLoad *pendingLoads = NULL;
+static CompImageLoad *currentLoad = NULL;
+static CompImageLoad *doneLoads = NULL;
+
+static int                 loadPipe[2] = { -1, -1 };
+static CompWatchFdHandle   loadWatchFdHandle = 0;
+static CompImageLoadHandle lastImageLoadHandle = 1;
+
+static void
+appendImageLoad (CompImageLoad **list,
+                 CompImageLoad *load)
+{
+	load->next = NULL;
+
+	while (*list)
+		list = &(*list)->next;
+
+	*list = load;
+}
+
+static Bool
+removeImageLoad (CompImageLoad       **list,
+                 CompImageLoadHandle handle)
+{
+	CompImageLoad *load;
+
+	for (; *list; list = &(*list)->next)
+	{
+		if ((*list)->handle == handle)
+		{
+			load  = *list;
+			*list = load->next;
+
+			if (load->data)
+				free (load->data);
+
+			free (load->name);
+			free (load);
+
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void *
+imageLoadThread (void *closure)
+{
+	CompImageLoad *load;
+	char          c = 0;
+
+	pthread_mutex_lock (&loadMutex);
+
+	for (;;)
+	{
+		while (!pendingLoads && !loadThreadQuit)
+			pthread_cond_wait (&loadCond, &loadMutex);
+
+		if (loadThreadQuit)
+			break;
+
+		load         = pendingLoads;
+		pendingLoads = load->next;
+		currentLoad  = load;
+
+		pthread_mutex_unlock (&loadMutex);
+
+		load->status = decodeImageFromFile (load->name,
+		                                    &load->width, &load->height,
+		                                    &load->data);
+
+		pthread_mutex_lock (&loadMutex);
+
+		currentLoad = NULL;
+
+		if (load->cancelled)
+		{
+			if (load->data)
+				free (load->data);
+
+			free (load->name);
+			free (load);
+		}
+		else
+		{
+			appendImageLoad (&doneLoads, load);
+
+			/* when the pipe is full the main loop is woken up anyway */
+			while (write (loadPipe[1], &c, 1) < 0 && errno == EINTR);
+		}
+	}
+
+	pthread_mutex_unlock (&loadMutex);
+
+	return NULL;
+}
+
+static void
+finishImageLoad (CompImageLoad *load)
+{
+	CompScreen *s = load->screen;
+
+	/* a format of a plugin */
+	if (!load->status)
+		load->status = readImageFromFile (load->name,
+		                                  &load->width, &load->height,
+		                                  &load->data);
+
+	if (load->status)
+	{
+		finiTexture (s, load->texture);
+		initTexture (s, load->texture);
+
+		load->status = imageBufferToTexture (s, load->texture, load->data,
+		                                     load->width, load->height);
+	}
+	else
+	{
+		load->width  = 0;
+		load->height = 0;
+	}
+
+	(*load->callBack) (s, load->texture, load->status,
+	                   load->width, load->height, load->closure);
+
+	if (load->data)
+		free (load->data);
+
+	free (load->name);
+	free (load);
+}
+
+static Bool
+imageLoadWatch (void *closure)
+{
+	CompImageLoad *load;
+	char          buf[64];
+
+	while (read (loadPipe[0], buf, sizeof (buf)) > 0);
+
+	/* one at a time, a callback can cancel the loads after it */
+	for (;;)
+	{
+		pthread_mutex_lock (&loadMutex);
+
+		load = doneLoads;
+		if (load)
+			doneLoads = load->next;
+
+		pthread_mutex_unlock (&loadMutex);
+
+		if (!load)
+			break;
+
+		finishImageLoad (load);
+	}
+
+	return TRUE;
+}
+
+static Bool
+startImageLoadThread (void)
+{
+	if (loadThreadRunning)
+		return TRUE;
+
+	if (pipe (loadPipe) < 0)
+		return FALSE;
+
+	fcntl (loadPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl (loadPipe[1], F_SETFL, O_NONBLOCK);
+	fcntl (loadPipe[0], F_SETFD, FD_CLOEXEC);
+	fcntl (loadPipe[1], F_SETFD, FD_CLOEXEC);
+
+	loadThreadQuit = FALSE;
+
+	if (pthread_create (&loadThread, NULL, imageLoadThread, NULL))
+	{
+		close (loadPipe[0]);
+		close (loadPipe[1]);
+		loadPipe[0] = loadPipe[1] = -1;
+
+		return FALSE;
+	}
+
+	loadWatchFdHandle = compAddWatchFd (loadPipe[0], POLLIN,
+	                                    imageLoadWatch, NULL);
+
+	loadThreadRunning = TRUE;
+
+	return TRUE;
+}
+
+/* without a worker the image is loaded right away */
+static CompImageLoadHandle
+readImageToTextureNow (CompScreen      *screen,
+                       CompTexture     *texture,
+                       const char      *imageFileName,
+                       ImageLoadedProc callBack,
+                       void            *closure)
+{
+	unsigned int width, height;
+	Bool         status;
+
+	status = readImageToTexture (screen, texture, imageFileName,
+	                             &width, &height);
+	if (!status)
+		width = height = 0;
+
+	(*callBack) (screen, texture, status, width, height, closure);
+
+	return 0;
+}
+
+CompImageLoadHandle
+readImageToTextureAsync (CompScreen      *screen,
+                         CompTexture     *texture,
+                         const char      *imageFileName,
+                         ImageLoadedProc callBack,
+                         void            *closure)
+{
+	CompImageLoad *load;
+
+	if (!startImageLoadThread ())
+	{
+		compLogMessage ("core", CompLogLevelWarn,
+		                "Couldn't start the image loader thread.");
+
+		return readImageToTextureNow (screen, texture, imageFileName,
+		                              callBack, closure);
+	}
+
+	load = calloc (1, sizeof (CompImageLoad));
+	if (!load)
+		return readImageToTextureNow (screen, texture, imageFileName,
+		                              callBack, closure);
+
+	load->name = strdup (imageFileName);
+	if (!load->name)
+	{
+		free (load);
+		return readImageToTextureNow (screen, texture, imageFileName,
+		                              callBack, closure);
+	}
+
+	load->screen   = screen;
+	load->texture  = texture;
+	load->callBack = callBack;
+	load->closure  = closure;
+	load->handle   = lastImageLoadHandle++;
+
+	if (lastImageLoadHandle == MAXSHORT)
+		lastImageLoadHandle = 1;
+
+	pthread_mutex_lock (&loadMutex);
+
+	appendImageLoad (&pendingLoads, load);
+	pthread_cond_signal (&loadCond);
+
+	pthread_mutex_unlock (&loadMutex);
+
+	return load->handle;
+}
+
+void
+cancelImageLoad (CompImageLoadHandle handle)
+{
+	if (!handle)
+		return;
+
+	pthread_mutex_lock (&loadMutex);
+
+	if (currentLoad && currentLoad->handle == handle)
+		currentLoad->cancelled = TRUE;
+	else if (!removeImageLoad (&pendingLoads, handle))
+		removeImageLoad (&doneLoads, handle);
+
+	pthread_mutex_unlock (&loadMutex);
+}
+
+void
+finiImageLoader (void)
+{
+	if (!loadThreadRunning)
+		return;
+
+	pthread_mutex_lock (&loadMutex);
+
+	loadThreadQuit = TRUE;
+	pthread_cond_signal (&loadCond);
+
+	pthread_mutex_unlock (&loadMutex);
+
+	/* waits for the file that is decoded now */
+	pthread_join (loadThread, NULL);
+
+	while (pendingLoads)
+		removeImageLoad (&pendingLoads, pendingLoads->handle);
+	while (doneLoads)
+		removeImageLoad (&doneLoads, doneLoads->handle);
+
+	compRemoveWatchFd (loadWatchFdHandle);
+
+	close (loadPipe[0]);
+	close (loadPipe[1]);
+	loadPipe[0] = loadPipe[1] = -1;
+
+	loadThreadRunning = FALSE;
+}
@@ -45,8 +45,7 @@ rgbToBGRA (const JSAMPLE *source,
            int           width,
            int           alpha)
 {
-	int  h, w;
-	char *dest;
+	unsigned int *dest;
 
 	dest = malloc (height * width * 4);
 	if (!dest)
@@ -54,22 +53,7 @@ rgbToBGRA (const JSAMPLE *source,
 
 	*data = dest;
 
-	for (h = 0; h < height; h++)
-		for (w = 0; w < width; w++)
-		{
-			int pos = h * width + w;
-#if __BYTE_ORDER == __BIG_ENDIAN
-			dest[(pos * 4) + 3] = source[(pos * 3) + 2];    /* blue */
-			dest[(pos * 4) + 2] = source[(pos * 3) + 1];    /* green */
-			dest[(pos * 4) + 1] = source[(pos * 3) + 0];    /* red */
-			dest[(pos * 4) + 0] = alpha;
-#else
-			dest[(pos * 4) + 0] = source[(pos * 3) + 2];    /* blue */
-			dest[(pos * 4) + 1] = source[(pos * 3) + 1];    /* green */
-			dest[(pos * 4) + 2] = source[(pos * 3) + 0];    /* red */
-			dest[(pos * 4) + 3] = alpha;
-#endif
-	}
+	convertRgbToArgb (source, dest, height * width, alpha);
 
 	return TRUE;
 }
@@ -81,8 +65,7 @@ rgbaToRGB (char    *source,
            int     width,
            int     stride)
 {
-	int     h, w;
-	int     ps = stride / width;   /* pixel size */
+	int     h;
 	JSAMPLE *d;
 
 	d = malloc (height * width * 3 * sizeof (JSAMPLE));
@@ -92,19 +75,8 @@ rgbaToRGB (char    *source,
 	*dest = d;
 
 	for (h = 0; h < height; h++)
-		for (w = 0; w < width; w++)
-		{
-			int pos = h * width + w;
-#if __BYTE_ORDER == __BIG_ENDIAN
-			d[(pos * 3) + 0] = source[(pos * ps) + 3];  /* red */
-			d[(pos * 3) + 1] = source[(pos * ps) + 2];  /* green */
-			d[(pos * 3) + 2] = source[(pos * ps) + 1];  /* blue */
-#else
-			d[(pos * 3) + 0] = source[(pos * ps) + 0];  /* red */
-			d[(pos * 3) + 1] = source[(pos * ps) + 1];  /* green */
-			d[(pos * 3) + 2] = source[(pos * ps) + 2];  /* blue */
-#endif
-	}
+		convertRgbaToRgb ((unsigned char *) source + h * stride,
+		                  d + h * width * 3, width);
 
 	return TRUE;
 }
@@ -64,8 +64,11 @@ Bool replaceCurrentWm = FALSE;
 Bool indirectRendering = FALSE;
 Bool strictBinding = TRUE;
 Bool useDesktopHints = FALSE;
+Bool useMetadataCache = TRUE;
 Bool onlyCurrentScreen = FALSE;
-static Bool debugOutput = FALSE;
+Bool debugOutput = FALSE;
+
+char *regionDumpFile = NULL;
 
 #ifdef USE_COW
 Bool useCow = TRUE;
@@ -73,9 +76,38 @@ Bool useCow = TRUE;
 
 int coreBananaIndex;
 
+BananaOptionHandle coreOptionSyncToVBlank;
+BananaOptionHandle coreOptionUnredirectFullscreenWindows;
+BananaOptionHandle coreOptionForceIndependentOutputPainting;
+BananaOptionHandle coreOptionLighting;
+BananaOptionHandle coreOptionOverlappingOutputs;
+BananaOptionHandle coreOptionFrameScheduler;
+BananaOptionHandle coreOptionTextureAtlas;
+
 char *metaDataDir = NULL;
 char *configurationFile = NULL;
 
+static void
+initCoreOptionHandles (void)
+{
+	coreOptionSyncToVBlank =
+	    bananaGetOptionHandle (coreBananaIndex, "sync_to_vblank");
+	coreOptionUnredirectFullscreenWindows =
+	    bananaGetOptionHandle (coreBananaIndex,
+	                           "unredirect_fullscreen_windows");
+	coreOptionForceIndependentOutputPainting =
+	    bananaGetOptionHandle (coreBananaIndex,
+	                           "force_independent_output_painting");
+	coreOptionLighting =
+	    bananaGetOptionHandle (coreBananaIndex, "lighting");
+	coreOptionOverlappingOutputs =
+	    bananaGetOptionHandle (coreBananaIndex, "overlapping_outputs");
+	coreOptionFrameScheduler =
+	    bananaGetOptionHandle (coreBananaIndex, "frame_scheduler");
+	coreOptionTextureAtlas =
+	    bananaGetOptionHandle (coreBananaIndex, "texture_atlas");
+}
+
 static void
 usage (void)
 {
@@ -90,6 +122,7 @@ usage (void)
 	        "[--sm-client-id ID] "
 	        "[--only-current-screen]\n"
 	        "\t[--metadatadir DIR] "
+	        "[--no-metadata-cache] "
 	        "[--bananafile FILE]\n    "
 
 #ifdef USE_COW
@@ -97,6 +130,8 @@ usage (void)
 #endif
 
 	        "\t[--debug] "
+	        "[--profile] "
+	        "[--dump-regions FILE] "
 	        "[--version] "
 	        "[--help]\n",
 	        programName);
@@ -225,6 +260,15 @@ main (int argc, char **argv)
 		{
 			debugOutput = TRUE;
 		}
+		else if (!strcmp (argv[i], "--profile"))
+		{
+			profilerEnabled = TRUE;
+		}
+		else if (!strcmp (argv[i], "--dump-regions"))
+		{
+			if (i + 1 < argc)
+				regionDumpFile = argv[++i];
+		}
 		else if (!strcmp (argv[i], "--display"))
 		{
 			if (i + 1 < argc)
@@ -259,6 +303,10 @@ main (int argc, char **argv)
 			if (i + 1 < argc)
 				metaDataDir = strdup (argv[++i]);
 		}
+		else if (!strcmp (argv[i], "--no-metadata-cache"))
+		{
+			useMetadataCache = FALSE;
+		}
 		else if (!strcmp (argv[i], "--bananafile"))
 		{
 			if (i + 1 < argc)
@@ -336,6 +384,8 @@ main (int argc, char **argv)
 
 	coreBananaIndex = bananaLoadPlugin ("core");
 
+	initCoreOptionHandles ();
+
 	coreInitialized = TRUE;
 
 	if (!disableSm)
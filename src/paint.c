@@ -24,6 +24,7 @@
  *         Michail Bitzes <noodlylight@gmail.com>
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -178,7 +179,7 @@ paintBackground (CompScreen   *s,
 		s->backgroundLoaded = TRUE;
 	}
 
-	data = malloc (sizeof (GLfloat) * nBox * 16);
+	data = allocFrameMemory (s, sizeof (GLfloat) * nBox * 16);
 	if (!data)
 		return;
 
@@ -233,10 +234,171 @@ paintBackground (CompScreen   *s,
 		glDrawArrays (GL_QUADS, 0, nBox * 4);
 		glColor4usv (defaultColor);
 	}
+}
+
+void
+setWindowOcclusionHook (CompWindow *w,
+                        Bool       *hooked,
+                        Bool       hook)
+{
+	hook = hook ? TRUE : FALSE;
+
+	if (*hooked == hook)
+		return;
+
+	*hooked = hook;
+
+	if (hook)
+		w->occlusionHooks++;
+	else
+		w->occlusionHooks--;
+}
+
+void
+setScreenOcclusionHook (CompScreen *s,
+                        Bool       *hooked,
+                        Bool       hook)
+{
+	hook = hook ? TRUE : FALSE;
+
+	if (*hooked == hook)
+		return;
+
+	*hooked = hook;
+
+	if (hook)
+		s->occlusionHooks++;
+	else
+		s->occlusionHooks--;
+}
+
+/* a window that no plugin hooks occludes exactly what core says it
+   does, so ask core directly instead of every plugin's paintWindow */
+static Bool
+detectWindowOcclusion (CompWindow          *w,
+                       const CompTransform *transform,
+                       Region              region,
+                       unsigned int        mask)
+{
+	CompScreen *s = w->screen;
+	Bool       status;
+
+	if (!s->occlusionHooks && !w->occlusionHooks)
+		return paintWindow (w, &w->paint, transform, region, mask);
+
+	PROFILER_ENTER (s, paintWindow);
+	status = (*s->paintWindow) (w, &w->paint, transform, region, mask);
+	PROFILER_LEAVE (paintWindow);
+
+	return status;
+}
+
+/* Walks either the windows of the screen walker or, when nothing
+   transforms or offsets the windows, only the ones overlapping the
+   output that is painted. */
+typedef struct _OutputWalker {
+	CompWalker        walk;
+	CompOutputWindows *list;
+	int               i;
+} OutputWalker;
+
+static CompWindow *
+outputWalkFirst (CompScreen   *s,
+                 OutputWalker *ow)
+{
+	if (!ow->list)
+		return (*ow->walk.first) (s);
+
+	ow->i = 0;
 
-	free (data);
+	return ow->i < ow->list->nWindow ? ow->list->windows[ow->i] : NULL;
 }
 
+static CompWindow *
+outputWalkLast (CompScreen   *s,
+                OutputWalker *ow)
+{
+	if (!ow->list)
+		return (*ow->walk.last) (s);
+
+	ow->i = ow->list->nWindow - 1;
+
+	return ow->i >= 0 ? ow->list->windows[ow->i] : NULL;
+}
+
+static CompWindow *
+outputWalkNext (CompWindow   *w,
+                OutputWalker *ow)
+{
+	if (!ow->list)
+		return (*ow->walk.next) (w);
+
+	return ++ow->i < ow->list->nWindow ? ow->list->windows[ow->i] : NULL;
+}
+
+static CompWindow *
+outputWalkPrev (CompWindow   *w,
+                OutputWalker *ow)
+{
+	if (!ow->list)
+		return (*ow->walk.prev) (w);
+
+	return --ow->i >= 0 ? ow->list->windows[ow->i] : NULL;
+}
+
+/* the output lists skip windows on other outputs, those still keep a
+   fullscreen window below them redirected */
+static Bool
+visibleWindowAbove (CompWindow *w)
+{
+	for (w = w->next; w; w = w->next)
+	{
+		if (w->destroyed || w->invisible)
+			continue;
+
+		if (w->shaded || (w->attrib.map_state == IsViewable && w->damaged))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* --dump-regions: every paintOutputRegion call writes its damage and
+   then the region of every window the occlusion pass looks at, top
+   to bottom, one line each. "opaque" windows are subtracted from the
+   clip of the windows below them, "window" ones are not. Viewport
+   offsets are not recorded. bench/fusilli-region-bench.c replays
+   these files. */
+static FILE *regionDump = NULL;
+
+static void
+dumpRegion (const char *tag,
+            Region     region)
+{
+	int i;
+
+	if (!regionDump)
+	{
+		regionDump = fopen (regionDumpFile, "w");
+		if (!regionDump)
+		{
+			compLogMessage ("core", CompLogLevelWarn,
+			                "Couldn't open %s to dump regions",
+			                regionDumpFile);
+			regionDumpFile = NULL;
+			return;
+		}
+	}
+
+	fprintf (regionDump, "%s %ld", tag, region->numRects);
+
+	for (i = 0; i < region->numRects; i++)
+		fprintf (regionDump, " %d %d %d %d",
+		         region->rects[i].x1, region->rects[i].y1,
+		         region->rects[i].x2, region->rects[i].y2);
+
+	fputc ('\n', regionDump);
+}
 
 /* This function currently always performs occlusion detection to
    minimize paint regions. OpenGL precision requirements are no good
@@ -257,7 +419,7 @@ paintOutputRegion (CompScreen          *screen,
 	CompCursor    *c;
 	int           count, windowMask, odMask, i;
 	CompWindow    *fullscreenWindow = NULL;
-	CompWalker    walk;
+	OutputWalker  walk;
 	Bool          status;
 	Bool          withOffset = FALSE;
 	CompTransform vTransform;
@@ -282,14 +444,24 @@ paintOutputRegion (CompScreen          *screen,
 		count          = 0;
 	}
 
-	XSubtractRegion (region, &emptyRegion, tmpRegion);
+	compCopyRegion (region, tmpRegion);
 
-	(*screen->initWindowWalker) (screen, &walk);
+	if (regionDumpFile)
+		dumpRegion ("damage", region);
+
+	(*screen->initWindowWalker) (screen, &walk.walk);
+
+	walk.list = NULL;
+	if (!(mask & PAINT_SCREEN_TRANSFORMED_MASK) &&
+	    !screen->windowOffsetX && !screen->windowOffsetY &&
+	    !screen->occlusionHooks && screen->nOutputDev > 1)
+		walk.list = getOutputWindows (screen, output);
 
 	if (!(mask & PAINT_SCREEN_NO_OCCLUSION_DETECTION_MASK))
 	{
 		/* detect occlusions */
-		for (w = (*walk.last) (screen); w; w = (*walk.prev) (w))
+		for (w = outputWalkLast (screen, &walk); w;
+		     w = outputWalkPrev (w, &walk))
 		{
 			if (w->destroyed)
 				continue;
@@ -301,7 +473,7 @@ paintOutputRegion (CompScreen          *screen,
 			}
 
 			/* copy region */
-			XSubtractRegion (tmpRegion, &emptyRegion, w->clip);
+			compCopyRegion (tmpRegion, w->clip);
 
 			odMask = PAINT_WINDOW_OCCLUSION_DETECTION_MASK;
 
@@ -320,35 +492,39 @@ paintOutputRegion (CompScreen          *screen,
 				XOffsetRegion (w->clip, -offX, -offY);
 
 				odMask |= PAINT_WINDOW_WITH_OFFSET_MASK;
-				status = (*screen->paintWindow) (w, &w->paint, &vTransform,
-				                                 tmpRegion, odMask);
+				status = detectWindowOcclusion (w, &vTransform,
+				                                tmpRegion, odMask);
 			}
 			else
 			{
 				withOffset = FALSE;
-				status = (*screen->paintWindow) (w, &w->paint, transform,
-				                                 tmpRegion, odMask);
+				status = detectWindowOcclusion (w, transform,
+				                                tmpRegion, odMask);
 			}
 
+			if (regionDumpFile)
+				dumpRegion (status ? "opaque" : "window", w->region);
+
 			if (status)
 			{
 				if (withOffset)
 				{
 					XOffsetRegion (w->region, offX, offY);
-					XSubtractRegion (tmpRegion, w->region, tmpRegion);
+					compSubtractRegion (tmpRegion, w->region, tmpRegion);
 					XOffsetRegion (w->region, -offX, -offY);
 				}
 				else
-					XSubtractRegion (tmpRegion, w->region, tmpRegion);
+					compSubtractRegion (tmpRegion, w->region, tmpRegion);
 
 				/* unredirect top most fullscreen windows. */
 				const BananaValue *
-				option_unredirect_fs = bananaGetOption (
-				    coreBananaIndex, "unredirect_fullscreen_windows", 
+				option_unredirect_fs = bananaGetOptionByHandle (
+				    coreOptionUnredirectFullscreenWindows,
 				    screen->screenNum);
 
 				if (count == 0 &&
-				    option_unredirect_fs->b)
+				    option_unredirect_fs->b &&
+				    (!walk.list || !visibleWindowAbove (w)))
 				{
 					if (XEqualRegion (w->region, &screen->region) &&
 					    !REGION_NOT_EMPTY (tmpRegion))
@@ -370,6 +546,9 @@ paintOutputRegion (CompScreen          *screen,
 		}
 	}
 
+	if (regionDump)
+		fflush (regionDump);
+
 	if (fullscreenWindow)
 		unredirectWindow (fullscreenWindow);
 
@@ -378,7 +557,8 @@ paintOutputRegion (CompScreen          *screen,
 		                (mask & PAINT_SCREEN_TRANSFORMED_MASK));
 
 	/* paint all windows from bottom to top */
-	for (w = (*walk.first) (screen); w; w = (*walk.next) (w))
+	for (w = outputWalkFirst (screen, &walk); w;
+	     w = outputWalkNext (w, &walk))
 	{
 		if (w->destroyed)
 			continue;
@@ -403,18 +583,22 @@ paintOutputRegion (CompScreen          *screen,
 
 			vTransform = *transform;
 			matrixTranslate (&vTransform, offX, offY, 0);
+			PROFILER_ENTER (screen, paintWindow);
 			(*screen->paintWindow) (w, &w->paint, &vTransform, clip,
 			               windowMask | PAINT_WINDOW_WITH_OFFSET_MASK);
+			PROFILER_LEAVE (paintWindow);
 		}
 		else
 		{
+			PROFILER_ENTER (screen, paintWindow);
 			(*screen->paintWindow) (w, &w->paint, transform, clip,
 			                        windowMask);
+			PROFILER_LEAVE (paintWindow);
 		}
 	}
 
-	if (walk.fini)
-		(*walk.fini) (screen, &walk);
+	if (walk.walk.fini)
+		(*walk.walk.fini) (screen, &walk.walk);
 
 	/* paint cursors */
 	for (c = screen->cursors; c; c = c->next)
@@ -680,15 +864,135 @@ moreWindowIndices (CompWindow *w,
 	return TRUE;
 }
 
+Bool
+initQuadIndices (CompScreen *s)
+{
+	GLushort *indices;
+	int      i;
+
+	indices = malloc (sizeof (GLushort) * 6 * QUAD_INDEX_QUADS);
+	if (!indices)
+		return FALSE;
+
+	for (i = 0; i < QUAD_INDEX_QUADS; i++)
+	{
+		indices[6 * i + 0] = 4 * i + 0;
+		indices[6 * i + 1] = 4 * i + 1;
+		indices[6 * i + 2] = 4 * i + 2;
+		indices[6 * i + 3] = 4 * i + 0;
+		indices[6 * i + 4] = 4 * i + 2;
+		indices[6 * i + 5] = 4 * i + 3;
+	}
+
+	s->quadIndices = indices;
+
+	if (s->vertexBufferObject)
+	{
+		(*s->genBuffers) (1, &s->quadIndexBuffer);
+		(*s->bindBuffer) (GL_ELEMENT_ARRAY_BUFFER_ARB, s->quadIndexBuffer);
+		(*s->bufferData) (GL_ELEMENT_ARRAY_BUFFER_ARB,
+		                  sizeof (GLushort) * 6 * QUAD_INDEX_QUADS,
+		                  indices, GL_STATIC_DRAW_ARB);
+		(*s->bindBuffer) (GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+	}
+
+	return TRUE;
+}
+
+void
+finiQuadIndices (CompScreen *s)
+{
+	if (s->quadIndexBuffer)
+		(*s->deleteBuffers) (1, &s->quadIndexBuffer);
+
+	if (s->quadIndices)
+		free (s->quadIndices);
+
+	s->quadIndexBuffer = 0;
+	s->quadIndices     = NULL;
+}
+
+void
+finiWindowVertexBuffers (CompWindow *w)
+{
+	CompWindowVertexBuffer *vb;
+	int                    i;
+
+	for (i = 0; i < WINDOW_VERTEX_BUFFERS; i++)
+	{
+		vb = &w->vertexBuffers[i];
+
+		if (vb->name)
+			(*w->screen->deleteBuffers) (1, &vb->name);
+
+		vb->name       = 0;
+		vb->generation = 0;
+		vb->vCount     = 0;
+	}
+}
+
+/* Bind a vertex buffer object holding the current geometry of w and
+   return the address to pass to the pointer functions, it is only
+   uploaded again when its generation differs from all buffers of w. */
+static GLfloat *
+bindWindowVertexBuffer (CompWindow *w)
+{
+	CompScreen             *s = w->screen;
+	CompWindowVertexBuffer *vb, *lru = NULL;
+	int                    size = w->vCount * w->vertexStride;
+	int                    i;
+
+	if (!s->vertexBufferObject)
+		return w->vertices;
+
+	w->vertexBufferClock++;
+
+	for (i = 0; i < WINDOW_VERTEX_BUFFERS; i++)
+	{
+		vb = &w->vertexBuffers[i];
+
+		if (vb->name                                   &&
+		    w->geometryGeneration                      &&
+		    vb->generation == w->geometryGeneration    &&
+		    vb->vCount     == w->vCount                &&
+		    vb->stride     == w->vertexStride)
+		{
+			vb->lastUse = w->vertexBufferClock;
+			(*s->bindBuffer) (GL_ARRAY_BUFFER_ARB, vb->name);
+
+			return NULL;
+		}
+
+		if (!lru || vb->lastUse < lru->lastUse)
+			lru = vb;
+	}
+
+	vb = lru;
+
+	if (!vb->name)
+		(*s->genBuffers) (1, &vb->name);
+
+	vb->generation = w->geometryGeneration;
+	vb->vCount     = w->vCount;
+	vb->stride     = w->vertexStride;
+	vb->lastUse    = w->vertexBufferClock;
+
+	(*s->bindBuffer) (GL_ARRAY_BUFFER_ARB, vb->name);
+	(*s->bufferData) (GL_ARRAY_BUFFER_ARB, sizeof (GLfloat) * size,
+	                  w->vertices, GL_STATIC_DRAW_ARB);
+
+	return NULL;
+}
+
 static void
-drawWindowGeometry (CompWindow *w)
+setWindowGeometryPointers (CompWindow *w,
+                           GLfloat    *vertices)
 {
-	int     texUnit = w->texUnits;
-	int     currentTexUnit = 0;
-	int     stride = w->vertexStride;
-	GLfloat *vertices = w->vertices + (stride - 3);
+	int texUnit = w->texUnits;
+	int currentTexUnit = 0;
+	int stride = w->vertexStride * sizeof (GLfloat);
 
-	stride *= sizeof (GLfloat);
+	vertices += w->vertexStride - 3;
 
 	glVertexPointer (3, GL_FLOAT, stride, vertices);
 
@@ -703,8 +1007,47 @@ drawWindowGeometry (CompWindow *w)
 		vertices -= w->texCoordSize;
 		glTexCoordPointer (w->texCoordSize, GL_FLOAT, stride, vertices);
 	}
+}
+
+static void
+drawWindowGeometry (CompWindow *w)
+{
+	CompScreen *s = w->screen;
+	GLfloat    *vertices;
+	int        texUnit, first, count;
+
+	if (!s->quadIndices)
+	{
+		setWindowGeometryPointers (w, w->vertices);
+		glDrawArrays (GL_QUADS, 0, w->vCount);
+	}
+	else
+	{
+		vertices = bindWindowVertexBuffer (w);
+
+		if (vertices != w->vertices)
+			(*s->bindBuffer) (GL_ELEMENT_ARRAY_BUFFER_ARB,
+			                  s->quadIndexBuffer);
+
+		/* the indices only reach QUAD_INDEX_QUADS quads at a time */
+		for (first = 0; first < w->vCount; first += count)
+		{
+			count = MIN (w->vCount - first, QUAD_INDEX_QUADS * 4);
+
+			setWindowGeometryPointers (w, vertices +
+			                           first * w->vertexStride);
+
+			glDrawElements (GL_TRIANGLES, count / 4 * 6, GL_UNSIGNED_SHORT,
+			                vertices != w->vertices ? NULL :
+			                s->quadIndices);
+		}
 
-	glDrawArrays (GL_QUADS, 0, w->vCount);
+		if (vertices != w->vertices)
+		{
+			(*s->bindBuffer) (GL_ARRAY_BUFFER_ARB, 0);
+			(*s->bindBuffer) (GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+		}
+	}
 
 	/* disable all texture coordinate arrays except 0 */
 	texUnit = w->texUnits;
@@ -720,6 +1063,180 @@ drawWindowGeometry (CompWindow *w)
 	}
 }
 
+void
+finiWindowGeometryCache (CompWindow *w)
+{
+	CompWindowGeometry *g;
+	int                i;
+
+	for (i = 0; i < WINDOW_GEOMETRY_CACHE; i++)
+	{
+		g = &w->geometryCache[i];
+
+		if (g->rects)
+			free (g->rects);
+
+		if (g->vertices)
+			free (g->vertices);
+
+		memset (g, 0, sizeof (CompWindowGeometry));
+	}
+}
+
+static unsigned int
+hashGeometryWords (unsigned int hash,
+                   const void   *data,
+                   int          size)
+{
+	const unsigned int *word = data;
+
+	size /= sizeof (unsigned int);
+
+	while (size--)
+		hash = (hash ^ *word++) * 16777619;
+
+	return hash;
+}
+
+static unsigned int
+hashWindowGeometry (CompMatrix *matrix,
+                    int        nMatrix,
+                    Region     region,
+                    Region     clip)
+{
+	unsigned int hash = 2166136261u ^ nMatrix;
+
+	hash = hashGeometryWords (hash, region->rects,
+	                          region->numRects * sizeof (BoxRec));
+	hash = hashGeometryWords (hash, clip->rects,
+	                          clip->numRects * sizeof (BoxRec));
+	hash = hashGeometryWords (hash, matrix, nMatrix * sizeof (CompMatrix));
+
+	return hash;
+}
+
+/* returns the entry for these arguments, or the one to replace with
+   their geometry and NULL in *hit */
+static CompWindowGeometry *
+findWindowGeometry (CompWindow   *w,
+                    unsigned int hash,
+                    CompMatrix   *matrix,
+                    int          nMatrix,
+                    Region       region,
+                    Region       clip,
+                    Bool         *hit)
+{
+	CompWindowGeometry *g, *lru = NULL;
+	int                i;
+
+	w->geometryCacheClock++;
+
+	for (i = 0; i < WINDOW_GEOMETRY_CACHE; i++)
+	{
+		g = &w->geometryCache[i];
+
+		if (g->vertexStride                                       &&
+		    g->hash    == hash                                    &&
+		    g->nMatrix == nMatrix                                 &&
+		    g->nRegion == region->numRects                        &&
+		    g->nClip   == clip->numRects                          &&
+		    !memcmp (g->rects, region->rects,
+		             region->numRects * sizeof (BoxRec))          &&
+		    !memcmp (g->rects + g->nRegion, clip->rects,
+		             clip->numRects * sizeof (BoxRec))            &&
+		    !memcmp (g->matrix, matrix, nMatrix * sizeof (CompMatrix)))
+		{
+			g->lastUse = w->geometryCacheClock;
+			*hit = TRUE;
+
+			return g;
+		}
+
+		if (!lru || g->lastUse < lru->lastUse)
+			lru = g;
+	}
+
+	*hit = FALSE;
+
+	return lru;
+}
+
+/* a generation that no geometry of w had before */
+static unsigned int
+newGeometryGeneration (CompWindow *w)
+{
+	if (!++w->geometryGenerationClock)
+		w->geometryGenerationClock++;
+
+	return w->geometryGenerationClock;
+}
+
+static void
+storeWindowGeometry (CompWindow         *w,
+                     CompWindowGeometry *g,
+                     unsigned int       hash,
+                     CompMatrix         *matrix,
+                     int                nMatrix,
+                     Region             region,
+                     Region             clip,
+                     int                first)
+{
+	int nRect = region->numRects + clip->numRects;
+	int size = (w->vCount - first) * w->vertexStride;
+
+	/* an entry is only valid with a vertex stride */
+	g->vertexStride = 0;
+
+	if (nRect > g->rectSize)
+	{
+		BoxPtr rects;
+
+		rects = realloc (g->rects, nRect * sizeof (BoxRec));
+		if (!rects)
+			return;
+
+		g->rects    = rects;
+		g->rectSize = nRect;
+	}
+
+	if (size > g->vertexCapacity)
+	{
+		GLfloat *vertices;
+
+		vertices = realloc (g->vertices, size * sizeof (GLfloat));
+		if (!vertices)
+			return;
+
+		g->vertices       = vertices;
+		g->vertexCapacity = size;
+	}
+
+	/* size is 0 when nothing of the region is inside the clip */
+	if (size)
+		memcpy (g->vertices, w->vertices + first * w->vertexStride,
+		        size * sizeof (GLfloat));
+
+	memcpy (g->rects, region->rects, region->numRects * sizeof (BoxRec));
+	memcpy (g->rects + region->numRects, clip->rects,
+	        clip->numRects * sizeof (BoxRec));
+	memcpy (g->matrix, matrix, nMatrix * sizeof (CompMatrix));
+
+	g->hash         = hash;
+	g->nMatrix      = nMatrix;
+	g->nRegion      = region->numRects;
+	g->nClip        = clip->numRects;
+	g->vertexSize   = size;
+	g->vCount       = w->vCount - first;
+	g->vertexStride = w->vertexStride;
+	g->lastUse      = w->geometryCacheClock;
+
+	/* the entry only holds the part of the geometry from first on */
+	if (first)
+		g->generation = newGeometryGeneration (w);
+	else
+		g->generation = w->geometryGeneration;
+}
+
 void
 addWindowGeometry (CompWindow *w,
                    CompMatrix *matrix,
@@ -727,7 +1244,11 @@ addWindowGeometry (CompWindow *w,
                    Region     region,
                    Region     clip)
 {
-	BoxRec full;
+	CompWindowGeometry *g = NULL;
+	BoxRec             full;
+	unsigned int       hash = 0;
+	int                first;
+	Bool               hit;
 
 	w->texUnits = nMatrix;
 
@@ -753,6 +1274,48 @@ addWindowGeometry (CompWindow *w,
 		GLfloat *d;
 		Bool    rect = TRUE;
 
+		vSize = 3 + nMatrix * 2;
+
+		if (!w->noGeometryCache && nMatrix <= GEOMETRY_CACHE_MATRICES)
+		{
+			hash = hashWindowGeometry (matrix, nMatrix, region, clip);
+			g = findWindowGeometry (w, hash, matrix, nMatrix, region, clip,
+			                        &hit);
+
+			if (hit)
+			{
+				n = w->vCount + g->vCount;
+
+				if (n * vSize > w->vertexSize)
+				{
+					if (!moreWindowVertices (w, n * vSize))
+						return;
+				}
+
+				if (g->vertexSize)
+					memcpy (w->vertices + w->vCount * vSize, g->vertices,
+					        g->vertexSize * sizeof (GLfloat));
+
+				/* appended to other geometry it is new as a whole */
+				if (w->vCount)
+					w->geometryGeneration = newGeometryGeneration (w);
+				else
+					w->geometryGeneration = g->generation;
+
+				w->vCount             = n;
+				w->vertexStride       = vSize;
+				w->texCoordSize       = 2;
+				w->drawWindowGeometry = drawWindowGeometry;
+
+				return;
+			}
+		}
+
+		first = w->vCount;
+
+		/* until the new geometry is complete */
+		w->geometryGeneration = 0;
+
 		for (it = 0; it < nMatrix; it++)
 		{
 			if (matrix[it].xy != 0.0f || matrix[it].yx != 0.0f)
@@ -765,8 +1328,6 @@ addWindowGeometry (CompWindow *w,
 		pBox = region->rects;
 		nBox = region->numRects;
 
-		vSize = 3 + nMatrix * 2;
-
 		n = w->vCount / 4;
 
 		if ((n + nBox) * vSize * 4 > w->vertexSize)
@@ -863,6 +1424,11 @@ addWindowGeometry (CompWindow *w,
 		w->vertexStride       = vSize;
 		w->texCoordSize       = 2;
 		w->drawWindowGeometry = drawWindowGeometry;
+		w->geometryGeneration = newGeometryGeneration (w);
+
+		if (g)
+			storeWindowGeometry (w, g, hash, matrix, nMatrix,
+			                     region, clip, first);
 	}
 }
 
@@ -1157,6 +1723,62 @@ enableFragmentOperationsAndDrawGeometry (CompWindow	          *w,
 	}
 }
 
+/* FALSE if the window is known to be drawn with transform at least at
+   the size of its texture, GL only samples the base level then */
+static Bool
+windowTextureMinified (CompWindow          *w,
+                       const CompTransform *transform)
+{
+	CompScreen    *s = w->screen;
+	CompTransform projection, m;
+	CompVector    corner, p[4];
+	float         dx, dy;
+	int           i;
+
+	memcpy (projection.m, s->projection, sizeof (projection.m));
+	matrixMultiply (&m, &projection, transform);
+
+	for (i = 0; i < 4; i++)
+	{
+		corner.x = w->attrib.x - w->attrib.border_width;
+		corner.y = w->attrib.y - w->attrib.border_width;
+		corner.z = 0.0f;
+		corner.w = 1.0f;
+
+		if (i & 1)
+			corner.x += w->width;
+		if (i & 2)
+			corner.y += w->height;
+
+		matrixMultiplyVector (&p[i], &corner, &m);
+
+		/* behind the camera */
+		if (p[i].w <= 0.0f)
+			return TRUE;
+
+		matrixVectorDiv (&p[i]);
+
+		p[i].x *= s->lastViewport.width / 2.0f;
+		p[i].y *= s->lastViewport.height / 2.0f;
+	}
+
+	/* horizontal edges against the width, vertical against the height */
+	for (i = 0; i < 4; i += 3)
+	{
+		dx = p[i ^ 1].x - p[i].x;
+		dy = p[i ^ 1].y - p[i].y;
+		if (dx * dx + dy * dy < w->width * w->width)
+			return TRUE;
+
+		dx = p[i ^ 2].x - p[i].x;
+		dy = p[i ^ 2].y - p[i].y;
+		if (dx * dx + dy * dy < w->height * w->height)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 void
 drawWindowTexture (CompWindow           *w,
                    CompTexture          *texture,
@@ -1171,6 +1793,10 @@ drawWindowTexture (CompWindow           *w,
 	else
 		filter = w->screen->filter[NOTHING_TRANS_FILTER];
 
+	if ((mask & PAINT_WINDOW_UNMINIFIED_MASK) &&
+	    filter == COMP_TEXTURE_FILTER_GOOD)
+		filter = COMP_TEXTURE_FILTER_GOOD_UNMINIFIED;
+
 	if ((!attrib->nFunction && (!w->screen->lighting ||
 	     attrib->saturation == COLOR || attrib->saturation == 0)) ||
 		!enableFragmentProgramAndDrawGeometry (w,
@@ -1194,6 +1820,8 @@ drawWindow (CompWindow           *w,
             Region               region,
             unsigned int         mask)
 {
+	CompTexture *atlas;
+
 	if (mask & PAINT_WINDOW_TRANSFORMED_MASK)
 		region = &infiniteRegion;
 
@@ -1209,7 +1837,38 @@ drawWindow (CompWindow           *w,
 	if (mask & PAINT_WINDOW_TRANSLUCENT_MASK)
 		mask |= PAINT_WINDOW_BLEND_MASK;
 
+	/* damage only invalidates the mipmaps, they are regenerated when
+	   the window is drawn minified */
+	if (w->texture->oldMipmaps &&
+	    display.textureFilter == GL_LINEAR_MIPMAP_LINEAR &&
+	    (mask & (PAINT_WINDOW_TRANSFORMED_MASK |
+	             PAINT_WINDOW_ON_TRANSFORMED_SCREEN_MASK)) &&
+	    !windowTextureMinified (w, transform))
+		mask |= PAINT_WINDOW_UNMINIFIED_MASK;
+
+	/* the atlas has no mipmaps, minified windows look better without */
+	atlas = getWindowAtlasTexture (w);
+	if (atlas && display.textureFilter == GL_LINEAR_MIPMAP_LINEAR &&
+	    (mask & (PAINT_WINDOW_TRANSFORMED_MASK |
+	             PAINT_WINDOW_ON_TRANSFORMED_SCREEN_MASK)))
+		atlas = NULL;
+
 	w->vCount = w->indexCount = 0;
+
+	if (atlas)
+	{
+		CompMatrix matrix = atlas->matrix;
+
+		matrix.x0 -= (w->attrib.x * matrix.xx);
+		matrix.y0 -= (w->attrib.y * matrix.yy);
+
+		(*w->screen->addWindowGeometry) (w, &matrix, 1, w->region, region);
+		if (w->vCount)
+			(*w->screen->drawWindowTexture) (w, atlas, fragment, mask);
+
+		return TRUE;
+	}
+
 	(*w->screen->addWindowGeometry) (w, &w->matrix, 1, w->region, region);
 	if (w->vCount)
 		(*w->screen->drawWindowTexture) (w, w->texture, fragment, mask);
@@ -1263,7 +1922,9 @@ paintWindow (CompWindow              *w,
 		glLoadMatrixf (transform->m);
 	}
 
+	PROFILER_ENTER (w->screen, drawWindow);
 	status = (*w->screen->drawWindow) (w, transform, &fragment, region, mask);
+	PROFILER_LEAVE (drawWindow);
 
 	if (mask & PAINT_WINDOW_TRANSFORMED_MASK ||
 	    mask & PAINT_WINDOW_WITH_OFFSET_MASK)
@@ -0,0 +1,437 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <string.h>
+#include <pthread.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Pixel conversion kernels for the image loaders and writers.
+ *
+ * Every kernel has a portable scalar version and, on x86, SSE2, SSSE3
+ * or AVX2 versions that produce exactly the same bytes. The best
+ * version the CPU supports is picked once, the first time any kernel
+ * runs; images are decoded on the image loader thread as well, so the
+ * choice is made under pthread_once.
+ *
+ * Premultiplying needs the product of two channels divided by 255,
+ * rounded down like the integer divide it replaces. For t = c * a in
+ * [0, 255 * 255], (t + 1 + (t >> 8)) >> 8 is exactly t / 255 and fits
+ * in 16 bits, so it maps onto 16 bit SIMD lanes without a divide.
+ */
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#  define PIXEL_X86 1
+#  include <immintrin.h>
+#endif
+
+#define DIV255(t) (((t) + 1 + ((t) >> 8)) >> 8)
+
+typedef void (*PremultiplyPixelsProc) (unsigned char *data,
+                                       int           n);
+typedef void (*ConvertRgbToArgbProc) (const unsigned char *src,
+                                      unsigned int        *dst,
+                                      int                 n,
+                                      unsigned char       alpha);
+typedef void (*ConvertRgbaToRgbProc) (const unsigned char *src,
+                                      unsigned char       *dst,
+                                      int                 n);
+
+static pthread_once_t        pixelOnce = PTHREAD_ONCE_INIT;
+static PixelKernels          cpuKernels = PixelKernelsScalar;
+static PixelKernels          usedKernels = PixelKernelsScalar;
+static PremultiplyPixelsProc premultiplyPixelsProc;
+static ConvertRgbToArgbProc  convertRgbToArgbProc;
+static ConvertRgbaToRgbProc  convertRgbaToRgbProc;
+
+static void
+premultiplyPixelsScalar (unsigned char *data,
+                         int           n)
+{
+	int i;
+
+	for (i = 0; i < n; i++, data += 4)
+	{
+		unsigned int blue  = data[0];
+		unsigned int green = data[1];
+		unsigned int red   = data[2];
+		unsigned int alpha = data[3];
+		unsigned int p;
+
+		red   = DIV255 (red * alpha);
+		green = DIV255 (green * alpha);
+		blue  = DIV255 (blue * alpha);
+
+		p = (alpha << 24) | (red << 16) | (green << 8) | (blue << 0);
+		memcpy (data, &p, sizeof (unsigned int));
+	}
+}
+
+static void
+convertRgbToArgbScalar (const unsigned char *src,
+                        unsigned int        *dst,
+                        int                 n,
+                        unsigned char       alpha)
+{
+	int i;
+
+	for (i = 0; i < n; i++, src += 3)
+		dst[i] = ((unsigned int) alpha << 24) | (src[0] << 16) |
+		         (src[1] << 8) | (src[2] << 0);
+}
+
+static void
+convertRgbaToRgbScalar (const unsigned char *src,
+                        unsigned char       *dst,
+                        int                 n)
+{
+	int i;
+
+	for (i = 0; i < n; i++, src += 4, dst += 3)
+	{
+#if __BYTE_ORDER == __BIG_ENDIAN
+		dst[0] = src[3];  /* red */
+		dst[1] = src[2];  /* green */
+		dst[2] = src[1];  /* blue */
+#else
+		dst[0] = src[0];  /* red */
+		dst[1] = src[1];  /* green */
+		dst[2] = src[2];  /* blue */
+#endif
+	}
+}
+
+#ifdef PIXEL_X86
+
+/* x86 is little endian, the B, G, R, A bytes of a pixel already are
+   the native A, R, G, B word that premultiplyPixels writes */
+
+__attribute__ ((target ("sse2"))) static inline __m128i
+premultiplyLanesSSE2 (__m128i pixels,
+                      __m128i zero,
+                      __m128i alphaLanes)
+{
+	__m128i lo, hi, a;
+
+	/* two pixels per register, one channel per 16 bit lane */
+	lo = _mm_unpacklo_epi8 (pixels, zero);
+	hi = _mm_unpackhi_epi8 (pixels, zero);
+
+	/* multiply alpha by 255 so that it comes out unchanged */
+	a  = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (lo, 0xff), 0xff);
+	lo = _mm_mullo_epi16 (lo, _mm_or_si128 (a, alphaLanes));
+	a  = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (hi, 0xff), 0xff);
+	hi = _mm_mullo_epi16 (hi, _mm_or_si128 (a, alphaLanes));
+
+	lo = _mm_add_epi16 (lo, _mm_add_epi16 (_mm_set1_epi16 (1),
+	                                       _mm_srli_epi16 (lo, 8)));
+	hi = _mm_add_epi16 (hi, _mm_add_epi16 (_mm_set1_epi16 (1),
+	                                       _mm_srli_epi16 (hi, 8)));
+
+	return _mm_packus_epi16 (_mm_srli_epi16 (lo, 8),
+	                         _mm_srli_epi16 (hi, 8));
+}
+
+__attribute__ ((target ("sse2"))) static void
+premultiplyPixelsSSE2 (unsigned char *data,
+                       int           n)
+{
+	__m128i zero = _mm_setzero_si128 ();
+	__m128i alphaLanes = _mm_set_epi16 (255, 0, 0, 0, 255, 0, 0, 0);
+	int     i;
+
+	for (i = 0; i + 4 <= n; i += 4, data += 16)
+	{
+		__m128i p = _mm_loadu_si128 ((const __m128i *) data);
+
+		p = premultiplyLanesSSE2 (p, zero, alphaLanes);
+		_mm_storeu_si128 ((__m128i *) data, p);
+	}
+
+	premultiplyPixelsScalar (data, n - i);
+}
+
+__attribute__ ((target ("avx2"))) static void
+premultiplyPixelsAVX2 (unsigned char *data,
+                       int           n)
+{
+	__m256i zero = _mm256_setzero_si256 ();
+	__m256i alphaLanes = _mm256_set_epi16 (255, 0, 0, 0, 255, 0, 0, 0,
+	                                       255, 0, 0, 0, 255, 0, 0, 0);
+	__m256i one = _mm256_set1_epi16 (1);
+	int     i;
+
+	for (i = 0; i + 8 <= n; i += 8, data += 32)
+	{
+		__m256i p = _mm256_loadu_si256 ((const __m256i *) data);
+		__m256i lo, hi, a;
+
+		/* unpack and pack work within 128 bit halves, which keeps
+		   the pixels in order */
+		lo = _mm256_unpacklo_epi8 (p, zero);
+		hi = _mm256_unpackhi_epi8 (p, zero);
+
+		a  = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (lo, 0xff), 0xff);
+		lo = _mm256_mullo_epi16 (lo, _mm256_or_si256 (a, alphaLanes));
+		a  = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (hi, 0xff), 0xff);
+		hi = _mm256_mullo_epi16 (hi, _mm256_or_si256 (a, alphaLanes));
+
+		lo = _mm256_add_epi16 (lo, _mm256_add_epi16 (one,
+		                                             _mm256_srli_epi16 (lo, 8)));
+		hi = _mm256_add_epi16 (hi, _mm256_add_epi16 (one,
+		                                             _mm256_srli_epi16 (hi, 8)));
+
+		p = _mm256_packus_epi16 (_mm256_srli_epi16 (lo, 8),
+		                         _mm256_srli_epi16 (hi, 8));
+		_mm256_storeu_si256 ((__m256i *) data, p);
+	}
+
+	premultiplyPixelsScalar (data, n - i);
+}
+
+/* SSE2 has no byte shuffle, the RGB kernels start at SSSE3 */
+
+__attribute__ ((target ("ssse3"))) static void
+convertRgbToArgbSSSE3 (const unsigned char *src,
+                       unsigned int        *dst,
+                       int                 n,
+                       unsigned char       alpha)
+{
+	__m128i shuffle = _mm_setr_epi8 (2, 1, 0, -1, 5, 4, 3, -1,
+	                                 8, 7, 6, -1, 11, 10, 9, -1);
+	__m128i a = _mm_set1_epi32 ((int) ((unsigned int) alpha << 24));
+	int     i;
+
+	/* 4 pixels are 12 bytes but the load reads 16, stop while
+	   there are at least 2 more pixels to read */
+	for (i = 0; i + 6 <= n; i += 4, src += 12)
+	{
+		__m128i p = _mm_loadu_si128 ((const __m128i *) src);
+
+		p = _mm_or_si128 (_mm_shuffle_epi8 (p, shuffle), a);
+		_mm_storeu_si128 ((__m128i *) (dst + i), p);
+	}
+
+	convertRgbToArgbScalar (src, dst + i, n - i, alpha);
+}
+
+__attribute__ ((target ("avx2"))) static void
+convertRgbToArgbAVX2 (const unsigned char *src,
+                      unsigned int        *dst,
+                      int                 n,
+                      unsigned char       alpha)
+{
+	__m256i shuffle = _mm256_setr_epi8 (2, 1, 0, -1, 5, 4, 3, -1,
+	                                    8, 7, 6, -1, 11, 10, 9, -1,
+	                                    2, 1, 0, -1, 5, 4, 3, -1,
+	                                    8, 7, 6, -1, 11, 10, 9, -1);
+	__m256i a = _mm256_set1_epi32 ((int) ((unsigned int) alpha << 24));
+	int     i;
+
+	/* the shuffle stays within 128 bit halves, so each half gets
+	   12 bytes of its own; the second load reads up to byte 28 */
+	for (i = 0; i + 10 <= n; i += 8, src += 24)
+	{
+		__m256i p;
+
+		p = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) src));
+		p = _mm256_inserti128_si256 (p,
+		                             _mm_loadu_si128 ((const __m128i *)
+		                                              (src + 12)), 1);
+
+		p = _mm256_or_si256 (_mm256_shuffle_epi8 (p, shuffle), a);
+		_mm256_storeu_si256 ((__m256i *) (dst + i), p);
+	}
+
+	convertRgbToArgbScalar (src, dst + i, n - i, alpha);
+}
+
+__attribute__ ((target ("ssse3"))) static void
+convertRgbaToRgbSSSE3 (const unsigned char *src,
+                       unsigned char       *dst,
+                       int                 n)
+{
+	__m128i shuffle = _mm_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9,
+	                                 10, 12, 13, 14, -1, -1, -1, -1);
+	int     i;
+
+	for (i = 0; i + 4 <= n; i += 4, src += 16, dst += 12)
+	{
+		__m128i p = _mm_loadu_si128 ((const __m128i *) src);
+		int     last;
+
+		p = _mm_shuffle_epi8 (p, shuffle);
+		_mm_storel_epi64 ((__m128i *) dst, p);
+		last = _mm_cvtsi128_si32 (_mm_srli_si128 (p, 8));
+		memcpy (dst + 8, &last, 4);
+	}
+
+	convertRgbaToRgbScalar (src, dst, n - i);
+}
+
+__attribute__ ((target ("avx2"))) static void
+convertRgbaToRgbAVX2 (const unsigned char *src,
+                      unsigned char       *dst,
+                      int                 n)
+{
+	__m256i shuffle = _mm256_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9,
+	                                    10, 12, 13, 14, -1, -1, -1, -1,
+	                                    0, 1, 2, 4, 5, 6, 8, 9,
+	                                    10, 12, 13, 14, -1, -1, -1, -1);
+	/* move the 12 bytes of the upper half next to those of the lower */
+	__m256i pack = _mm256_setr_epi32 (0, 1, 2, 4, 5, 6, 3, 7);
+	int     i;
+
+	for (i = 0; i + 8 <= n; i += 8, src += 32, dst += 24)
+	{
+		__m256i p = _mm256_loadu_si256 ((const __m256i *) src);
+
+		p = _mm256_permutevar8x32_epi32 (_mm256_shuffle_epi8 (p, shuffle),
+		                                 pack);
+		_mm_storeu_si128 ((__m128i *) dst, _mm256_castsi256_si128 (p));
+		_mm_storel_epi64 ((__m128i *) (dst + 16),
+		                  _mm256_extracti128_si256 (p, 1));
+	}
+
+	convertRgbaToRgbScalar (src, dst, n - i);
+}
+
+#endif
+
+static void
+selectPixelKernels (PixelKernels kernels)
+{
+	premultiplyPixelsProc = premultiplyPixelsScalar;
+	convertRgbToArgbProc  = convertRgbToArgbScalar;
+	convertRgbaToRgbProc  = convertRgbaToRgbScalar;
+
+	if (kernels > cpuKernels)
+		kernels = cpuKernels;
+
+	usedKernels = kernels;
+
+#ifdef PIXEL_X86
+	if (kernels >= PixelKernelsSSE2)
+		premultiplyPixelsProc = premultiplyPixelsSSE2;
+
+	if (kernels >= PixelKernelsSSSE3)
+	{
+		convertRgbToArgbProc = convertRgbToArgbSSSE3;
+		convertRgbaToRgbProc = convertRgbaToRgbSSSE3;
+	}
+
+	if (kernels >= PixelKernelsAVX2)
+	{
+		premultiplyPixelsProc = premultiplyPixelsAVX2;
+		convertRgbToArgbProc  = convertRgbToArgbAVX2;
+		convertRgbaToRgbProc  = convertRgbaToRgbAVX2;
+	}
+#endif
+}
+
+static void
+initPixelKernels (void)
+{
+#ifdef PIXEL_X86
+	__builtin_cpu_init ();
+
+	if (__builtin_cpu_supports ("avx2"))
+		cpuKernels = PixelKernelsAVX2;
+	else if (__builtin_cpu_supports ("ssse3"))
+		cpuKernels = PixelKernelsSSSE3;
+	else if (__builtin_cpu_supports ("sse2"))
+		cpuKernels = PixelKernelsSSE2;
+#endif
+
+	selectPixelKernels (cpuKernels);
+}
+
+/* limits the kernels to the given instruction set and returns the one
+   in use, for comparing them; not safe while images are being loaded */
+PixelKernels
+setPixelKernels (PixelKernels kernels)
+{
+	pthread_once (&pixelOnce, initPixelKernels);
+
+	selectPixelKernels (kernels);
+
+	return usedKernels;
+}
+
+/* n pixels of B, G, R, A bytes, as png hands them out, to premultiplied
+   native A, R, G, B words, in place */
+void
+premultiplyPixels (unsigned char *data,
+                   int           n)
+{
+	pthread_once (&pixelOnce, initPixelKernels);
+
+	(*premultiplyPixelsProc) (data, n);
+}
+
+/* n pixels of R, G, B bytes to native A, R, G, B words */
+void
+convertRgbToArgb (const unsigned char *src,
+                  unsigned int        *dst,
+                  int                 n,
+                  unsigned char       alpha)
+{
+	pthread_once (&pixelOnce, initPixelKernels);
+
+	(*convertRgbToArgbProc) (src, dst, n, alpha);
+}
+
+/* n pixels of R, G, B, A bytes, as read back from GL, to R, G, B bytes */
+void
+convertRgbaToRgb (const unsigned char *src,
+                  unsigned char       *dst,
+                  int                 n)
+{
+	pthread_once (&pixelOnce, initPixelKernels);
+
+	(*convertRgbaToRgbProc) (src, dst, n);
+}
+
+/* copies height rows of stride bytes from src to dst, bottom row first */
+void
+flipImageRows (void       *dst,
+               const void *src,
+               int        stride,
+               int        height)
+{
+	const unsigned char *s = src;
+	unsigned char       *d = dst;
+	int                 i;
+
+	s += (size_t) (height - 1) * stride;
+
+	for (i = 0; i < height; i++, s -= stride, d += stride)
+		memcpy (d, s, stride);
+}
@@ -336,6 +336,8 @@ unloadPlugin (CompPlugin *p)
 
 	dlclose (p->dlhand);
 
+	profilerFlushNameCache ();
+
 	free (p);
 }
 
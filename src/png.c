@@ -39,24 +39,7 @@ premultiplyData (png_structp   png,
                  png_row_infop row_info,
                  png_bytep     data)
 {
-	unsigned int i;
-
-	for (i = 0; i < row_info->rowbytes; i += 4)
-	{
-		unsigned char *base = &data[i];
-		unsigned char blue  = base[0];
-		unsigned char green = base[1];
-		unsigned char red   = base[2];
-		unsigned char alpha = base[3];
-		int           p;
-
-		red   = (unsigned) red   * (unsigned) alpha / 255;
-		green = (unsigned) green * (unsigned) alpha / 255;
-		blue  = (unsigned) blue  * (unsigned) alpha / 255;
-
-		p = (alpha << 24) | (red << 16) | (green << 8) | (blue << 0);
-		memcpy (base, &p, sizeof (int));
-	}
+	premultiplyPixels (data, row_info->rowbytes / 4);
 }
 
 static Bool
@@ -177,13 +160,15 @@ readPngFileToImage (FILE *file,
 	return status;
 }
 
+/* level is a zlib compression level, or -1 for the default */
 static Bool
 writePng (unsigned char *buffer,
           png_rw_ptr    writeFunc,
           void          *closure,
           int           width,
           int           height,
-          int           stride)
+          int           stride,
+          int           level)
 {
 	png_struct   *png;
 	png_info     *info;
@@ -225,6 +210,15 @@ writePng (unsigned char *buffer,
 
 	png_set_write_fn (png, closure, writeFunc, NULL);
 
+	if (level >= 0)
+	{
+		png_set_compression_level (png, level);
+
+		/* filters only help the compression */
+		if (level == 0)
+			png_set_filter (png, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+	}
+
 	png_set_IHDR (png, info,
 	              width, height, 8,
 	              PNG_COLOR_TYPE_RGB_ALPHA,
@@ -280,6 +274,21 @@ pngImageToFile (const char  *path,
                 int         height,
                 int         stride,
                 void        *data)
+{
+	return pngImageToFileWithCompression (path, name, width, height,
+	                                      stride, data, -1);
+}
+
+/* level 0 writes an uncompressed png several times faster than the
+   default level, for images that have to be written quickly */
+Bool
+pngImageToFileWithCompression (const char  *path,
+                               const char  *name,
+                               int         width,
+                               int         height,
+                               int         stride,
+                               void        *data,
+                               int         level)
 {
 	Bool status = FALSE;
 	char *extension = pngExtension (name);
@@ -300,7 +309,8 @@ pngImageToFile (const char  *path,
 		fp = fopen (file, "wb");
 		if (fp)
 		{
-			status = writePng (data, stdioWriteFunc, fp, width, height, stride);
+			status = writePng (data, stdioWriteFunc, fp,
+			                   width, height, stride, level);
 			fclose (fp);
 		}
 
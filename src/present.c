@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <string.h>
+
+#include <fusilli-core.h>
+
+/*
+ * How a painted frame reaches the front buffer.
+ *
+ * A frame with full damage is swapped. A frame with region damage is
+ * swapped too when GLX_EXT_buffer_age tells how old the back buffer
+ * is: the damage of the frames the back buffer missed is painted
+ * along with the new damage. Otherwise only the damaged boxes are
+ * copied to the front buffer.
+ *
+ * A frame with only pending damage paints nothing, so it is not
+ * presented at all. Swapping would show a back buffer that is some
+ * frames old.
+ */
+
+CompPresentMode
+getFramePresentMode (CompScreen   *s,
+                     unsigned int mask,
+                     unsigned int age,
+                     Region       damage)
+{
+	unsigned int i;
+
+	if (mask & COMP_SCREEN_DAMAGE_ALL_MASK)
+	{
+		if (s->bufferAge)
+			compCopyRegion (&s->region, s->frameDamage);
+
+		return CompPresentSwap;
+	}
+
+	if (!(mask & COMP_SCREEN_DAMAGE_REGION_MASK))
+		return CompPresentNone;
+
+	if (!s->bufferAge)
+		return CompPresentCopy;
+
+	compUnionRegion (s->frameDamage, damage, s->frameDamage);
+
+	/* 0 means the contents of the back buffer are undefined */
+	if (!age || age > DAMAGE_HISTORY_SIZE)
+		return CompPresentCopy;
+
+	compUnionRegion (damage, s->frameDamage, damage);
+
+	for (i = 0; i < age - 1; i++)
+		compUnionRegion (damage, s->damageHistory[i], damage);
+
+	return CompPresentSwap;
+}
+
+/* after a swap, the damage of the frame becomes the newest history */
+void
+pushFrameDamage (CompScreen *s)
+{
+	Region oldest = s->damageHistory[DAMAGE_HISTORY_SIZE - 1];
+
+	memmove (s->damageHistory + 1, s->damageHistory,
+	         (DAMAGE_HISTORY_SIZE - 1) * sizeof (Region));
+
+	s->damageHistory[0] = s->frameDamage;
+	s->frameDamage      = oldest;
+
+	compEmptyRegion (s->frameDamage);
+}
@@ -0,0 +1,1103 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Per-hook paint profiling.
+ *
+ * UNWRAP and WRAP mark the points where a plugin calls into the next
+ * function of a wrapped hook, and core marks the top of each chain and
+ * the start and end of every frame. Every completed call is written to
+ * a ring buffer with its CPU time, the part of it not spent in nested
+ * calls and, when ARB_timer_query is available, the GPU time between
+ * the two marks. The buffer is dumped on request over D-Bus as JSON or
+ * in the Chrome trace event format, or summed up as frame rate and
+ * frame time distributions for benchmarks.
+ *
+ * When profiling is off, the marks only test profilerEnabled.
+ */
+
+#define PROFILER_RING_SIZE  16384 /* power of two */
+#define PROFILER_MAX_DEPTH  64
+#define PROFILER_NAME_CACHE 256   /* power of two */
+#define PROFILER_QUERY_POOL 4096  /* query pairs */
+#define PROFILER_FRAME_RING 8192  /* power of two */
+#define PROFILER_MAX_SCREEN 32
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+typedef void (*ProfilerGenQueriesProc) (GLsizei n,
+                                        GLuint  *ids);
+typedef void (*ProfilerQueryCounterProc) (GLuint id,
+                                          GLenum target);
+typedef void (*ProfilerGetQueryObjectivProc) (GLuint id,
+                                              GLenum pname,
+                                              GLint  *params);
+typedef void (*ProfilerGetQueryObjectui64vProc) (GLuint             id,
+                                                 GLenum             pname,
+                                                 unsigned long long *params);
+
+typedef struct _ProfileEvent {
+	const char   *hook;
+	const char   *plugin;
+	unsigned int frame;
+	int          screenNum;
+	int          depth;
+	int          query;    /* query pair, -1 if not timed on the GPU */
+	long long    start;    /* all times in nanoseconds */
+	long long    duration;
+	long long    self;
+	long long    gpu;      /* -1 until known */
+} ProfileEvent;
+
+/* frames are also kept on their own, a frame with many windows can
+   fill the event ring by itself */
+typedef struct _ProfileFrame {
+	unsigned int frame;
+	int          screenNum;
+	long long    start;
+	long long    duration;
+	long long    latency;  /* since the first damage, -1 if unknown */
+	unsigned int mipmaps;  /* full mipmap regenerations */
+	long         allocations; /* heap allocations, -1 if not counted */
+} ProfileFrame;
+
+typedef struct _ProfileCall {
+	const char *hook;
+	const char *plugin;
+	long long  start;
+	long long  children;
+	int        query;
+} ProfileCall;
+
+typedef struct _ProfileName {
+	void       *func;
+	const char *name;
+} ProfileName;
+
+typedef struct _ProfileBuffer {
+	char   *data;
+	size_t length;
+	size_t size;
+} ProfileBuffer;
+
+Bool profilerEnabled = FALSE;
+
+/* Single producer ring. Only the paint path writes events, readers
+   take a snapshot and drop whatever was overwritten meanwhile. */
+static ProfileEvent  ring[PROFILER_RING_SIZE];
+static unsigned long ringHead = 0;
+static unsigned long ringTail = 0;    /* first event to dump */
+static unsigned long resolveHead = 0; /* first event without GPU time */
+
+static ProfileFrame  frames[PROFILER_FRAME_RING];
+static unsigned long frameHead = 0;
+static unsigned long frameTail = 0;
+static long long     damageTime[PROFILER_MAX_SCREEN];
+
+static ProfileCall  stack[PROFILER_MAX_DEPTH];
+static int          depth = 0;
+static int          overflow = 0;
+static Bool         inFrame = FALSE;
+static CompScreen   *frameScreen = NULL;
+static unsigned int frameCount = 0;
+
+/* heap allocations made before the current frame */
+static Bool          countAllocations = FALSE;
+static unsigned long frameAllocations;
+
+static ProfileName nameCache[PROFILER_NAME_CACHE];
+static int         nNameCache = 0;
+static char        **names = NULL;
+static int         nNames = 0;
+static void        *coreBase = NULL;
+
+/* queries only exist in the context of one screen */
+static CompScreen   *gpuScreen = NULL;
+static Bool         gpuChecked = FALSE;
+static GLuint       *queries = NULL;
+static unsigned int queryHead = 0;
+static int          nFrameQuery = 0;
+
+static ProfilerGenQueriesProc          genQueries;
+static ProfilerQueryCounterProc        queryCounter;
+static ProfilerGetQueryObjectivProc    getQueryObjectiv;
+static ProfilerGetQueryObjectui64vProc getQueryObjectui64v;
+
+static long long
+getProfileTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static const char *
+internName (const char *name)
+{
+	char **newNames;
+	int  i;
+
+	for (i = 0; i < nNames; i++)
+		if (!strcmp (names[i], name))
+			return names[i];
+
+	newNames = realloc (names, sizeof (char *) * (nNames + 1));
+	if (!newNames)
+		return "unknown";
+
+	names = newNames;
+	names[nNames] = strdup (name);
+	if (!names[nNames])
+		return "unknown";
+
+	return names[nNames++];
+}
+
+/* libfoo.so -> foo, functions of the executable -> core */
+static const char *
+lookupPluginName (void *func)
+{
+	Dl_info    info;
+	const char *file, *base;
+	char       name[256];
+	size_t     length;
+
+	if (!dladdr (func, &info) || !info.dli_fname)
+		return "unknown";
+
+	if (!coreBase)
+	{
+		Dl_info coreInfo;
+
+		if (dladdr ((void *) profilerEnterHook, &coreInfo))
+			coreBase = coreInfo.dli_fbase;
+	}
+
+	if (info.dli_fbase == coreBase)
+		return "core";
+
+	file = info.dli_fname;
+	base = strrchr (file, '/');
+	if (base)
+		file = base + 1;
+
+	if (!strncmp (file, "lib", 3))
+		file += 3;
+
+	length = strcspn (file, ".");
+	if (length >= sizeof (name))
+		length = sizeof (name) - 1;
+
+	memcpy (name, file, length);
+	name[length] = '\0';
+
+	return internName (name);
+}
+
+static const char *
+getPluginName (void *func)
+{
+	ProfileName  *entry;
+	unsigned int i;
+
+	if (!func)
+		return "unknown";
+
+	i = ((unsigned long) func >> 4) & (PROFILER_NAME_CACHE - 1);
+
+	for (;;)
+	{
+		entry = &nameCache[i];
+
+		if (entry->func == func)
+			return entry->name;
+
+		if (!entry->func)
+			break;
+
+		i = (i + 1) & (PROFILER_NAME_CACHE - 1);
+	}
+
+	if (nNameCache >= PROFILER_NAME_CACHE / 2)
+	{
+		profilerFlushNameCache ();
+
+		return getPluginName (func);
+	}
+
+	entry->func = func;
+	entry->name = lookupPluginName (func);
+	nNameCache++;
+
+	return entry->name;
+}
+
+/* a plugin was unloaded, its addresses may be reused */
+void
+profilerFlushNameCache (void)
+{
+	memset (nameCache, 0, sizeof (nameCache));
+	nNameCache = 0;
+}
+
+static void
+initGpuTimer (CompScreen *s)
+{
+	const char *glExtensions;
+
+	gpuChecked = TRUE;
+
+	glExtensions = (const char *) glGetString (GL_EXTENSIONS);
+	if (!glExtensions || !strstr (glExtensions, "GL_ARB_timer_query") ||
+	    !s->getProcAddress)
+	{
+		compLogMessage ("core", CompLogLevelDebug,
+		                "GL_ARB_timer_query is missing, "
+		                "profiling without GPU times");
+		return;
+	}
+
+	genQueries = (ProfilerGenQueriesProc)
+	    s->getProcAddress ((GLubyte *) "glGenQueries");
+	queryCounter = (ProfilerQueryCounterProc)
+	    s->getProcAddress ((GLubyte *) "glQueryCounter");
+	getQueryObjectiv = (ProfilerGetQueryObjectivProc)
+	    s->getProcAddress ((GLubyte *) "glGetQueryObjectiv");
+	getQueryObjectui64v = (ProfilerGetQueryObjectui64vProc)
+	    s->getProcAddress ((GLubyte *) "glGetQueryObjectui64v");
+
+	if (!genQueries || !queryCounter ||
+	    !getQueryObjectiv || !getQueryObjectui64v)
+		return;
+
+	queries = malloc (sizeof (GLuint) * 2 * PROFILER_QUERY_POOL);
+	if (!queries)
+		return;
+
+	(*genQueries) (2 * PROFILER_QUERY_POOL, queries);
+
+	gpuScreen = s;
+}
+
+/* Results of a frame are collected at the end of the next frame of the
+   same screen at the latest, so with at most half the pool used per
+   frame a query pair is never reused while still pending. */
+static int
+beginQuery (void)
+{
+	int query;
+
+	if (frameScreen != gpuScreen || nFrameQuery >= PROFILER_QUERY_POOL / 2)
+		return -1;
+
+	query = queryHead++ % PROFILER_QUERY_POOL;
+	nFrameQuery++;
+
+	(*queryCounter) (queries[2 * query], GL_TIMESTAMP);
+
+	return query;
+}
+
+static void
+endQuery (int query)
+{
+	if (query >= 0)
+		(*queryCounter) (queries[2 * query + 1], GL_TIMESTAMP);
+}
+
+static void
+resolveQueries (void)
+{
+	unsigned long long begin, end;
+	ProfileEvent       *e;
+	GLint              available;
+
+	while (resolveHead < ringHead)
+	{
+		e = &ring[resolveHead & (PROFILER_RING_SIZE - 1)];
+
+		if (e->query >= 0)
+		{
+			/* older frames are waited for, they should be done anyway */
+			if (e->frame == frameCount)
+			{
+				available = 0;
+				(*getQueryObjectiv) (queries[2 * e->query + 1],
+				                     GL_QUERY_RESULT_AVAILABLE, &available);
+				if (!available)
+					break;
+			}
+
+			(*getQueryObjectui64v) (queries[2 * e->query],
+			                        GL_QUERY_RESULT, &begin);
+			(*getQueryObjectui64v) (queries[2 * e->query + 1],
+			                        GL_QUERY_RESULT, &end);
+
+			__atomic_store_n (&e->gpu, (long long) (end - begin),
+			                  __ATOMIC_RELAXED);
+		}
+
+		resolveHead++;
+	}
+}
+
+static void
+pushEvent (ProfileCall *call,
+           long long   duration)
+{
+	ProfileEvent *e;
+
+	/* the slot of the oldest event is reused, whatever it still waits
+	   for is lost */
+	if (ringHead - resolveHead >= PROFILER_RING_SIZE)
+		resolveHead++;
+
+	e = &ring[ringHead & (PROFILER_RING_SIZE - 1)];
+
+	e->hook      = call->hook;
+	e->plugin    = call->plugin;
+	e->frame     = frameCount;
+	e->screenNum = frameScreen->screenNum;
+	e->depth     = depth;
+	e->query     = call->query;
+	e->start     = call->start;
+	e->duration  = duration;
+	e->self      = duration - call->children;
+	e->gpu       = -1;
+
+	__atomic_store_n (&ringHead, ringHead + 1, __ATOMIC_RELEASE);
+}
+
+static void
+closeCall (long long now)
+{
+	ProfileCall *call = &stack[--depth];
+	long long   duration = now - call->start;
+
+	endQuery (call->query);
+
+	if (depth)
+		stack[depth - 1].children += duration;
+
+	pushEvent (call, duration);
+}
+
+static void
+openCall (const char *hook,
+          const char *plugin)
+{
+	ProfileCall *call = &stack[depth++];
+
+	call->hook     = hook;
+	call->plugin   = plugin;
+	call->children = 0;
+	call->query    = beginQuery ();
+	call->start    = getProfileTime ();
+}
+
+static void
+pushFrame (CompScreen *s,
+           long long  start,
+           long long  duration)
+{
+	ProfileFrame  *f = &frames[frameHead & (PROFILER_FRAME_RING - 1)];
+	long long     *damage = NULL;
+	unsigned long allocations;
+
+	if (s->screenNum < PROFILER_MAX_SCREEN)
+		damage = &damageTime[s->screenNum];
+
+	f->frame     = frameCount;
+	f->screenNum = s->screenNum;
+	f->start     = start;
+	f->duration  = duration;
+	f->latency   = -1;
+	f->mipmaps   = s->mipmapRebuilds;
+
+	f->allocations = -1;
+	if (countAllocations && getHeapAllocationCount (&allocations))
+		f->allocations = allocations - frameAllocations;
+
+	/* damage from before the frame started is painted by it */
+	if (damage && *damage && *damage <= start)
+	{
+		f->latency = start - *damage;
+		*damage = 0;
+	}
+
+	__atomic_store_n (&frameHead, frameHead + 1, __ATOMIC_RELEASE);
+}
+
+void
+profilerEnterHook (const char *hook,
+                   void       *func)
+{
+	if (!inFrame)
+		return;
+
+	if (depth == PROFILER_MAX_DEPTH)
+	{
+		overflow++;
+		return;
+	}
+
+	openCall (hook, getPluginName (func));
+}
+
+void
+profilerLeaveHook (const char *hook)
+{
+	long long now;
+	int       i;
+
+	if (!inFrame)
+		return;
+
+	if (overflow)
+	{
+		overflow--;
+		return;
+	}
+
+	/* calls that were entered but never left are closed as well,
+	   stack[0] is the frame itself */
+	for (i = depth - 1; i > 0; i--)
+		if (stack[i].hook == hook || !strcmp (stack[i].hook, hook))
+			break;
+
+	if (i <= 0)
+		return;
+
+	now = getProfileTime ();
+
+	while (depth > i)
+		closeCall (now);
+}
+
+/* s has no damage yet, the next frame of s will be late by as much as
+   it takes to get there from now */
+void
+profilerDamageScreen (CompScreen *s)
+{
+	if (s->screenNum < PROFILER_MAX_SCREEN && !damageTime[s->screenNum])
+		damageTime[s->screenNum] = getProfileTime ();
+}
+
+void
+profilerBeginFrame (CompScreen *s)
+{
+	if (!profilerEnabled)
+		return;
+
+	if (!gpuChecked)
+		initGpuTimer (s);
+
+	inFrame     = TRUE;
+	frameScreen = s;
+	depth       = 0;
+	overflow    = 0;
+	nFrameQuery = 0;
+
+	frameCount++;
+
+	countAllocations = getHeapAllocationCount (&frameAllocations);
+
+	openCall ("frame", "core");
+}
+
+void
+profilerEndFrame (CompScreen *s)
+{
+	long long now;
+
+	if (!inFrame)
+		return;
+
+	now = getProfileTime ();
+
+	pushFrame (s, stack[0].start, now - stack[0].start);
+
+	while (depth)
+		closeCall (now);
+
+	inFrame = FALSE;
+
+	if (s == gpuScreen)
+		resolveQueries ();
+}
+
+static void
+appendBuffer (ProfileBuffer *buffer,
+              const char    *format,
+              ...)
+{
+	va_list args;
+	int     length;
+
+	for (;;)
+	{
+		va_start (args, format);
+		length = vsnprintf (buffer->data + buffer->length,
+		                    buffer->size - buffer->length, format, args);
+		va_end (args);
+
+		if (length < 0)
+			return;
+
+		if (buffer->length + length < buffer->size)
+		{
+			buffer->length += length;
+			return;
+		}
+
+		char *data = realloc (buffer->data,
+		                      buffer->size * 2 + length + 1);
+		if (!data)
+			return;
+
+		buffer->data = data;
+		buffer->size = buffer->size * 2 + length + 1;
+	}
+}
+
+static void
+appendString (ProfileBuffer *buffer,
+              const char    *string)
+{
+	appendBuffer (buffer, "\"");
+
+	for (; *string; string++)
+	{
+		if (*string == '"' || *string == '\\')
+			appendBuffer (buffer, "\\%c", *string);
+		else if ((unsigned char) *string < 0x20)
+			appendBuffer (buffer, "\\u%04x", *string);
+		else
+			appendBuffer (buffer, "%c", *string);
+	}
+
+	appendBuffer (buffer, "\"");
+}
+
+/* copy the events that are still in the ring, returns the number */
+static int
+snapshotEvents (ProfileEvent **events)
+{
+	unsigned long head, first, after, i;
+	int           n = 0;
+
+	head  = __atomic_load_n (&ringHead, __ATOMIC_ACQUIRE);
+	first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+	if (first < ringTail)
+		first = ringTail;
+
+	*events = malloc (sizeof (ProfileEvent) * (head - first + 1));
+	if (!*events)
+		return 0;
+
+	for (i = first; i < head; i++)
+		(*events)[i - first] = ring[i & (PROFILER_RING_SIZE - 1)];
+
+	/* whatever was overwritten while copying is garbage */
+	after = __atomic_load_n (&ringHead, __ATOMIC_ACQUIRE);
+	if (after > PROFILER_RING_SIZE && after - PROFILER_RING_SIZE > first)
+	{
+		unsigned long skip = after - PROFILER_RING_SIZE - first;
+
+		if (skip > head - first)
+			skip = head - first;
+
+		memmove (*events, *events + skip,
+		         sizeof (ProfileEvent) * (head - first - skip));
+		first += skip;
+	}
+
+	n = head - first;
+
+	return n;
+}
+
+static void
+appendTime (ProfileBuffer *buffer,
+            const char    *name,
+            long long     ns)
+{
+	if (ns < 0)
+		appendBuffer (buffer, ",\"%s\":null", name);
+	else
+		appendBuffer (buffer, ",\"%s\":%.3f", name, ns / 1000.0);
+}
+
+static void
+dumpJson (ProfileBuffer *buffer,
+          ProfileEvent  *events,
+          int           nEvent)
+{
+	typedef struct _ProfileSummary {
+		const char *hook;
+		const char *plugin;
+		int        calls;
+		long long  cpu, self, gpu;
+	} ProfileSummary;
+
+	ProfileSummary *summary = NULL, *newSummary;
+	int            nSummary = 0;
+	int            i, j;
+
+	appendBuffer (buffer, "{\"frames\":%u,\"gpu\":%s,\"events\":[",
+	              frameCount, gpuScreen ? "true" : "false");
+
+	for (i = 0; i < nEvent; i++)
+	{
+		ProfileEvent *e = &events[i];
+
+		appendBuffer (buffer, "%s{\"frame\":%u,\"screen\":%d,\"hook\":",
+		              i ? "," : "", e->frame, e->screenNum);
+		appendString (buffer, e->hook);
+		appendBuffer (buffer, ",\"plugin\":");
+		appendString (buffer, e->plugin);
+		appendBuffer (buffer, ",\"depth\":%d", e->depth);
+		appendTime (buffer, "start", e->start);
+		appendTime (buffer, "cpu", e->duration);
+		appendTime (buffer, "self", e->self);
+		appendTime (buffer, "gpu", e->gpu);
+		appendBuffer (buffer, "}");
+
+		/* hook and plugin names are unique pointers */
+		for (j = 0; j < nSummary; j++)
+			if (summary[j].hook == e->hook && summary[j].plugin == e->plugin)
+				break;
+
+		if (j == nSummary)
+		{
+			newSummary = realloc (summary,
+			                      sizeof (ProfileSummary) * (nSummary + 1));
+			if (!newSummary)
+				continue;
+
+			summary = newSummary;
+			summary[j].hook   = e->hook;
+			summary[j].plugin = e->plugin;
+			summary[j].calls  = 0;
+			summary[j].cpu    = 0;
+			summary[j].self   = 0;
+			summary[j].gpu    = -1;
+			nSummary++;
+		}
+
+		summary[j].calls++;
+		summary[j].cpu  += e->duration;
+		summary[j].self += e->self;
+
+		if (e->gpu >= 0)
+			summary[j].gpu = MAX (summary[j].gpu, 0) + e->gpu;
+	}
+
+	appendBuffer (buffer, "],\"summary\":[");
+
+	for (i = 0; i < nSummary; i++)
+	{
+		appendBuffer (buffer, "%s{\"hook\":", i ? "," : "");
+		appendString (buffer, summary[i].hook);
+		appendBuffer (buffer, ",\"plugin\":");
+		appendString (buffer, summary[i].plugin);
+		appendBuffer (buffer, ",\"calls\":%d", summary[i].calls);
+		appendTime (buffer, "cpu", summary[i].cpu);
+		appendTime (buffer, "self", summary[i].self);
+		appendTime (buffer, "gpu", summary[i].gpu);
+		appendBuffer (buffer, "}");
+	}
+
+	appendBuffer (buffer, "]}");
+
+	if (summary)
+		free (summary);
+}
+
+/* complete events, one thread per screen, load it in chrome://tracing */
+static void
+dumpChromeTrace (ProfileBuffer *buffer,
+                 ProfileEvent  *events,
+                 int           nEvent)
+{
+	int i;
+
+	appendBuffer (buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (i = 0; i < nEvent; i++)
+	{
+		ProfileEvent *e = &events[i];
+
+		appendBuffer (buffer, "%s{\"name\":", i ? "," : "");
+		appendString (buffer, e->hook);
+		appendBuffer (buffer, ",\"cat\":");
+		appendString (buffer, e->plugin);
+		appendBuffer (buffer, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d",
+		              e->screenNum);
+		appendTime (buffer, "ts", e->start);
+		appendTime (buffer, "dur", e->duration);
+		appendBuffer (buffer, ",\"args\":{\"frame\":%u", e->frame);
+		appendTime (buffer, "self", e->self);
+		appendTime (buffer, "gpu", e->gpu);
+		appendBuffer (buffer, "}}");
+	}
+
+	appendBuffer (buffer, "]}");
+}
+
+static int
+compareTimes (const void *a,
+              const void *b)
+{
+	long long ta = *(const long long *) a;
+	long long tb = *(const long long *) b;
+
+	return ta < tb ? -1 : ta > tb;
+}
+
+/* sorts times */
+static void
+appendDistribution (ProfileBuffer *buffer,
+                    const char    *name,
+                    long long     *times,
+                    int           n)
+{
+	long long total = 0;
+	int       i;
+
+	appendBuffer (buffer, ",\"%s\":{\"count\":%d", name, n);
+
+	if (n)
+	{
+		qsort (times, n, sizeof (long long), compareTimes);
+
+		for (i = 0; i < n; i++)
+			total += times[i];
+
+		appendTime (buffer, "mean", total / n);
+		appendTime (buffer, "p50", times[n / 2]);
+		appendTime (buffer, "p90", times[(n * 9) / 10]);
+		appendTime (buffer, "p99", times[(n * 99) / 100]);
+		appendTime (buffer, "max", times[n - 1]);
+	}
+
+	appendBuffer (buffer, "}");
+}
+
+/* Frame rate and distributions of the frames since the last clear,
+   times in microseconds. "paint" is the time spent in a frame,
+   "interval" the time between the starts of two frames of a screen and
+   "latency" the time from the first damage to the frame painting it.
+   "mipmaps" counts the full mipmap regenerations of all frames and
+   "allocations" the heap allocations made by frames, when something
+   counts them. */
+static void
+dumpStats (ProfileBuffer *buffer)
+{
+	ProfileFrame  *f, *last[PROFILER_MAX_SCREEN];
+	unsigned long head, first, i;
+	long long     *paint, *interval, *latency, *allocations;
+	long long     begin = 0, end = 0, totalAllocations = 0;
+	unsigned long mipmaps = 0;
+	int           nPaint = 0, nInterval = 0, nLatency = 0, nAllocations = 0;
+	double        seconds;
+
+	head  = __atomic_load_n (&frameHead, __ATOMIC_ACQUIRE);
+	first = head > PROFILER_FRAME_RING ? head - PROFILER_FRAME_RING : 0;
+	if (first < frameTail)
+		first = frameTail;
+
+	paint    = malloc (sizeof (long long) * (head - first + 1));
+	interval = malloc (sizeof (long long) * (head - first + 1));
+	latency  = malloc (sizeof (long long) * (head - first + 1));
+
+	allocations = malloc (sizeof (long long) * (head - first + 1));
+
+	if (paint && interval && latency && allocations)
+	{
+		memset (last, 0, sizeof (last));
+
+		for (i = first; i < head; i++)
+		{
+			f = &frames[i & (PROFILER_FRAME_RING - 1)];
+
+			if (!nPaint || f->start < begin)
+				begin = f->start;
+
+			if (f->start + f->duration > end)
+				end = f->start + f->duration;
+
+			paint[nPaint++] = f->duration;
+			mipmaps += f->mipmaps;
+
+			if (f->latency >= 0)
+				latency[nLatency++] = f->latency;
+
+			if (f->allocations >= 0)
+			{
+				allocations[nAllocations++] = f->allocations;
+				totalAllocations += f->allocations;
+			}
+
+			if (f->screenNum < PROFILER_MAX_SCREEN)
+			{
+				if (last[f->screenNum])
+					interval[nInterval++] = f->start -
+					                        last[f->screenNum]->start;
+
+				last[f->screenNum] = f;
+			}
+		}
+	}
+
+	seconds = (end - begin) / 1000000000.0;
+
+	appendBuffer (buffer, "{\"frames\":%d,\"seconds\":%.3f,\"fps\":%.2f",
+	              nPaint, seconds, seconds > 0 ? nPaint / seconds : 0.0);
+
+	appendDistribution (buffer, "paint", paint, nPaint);
+	appendDistribution (buffer, "interval", interval, nInterval);
+	appendDistribution (buffer, "latency", latency, nLatency);
+
+	appendBuffer (buffer, ",\"mipmaps\":{\"count\":%lu,\"per_frame\":%.2f}",
+	              mipmaps, nPaint ? (double) mipmaps / nPaint : 0.0);
+
+	if (nAllocations)
+	{
+		qsort (allocations, nAllocations, sizeof (long long), compareTimes);
+
+		appendBuffer (buffer, ",\"allocations\":{\"count\":%lld,"
+		              "\"per_frame\":%.2f,\"p50\":%lld,\"max\":%lld}",
+		              totalAllocations,
+		              (double) totalAllocations / nAllocations,
+		              allocations[nAllocations / 2],
+		              allocations[nAllocations - 1]);
+	}
+
+	appendBuffer (buffer, "}");
+
+	if (paint)
+		free (paint);
+
+	if (interval)
+		free (interval);
+
+	if (latency)
+		free (latency);
+
+	if (allocations)
+		free (allocations);
+}
+
+/* returns a string to be freed by the caller */
+char *
+profilerDump (const char *format)
+{
+	ProfileBuffer buffer;
+	ProfileEvent  *events;
+	int           nEvent;
+
+	buffer.size   = 4096;
+	buffer.length = 0;
+	buffer.data   = malloc (buffer.size);
+	if (!buffer.data)
+		return NULL;
+
+	buffer.data[0] = '\0';
+
+	if (format && !strcmp (format, "stats"))
+	{
+		dumpStats (&buffer);
+
+		return buffer.data;
+	}
+
+	nEvent = snapshotEvents (&events);
+
+	if (format && !strcmp (format, "chrome"))
+		dumpChromeTrace (&buffer, events, nEvent);
+	else
+		dumpJson (&buffer, events, nEvent);
+
+	if (events)
+		free (events);
+
+	return buffer.data;
+}
+
+static void
+profilerSendReply (DBusConnection *connection,
+                   DBusMessage    *message,
+                   const char     *string)
+{
+	DBusMessage *reply;
+
+	reply = dbus_message_new_method_return (message);
+
+	if (string)
+		dbus_message_append_args (reply,
+		                          DBUS_TYPE_STRING, &string,
+		                          DBUS_TYPE_INVALID);
+
+	dbus_connection_send (connection, reply, NULL);
+	dbus_connection_flush (connection);
+	dbus_message_unref (reply);
+}
+
+static DBusHandlerResult
+profilerDbusHandleMessage (DBusConnection *connection,
+                           DBusMessage    *message,
+                           void           *userData)
+{
+	if (dbus_message_is_method_call (message, "org.fusilli", "start"))
+	{
+		if (!profilerEnabled)
+		{
+			profilerFlushNameCache ();
+			memset (damageTime, 0, sizeof (damageTime));
+		}
+
+		profilerEnabled = TRUE;
+
+		profilerSendReply (connection, message, NULL);
+
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+	else if (dbus_message_is_method_call (message, "org.fusilli", "stop"))
+	{
+		profilerEnabled = FALSE;
+
+		profilerSendReply (connection, message, NULL);
+
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+	else if (dbus_message_is_method_call (message, "org.fusilli", "clear"))
+	{
+		ringTail  = __atomic_load_n (&ringHead, __ATOMIC_ACQUIRE);
+		frameTail = __atomic_load_n (&frameHead, __ATOMIC_ACQUIRE);
+
+		profilerSendReply (connection, message, NULL);
+
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+	else if (dbus_message_is_method_call (message, "org.fusilli", "dump"))
+	{
+		DBusMessageIter paramIter;
+		const char      *format = "json";
+		char            *dump;
+
+		//read the optional format, "json", "chrome" or "stats"
+		if (dbus_message_iter_init (message, &paramIter))
+			if (dbus_message_iter_get_arg_type (&paramIter) ==
+			                                            DBUS_TYPE_STRING)
+				dbus_message_iter_get_basic (&paramIter, &format);
+
+		dump = profilerDump (format);
+		if (!dump)
+			return DBUS_HANDLER_RESULT_NEED_MEMORY;
+
+		profilerSendReply (connection, message, dump);
+
+		free (dump);
+
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
+	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static DBusObjectPathVTable profilerDbusMessagesVTable = {
+	NULL, profilerDbusHandleMessage, NULL, NULL, NULL, NULL
+};
+
+void
+initProfiler (void)
+{
+	if (core.dbusConnection)
+		dbus_connection_register_object_path (core.dbusConnection,
+		                                      "/org/fusilli/profiler",
+		                                      &profilerDbusMessagesVTable,
+		                                      NULL);
+
+	if (profilerEnabled)
+		compLogMessage ("core", CompLogLevelInfo,
+		                "Profiling enabled, dump with "
+		                "org.fusilli.dump on /org/fusilli/profiler");
+}
+
+void
+finiProfiler (void)
+{
+	int i;
+
+	if (core.dbusConnection)
+		dbus_connection_unregister_object_path (core.dbusConnection,
+		                                        "/org/fusilli/profiler");
+
+	/* the query objects go away with the GL context */
+	if (queries)
+		free (queries);
+
+	queries    = NULL;
+	gpuScreen  = NULL;
+	gpuChecked = FALSE;
+
+	for (i = 0; i < nNames; i++)
+		free (names[i]);
+
+	if (names)
+		free (names);
+
+	names  = NULL;
+	nNames = 0;
+
+	profilerFlushNameCache ();
+}
@@ -0,0 +1,606 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Band based region operations working directly on Xlib's REGION
+ * layout, so every Region in the tree can be passed to them and the
+ * results can still be read by Xlib and by plugins.
+ *
+ * Rects are y-x banded like Xlib's: sorted by y1 then x1, all rects of
+ * a band share y1 and y2, and vertically adjacent bands with identical
+ * spans are coalesced.
+ *
+ * Xlib allocates a new rect array for the result of every operation.
+ * Here results are built in a scratch buffer that is kept between
+ * calls and then copied into the destination, whose storage is only
+ * reallocated when it is too small.
+ *
+ * A REGION with size <= 0 does not own its rects, -size of them are
+ * available. CompRegion uses that for inline storage, which avoids any
+ * allocation for the small regions that are most common. Such a region
+ * must only be modified with the functions in this file, never with
+ * Xlib ones, and is released with finiRegion.
+ *
+ * Grown rects are not taken from the frame arena. Most regions outlive
+ * the frame and are released by Xlib with free, and the CompRegion
+ * temporaries of flushPendingDamage are filled outside of the paint of
+ * any one screen, so no frame arena owns them.
+ */
+
+#include <string.h>
+
+#include <fusilli-core.h>
+
+typedef void (*OverlapProc) (BoxPtr r1, BoxPtr r1End,
+                             BoxPtr r2, BoxPtr r2End,
+                             short  y1, short  y2);
+
+static BoxPtr scratchRects = NULL;
+static int    scratchSize = 0;
+static int    nScratch;
+static int    prevBand;
+static int    curBand;
+static Bool   scratchFailed;
+
+static void
+appendRect (short x1,
+            short y1,
+            short x2,
+            short y2)
+{
+	BoxPtr box;
+
+	if (nScratch == scratchSize)
+	{
+		BoxPtr rects;
+		int    size = scratchSize ? scratchSize * 2 : 256;
+
+		rects = realloc (scratchRects, sizeof (BOX) * size);
+		if (!rects)
+		{
+			scratchFailed = TRUE;
+			return;
+		}
+
+		scratchRects = rects;
+		scratchSize  = size;
+	}
+
+	box = &scratchRects[nScratch++];
+
+	box->x1 = x1;
+	box->y1 = y1;
+	box->x2 = x2;
+	box->y2 = y2;
+}
+
+static void
+beginBand (void)
+{
+	curBand = nScratch;
+}
+
+/* merge the band just written with the previous one if they touch
+   vertically and have the same spans */
+static void
+endBand (void)
+{
+	int n = nScratch - curBand;
+	int i;
+
+	if (!n)
+		return;
+
+	if (prevBand >= 0 && curBand - prevBand == n &&
+	    scratchRects[prevBand].y2 == scratchRects[curBand].y1)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (scratchRects[prevBand + i].x1 != scratchRects[curBand + i].x1 ||
+			    scratchRects[prevBand + i].x2 != scratchRects[curBand + i].x2)
+				break;
+		}
+
+		if (i == n)
+		{
+			short y2 = scratchRects[curBand].y2;
+
+			for (i = 0; i < n; i++)
+				scratchRects[prevBand + i].y2 = y2;
+
+			nScratch = curBand;
+			return;
+		}
+	}
+
+	prevBand = curBand;
+}
+
+static void
+appendBand (BoxPtr r,
+            BoxPtr rEnd,
+            short  y1,
+            short  y2)
+{
+	beginBand ();
+
+	for (; r != rEnd; r++)
+		appendRect (r->x1, y1, r->x2, y2);
+
+	endBand ();
+}
+
+static void
+unionOverlap (BoxPtr r1, BoxPtr r1End,
+              BoxPtr r2, BoxPtr r2End,
+              short  y1, short  y2)
+{
+	BoxPtr r;
+	short  x1, x2;
+
+	if (r1->x1 < r2->x1)
+		r = r1++;
+	else
+		r = r2++;
+
+	x1 = r->x1;
+	x2 = r->x2;
+
+	while (r1 != r1End || r2 != r2End)
+	{
+		if (r2 == r2End || (r1 != r1End && r1->x1 < r2->x1))
+			r = r1++;
+		else
+			r = r2++;
+
+		if (r->x1 <= x2)
+		{
+			if (r->x2 > x2)
+				x2 = r->x2;
+		}
+		else
+		{
+			appendRect (x1, y1, x2, y2);
+
+			x1 = r->x1;
+			x2 = r->x2;
+		}
+	}
+
+	appendRect (x1, y1, x2, y2);
+}
+
+static void
+intersectOverlap (BoxPtr r1, BoxPtr r1End,
+                  BoxPtr r2, BoxPtr r2End,
+                  short  y1, short  y2)
+{
+	short x1, x2;
+
+	while (r1 != r1End && r2 != r2End)
+	{
+		x1 = MAX (r1->x1, r2->x1);
+		x2 = MIN (r1->x2, r2->x2);
+
+		if (x1 < x2)
+			appendRect (x1, y1, x2, y2);
+
+		if (r1->x2 < r2->x2)
+			r1++;
+		else if (r2->x2 < r1->x2)
+			r2++;
+		else
+		{
+			r1++;
+			r2++;
+		}
+	}
+}
+
+static void
+subtractOverlap (BoxPtr r1, BoxPtr r1End,
+                 BoxPtr r2, BoxPtr r2End,
+                 short  y1, short  y2)
+{
+	short x1 = r1->x1;
+
+	while (r1 != r1End && r2 != r2End)
+	{
+		if (r2->x2 <= x1)
+		{
+			/* subtrahend entirely to the left */
+			r2++;
+		}
+		else if (r2->x1 <= x1)
+		{
+			/* subtrahend covers the left part of the minuend */
+			x1 = r2->x2;
+			if (x1 >= r1->x2)
+			{
+				if (++r1 != r1End)
+					x1 = r1->x1;
+			}
+			else
+			{
+				r2++;
+			}
+		}
+		else if (r2->x1 < r1->x2)
+		{
+			/* subtrahend splits the minuend */
+			appendRect (x1, y1, r2->x1, y2);
+
+			x1 = r2->x2;
+			if (x1 >= r1->x2)
+			{
+				if (++r1 != r1End)
+					x1 = r1->x1;
+			}
+			else
+			{
+				r2++;
+			}
+		}
+		else
+		{
+			/* subtrahend entirely to the right */
+			if (r1->x2 > x1)
+				appendRect (x1, y1, r1->x2, y2);
+
+			if (++r1 != r1End)
+				x1 = r1->x1;
+		}
+	}
+
+	while (r1 != r1End)
+	{
+		appendRect (x1, y1, r1->x2, y2);
+
+		if (++r1 != r1End)
+			x1 = r1->x1;
+	}
+}
+
+static BoxPtr
+findBandEnd (BoxPtr r,
+             BoxPtr rEnd)
+{
+	short y1 = r->y1;
+
+	while (r != rEnd && r->y1 == y1)
+		r++;
+
+	return r;
+}
+
+/* walks both regions band by band, calling overlap for the parts where
+   bands of both regions overlap vertically and copying the parts of a
+   and b that don't overlap if appendA and appendB are set */
+static void
+regionOp (Region      a,
+          Region      b,
+          OverlapProc overlap,
+          Bool        appendA,
+          Bool        appendB)
+{
+	BoxPtr r1 = a->rects, r1End = a->rects + a->numRects, r1BandEnd;
+	BoxPtr r2 = b->rects, r2End = b->rects + b->numRects, r2BandEnd;
+	short  ytop, ybot, top, bot;
+
+	nScratch      = 0;
+	prevBand      = -1;
+	scratchFailed = FALSE;
+
+	ybot = MIN (r1->y1, r2->y1);
+
+	while (r1 != r1End && r2 != r2End)
+	{
+		r1BandEnd = findBandEnd (r1, r1End);
+		r2BandEnd = findBandEnd (r2, r2End);
+
+		if (r1->y1 < r2->y1)
+		{
+			if (appendA)
+			{
+				top = MAX (r1->y1, ybot);
+				bot = MIN (r1->y2, r2->y1);
+				if (top < bot)
+					appendBand (r1, r1BandEnd, top, bot);
+			}
+
+			ytop = r2->y1;
+		}
+		else if (r2->y1 < r1->y1)
+		{
+			if (appendB)
+			{
+				top = MAX (r2->y1, ybot);
+				bot = MIN (r2->y2, r1->y1);
+				if (top < bot)
+					appendBand (r2, r2BandEnd, top, bot);
+			}
+
+			ytop = r1->y1;
+		}
+		else
+		{
+			ytop = r1->y1;
+		}
+
+		ybot = MIN (r1->y2, r2->y2);
+		if (ybot > ytop)
+		{
+			beginBand ();
+			(*overlap) (r1, r1BandEnd, r2, r2BandEnd, ytop, ybot);
+			endBand ();
+		}
+
+		if (r1->y2 == ybot)
+			r1 = r1BandEnd;
+		if (r2->y2 == ybot)
+			r2 = r2BandEnd;
+	}
+
+	if (appendA)
+	{
+		while (r1 != r1End)
+		{
+			r1BandEnd = findBandEnd (r1, r1End);
+			appendBand (r1, r1BandEnd, MAX (r1->y1, ybot), r1->y2);
+			r1 = r1BandEnd;
+		}
+	}
+
+	if (appendB)
+	{
+		while (r2 != r2End)
+		{
+			r2BandEnd = findBandEnd (r2, r2End);
+			appendBand (r2, r2BandEnd, MAX (r2->y1, ybot), r2->y2);
+			r2 = r2BandEnd;
+		}
+	}
+}
+
+static Bool
+reserveRegionRects (Region r,
+                    int    n)
+{
+	BoxPtr rects;
+	int    size;
+
+	if (n <= (r->size > 0 ? r->size : -r->size))
+		return TRUE;
+
+	size = MAX (n, 8);
+
+	if (r->size > 0)
+	{
+		rects = realloc (r->rects, sizeof (BOX) * size);
+		if (!rects)
+			return FALSE;
+	}
+	else
+	{
+		rects = malloc (sizeof (BOX) * size);
+		if (!rects)
+			return FALSE;
+
+		if (r->numRects)
+			memcpy (rects, r->rects, sizeof (BOX) * r->numRects);
+	}
+
+	r->rects = rects;
+	r->size  = size;
+
+	return TRUE;
+}
+
+static Bool
+setRegionRects (Region dst,
+                BoxPtr rects,
+                int    n)
+{
+	int i;
+
+	if (!reserveRegionRects (dst, n))
+		return FALSE;
+
+	if (n && dst->rects != rects)
+		memmove (dst->rects, rects, sizeof (BOX) * n);
+
+	dst->numRects = n;
+
+	if (!n)
+	{
+		dst->extents.x1 = dst->extents.y1 = 0;
+		dst->extents.x2 = dst->extents.y2 = 0;
+
+		return TRUE;
+	}
+
+	dst->extents.x1 = rects[0].x1;
+	dst->extents.y1 = rects[0].y1;
+	dst->extents.x2 = rects[0].x2;
+	dst->extents.y2 = rects[n - 1].y2;
+
+	for (i = 1; i < n; i++)
+	{
+		if (rects[i].x1 < dst->extents.x1)
+			dst->extents.x1 = rects[i].x1;
+		if (rects[i].x2 > dst->extents.x2)
+			dst->extents.x2 = rects[i].x2;
+	}
+
+	return TRUE;
+}
+
+static Bool
+finishRegionOp (Region dst)
+{
+	if (scratchFailed)
+		return FALSE;
+
+	return setRegionRects (dst, scratchRects, nScratch);
+}
+
+static Bool
+regionContainsBox (Region r,
+                   BoxPtr box)
+{
+	return r->numRects == 1 &&
+	       r->extents.x1 <= box->x1 && r->extents.y1 <= box->y1 &&
+	       r->extents.x2 >= box->x2 && r->extents.y2 >= box->y2;
+}
+
+static Bool
+extentsOverlap (Region a,
+                Region b)
+{
+	return a->extents.x1 < b->extents.x2 && b->extents.x1 < a->extents.x2 &&
+	       a->extents.y1 < b->extents.y2 && b->extents.y1 < a->extents.y2;
+}
+
+void
+initRegion (CompRegion *r)
+{
+	r->region.rects    = r->inlineRects;
+	r->region.size     = -COMP_REGION_INLINE_RECTS;
+	r->region.numRects = 0;
+
+	r->region.extents.x1 = r->region.extents.y1 = 0;
+	r->region.extents.x2 = r->region.extents.y2 = 0;
+}
+
+void
+finiRegion (CompRegion *r)
+{
+	if (r->region.size > 0)
+		free (r->region.rects);
+
+	initRegion (r);
+}
+
+void
+compEmptyRegion (Region r)
+{
+	r->numRects = 0;
+
+	r->extents.x1 = r->extents.y1 = 0;
+	r->extents.x2 = r->extents.y2 = 0;
+}
+
+Bool
+compCopyRegion (Region src,
+                Region dst)
+{
+	if (src == dst)
+		return TRUE;
+
+	if (!reserveRegionRects (dst, src->numRects))
+		return FALSE;
+
+	if (src->numRects)
+		memcpy (dst->rects, src->rects, sizeof (BOX) * src->numRects);
+
+	dst->numRects = src->numRects;
+	dst->extents  = src->extents;
+
+	return TRUE;
+}
+
+Bool
+compUnionRegion (Region a,
+                 Region b,
+                 Region dst)
+{
+	if (a == b || !b->numRects || regionContainsBox (a, &b->extents))
+		return compCopyRegion (a, dst);
+
+	if (!a->numRects || regionContainsBox (b, &a->extents))
+		return compCopyRegion (b, dst);
+
+	regionOp (a, b, unionOverlap, TRUE, TRUE);
+
+	return finishRegionOp (dst);
+}
+
+Bool
+compUnionRectWithRegion (const BoxRec *box,
+                         Region       src,
+                         Region       dst)
+{
+	REGION region;
+
+	if (box->x1 >= box->x2 || box->y1 >= box->y2)
+		return compCopyRegion (src, dst);
+
+	region.extents  = *box;
+	region.rects    = &region.extents;
+	region.numRects = 1;
+	region.size     = 0;
+
+	return compUnionRegion (src, &region, dst);
+}
+
+Bool
+compIntersectRegion (Region a,
+                     Region b,
+                     Region dst)
+{
+	if (!a->numRects || !b->numRects || !extentsOverlap (a, b))
+	{
+		compEmptyRegion (dst);
+		return TRUE;
+	}
+
+	if (a == b || regionContainsBox (b, &a->extents))
+		return compCopyRegion (a, dst);
+
+	if (regionContainsBox (a, &b->extents))
+		return compCopyRegion (b, dst);
+
+	regionOp (a, b, intersectOverlap, FALSE, FALSE);
+
+	return finishRegionOp (dst);
+}
+
+Bool
+compSubtractRegion (Region a,
+                    Region b,
+                    Region dst)
+{
+	if (!a->numRects || !b->numRects || !extentsOverlap (a, b))
+		return compCopyRegion (a, dst);
+
+	if (a == b || regionContainsBox (b, &a->extents))
+	{
+		compEmptyRegion (dst);
+		return TRUE;
+	}
+
+	regionOp (a, b, subtractOverlap, TRUE, FALSE);
+
+	return finishRegionOp (dst);
+}
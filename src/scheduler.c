@@ -0,0 +1,308 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Frame scheduling.
+ *
+ * The adaptive scheduler measures what painting a frame costs, from
+ * the start of preparePaintScreen until the GPU is done with the
+ * commands of paintScreen, and keeps a moving average of the cost and
+ * of how far it is off. The GPU clock is read at the start of the
+ * frame and a timestamp query is placed after paintScreen. Its result
+ * is only read once the GPU got there, a frame or two later, so the
+ * CPU never waits for the GPU. Without ARB_timer_query only the CPU
+ * time is measured. A damaged screen is painted that long, plus a safety
+ * margin of a few deviations, before the refresh that the frame can
+ * still make. Input that arrives while waiting is part of the frame,
+ * which keeps the latency from input to photon low.
+ *
+ * With sync to vblank the refreshes are aligned to the time the last
+ * frame was presented, otherwise a frame is due one refresh period
+ * after the last one or as soon as it can be painted.
+ *
+ * The max throughput scheduler paints as soon as anything changed and
+ * does not wait for vertical blanking, for benchmarks.
+ */
+
+#define SCHEDULER_MIN_MARGIN       500  /* microseconds */
+#define SCHEDULER_INITIAL_COST     4000
+#define SCHEDULER_COST_WEIGHT      0.125
+#define SCHEDULER_DEVIATION_WEIGHT 0.25
+
+static long long
+getSchedulerTime (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int
+getFrameSchedulerMode (CompScreen *s)
+{
+	const BananaValue *
+	option_frame_scheduler = bananaGetOptionByHandle (coreOptionFrameScheduler,
+	                                                  s->screenNum);
+
+	return option_frame_scheduler->i;
+}
+
+void
+initFrameScheduler (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+
+	fs->period     = 1000000 / DEFAULT_REFRESH_RATE;
+	fs->lastFrame  = getSchedulerTime ();
+	fs->frameStart = fs->lastFrame;
+	fs->deadline   = fs->lastFrame;
+	fs->cost       = SCHEDULER_INITIAL_COST;
+	fs->deviation  = SCHEDULER_INITIAL_COST / 4;
+	fs->predicted  = fs->cost;
+	fs->measured   = fs->cost;
+	fs->gpuStart   = 0;
+	fs->nextQuery  = 0;
+
+	memset (fs->queries, 0, sizeof (fs->queries));
+}
+
+void
+finiFrameScheduler (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+	int                i;
+
+	for (i = 0; i < FRAME_SCHEDULER_QUERIES; i++)
+	{
+		if (fs->queries[i].query)
+			(*s->deleteQueries) (1, &fs->queries[i].query);
+
+		fs->queries[i].query   = 0;
+		fs->queries[i].pending = FALSE;
+	}
+}
+
+void
+setFrameSchedulerRate (CompScreen *s,
+                       int        rate)
+{
+	s->frameScheduler.period = 1000000 / rate;
+}
+
+/* milliseconds until painting should start */
+int
+getTimeToNextRedraw (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+	long long          now, lead, start, n;
+
+	now = getSchedulerTime ();
+
+	if (getFrameSchedulerMode (s) == FRAME_SCHEDULER_MAX_THROUGHPUT)
+	{
+		fs->deadline = now;
+		return 0;
+	}
+
+	lead = fs->cost + 2 * fs->deviation + SCHEDULER_MIN_MARGIN;
+
+	if (frameSchedulerSyncToVBlank (s))
+	{
+		/* the first refresh after the last frame that can be made */
+		n = (now + lead - fs->lastFrame + fs->period - 1) / fs->period;
+		if (n < 1)
+			n = 1;
+
+		fs->deadline = fs->lastFrame + n * fs->period;
+	}
+	else
+	{
+		fs->deadline = fs->lastFrame + fs->period;
+		if (fs->deadline < now + lead)
+			fs->deadline = now + lead;
+	}
+
+	start = fs->deadline - lead;
+	if (start <= now)
+		return 0;
+
+	return (start - now) / 1000;
+}
+
+Bool
+frameSchedulerSyncToVBlank (CompScreen *s)
+{
+	const BananaValue *
+	option_sync_to_vblank = bananaGetOptionByHandle (coreOptionSyncToVBlank,
+	                                                 s->screenNum);
+
+	if (getFrameSchedulerMode (s) == FRAME_SCHEDULER_MAX_THROUGHPUT)
+		return FALSE;
+
+	return s->getVideoSync && option_sync_to_vblank->b;
+}
+
+static Bool
+useTimerQueries (CompScreen *s)
+{
+	return s->timerQuery &&
+	       getFrameSchedulerMode (s) != FRAME_SCHEDULER_MAX_THROUGHPUT;
+}
+
+/* the screen must be current */
+void
+frameSchedulerBeginFrame (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+	GLint64            gpuStart;
+
+	fs->frameStart = getSchedulerTime ();
+	fs->predicted  = fs->cost;
+
+	if (useTimerQueries (s))
+	{
+		(*s->getInteger64v) (GL_TIMESTAMP, &gpuStart);
+		fs->gpuStart = gpuStart;
+	}
+}
+
+static void
+addFrameCost (CompFrameScheduler *fs,
+              double             cost)
+{
+	double error;
+
+	fs->measured = cost;
+
+	error = cost - fs->cost;
+
+	fs->cost      += error * SCHEDULER_COST_WEIGHT;
+	fs->deviation += ((error < 0 ? -error : error) - fs->deviation) *
+	                 SCHEDULER_DEVIATION_WEIGHT;
+}
+
+/* adds the cost of the frames the GPU is done with, oldest first. A
+   frame costs what the CPU or the GPU took, whichever was longer */
+static void
+collectFrameQueries (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+	CompFrameQuery     *q;
+	GLint              available;
+	GLuint64           gpuEnd;
+	long long          gpuTime;
+	int                i;
+
+	for (i = 0; i < FRAME_SCHEDULER_QUERIES; i++)
+	{
+		q = &fs->queries[(fs->nextQuery + i) % FRAME_SCHEDULER_QUERIES];
+		if (!q->pending)
+			continue;
+
+		(*s->getQueryObjectiv) (q->query, GL_QUERY_RESULT_AVAILABLE,
+		                        &available);
+		if (!available)
+			break;
+
+		(*s->getQueryObjectui64v) (q->query, GL_QUERY_RESULT, &gpuEnd);
+
+		gpuTime = ((long long) gpuEnd - q->gpuStart) / 1000;
+
+		addFrameCost (fs, gpuTime > q->cpuTime ? gpuTime : q->cpuTime);
+
+		q->pending = FALSE;
+	}
+}
+
+/* called after paintScreen. The GPU time of the frame is added later,
+   when it is known, without waiting for it */
+void
+frameSchedulerEndPaint (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+	CompFrameQuery     *q;
+	long long          cpuTime;
+
+	cpuTime = getSchedulerTime () - fs->frameStart;
+
+	if (!useTimerQueries (s))
+	{
+		addFrameCost (fs, cpuTime);
+		return;
+	}
+
+	collectFrameQueries (s);
+
+	/* the GPU is more than FRAME_SCHEDULER_QUERIES frames behind, the
+	   pending frames tell what that costs */
+	q = &fs->queries[fs->nextQuery];
+	if (q->pending)
+		return;
+
+	if (!q->query)
+		(*s->genQueries) (1, &q->query);
+
+	(*s->queryCounter) (q->query, GL_TIMESTAMP);
+
+	q->gpuStart = fs->gpuStart;
+	q->cpuTime  = cpuTime;
+	q->pending  = TRUE;
+
+	fs->nextQuery = (fs->nextQuery + 1) % FRAME_SCHEDULER_QUERIES;
+}
+
+void
+frameSchedulerEndFrame (CompScreen *s)
+{
+	CompFrameScheduler *fs = &s->frameScheduler;
+
+	fs->lastFrame = getSchedulerTime ();
+
+	/* compLogMessage formats before it drops debug messages, not
+	   something to do every frame */
+	if (!debugOutput)
+		return;
+
+	compLogMessage ("core", CompLogLevelDebug,
+	                "screen %d frame: predicted %.2f ms, painted in %.2f ms, "
+	                "presented %.2f ms %s deadline, %u mipmap rebuilds",
+	                s->screenNum,
+	                fs->predicted / 1000.0,
+	                fs->measured / 1000.0,
+	                llabs (fs->lastFrame - fs->deadline) / 1000.0,
+	                fs->lastFrame > fs->deadline ? "after" : "before",
+	                s->mipmapRebuilds);
+}
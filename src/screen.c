@@ -368,6 +368,8 @@ updateOutputDevices (CompScreen	*s)
 	s->nOutputDev            = nOutput;
 	s->hasOverlappingOutputs = FALSE;
 
+	invalidateOutputWindows (s);
+
 	setCurrentOutput (s, s->currentOutputDev);
 
 	/* clear out fullscreen monitor hints of all windows as
@@ -534,6 +536,8 @@ screenChangeNotify (const char        *optionName,
 
 		screen->redrawTime = 1000 / optionValue->i;
 		screen->optimalRedrawTime = screen->redrawTime;
+
+		setFrameSchedulerRate (screen, optionValue->i);
 	}
 	else if (strcasecmp (optionName, "hsize") == 0)
 	{
@@ -1050,6 +1054,8 @@ detectRefreshRateOfScreen (CompScreen *s)
 			value.i = DEFAULT_REFRESH_RATE;
 
 		bananaSetOption (coreBananaIndex, "refresh_rate", s->screenNum, &value);
+
+		setFrameSchedulerRate (s, value.i);
 	}
 	else
 	{
@@ -1060,6 +1066,8 @@ detectRefreshRateOfScreen (CompScreen *s)
 
 		s->redrawTime = 1000 / option_refresh_rate->i;
 		s->optimalRedrawTime = s->redrawTime;
+
+		setFrameSchedulerRate (s, option_refresh_rate->i);
 	}
 }
 
@@ -1536,6 +1544,120 @@ initWindowWalker (CompScreen *screen,
 	walker->prev  = walkPrev;
 }
 
+static void
+freeOutputWindows (CompScreen *s)
+{
+	int i;
+
+	for (i = 0; i < s->nOutputWindows; i++)
+		if (s->outputWindows[i].windows)
+			free (s->outputWindows[i].windows);
+
+	if (s->outputWindows)
+		free (s->outputWindows);
+
+	s->outputWindows  = NULL;
+	s->nOutputWindows = 0;
+}
+
+static Bool
+addOutputWindow (CompOutputWindows *ow,
+                 CompWindow        *w)
+{
+	if (ow->nWindow == ow->size)
+	{
+		CompWindow **windows;
+		int        size = ow->size ? ow->size * 2 : 32;
+
+		windows = realloc (ow->windows, size * sizeof (CompWindow *));
+		if (!windows)
+			return FALSE;
+
+		ow->windows = windows;
+		ow->size    = size;
+	}
+
+	ow->windows[ow->nWindow++] = w;
+
+	return TRUE;
+}
+
+/* sort the windows into the outputs their output rect overlaps, keeping
+   the stacking order */
+static void
+updateOutputWindows (CompScreen *s)
+{
+	CompWindow *w;
+	BOX        *box;
+	int        i, x1, y1, x2, y2;
+
+	if (s->nOutputWindows != s->nOutputDev)
+	{
+		freeOutputWindows (s);
+
+		s->outputWindows = calloc (s->nOutputDev, sizeof (CompOutputWindows));
+		if (!s->outputWindows)
+			return;
+
+		s->nOutputWindows = s->nOutputDev;
+	}
+
+	for (i = 0; i < s->nOutputWindows; i++)
+		s->outputWindows[i].nWindow = 0;
+
+	for (w = s->windows; w; w = w->next)
+	{
+		x1 = w->attrib.x - w->output.left - w->attrib.border_width;
+		y1 = w->attrib.y - w->output.top - w->attrib.border_width;
+		x2 = w->attrib.x + w->width + w->output.right;
+		y2 = w->attrib.y + w->height + w->output.bottom;
+
+		for (i = 0; i < s->nOutputWindows; i++)
+		{
+			box = &s->outputDev[i].region.extents;
+
+			if (x1 >= box->x2 || x2 <= box->x1 ||
+			    y1 >= box->y2 || y2 <= box->y1)
+				continue;
+
+			if (!addOutputWindow (&s->outputWindows[i], w))
+				return;
+		}
+	}
+
+	s->outputWindowsDirty = FALSE;
+}
+
+void
+invalidateOutputWindows (CompScreen *s)
+{
+	s->outputWindowsDirty = TRUE;
+}
+
+/* returns the windows overlapping output in stacking order or NULL if
+   the output has to be painted with the window walker of the screen */
+CompOutputWindows *
+getOutputWindows (CompScreen *s,
+                  CompOutput *output)
+{
+	/* a plugin walker may paint windows that are not in the stack */
+	if (s->initWindowWalker != initWindowWalker)
+		return NULL;
+
+	if (output->id < 0 || output->id >= s->nOutputDev ||
+	    output != &s->outputDev[output->id])
+		return NULL;
+
+	if (s->outputWindowsDirty)
+	{
+		updateOutputWindows (s);
+		if (s->outputWindowsDirty)
+			return NULL;
+	}
+
+	return &s->outputWindows[output->id];
+}
+
 static void
 freeScreen (CompScreen *s)
 {
@@ -1550,6 +1672,8 @@ freeScreen (CompScreen *s)
 		free (s->outputDev);
 	}
 
+	freeOutputWindows (s);
+
 	if (s->clientList)
 		free (s->clientList);
 
@@ -1568,6 +1692,13 @@ freeScreen (CompScreen *s)
 	if (s->damage)
 		XDestroyRegion (s->damage);
 
+	if (s->frameDamage)
+		XDestroyRegion (s->frameDamage);
+
+	for (i = 0; i < DAMAGE_HISTORY_SIZE; i++)
+		if (s->damageHistory[i])
+			XDestroyRegion (s->damageHistory[i]);
+
 	if (s->grabs)
 		free (s->grabs);
 
@@ -1581,6 +1712,17 @@ freeScreen (CompScreen *s)
 			if (s->saturateFunction[i][j])
 				destroyFragmentFunction (s, s->saturateFunction[i][j]);
 
+	finiArena (&s->frameArena);
+
+	if (s->windowHash.entries)
+		free (s->windowHash.entries);
+
+	if (s->frameHash.entries)
+		free (s->frameHash.entries);
+
+	if (s->syncAlarmHash.entries)
+		free (s->syncAlarmHash.entries);
+
 	if (s->windowPrivateIndices)
 		free (s->windowPrivateIndices);
 
@@ -1644,6 +1786,22 @@ addScreen (int         screenNum,
 	if (!s->damage)
 		return FALSE;
 
+	s->frameDamage = XCreateRegion ();
+	if (!s->frameDamage)
+		return FALSE;
+
+	for (i = 0; i < DAMAGE_HISTORY_SIZE; i++)
+	{
+		s->damageHistory[i] = XCreateRegion ();
+		if (!s->damageHistory[i])
+			return FALSE;
+	}
+
+	s->atlasPages = NULL;
+	s->atlasFbo   = 0;
+
+	s->textCache = NULL;
+
 	s->x     = 0;
 	s->y     = 0;
 
@@ -1659,6 +1817,8 @@ addScreen (int         screenNum,
 	s->windowOffsetX = 0;
 	s->windowOffsetY = 0;
 
+	s->occlusionHooks = 0;
+
 	s->nDesktop	      = 1;
 	s->currentDesktop = 0;
 
@@ -1716,21 +1876,37 @@ addScreen (int         screenNum,
 	s->nOutputDev       = 0;
 	s->currentOutputDev = 0;
 
+	s->outputWindows      = NULL;
+	s->nOutputWindows     = 0;
+	s->outputWindowsDirty = TRUE;
+
 	s->windows = 0;
 	s->reverseWindows = 0;
 
+	initArena (&s->frameArena);
+
+	s->windowHash.entries    = NULL;
+	s->windowHash.size       = 0;
+	s->windowHash.count      = 0;
+	s->frameHash.entries     = NULL;
+	s->frameHash.size        = 0;
+	s->frameHash.count       = 0;
+	s->syncAlarmHash.entries = NULL;
+	s->syncAlarmHash.size    = 0;
+	s->syncAlarmHash.count   = 0;
+
 	s->nextRedraw  = 0;
-	s->frameStatus = 0;
-	s->timeMult    = 1;
 	s->idle	       = TRUE;
 	s->timeLeft    = 0;
 
+	initFrameScheduler (s);
+
 	s->pendingCommands = TRUE;
 
 	s->lastFunctionId = 0;
 
 	s->fragmentFunctions = NULL;
-	s->fragmentPrograms = NULL;
+	memset (s->fragmentPrograms, 0, sizeof (s->fragmentPrograms));
 
 	memset (s->saturateFunction, 0, sizeof (s->saturateFunction));
 
@@ -1938,6 +2114,10 @@ addScreen (int         screenNum,
 		s->copySubBuffer = (GLXCopySubBufferProc)
 		    getProcAddress (s, "glXCopySubBufferMESA");
 
+	/* the back buffer keeps what was painted into it before a swap, only
+	   the damage since then needs to be painted again */
+	s->bufferAge = (strstr (glxExtensions, "GLX_EXT_buffer_age") != NULL);
+
 	s->getVideoSync = NULL;
 	s->waitVideoSync = NULL;
 	if (strstr (glxExtensions, "GLX_SGI_video_sync"))
@@ -2061,6 +2241,8 @@ addScreen (int         screenNum,
 			s->fragmentProgram = 1;
 	}
 
+	initFragmentShaders (s);
+
 	s->genFramebuffers        = NULL;
 	s->deleteFramebuffers     = NULL;
 	s->bindFramebuffer        = NULL;
@@ -2093,6 +2275,102 @@ addScreen (int         screenNum,
 			s->fbo = 1;
 	}
 
+	s->genBuffers    = NULL;
+	s->deleteBuffers = NULL;
+	s->bindBuffer    = NULL;
+	s->bufferData    = NULL;
+
+	s->vertexBufferObject = 0;
+	if (strstr (glExtensions, "GL_ARB_vertex_buffer_object"))
+	{
+		s->genBuffers = (GLGenBuffersProc)
+		    getProcAddress (s, "glGenBuffersARB");
+		s->deleteBuffers = (GLDeleteBuffersProc)
+		    getProcAddress (s, "glDeleteBuffersARB");
+		s->bindBuffer = (GLBindBufferProc)
+		    getProcAddress (s, "glBindBufferARB");
+		s->bufferData = (GLBufferDataProc)
+		    getProcAddress (s, "glBufferDataARB");
+
+		if (s->genBuffers    &&
+		    s->deleteBuffers &&
+		    s->bindBuffer    &&
+		    s->bufferData)
+			s->vertexBufferObject = 1;
+	}
+
+	s->mapBuffer   = NULL;
+	s->unmapBuffer = NULL;
+
+	s->pixelBufferObject = 0;
+	if (s->vertexBufferObject &&
+	    (strstr (glExtensions, "GL_ARB_pixel_buffer_object") ||
+	     strstr (glExtensions, "GL_EXT_pixel_buffer_object")))
+	{
+		s->mapBuffer = (GLMapBufferProc)
+		    getProcAddress (s, "glMapBufferARB");
+		s->unmapBuffer = (GLUnmapBufferProc)
+		    getProcAddress (s, "glUnmapBufferARB");
+
+		if (s->mapBuffer && s->unmapBuffer)
+			s->pixelBufferObject = 1;
+	}
+
+	s->fenceSync      = NULL;
+	s->clientWaitSync = NULL;
+	s->deleteSync     = NULL;
+
+	s->syncObject = 0;
+	if (strstr (glExtensions, "GL_ARB_sync"))
+	{
+		s->fenceSync = (GLFenceSyncProc)
+		    getProcAddress (s, "glFenceSync");
+		s->clientWaitSync = (GLClientWaitSyncProc)
+		    getProcAddress (s, "glClientWaitSync");
+		s->deleteSync = (GLDeleteSyncProc)
+		    getProcAddress (s, "glDeleteSync");
+
+		if (s->fenceSync && s->clientWaitSync && s->deleteSync)
+			s->syncObject = 1;
+	}
+
+	s->genQueries          = NULL;
+	s->deleteQueries       = NULL;
+	s->queryCounter        = NULL;
+	s->getQueryObjectiv    = NULL;
+	s->getQueryObjectui64v = NULL;
+	s->getInteger64v       = NULL;
+
+	s->timerQuery = 0;
+	if (strstr (glExtensions, "GL_ARB_timer_query"))
+	{
+		s->genQueries = (GLGenQueriesProc)
+		    getProcAddress (s, "glGenQueries");
+		s->deleteQueries = (GLDeleteQueriesProc)
+		    getProcAddress (s, "glDeleteQueries");
+		s->queryCounter = (GLQueryCounterProc)
+		    getProcAddress (s, "glQueryCounter");
+		s->getQueryObjectiv = (GLGetQueryObjectivProc)
+		    getProcAddress (s, "glGetQueryObjectiv");
+		s->getQueryObjectui64v = (GLGetQueryObjectui64vProc)
+		    getProcAddress (s, "glGetQueryObjectui64v");
+		s->getInteger64v = (GLGetInteger64vProc)
+		    getProcAddress (s, "glGetInteger64v");
+
+		if (s->genQueries          &&
+		    s->deleteQueries       &&
+		    s->queryCounter        &&
+		    s->getQueryObjectiv    &&
+		    s->getQueryObjectui64v &&
+		    s->getInteger64v)
+			s->timerQuery = 1;
+	}
+
+	if (!s->timerQuery)
+		compLogMessage ("core", CompLogLevelDebug,
+		                "GL_ARB_timer_query is missing, frame scheduling "
+		                "without GPU times");
+
 	s->textureCompression = 0;
 	if (strstr (glExtensions, "GL_ARB_texture_compression"))
 		s->textureCompression = 1;
@@ -2262,6 +2540,12 @@ addScreen (int         screenNum,
 	glEnableClientState (GL_VERTEX_ARRAY);
 	glEnableClientState (GL_TEXTURE_COORD_ARRAY);
 
+	s->quadIndices     = NULL;
+	s->quadIndexBuffer = 0;
+
+	/* without it window geometry is drawn as quads */
+	initQuadIndices (s);
+
 	s->canDoSaturated = s->canDoSlightlySaturated = FALSE;
 	if (s->textureEnvCombine && s->maxTextureUnits >= 2)
 	{
@@ -2272,6 +2556,7 @@ addScreen (int         screenNum,
 
 	s->redrawTime = 1000 / DEFAULT_REFRESH_RATE;
 	s->optimalRedrawTime = s->redrawTime;
+	setFrameSchedulerRate (s, DEFAULT_REFRESH_RATE);
 
 	reshape (s, s->attrib.width, s->attrib.height);
 
@@ -2421,6 +2706,12 @@ removeScreen (CompScreen *s)
 		free (s->defaultIcon);
 	}
 
+	finiQuadIndices (s);
+	finiFrameScheduler (s);
+
+	finiScreenAtlas (s);
+	finiScreenText (s);
+
 	glXDestroyContext (display.display, s->ctx);
 
 	XFreeCursor (display.display, s->invisibleCursor);
@@ -2440,7 +2731,10 @@ damageScreenRegion (CompScreen *screen,
 	if (screen->damageMask & COMP_SCREEN_DAMAGE_ALL_MASK)
 		return;
 
-	XUnionRegion (screen->damage, region, screen->damage);
+	if (profilerEnabled && !screen->damageMask)
+		profilerDamageScreen (screen);
+
+	compUnionRegion (screen->damage, region, screen->damage);
 
 	screen->damageMask |= COMP_SCREEN_DAMAGE_REGION_MASK;
 
@@ -2455,6 +2749,9 @@ damageScreenRegion (CompScreen *screen,
 void
 damageScreen (CompScreen *s)
 {
+	if (profilerEnabled && !s->damageMask)
+		profilerDamageScreen (s);
+
 	s->damageMask |= COMP_SCREEN_DAMAGE_ALL_MASK;
 	s->damageMask &= ~COMP_SCREEN_DAMAGE_REGION_MASK;
 }
@@ -2462,6 +2759,9 @@ damageScreen (CompScreen *s)
 void
 damagePendingOnScreen (CompScreen *s)
 {
+	if (profilerEnabled && !s->damageMask)
+		profilerDamageScreen (s);
+
 	s->damageMask |= COMP_SCREEN_DAMAGE_PENDING_MASK;
 }
 
@@ -2563,24 +2863,172 @@ focusDefaultWindow (CompScreen *s)
 	}
 }
 
+static unsigned int
+hashWindowId (XID id)
+{
+	unsigned int h = id;
+
+	/* XIDs of different clients differ only in the high bits */
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static Bool
+resizeWindowHash (CompWindowHash *hash,
+                  int            size)
+{
+	CompWindowHashEntry *entries, *old = hash->entries;
+	int                 oldSize = hash->size, i, j;
+
+	entries = calloc (size, sizeof (CompWindowHashEntry));
+	if (!entries)
+		return FALSE;
+
+	for (i = 0; i < oldSize; i++)
+	{
+		if (!old[i].id)
+			continue;
+
+		j = hashWindowId (old[i].id) & (size - 1);
+		while (entries[j].id)
+			j = (j + 1) & (size - 1);
+
+		entries[j] = old[i];
+	}
+
+	if (old)
+		free (old);
+
+	hash->entries = entries;
+	hash->size    = size;
+
+	return TRUE;
+}
+
+/* replaces any existing entry for id */
+void
+addWindowToHash (CompWindowHash *hash,
+                 XID            id,
+                 CompWindow     *w)
+{
+	int i;
+
+	if (!id)
+		return;
+
+	/* keep the load factor at or below 1/2 so probe sequences stay short,
+	   an allocation failure is only fatal once the table is full */
+	if ((hash->count + 1) * 2 > hash->size)
+	{
+		if (!resizeWindowHash (hash, hash->size ? hash->size * 2 : 64) &&
+		    hash->count == hash->size)
+		{
+			compLogMessage ("core", CompLogLevelError,
+			                "Couldn't grow window hash table");
+			return;
+		}
+	}
+
+	i = hashWindowId (id) & (hash->size - 1);
+	while (hash->entries[i].id && hash->entries[i].id != id)
+		i = (i + 1) & (hash->size - 1);
+
+	if (!hash->entries[i].id)
+		hash->count++;
+
+	hash->entries[i].id     = id;
+	hash->entries[i].window = w;
+}
+
+/* only removes the entry if it still belongs to w */
+void
+removeWindowFromHash (CompWindowHash *hash,
+                      XID            id,
+                      CompWindow     *w)
+{
+	int i, j, k, mask = hash->size - 1;
+
+	if (!id || !hash->count)
+		return;
+
+	i = hashWindowId (id) & mask;
+	while (hash->entries[i].id != id)
+	{
+		if (!hash->entries[i].id)
+			return;
+
+		i = (i + 1) & mask;
+	}
+
+	if (hash->entries[i].window != w)
+		return;
+
+	hash->count--;
+
+	/* backward shift deletion, move later entries of the probe sequence
+	   into the hole so that lookups never need tombstones */
+	for (;;)
+	{
+		hash->entries[i].id = 0;
+
+		for (j = i;;)
+		{
+			j = (j + 1) & mask;
+			if (!hash->entries[j].id)
+				return;
+
+			/* an entry whose home slot lies cyclically in (i, j] can't
+			   move to i */
+			k = hashWindowId (hash->entries[j].id) & mask;
+			if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+				continue;
+
+			break;
+		}
+
+		hash->entries[i] = hash->entries[j];
+		i = j;
+	}
+}
+
+CompWindow *
+findWindowInHash (CompWindowHash *hash,
+                  XID            id)
+{
+	int i, mask = hash->size - 1;
+
+	if (!id || !hash->count)
+		return NULL;
+
+	i = hashWindowId (id) & mask;
+	while (hash->entries[i].id)
+	{
+		if (hash->entries[i].id == id)
+			return hash->entries[i].window;
+
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
 CompWindow *
 findWindowAtScreen (CompScreen *s,
                     Window     id)
 {
+	CompWindow *w;
+
 	if (lastFoundWindow && lastFoundWindow->id == id)
-	{
 		return lastFoundWindow;
-	}
-	else
-	{
-		CompWindow *w;
 
-		for (w = s->windows; w; w = w->next)
-			if (w->id == id)
-				return (lastFoundWindow = w);
-	}
+	w = findWindowInHash (&s->windowHash, id);
+	if (w)
+		lastFoundWindow = w;
 
-	return 0;
+	return w;
 }
 
 CompWindow *
@@ -2597,11 +3045,7 @@ findTopLevelWindowAtScreen (CompScreen *s,
 	{
 		/* likely a frame window */
 		if (w->attrib.class == InputOnly)
-		{
-			for (w = s->windows; w; w = w->next)
-				if (w->frame == id)
-					return w;
-		}
+			return findWindowInHash (&s->frameHash, id);
 
 		return NULL;
 	}
@@ -2627,25 +3071,22 @@ insertWindowIntoScreen (CompScreen *s,
 		}
 		else
 		{
-			for (p = s->windows; p; p = p->next)
+			p = findWindowInHash (&s->windowHash, aboveId);
+			if (p)
 			{
-				if (p->id == aboveId)
+				if (p->next)
 				{
-					if (p->next)
-					{
-						w->next = p->next;
-						w->prev = p;
-						p->next->prev = w;
-						p->next = w;
-					}
-					else
-					{
-						p->next = w;
-						w->next = NULL;
-						w->prev = p;
-						s->reverseWindows = w;
-					}
-					break;
+					w->next = p->next;
+					w->prev = p;
+					p->next->prev = w;
+					p->next = w;
+				}
+				else
+				{
+					p->next = w;
+					w->next = NULL;
+					w->prev = p;
+					s->reverseWindows = w;
 				}
 			}
 
@@ -2661,6 +3102,12 @@ insertWindowIntoScreen (CompScreen *s,
 		s->reverseWindows = s->windows = w;
 		w->prev = w->next = NULL;
 	}
+
+	addWindowToHash (&s->windowHash, w->id, w);
+	addWindowToHash (&s->frameHash, w->frame, w);
+	addWindowToHash (&s->syncAlarmHash, w->syncAlarm, w);
+
+	invalidateOutputWindows (s);
 }
 
 void
@@ -2705,10 +3152,16 @@ unhookWindowFromScreen (CompScreen *s,
 		s->windows = s->reverseWindows = NULL;
 	}
 
+	removeWindowFromHash (&s->windowHash, w->id, w);
+	removeWindowFromHash (&s->frameHash, w->frame, w);
+	removeWindowFromHash (&s->syncAlarmHash, w->syncAlarm, w);
+
 	if (w == lastFoundWindow)
 		lastFoundWindow = NULL;
 	if (w == lastDamagedWindow)
 		lastDamagedWindow = NULL;
+
+	invalidateOutputWindows (s);
 }
 
 #define POINTER_GRAB_MASK (ButtonReleaseMask | \
@@ -3810,9 +4263,8 @@ screenLighting (CompScreen *s,
 	if (s->lighting != lighting)
 	{
 		const BananaValue *
-		option_lighting = bananaGetOption (coreBananaIndex,
-		                                   "lighting",
-		                                   s->screenNum);
+		option_lighting = bananaGetOptionByHandle (coreOptionLighting,
+		                                           s->screenNum);
 
 		if (!option_lighting->b)
 			lighting = FALSE;
@@ -4116,9 +4568,9 @@ outputDeviceForGeometry (CompScreen *s,
 		return 0;
 
 	const BananaValue *
-	option_overlapping_outputs = bananaGetOption (coreBananaIndex,
-	                                              "overlapping_outputs",
-	                                              s->screenNum);
+	option_overlapping_outputs =
+	    bananaGetOptionByHandle (coreOptionOverlappingOutputs,
+	                             s->screenNum);
 
 	strategy = option_overlapping_outputs->i;
 
@@ -0,0 +1,1611 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fusilli-core.h>
+
+/*
+ * GLSL backend of the fragment functions.
+ *
+ * Fragment functions are written in ARB fragment program assembly and
+ * fragment.c links them into a single program text. Drivers that only
+ * translate ARB programs to their shader compiler internally are faster
+ * with GLSL, so when GL 2.0 is available that text is translated to a
+ * GLSL fragment shader here. Vertices still go through fixed function,
+ * which writes the gl_Color and gl_TexCoord varyings the shader reads.
+ *
+ * The translation covers the instructions, bindings and constants that
+ * fragment functions use. Anything else, like program.local or most of
+ * the state bindings, makes it fail and fragment.c loads the program as
+ * ARB assembly instead.
+ *
+ * program.env[n] becomes the uniform env_n. Plugins keep setting env
+ * parameters with s->programEnvParameter4f, which also stores the value
+ * here, and every shader uploads a parameter only when it has changed
+ * since the shader was last used.
+ *
+ * With GL_ARB_get_program_binary, linked shaders are kept in
+ * $XDG_CACHE_HOME/fusilli/shader-<key>.bin, so that the same plugin
+ * combinations aren't compiled and linked again on every start or
+ * plugin reload. The key hashes the signature hash of the program,
+ * the GLSL text and GL_RENDERER and GL_VERSION, and is stored in the
+ * file as well. A binary that the driver rejects is removed and the
+ * shader is compiled again.
+ */
+
+#define SHADER_MAX_SAMPLERS 32
+#define SHADER_EXPR_SIZE    1024
+
+#define SHADER_TARGET_1D   1
+#define SHADER_TARGET_2D   2
+#define SHADER_TARGET_3D   3
+#define SHADER_TARGET_CUBE 4
+#define SHADER_TARGET_RECT 5
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER  0x8B30
+#define GL_COMPILE_STATUS   0x8B81
+#define GL_LINK_STATUS      0x8B82
+#endif
+
+#ifndef GL_ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+
+#define SHADER_CACHE_MAGIC   0x52444853 /* "SHDR" */
+#define SHADER_CACHE_VERSION 1
+
+typedef struct _ShaderCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t signatureHash;
+	uint32_t format;
+	uint32_t length; /* of the binary that follows */
+	uint32_t pad;
+} ShaderCacheHeader;
+
+typedef char ShaderChar;
+
+typedef GLuint (*ShaderCreateShaderProc) (GLenum type);
+typedef void (*ShaderShaderSourceProc) (GLuint            shader,
+                                        GLsizei           count,
+                                        const ShaderChar **string,
+                                        const GLint       *length);
+typedef void (*ShaderCompileShaderProc) (GLuint shader);
+typedef void (*ShaderGetShaderivProc) (GLuint shader,
+                                       GLenum pname,
+                                       GLint  *params);
+typedef void (*ShaderGetInfoLogProc) (GLuint     object,
+                                      GLsizei    bufSize,
+                                      GLsizei    *length,
+                                      ShaderChar *infoLog);
+typedef void (*ShaderDeleteShaderProc) (GLuint shader);
+typedef GLuint (*ShaderCreateProgramProc) (void);
+typedef void (*ShaderAttachShaderProc) (GLuint program,
+                                        GLuint shader);
+typedef void (*ShaderLinkProgramProc) (GLuint program);
+typedef void (*ShaderGetProgramivProc) (GLuint program,
+                                        GLenum pname,
+                                        GLint  *params);
+typedef void (*ShaderUseProgramProc) (GLuint program);
+typedef void (*ShaderDeleteProgramProc) (GLuint program);
+typedef GLint (*ShaderGetUniformLocationProc) (GLuint           program,
+                                               const ShaderChar *name);
+typedef void (*ShaderUniform1iProc) (GLint location,
+                                     GLint v0);
+typedef void (*ShaderUniform4fvProc) (GLint         location,
+                                      GLsizei       count,
+                                      const GLfloat *value);
+typedef void (*ShaderGetProgramBinaryProc) (GLuint  program,
+                                            GLsizei bufSize,
+                                            GLsizei *length,
+                                            GLenum  *binaryFormat,
+                                            void    *binary);
+typedef void (*ShaderProgramBinaryProc) (GLuint     program,
+                                         GLenum     binaryFormat,
+                                         const void *binary,
+                                         GLsizei    length);
+typedef void (*ShaderProgramParameteriProc) (GLuint program,
+                                             GLenum pname,
+                                             GLint  value);
+
+static ShaderCreateShaderProc       createShader = NULL;
+static ShaderShaderSourceProc       shaderSource = NULL;
+static ShaderCompileShaderProc      compileShader = NULL;
+static ShaderGetShaderivProc        getShaderiv = NULL;
+static ShaderGetInfoLogProc         getShaderInfoLog = NULL;
+static ShaderDeleteShaderProc       deleteShader = NULL;
+static ShaderCreateProgramProc      createProgram = NULL;
+static ShaderAttachShaderProc       attachShader = NULL;
+static ShaderLinkProgramProc        linkProgram = NULL;
+static ShaderGetProgramivProc       getProgramiv = NULL;
+static ShaderGetInfoLogProc         getProgramInfoLog = NULL;
+static ShaderUseProgramProc         useProgram = NULL;
+static ShaderDeleteProgramProc      deleteProgram = NULL;
+static ShaderGetUniformLocationProc getUniformLocation = NULL;
+static ShaderUniform1iProc          uniform1i = NULL;
+static ShaderUniform4fvProc         uniform4fv = NULL;
+static ShaderGetProgramBinaryProc   getProgramBinary = NULL;
+static ShaderProgramBinaryProc      programBinary = NULL;
+static ShaderProgramParameteriProc  programParameteri = NULL;
+
+/* seeds the keys of the binary cache, 0 if there is no cache */
+static uint64_t driverHash = 0;
+
+/* ARB env parameters as last set, serial 0 means never set */
+static GLfloat      envValue[MAX_FRAGMENT_ENV_PARAMETERS][4];
+static unsigned int envSerial[MAX_FRAGMENT_ENV_PARAMETERS];
+static unsigned int lastEnvSerial = 0;
+
+static GLProgramParameter4fProc arbProgramEnvParameter4f = NULL;
+
+static CompShader *boundShader = NULL;
+
+typedef struct _CompShaderParameter {
+	GLuint       index;
+	GLint        location;
+	unsigned int serial;
+} CompShaderParameter;
+
+struct _CompShader {
+	GLuint              program;
+	CompShaderParameter *env;
+	int                 nEnv;
+};
+
+typedef struct _ShaderText {
+	char   *data;
+	size_t length;
+	size_t size;
+	Bool   error;
+} ShaderText;
+
+typedef struct _ShaderTranslation {
+	ShaderText    header;
+	ShaderText    temps;
+	ShaderText    body;
+	int           sampler[SHADER_MAX_SAMPLERS];
+	unsigned char env[MAX_FRAGMENT_ENV_PARAMETERS];
+	Bool          error;
+} ShaderTranslation;
+
+static void
+appendShaderText (ShaderText *text,
+                  const char *format,
+                  ...)
+{
+	va_list ap;
+	int     n;
+
+	if (text->error)
+		return;
+
+	for (;;)
+	{
+		if (text->size)
+		{
+			va_start (ap, format);
+			n = vsnprintf (text->data + text->length,
+			               text->size - text->length, format, ap);
+			va_end (ap);
+
+			if (n < 0)
+			{
+				text->error = TRUE;
+				return;
+			}
+
+			if (text->length + n < text->size)
+			{
+				text->length += n;
+				return;
+			}
+		}
+
+		{
+			char   *data;
+			size_t size = text->size ? text->size * 2 : 1024;
+
+			data = realloc (text->data, size);
+			if (!data)
+			{
+				text->error = TRUE;
+				return;
+			}
+
+			text->data = data;
+			text->size = size;
+		}
+	}
+}
+
+static void
+translationError (ShaderTranslation *t,
+                  const char        *statement)
+{
+	if (!t->error)
+		compLogMessage ("core", CompLogLevelDebug,
+		                "no GLSL translation for \"%s\"", statement);
+
+	t->error = TRUE;
+}
+
+static void
+skipSpace (const char **p)
+{
+	while (isspace ((unsigned char) **p))
+		(*p)++;
+}
+
+static Bool
+parseIdentifier (const char **p,
+                 char       *name,
+                 int        size)
+{
+	int n = 0;
+
+	skipSpace (p);
+
+	if (!isalpha ((unsigned char) **p) && **p != '_')
+		return FALSE;
+
+	while (isalnum ((unsigned char) **p) || **p == '_')
+	{
+		if (n + 1 >= size)
+			return FALSE;
+
+		name[n++] = *(*p)++;
+	}
+
+	name[n] = '\0';
+
+	return TRUE;
+}
+
+static Bool
+parseIndex (const char **p,
+            int        *index)
+{
+	char *end;
+
+	skipSpace (p);
+	if (**p != '[')
+		return FALSE;
+
+	(*p)++;
+	*index = strtol (*p, &end, 10);
+	if (end == *p || *index < 0)
+		return FALSE;
+
+	*p = end;
+
+	skipSpace (p);
+	if (**p != ']')
+		return FALSE;
+
+	(*p)++;
+
+	return TRUE;
+}
+
+static Bool
+expectChar (const char **p,
+            char       c)
+{
+	skipSpace (p);
+	if (**p != c)
+		return FALSE;
+
+	(*p)++;
+
+	return TRUE;
+}
+
+/* copies a float literal with an optional sign, GLSL 1.10 wants a dot */
+static Bool
+parseConstant (const char **p,
+               char       *value,
+               int        size)
+{
+	Bool dot = FALSE;
+	int  n = 0;
+
+	skipSpace (p);
+
+	if (**p == '-' || **p == '+')
+	{
+		if (**p == '-')
+			value[n++] = '-';
+
+		(*p)++;
+		skipSpace (p);
+	}
+
+	if (!isdigit ((unsigned char) **p) && **p != '.')
+		return FALSE;
+
+	while (isdigit ((unsigned char) **p) || **p == '.' ||
+	       **p == 'e' || **p == 'E' ||
+	       ((**p == '-' || **p == '+') && n && tolower (value[n - 1]) == 'e'))
+	{
+		if (n + 3 >= size)
+			return FALSE;
+
+		if (**p == '.' || **p == 'e' || **p == 'E')
+			dot = TRUE;
+
+		value[n++] = *(*p)++;
+	}
+
+	if (!dot)
+	{
+		value[n++] = '.';
+		value[n++] = '0';
+	}
+
+	value[n] = '\0';
+
+	return TRUE;
+}
+
+/* user names may contain "__", which GLSL reserves, so every '_' is
+   written as "_1" behind a prefix that keeps them apart from the
+   uniforms */
+static Bool
+mangleName (const char *name,
+            char       *glsl,
+            int        size)
+{
+	int n = 0;
+
+	glsl[n++] = 'r';
+
+	for (; *name; name++)
+	{
+		if (n + 3 >= size)
+			return FALSE;
+
+		glsl[n++] = *name;
+		if (*name == '_')
+			glsl[n++] = '1';
+	}
+
+	glsl[n] = '\0';
+
+	return TRUE;
+}
+
+/* swizzle or write mask, rgba is the same as xyzw */
+static int
+parseComponents (const char **p,
+                 char       *components)
+{
+	const char *s = *p;
+	int        n = 0;
+
+	components[0] = '\0';
+
+	if (*s != '.' || !strchr ("xyzwrgba", s[1]) || !s[1])
+		return 0;
+
+	s++;
+	while (*s && strchr ("xyzwrgba", *s) && n < 4)
+	{
+		switch (*s) {
+		case 'r': components[n] = 'x'; break;
+		case 'g': components[n] = 'y'; break;
+		case 'b': components[n] = 'z'; break;
+		case 'a': components[n] = 'w'; break;
+		default:  components[n] = *s;  break;
+		}
+
+		n++;
+		s++;
+	}
+
+	if (isalnum ((unsigned char) *s) || *s == '_')
+		return -1;
+
+	components[n] = '\0';
+	*p = s;
+
+	return n;
+}
+
+static Bool
+parseBinding (ShaderTranslation *t,
+              const char        **p,
+              const char        *name,
+              char              *expr)
+{
+	char member[64];
+	int  index = 0;
+
+	if (!strcmp (name, "fragment"))
+	{
+		if (!expectChar (p, '.') || !parseIdentifier (p, member, 64))
+			return FALSE;
+
+		if (!strcmp (member, "color"))
+		{
+			const char *s = *p;
+			char       which[64];
+
+			strcpy (expr, "gl_Color");
+
+			if (*s == '.' && (s++, parseIdentifier (&s, which, 64)))
+			{
+				if (!strcmp (which, "primary"))
+					*p = s;
+				else if (!strcmp (which, "secondary"))
+				{
+					strcpy (expr, "gl_SecondaryColor");
+					*p = s;
+				}
+			}
+		}
+		else if (!strcmp (member, "texcoord"))
+		{
+			const char *s = *p;
+
+			skipSpace (&s);
+			if (*s == '[' && !parseIndex (p, &index))
+				return FALSE;
+
+			sprintf (expr, "gl_TexCoord[%d]", index);
+		}
+		else if (!strcmp (member, "position"))
+		{
+			strcpy (expr, "gl_FragCoord");
+		}
+		else if (!strcmp (member, "fogcoord"))
+		{
+			strcpy (expr, "vec4 (gl_FogFragCoord, 0.0, 0.0, 1.0)");
+		}
+		else
+		{
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	if (!strcmp (name, "program"))
+	{
+		if (!expectChar (p, '.') || !parseIdentifier (p, member, 64))
+			return FALSE;
+
+		if (strcmp (member, "env") || !parseIndex (p, &index) ||
+		    index >= MAX_FRAGMENT_ENV_PARAMETERS)
+			return FALSE;
+
+		t->env[index] = TRUE;
+		sprintf (expr, "env_%d", index);
+
+		return TRUE;
+	}
+
+	/* only the light colors of state are used by fragment functions */
+	if (!strcmp (name, "state"))
+	{
+		char property[64];
+
+		if (!expectChar (p, '.') || !parseIdentifier (p, member, 64))
+			return FALSE;
+
+		if (strcmp (member, "light") || !parseIndex (p, &index))
+			return FALSE;
+
+		if (!expectChar (p, '.') || !parseIdentifier (p, property, 64))
+			return FALSE;
+
+		if (strcmp (property, "ambient") && strcmp (property, "diffuse") &&
+		    strcmp (property, "specular") && strcmp (property, "position"))
+			return FALSE;
+
+		sprintf (expr, "gl_LightSource[%d].%s", index, property);
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* a source operand as a vec4 expression */
+static Bool
+parseSource (ShaderTranslation *t,
+             const char        **p,
+             char              *expr)
+{
+	char base[SHADER_EXPR_SIZE];
+	char components[5];
+	Bool negate = FALSE;
+	int  n;
+
+	skipSpace (p);
+	if (**p == '-')
+	{
+		negate = TRUE;
+		(*p)++;
+	}
+	else if (**p == '+')
+	{
+		(*p)++;
+	}
+
+	skipSpace (p);
+
+	if (**p == '{')
+	{
+		char value[4][64];
+		int  nValue = 0;
+
+		strcpy (value[1], "0.0");
+		strcpy (value[2], "0.0");
+		strcpy (value[3], "1.0");
+
+		(*p)++;
+		do {
+			if (nValue == 4 || !parseConstant (p, value[nValue++], 64))
+				return FALSE;
+		} while (expectChar (p, ','));
+
+		if (!expectChar (p, '}'))
+			return FALSE;
+
+		snprintf (base, sizeof (base), "vec4 (%s, %s, %s, %s)",
+		          value[0], value[1], value[2], value[3]);
+	}
+	else if (isdigit ((unsigned char) **p) || **p == '.')
+	{
+		char value[64];
+
+		if (!parseConstant (p, value, 64))
+			return FALSE;
+
+		snprintf (base, sizeof (base), "vec4 (%s)", value);
+	}
+	else
+	{
+		char name[256];
+
+		if (!parseIdentifier (p, name, 256))
+			return FALSE;
+
+		if (!strcmp (name, "fragment") || !strcmp (name, "program") ||
+		    !strcmp (name, "state"))
+		{
+			if (!parseBinding (t, p, name, base))
+				return FALSE;
+		}
+		else
+		{
+			skipSpace (p);
+			if (**p == '[')
+				return FALSE;
+
+			if (!mangleName (name, base, sizeof (base)))
+				return FALSE;
+		}
+	}
+
+	n = parseComponents (p, components);
+	if (n < 0 || n == 2 || n == 3)
+		return FALSE;
+
+	if (n == 1)
+		snprintf (expr, SHADER_EXPR_SIZE, "vec4 (%s.%s)", base, components);
+	else if (n == 4)
+		snprintf (expr, SHADER_EXPR_SIZE, "%s.%s", base, components);
+	else
+		snprintf (expr, SHADER_EXPR_SIZE, "%s", base);
+
+	if (negate)
+	{
+		char tmp[SHADER_EXPR_SIZE];
+
+		snprintf (tmp, sizeof (tmp), "(-%s)", expr);
+		strcpy (expr, tmp);
+	}
+
+	return TRUE;
+}
+
+static Bool
+parseDestination (const char **p,
+                  char       *dst,
+                  char       *mask)
+{
+	char name[256];
+	int  n;
+
+	if (!parseIdentifier (p, name, 256))
+		return FALSE;
+
+	if (!strcmp (name, "result"))
+	{
+		char member[64];
+
+		if (!expectChar (p, '.') || !parseIdentifier (p, member, 64) ||
+		    strcmp (member, "color"))
+			return FALSE;
+
+		strcpy (dst, "gl_FragColor");
+	}
+	else if (!mangleName (name, dst, SHADER_EXPR_SIZE))
+	{
+		return FALSE;
+	}
+
+	n = parseComponents (p, mask);
+	if (n < 0)
+		return FALSE;
+
+	return TRUE;
+}
+
+static Bool
+parseTextureTarget (ShaderTranslation *t,
+                    const char        **p,
+                    int               *unit,
+                    int               *target)
+{
+	char name[64];
+
+	if (!expectChar (p, ',') || !parseIdentifier (p, name, 64) ||
+	    strcmp (name, "texture"))
+		return FALSE;
+
+	*unit = 0;
+
+	skipSpace (p);
+	if (**p == '[' && !parseIndex (p, unit))
+		return FALSE;
+
+	if (*unit >= SHADER_MAX_SAMPLERS || !expectChar (p, ','))
+		return FALSE;
+
+	skipSpace (p);
+
+	if (!strncmp (*p, "1D", 2))
+		*target = SHADER_TARGET_1D;
+	else if (!strncmp (*p, "2D", 2))
+		*target = SHADER_TARGET_2D;
+	else if (!strncmp (*p, "3D", 2))
+		*target = SHADER_TARGET_3D;
+	else if (!strncmp (*p, "CUBE", 4))
+		*target = SHADER_TARGET_CUBE;
+	else if (!strncmp (*p, "RECT", 4))
+		*target = SHADER_TARGET_RECT;
+	else
+		return FALSE;
+
+	*p += (*target == SHADER_TARGET_CUBE ||
+	       *target == SHADER_TARGET_RECT) ? 4 : 2;
+
+	/* a sampler has one type in GLSL */
+	if (t->sampler[*unit] && t->sampler[*unit] != *target)
+		return FALSE;
+
+	t->sampler[*unit] = *target;
+
+	return TRUE;
+}
+
+/* TEX, TXP and TXB */
+static Bool
+translateTexture (ShaderTranslation *t,
+                  const char        *opcode,
+                  const char        **p,
+                  char              *expr)
+{
+	static const char *lookup[][3] = {
+		/* TEX, TXP, TXB */
+		{ NULL, NULL, NULL },
+		{ "texture1D (tex_%d, %s.x)", "texture1DProj (tex_%d, %s)",
+		  "texture1D (tex_%d, %s.x, %s.w)" },
+		{ "texture2D (tex_%d, %s.xy)", "texture2DProj (tex_%d, %s)",
+		  "texture2D (tex_%d, %s.xy, %s.w)" },
+		{ "texture3D (tex_%d, %s.xyz)", "texture3DProj (tex_%d, %s)",
+		  "texture3D (tex_%d, %s.xyz, %s.w)" },
+		{ "textureCube (tex_%d, %s.xyz)", "textureCube (tex_%d, %s.xyz)",
+		  "textureCube (tex_%d, %s.xyz, %s.w)" },
+		{ "texture2DRect (tex_%d, %s.xy)", "texture2DRectProj (tex_%d, %s)",
+		  "texture2DRect (tex_%d, %s.xy)" }
+	};
+	char coord[SHADER_EXPR_SIZE];
+	char tmp[SHADER_EXPR_SIZE];
+	int  unit, target, lookupType;
+
+	if (!strcmp (opcode, "TEX"))
+		lookupType = 0;
+	else if (!strcmp (opcode, "TXP"))
+		lookupType = 1;
+	else
+		lookupType = 2;
+
+	if (!parseSource (t, p, tmp))
+		return FALSE;
+
+	/* the coordinate is used twice with a bias */
+	snprintf (coord, sizeof (coord), "(%s)", tmp);
+
+	if (!parseTextureTarget (t, p, &unit, &target))
+		return FALSE;
+
+	snprintf (expr, SHADER_EXPR_SIZE, lookup[target][lookupType],
+	          unit, coord, coord);
+
+	return TRUE;
+}
+
+static Bool
+translateInstruction (ShaderTranslation *t,
+                      const char        *statement)
+{
+	static const struct {
+		const char *opcode;
+		int        nSource;
+		const char *format;
+	} instructions[] = {
+		{ "ABS", 1, "abs (%1$s)" },
+		{ "ADD", 2, "(%1$s + %2$s)" },
+		{ "CMP", 3, "mix (%3$s, %2$s, vec4 (lessThan (%1$s, vec4 (0.0))))" },
+		{ "COS", 1, "vec4 (cos (%1$s.x))" },
+		{ "DP3", 2, "vec4 (dot (%1$s.xyz, %2$s.xyz))" },
+		{ "DP4", 2, "vec4 (dot (%1$s, %2$s))" },
+		{ "DPH", 2, "vec4 (dot (%1$s.xyz, %2$s.xyz) + %2$s.w)" },
+		{ "DST", 2, "vec4 (1.0, %1$s.y * %2$s.y, %1$s.z, %2$s.w)" },
+		{ "EX2", 1, "vec4 (exp2 (%1$s.x))" },
+		{ "FLR", 1, "floor (%1$s)" },
+		{ "FRC", 1, "fract (%1$s)" },
+		{ "LG2", 1, "vec4 (log2 (%1$s.x))" },
+		{ "LIT", 1, "vec4 (1.0, max (%1$s.x, 0.0), %1$s.x > 0.0 ? "
+		            "pow (max (%1$s.y, 0.0), clamp (%1$s.w, -128.0, 128.0)) "
+		            ": 0.0, 1.0)" },
+		{ "LRP", 3, "mix (%3$s, %2$s, %1$s)" },
+		{ "MAD", 3, "(%1$s * %2$s + %3$s)" },
+		{ "MAX", 2, "max (%1$s, %2$s)" },
+		{ "MIN", 2, "min (%1$s, %2$s)" },
+		{ "MOV", 1, "%1$s" },
+		{ "MUL", 2, "(%1$s * %2$s)" },
+		{ "POW", 2, "vec4 (pow (%1$s.x, %2$s.x))" },
+		{ "RCP", 1, "vec4 (1.0 / %1$s.x)" },
+		{ "RSQ", 1, "vec4 (inversesqrt (abs (%1$s.x)))" },
+		{ "SCS", 1, "vec4 (cos (%1$s.x), sin (%1$s.x), 0.0, 0.0)" },
+		{ "SGE", 2, "vec4 (greaterThanEqual (%1$s, %2$s))" },
+		{ "SIN", 1, "vec4 (sin (%1$s.x))" },
+		{ "SLT", 2, "vec4 (lessThan (%1$s, %2$s))" },
+		{ "SUB", 2, "(%1$s - %2$s)" },
+		{ "XPD", 2, "vec4 (cross (%1$s.xyz, %2$s.xyz), 1.0)" }
+	};
+	const char *p = statement;
+	char       opcode[64];
+	char       dst[SHADER_EXPR_SIZE];
+	char       mask[5];
+	char       src[3][SHADER_EXPR_SIZE];
+	char       expr[SHADER_EXPR_SIZE];
+	char       *suffix;
+	Bool       saturate = FALSE;
+	int        i, j;
+
+	if (!parseIdentifier (&p, opcode, 64))
+		return FALSE;
+
+	suffix = strchr (opcode, '_');
+	if (suffix)
+	{
+		if (strcmp (suffix, "_SAT"))
+			return FALSE;
+
+		*suffix = '\0';
+		saturate = TRUE;
+	}
+
+	if (!strcmp (opcode, "KIL"))
+	{
+		if (!parseSource (t, &p, src[0]))
+			return FALSE;
+
+		skipSpace (&p);
+		if (*p)
+			return FALSE;
+
+		appendShaderText (&t->body,
+		                  "\tif (any (lessThan (%s, vec4 (0.0))))\n"
+		                  "\t\tdiscard;\n", src[0]);
+
+		return TRUE;
+	}
+
+	if (!parseDestination (&p, dst, mask) || !expectChar (&p, ','))
+		return FALSE;
+
+	if (!strcmp (opcode, "TEX") || !strcmp (opcode, "TXP") ||
+	    !strcmp (opcode, "TXB"))
+	{
+		if (!translateTexture (t, opcode, &p, expr))
+			return FALSE;
+	}
+	else
+	{
+		for (i = 0; i < sizeof (instructions) / sizeof (instructions[0]); i++)
+			if (!strcmp (opcode, instructions[i].opcode))
+				break;
+
+		if (i == sizeof (instructions) / sizeof (instructions[0]))
+			return FALSE;
+
+		for (j = 0; j < instructions[i].nSource; j++)
+		{
+			char tmp[SHADER_EXPR_SIZE];
+
+			if (j && !expectChar (&p, ','))
+				return FALSE;
+
+			if (!parseSource (t, &p, tmp))
+				return FALSE;
+
+			snprintf (src[j], SHADER_EXPR_SIZE, "(%s)", tmp);
+		}
+
+		for (; j < 3; j++)
+			src[j][0] = '\0';
+
+		if (snprintf (expr, sizeof (expr), instructions[i].format,
+		              src[0], src[1], src[2]) >= sizeof (expr))
+			return FALSE;
+	}
+
+	skipSpace (&p);
+	if (*p)
+		return FALSE;
+
+	if (saturate)
+		appendShaderText (&t->body, "\t%s%s%s = clamp (%s, 0.0, 1.0)%s%s;\n",
+		                  dst, *mask ? "." : "", mask,
+		                  expr, *mask ? "." : "", mask);
+	else
+		appendShaderText (&t->body, "\t%s%s%s = (%s)%s%s;\n",
+		                  dst, *mask ? "." : "", mask,
+		                  expr, *mask ? "." : "", mask);
+
+	return TRUE;
+}
+
+/* TEMP, PARAM and ATTRIB, all of them become vec4 locals */
+static Bool
+translateDeclaration (ShaderTranslation *t,
+                      const char        *statement,
+                      Bool              temp)
+{
+	const char *p = statement;
+	char       name[256];
+	char       glsl[SHADER_EXPR_SIZE];
+	char       value[SHADER_EXPR_SIZE];
+
+	do {
+		if (!parseIdentifier (&p, name, 256) ||
+		    !mangleName (name, glsl, SHADER_EXPR_SIZE))
+			return FALSE;
+
+		skipSpace (&p);
+		if (*p == '[')
+			return FALSE;
+
+		if (!temp && expectChar (&p, '='))
+		{
+			if (!parseSource (t, &p, value))
+				return FALSE;
+
+			appendShaderText (&t->temps, "\tvec4 %s = %s;\n", glsl, value);
+		}
+		else
+		{
+			appendShaderText (&t->temps, "\tvec4 %s = vec4 (0.0);\n", glsl);
+		}
+	} while (expectChar (&p, ','));
+
+	skipSpace (&p);
+
+	return *p == '\0';
+}
+
+static Bool
+translateStatement (ShaderTranslation *t,
+                    char              *statement)
+{
+	const char *p = statement;
+	char       keyword[64];
+
+	skipSpace (&p);
+	if (!*p)
+		return TRUE;
+
+	if (!parseIdentifier (&p, keyword, 64))
+		return FALSE;
+
+	if (!strcmp (keyword, "TEMP"))
+		return translateDeclaration (t, p, TRUE);
+
+	if (!strcmp (keyword, "PARAM") || !strcmp (keyword, "ATTRIB"))
+		return translateDeclaration (t, p, FALSE);
+
+	/* precision hints and the like don't change the result */
+	if (!strcmp (keyword, "OPTION"))
+		return TRUE;
+
+	return translateInstruction (t, statement);
+}
+
+/* returns the GLSL source, or NULL if the program can't be translated */
+static char *
+translateFragmentProgram (const char *program,
+                          int        *nEnv)
+{
+	static const char *samplerType[] = {
+		NULL, "sampler1D", "sampler2D", "sampler3D",
+		"samplerCube", "sampler2DRect"
+	};
+	ShaderTranslation t;
+	const char        *p, *end;
+	char              *statement;
+	Bool              rect = FALSE;
+	int               i;
+
+	memset (&t, 0, sizeof (t));
+
+	p = program;
+	if (strncmp (p, "!!ARBfp1.0", 10))
+		return NULL;
+
+	p += 10;
+
+	statement = malloc (strlen (p) + 1);
+	if (!statement)
+		return NULL;
+
+	while (*p && !t.error)
+	{
+		const char *s;
+
+		end = strchr (p, ';');
+
+		s = p;
+		skipSpace (&s);
+		if (!strncmp (s, "END", 3) && (!end || end > s + 3))
+			break;
+
+		if (!end)
+		{
+			translationError (&t, p);
+			break;
+		}
+
+		memcpy (statement, p, end - p);
+		statement[end - p] = '\0';
+
+		/* comments run to the end of the line */
+		{
+			char *comment, *line;
+
+			while ((comment = strchr (statement, '#')))
+			{
+				line = strchr (comment, '\n');
+				if (line)
+					memmove (comment, line, strlen (line) + 1);
+				else
+					*comment = '\0';
+			}
+		}
+
+		if (!translateStatement (&t, statement))
+			translationError (&t, statement);
+
+		p = end + 1;
+	}
+
+	free (statement);
+
+	appendShaderText (&t.header, "#version 110\n");
+
+	for (i = 0; i < SHADER_MAX_SAMPLERS; i++)
+		if (t.sampler[i] == SHADER_TARGET_RECT)
+			rect = TRUE;
+
+	if (rect)
+		appendShaderText (&t.header,
+		                  "#extension GL_ARB_texture_rectangle : require\n");
+
+	for (i = 0; i < SHADER_MAX_SAMPLERS; i++)
+		if (t.sampler[i])
+			appendShaderText (&t.header, "uniform %s tex_%d;\n",
+			                  samplerType[t.sampler[i]], i);
+
+	*nEnv = 0;
+	for (i = 0; i < MAX_FRAGMENT_ENV_PARAMETERS; i++)
+	{
+		if (t.env[i])
+		{
+			appendShaderText (&t.header, "uniform vec4 env_%d;\n", i);
+			(*nEnv)++;
+		}
+	}
+
+	appendShaderText (&t.header, "void main ()\n{\n%s%s}\n",
+	                  t.temps.data ? t.temps.data : "",
+	                  t.body.data ? t.body.data : "");
+
+	free (t.temps.data);
+	free (t.body.data);
+
+	if (t.error || t.header.error || t.temps.error || t.body.error)
+	{
+		free (t.header.data);
+		return NULL;
+	}
+
+	return t.header.data;
+}
+
+static void
+logInfoLog (GLuint               object,
+            ShaderGetInfoLogProc getInfoLog,
+            const char           *what)
+{
+	char log[1024];
+
+	log[0] = '\0';
+	(*getInfoLog) (object, sizeof (log), NULL, log);
+
+	compLogMessage ("core", CompLogLevelWarn,
+	                "failed to %s fragment shader: %s", what, log);
+}
+
+static uint64_t
+hashShaderData (uint64_t   hash,
+                const void *data,
+                size_t     size)
+{
+	const unsigned char *p = data;
+	size_t              i;
+
+	for (i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static char *
+getShaderCachePath (uint64_t key)
+{
+	const char *dir = bananaGetCacheDir ();
+	char       *path;
+
+	if (!dir)
+		return NULL;
+
+	path = malloc (strlen (dir) + 32);
+	if (path)
+		sprintf (path, "%s/shader-%016llx.bin", dir, (unsigned long long) key);
+
+	return path;
+}
+
+/* a program linked from the cached binary, or 0 */
+static GLuint
+loadCachedShader (uint64_t     key,
+                  unsigned int signatureHash)
+{
+	ShaderCacheHeader h;
+	struct stat       buf;
+	char              *path;
+	void              *binary = NULL;
+	GLuint            program = 0;
+	GLint             status;
+	FILE              *fp;
+
+	path = getShaderCachePath (key);
+	if (!path)
+		return 0;
+
+	fp = fopen (path, "rb");
+	if (!fp)
+	{
+		free (path);
+		return 0;
+	}
+
+	if (fstat (fileno (fp), &buf) != 0              ||
+	    fread (&h, sizeof (h), 1, fp) != 1          ||
+	    h.magic         != SHADER_CACHE_MAGIC       ||
+	    h.version       != SHADER_CACHE_VERSION     ||
+	    h.key           != key                      ||
+	    h.signatureHash != signatureHash            ||
+	    buf.st_size     != (off_t) (sizeof (h) + h.length))
+		goto out;
+
+	binary = malloc (h.length);
+	if (!binary || fread (binary, 1, h.length, fp) != h.length)
+		goto out;
+
+	program = (*createProgram) ();
+	if (!program)
+		goto out;
+
+	(*programBinary) (program, h.format, binary, h.length);
+
+	/* the driver changed in a way GL_VERSION doesn't show, the
+	   binary is written again after compiling */
+	(*getProgramiv) (program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		(*deleteProgram) (program);
+		program = 0;
+
+		unlink (path);
+	}
+
+out:
+	fclose (fp);
+	free (binary);
+	free (path);
+
+	return program;
+}
+
+static void
+storeCachedShader (GLuint       program,
+                   uint64_t     key,
+                   unsigned int signatureHash)
+{
+	ShaderCacheHeader h;
+	char              *path, *tmpPath;
+	void              *binary;
+	GLint             length = 0;
+	GLsizei           written = 0;
+	GLenum            format = 0;
+	FILE              *fp;
+
+	(*getProgramiv) (program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	binary = malloc (length);
+	if (!binary)
+		return;
+
+	(*getProgramBinary) (program, length, &written, &format, binary);
+
+	path = getShaderCachePath (key);
+	if (!path || written <= 0)
+	{
+		free (path);
+		free (binary);
+		return;
+	}
+
+	memset (&h, 0, sizeof (h));
+
+	h.magic         = SHADER_CACHE_MAGIC;
+	h.version       = SHADER_CACHE_VERSION;
+	h.key           = key;
+	h.signatureHash = signatureHash;
+	h.format        = format;
+	h.length        = written;
+
+	/* written to a temporary file and renamed, so that a concurrently
+	   starting fusilli never loads a half written binary */
+	tmpPath = malloc (strlen (path) + 16);
+	if (tmpPath)
+	{
+		sprintf (tmpPath, "%s.%d", path, (int) getpid ());
+
+		fp = fopen (tmpPath, "wb");
+		if (fp)
+		{
+			Bool ok;
+
+			ok = fwrite (&h, sizeof (h), 1, fp) == 1;
+			ok = ok && fwrite (binary, 1, written, fp) == (size_t) written;
+			ok = (fclose (fp) == 0) && ok;
+
+			if (!ok || rename (tmpPath, path) != 0)
+				unlink (tmpPath);
+		}
+
+		free (tmpPath);
+	}
+
+	free (path);
+	free (binary);
+}
+
+static GLuint
+compileFragmentShader (const char *source)
+{
+	GLuint shader, program;
+	GLint  status;
+
+	shader = (*createShader) (GL_FRAGMENT_SHADER);
+	if (!shader)
+		return 0;
+
+	(*shaderSource) (shader, 1, (const ShaderChar **) &source, NULL);
+	(*compileShader) (shader);
+
+	(*getShaderiv) (shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		logInfoLog (shader, getShaderInfoLog, "compile");
+		(*deleteShader) (shader);
+
+		return 0;
+	}
+
+	program = (*createProgram) ();
+	if (program)
+	{
+		(*attachShader) (program, shader);
+
+		if (driverHash)
+			(*programParameteri) (program,
+			                      GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+			                      GL_TRUE);
+
+		(*linkProgram) (program);
+
+		(*getProgramiv) (program, GL_LINK_STATUS, &status);
+		if (!status)
+		{
+			logInfoLog (program, getProgramInfoLog, "link");
+			(*deleteProgram) (program);
+
+			program = 0;
+		}
+	}
+
+	/* the program keeps it until the program is deleted */
+	(*deleteShader) (shader);
+
+	return program;
+}
+
+/* keeps a copy of every env parameter for the shaders */
+static void
+shaderProgramEnvParameter4f (GLenum  target,
+                             GLuint  index,
+                             GLfloat x,
+                             GLfloat y,
+                             GLfloat z,
+                             GLfloat w)
+{
+	if (target == GL_FRAGMENT_PROGRAM_ARB)
+		storeFragmentEnvParameter (index, x, y, z, w);
+
+	(*arbProgramEnvParameter4f) (target, index, x, y, z, w);
+}
+
+Bool
+initFragmentShaders (CompScreen *s)
+{
+	const char *glVersion, *glRenderer, *glExtensions;
+	GLint      nFormat = 0;
+
+	s->fragmentShader = 0;
+
+	glVersion = (const char *) glGetString (GL_VERSION);
+	if (!glVersion || atoi (glVersion) < 2)
+		return FALSE;
+
+	createShader = (ShaderCreateShaderProc)
+	    (*s->getProcAddress) ((GLubyte *) "glCreateShader");
+	shaderSource = (ShaderShaderSourceProc)
+	    (*s->getProcAddress) ((GLubyte *) "glShaderSource");
+	compileShader = (ShaderCompileShaderProc)
+	    (*s->getProcAddress) ((GLubyte *) "glCompileShader");
+	getShaderiv = (ShaderGetShaderivProc)
+	    (*s->getProcAddress) ((GLubyte *) "glGetShaderiv");
+	getShaderInfoLog = (ShaderGetInfoLogProc)
+	    (*s->getProcAddress) ((GLubyte *) "glGetShaderInfoLog");
+	deleteShader = (ShaderDeleteShaderProc)
+	    (*s->getProcAddress) ((GLubyte *) "glDeleteShader");
+	createProgram = (ShaderCreateProgramProc)
+	    (*s->getProcAddress) ((GLubyte *) "glCreateProgram");
+	attachShader = (ShaderAttachShaderProc)
+	    (*s->getProcAddress) ((GLubyte *) "glAttachShader");
+	linkProgram = (ShaderLinkProgramProc)
+	    (*s->getProcAddress) ((GLubyte *) "glLinkProgram");
+	getProgramiv = (ShaderGetProgramivProc)
+	    (*s->getProcAddress) ((GLubyte *) "glGetProgramiv");
+	getProgramInfoLog = (ShaderGetInfoLogProc)
+	    (*s->getProcAddress) ((GLubyte *) "glGetProgramInfoLog");
+	useProgram = (ShaderUseProgramProc)
+	    (*s->getProcAddress) ((GLubyte *) "glUseProgram");
+	deleteProgram = (ShaderDeleteProgramProc)
+	    (*s->getProcAddress) ((GLubyte *) "glDeleteProgram");
+	getUniformLocation = (ShaderGetUniformLocationProc)
+	    (*s->getProcAddress) ((GLubyte *) "glGetUniformLocation");
+	uniform1i = (ShaderUniform1iProc)
+	    (*s->getProcAddress) ((GLubyte *) "glUniform1i");
+	uniform4fv = (ShaderUniform4fvProc)
+	    (*s->getProcAddress) ((GLubyte *) "glUniform4fv");
+
+	if (!createShader || !shaderSource || !compileShader || !getShaderiv ||
+	    !getShaderInfoLog || !deleteShader || !createProgram ||
+	    !attachShader || !linkProgram || !getProgramiv ||
+	    !getProgramInfoLog || !useProgram || !deleteProgram ||
+	    !getUniformLocation || !uniform1i || !uniform4fv)
+		return FALSE;
+
+	/* fragment functions are only used with ARB fragment program
+	   support, whose env parameters the shaders need to see */
+	if (!s->fragmentProgram)
+		return FALSE;
+
+	driverHash = 0;
+
+	glExtensions = (const char *) glGetString (GL_EXTENSIONS);
+	glRenderer   = (const char *) glGetString (GL_RENDERER);
+
+	if (glExtensions && glRenderer && bananaGetCacheDir () &&
+	    strstr (glExtensions, "GL_ARB_get_program_binary"))
+	{
+		getProgramBinary = (ShaderGetProgramBinaryProc)
+		    (*s->getProcAddress) ((GLubyte *) "glGetProgramBinary");
+		programBinary = (ShaderProgramBinaryProc)
+		    (*s->getProcAddress) ((GLubyte *) "glProgramBinary");
+		programParameteri = (ShaderProgramParameteriProc)
+		    (*s->getProcAddress) ((GLubyte *) "glProgramParameteri");
+
+		/* some drivers have the extension without any format */
+		glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &nFormat);
+
+		if (getProgramBinary && programBinary && programParameteri &&
+		    nFormat > 0)
+		{
+			driverHash = hashShaderData (14695981039346656037ull,
+			                             glRenderer, strlen (glRenderer) + 1);
+			driverHash = hashShaderData (driverHash,
+			                             glVersion, strlen (glVersion) + 1);
+		}
+	}
+
+	if (s->programEnvParameter4f != shaderProgramEnvParameter4f)
+	{
+		arbProgramEnvParameter4f = s->programEnvParameter4f;
+		s->programEnvParameter4f = shaderProgramEnvParameter4f;
+	}
+
+	s->fragmentShader = 1;
+
+	return TRUE;
+}
+
+void
+storeFragmentEnvParameter (GLuint  index,
+                           GLfloat x,
+                           GLfloat y,
+                           GLfloat z,
+                           GLfloat w)
+{
+	GLfloat *value;
+
+	if (index >= MAX_FRAGMENT_ENV_PARAMETERS)
+		return;
+
+	value = envValue[index];
+
+	/* shaders that have this value already don't need it again */
+	if (envSerial[index] &&
+	    value[0] == x && value[1] == y && value[2] == z && value[3] == w)
+		return;
+
+	value[0] = x;
+	value[1] = y;
+	value[2] = z;
+	value[3] = w;
+
+	envSerial[index] = ++lastEnvSerial;
+}
+
+CompShader *
+createFragmentShader (CompScreen   *s,
+                      const char   *program,
+                      unsigned int signatureHash)
+{
+	CompShader *shader;
+	char       *source;
+	char       name[64];
+	uint64_t   key = 0;
+	int        nEnv, i;
+
+	if (!s->fragmentShader)
+		return NULL;
+
+	source = translateFragmentProgram (program, &nEnv);
+	if (!source)
+		return NULL;
+
+	shader = malloc (sizeof (CompShader));
+	if (!shader)
+	{
+		free (source);
+		return NULL;
+	}
+
+	shader->env  = NULL;
+	shader->nEnv = 0;
+
+	if (nEnv)
+	{
+		shader->env = malloc (nEnv * sizeof (CompShaderParameter));
+		if (!shader->env)
+		{
+			free (shader);
+			free (source);
+
+			return NULL;
+		}
+	}
+
+	/* the GLSL text, so that changes of the translation miss too */
+	if (driverHash)
+	{
+		key = hashShaderData (driverHash, &signatureHash,
+		                      sizeof (signatureHash));
+		key = hashShaderData (key, source, strlen (source));
+
+		shader->program = loadCachedShader (key, signatureHash);
+	}
+	else
+	{
+		shader->program = 0;
+	}
+
+	if (!shader->program)
+	{
+		shader->program = compileFragmentShader (source);
+
+		if (shader->program && driverHash)
+			storeCachedShader (shader->program, key, signatureHash);
+	}
+
+	free (source);
+
+	if (!shader->program)
+	{
+		if (shader->env)
+			free (shader->env);
+
+		free (shader);
+
+		return NULL;
+	}
+
+	(*useProgram) (shader->program);
+
+	/* the samplers never change their units */
+	for (i = 0; i < SHADER_MAX_SAMPLERS; i++)
+	{
+		GLint location;
+
+		snprintf (name, 64, "tex_%d", i);
+
+		location = (*getUniformLocation) (shader->program, name);
+		if (location >= 0)
+			(*uniform1i) (location, i);
+	}
+
+	for (i = 0; i < MAX_FRAGMENT_ENV_PARAMETERS; i++)
+	{
+		GLint location;
+
+		snprintf (name, 64, "env_%d", i);
+
+		location = (*getUniformLocation) (shader->program, name);
+		if (location < 0)
+			continue;
+
+		shader->env[shader->nEnv].index    = i;
+		shader->env[shader->nEnv].location = location;
+		shader->env[shader->nEnv].serial   = 0;
+		shader->nEnv++;
+	}
+
+	(*useProgram) (boundShader ? boundShader->program : 0);
+
+	return shader;
+}
+
+void
+destroyFragmentShader (CompScreen *s,
+                       CompShader *shader)
+{
+	if (boundShader == shader)
+	{
+		(*useProgram) (0);
+		boundShader = NULL;
+	}
+
+	(*deleteProgram) (shader->program);
+
+	if (shader->env)
+		free (shader->env);
+
+	free (shader);
+}
+
+void
+enableFragmentShader (CompScreen *s,
+                      CompShader *shader)
+{
+	int i;
+
+	if (boundShader != shader)
+	{
+		(*useProgram) (shader->program);
+		boundShader = shader;
+	}
+
+	for (i = 0; i < shader->nEnv; i++)
+	{
+		CompShaderParameter *param = &shader->env[i];
+
+		if (param->serial == envSerial[param->index])
+			continue;
+
+		(*uniform4fv) (param->location, 1, envValue[param->index]);
+		param->serial = envSerial[param->index];
+	}
+}
+
+void
+disableFragmentShader (CompScreen *s)
+{
+	if (!boundShader)
+		return;
+
+	(*useProgram) (0);
+	boundShader = NULL;
+}
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include <X11/Xatom.h>
 
@@ -55,6 +56,79 @@ typedef struct _TextSurfaceData {
 	Screen               *screen;
 } TextSurfaceData;
 
+/*
+ * Glyph atlas and text cache.
+ *
+ * Text that is bound to a texture is not rendered into a pixmap of its
+ * own. Pango lays the string out once, every glyph is rasterized with
+ * cairo into an alpha texture that is shared by all strings of a screen
+ * and the string is kept as a run of quads into that texture, which
+ * textDrawText draws in one call per color. The rounded background is
+ * drawn from a disc in the atlas, stretched in the middle.
+ *
+ * The rendered strings stay in a cache keyed on the text and all its
+ * attributes and are shared by every caller that asks for the same
+ * string, so showing a title again only costs a lookup. Unused strings
+ * are dropped least recently used first.
+ *
+ * When the atlas is full it is cleared, and strings whose glyphs were
+ * in it are laid out again the next time they are drawn.
+ *
+ * Text that is not bound to a texture is still rendered into a pixmap
+ * that the caller owns.
+ */
+
+#define TEXT_ATLAS_SIZE      1024
+#define TEXT_GLYPH_HASH_SIZE 512
+#define TEXT_CACHE_SIZE      256
+
+typedef struct _TextGlyph {
+	struct _TextGlyph *next;
+
+	PangoFont  *font; /* NULL for the background disc */
+	PangoGlyph glyph; /* radius of the background disc */
+
+	int x, y;         /* in the atlas */
+	int width, height;
+	int offX, offY;   /* of the bitmap from the pen position */
+} TextGlyph;
+
+typedef struct _TextCacheEntry {
+	CompTextData data; /* handed out to the callers */
+
+	struct _TextCacheEntry *prev, *next;
+
+	unsigned int   hash;
+	char           *text;
+	CompTextAttrib attrib;
+	int            refCount;
+
+	/* texture and vertex coordinates of the quads, relative to the
+	   top left corner of the text, background quads first */
+	GLfloat      *vertices;
+	int          nQuad;
+	int          nBackgroundQuad;
+	int          vertexSize;
+	unsigned int generation;
+} TextCacheEntry;
+
+struct _CompTextCache {
+	CompTexture  texture;
+	int          size;
+	int          shelfX, shelfY, shelfHeight;
+	unsigned int generation;
+	TextGlyph    *glyphs[TEXT_GLYPH_HASH_SIZE];
+
+	cairo_surface_t      *surface;
+	cairo_t              *cr;
+	PangoLayout          *layout;
+	PangoFontDescription *font;
+
+	/* most recently used first */
+	TextCacheEntry *head, *tail;
+	int            nEntry;
+};
+
 /*
  * Draw a rounded rectangle path
  */
@@ -194,50 +268,69 @@ textUpdateSurface (CompScreen      *s,
 	return textInitCairo (s, data, width, height);
 }
 
-static Bool
-textRenderTextToSurface (CompScreen           *s,
-                         const char           *text,
-                         TextSurfaceData      *data,
-                         const CompTextAttrib *attrib)
+/* sets up the layout for the text, width and height are the size of
+   the text including its background */
+static void
+textSetupLayout (PangoLayout          *layout,
+                 PangoFontDescription *font,
+                 const char           *text,
+                 const CompTextAttrib *attrib,
+                 int                  *width,
+                 int                  *height)
 {
-	int width, height, layoutWidth;
+	int layoutWidth;
 
-	pango_font_description_set_family (data->font, attrib->family);
-	pango_font_description_set_absolute_size (data->font,
+	pango_font_description_set_family (font, attrib->family);
+	pango_font_description_set_absolute_size (font,
 	                                          attrib->size * PANGO_SCALE);
-	pango_font_description_set_style (data->font, PANGO_STYLE_NORMAL);
+	pango_font_description_set_style (font, PANGO_STYLE_NORMAL);
+	pango_font_description_set_weight (font, PANGO_WEIGHT_NORMAL);
 
 	if (attrib->flags & CompTextFlagStyleBold)
-		pango_font_description_set_weight (data->font, PANGO_WEIGHT_BOLD);
+		pango_font_description_set_weight (font, PANGO_WEIGHT_BOLD);
 
 	if (attrib->flags & CompTextFlagStyleItalic)
-		pango_font_description_set_style (data->font, PANGO_STYLE_ITALIC);
+		pango_font_description_set_style (font, PANGO_STYLE_ITALIC);
 
-	pango_layout_set_font_description (data->layout, data->font);
+	pango_layout_set_font_description (layout, font);
 
 	if (attrib->flags & CompTextFlagEllipsized)
-		pango_layout_set_ellipsize (data->layout, PANGO_ELLIPSIZE_END);
+		pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+	else
+		pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
 
-	pango_layout_set_auto_dir (data->layout, FALSE);
-	pango_layout_set_text (data->layout, text, -1);
+	pango_layout_set_auto_dir (layout, FALSE);
+	pango_layout_set_width (layout, -1);
+	pango_layout_set_text (layout, text, -1);
 
-	pango_layout_get_pixel_size (data->layout, &width, &height);
+	pango_layout_get_pixel_size (layout, width, height);
 
 	if (attrib->flags & CompTextFlagWithBackground)
 	{
-		width  += 2 * attrib->bgHMargin;
-		height += 2 * attrib->bgVMargin;
+		*width  += 2 * attrib->bgHMargin;
+		*height += 2 * attrib->bgVMargin;
 	}
 
-	width  = MIN (attrib->maxWidth, width);
-	height = MIN (attrib->maxHeight, height);
+	*width  = MIN (attrib->maxWidth, *width);
+	*height = MIN (attrib->maxHeight, *height);
 
 	/* update the size of the pango layout */
 	layoutWidth = attrib->maxWidth;
 	if (attrib->flags & CompTextFlagWithBackground)
 		layoutWidth -= 2 * attrib->bgHMargin;
 
-	pango_layout_set_width (data->layout, layoutWidth * PANGO_SCALE);
+	pango_layout_set_width (layout, layoutWidth * PANGO_SCALE);
+}
+
+static Bool
+textRenderTextToSurface (CompScreen           *s,
+                         const char           *text,
+                         TextSurfaceData      *data,
+                         const CompTextAttrib *attrib)
+{
+	int width, height;
+
+	textSetupLayout (data->layout, data->font, text, attrib, &width, &height);
 
 	if (!textUpdateSurface (s, data, width, height))
 		return FALSE;
@@ -288,17 +381,14 @@ textCleanupSurface (TextSurfaceData *data)
 		pango_font_description_free (data->font);
 }
 
-CompTextData *
-textRenderText (CompScreen           *s,
-                const char           *text,
-                const CompTextAttrib *attrib)
+static CompTextData *
+textRenderTextToPixmap (CompScreen           *s,
+                        const char           *text,
+                        const CompTextAttrib *attrib)
 {
 	TextSurfaceData surface;
 	CompTextData    *retval = NULL;
 
-	if (!text || !strlen (text))
-		return NULL;
-
 	memset (&surface, 0, sizeof (TextSurfaceData));
 
 	if (textInitSurface (s, &surface) &&
@@ -345,6 +435,647 @@ textRenderText (CompScreen           *s,
 	return retval;
 }
 
+static unsigned int
+textHashBytes (unsigned int hash,
+               const void   *data,
+               size_t       size)
+{
+	const unsigned char *p = data;
+
+	while (size--)
+		hash = (hash ^ *p++) * 16777619;
+
+	return hash;
+}
+
+static unsigned int
+textHashKey (const char           *text,
+             const CompTextAttrib *attrib)
+{
+	unsigned int hash = 2166136261u;
+
+	hash = textHashBytes (hash, text, strlen (text));
+	if (attrib->family)
+		hash = textHashBytes (hash, attrib->family, strlen (attrib->family));
+
+	hash = textHashBytes (hash, &attrib->size, sizeof (attrib->size));
+	hash = textHashBytes (hash, attrib->color, sizeof (attrib->color));
+	hash = textHashBytes (hash, &attrib->flags, sizeof (attrib->flags));
+	hash = textHashBytes (hash, &attrib->maxWidth, sizeof (attrib->maxWidth));
+	hash = textHashBytes (hash, &attrib->maxHeight, sizeof (attrib->maxHeight));
+	hash = textHashBytes (hash, &attrib->bgHMargin, sizeof (attrib->bgHMargin));
+	hash = textHashBytes (hash, &attrib->bgVMargin, sizeof (attrib->bgVMargin));
+	hash = textHashBytes (hash, attrib->bgColor, sizeof (attrib->bgColor));
+
+	return hash;
+}
+
+static Bool
+textEntryMatches (const TextCacheEntry *entry,
+                  unsigned int         hash,
+                  const char           *text,
+                  const CompTextAttrib *attrib)
+{
+	const CompTextAttrib *a = &entry->attrib;
+
+	if (entry->hash != hash || strcmp (entry->text, text))
+		return FALSE;
+
+	if (!a->family != !attrib->family ||
+	    (a->family && strcmp (a->family, attrib->family)))
+		return FALSE;
+
+	return a->size == attrib->size &&
+	       a->flags == attrib->flags &&
+	       a->maxWidth == attrib->maxWidth &&
+	       a->maxHeight == attrib->maxHeight &&
+	       a->bgHMargin == attrib->bgHMargin &&
+	       a->bgVMargin == attrib->bgVMargin &&
+	       !memcmp (a->color, attrib->color, sizeof (a->color)) &&
+	       !memcmp (a->bgColor, attrib->bgColor, sizeof (a->bgColor));
+}
+
+static void
+textClearGlyphs (CompTextCache *tc)
+{
+	TextGlyph *glyph;
+	int       i;
+
+	for (i = 0; i < TEXT_GLYPH_HASH_SIZE; i++)
+	{
+		while (tc->glyphs[i])
+		{
+			glyph = tc->glyphs[i];
+			tc->glyphs[i] = glyph->next;
+
+			if (glyph->font)
+				g_object_unref (glyph->font);
+
+			free (glyph);
+		}
+	}
+
+	tc->shelfX      = 0;
+	tc->shelfY      = 0;
+	tc->shelfHeight = 0;
+	tc->generation++;
+}
+
+static CompTextCache *
+textGetCache (CompScreen *s)
+{
+	CompTextCache *tc;
+
+	if (s->textCache)
+		return s->textCache;
+
+	tc = calloc (1, sizeof (CompTextCache));
+	if (!tc)
+		return NULL;
+
+	initTexture (s, &tc->texture);
+	s->textCache = tc;
+
+	/* the layout is only measured, glyphs are drawn on their own */
+	tc->surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+	tc->cr      = cairo_create (tc->surface);
+	if (cairo_status (tc->cr) != CAIRO_STATUS_SUCCESS)
+	{
+		compLogMessage ("text", CompLogLevelError,
+		                "Couldn't create cairo context.");
+		finiScreenText (s);
+		return NULL;
+	}
+
+	tc->layout = pango_cairo_create_layout (tc->cr);
+	tc->font   = pango_font_description_new ();
+	if (!tc->layout || !tc->font)
+	{
+		compLogMessage ("text", CompLogLevelError,
+		                "Couldn't create pango layout.");
+		finiScreenText (s);
+		return NULL;
+	}
+
+	tc->size = MIN (TEXT_ATLAS_SIZE, s->maxTextureSize);
+
+	tc->texture.target    = GL_TEXTURE_2D;
+	tc->texture.matrix.xx = 1.0f / tc->size;
+	tc->texture.matrix.yy = 1.0f / tc->size;
+	tc->texture.mipmap    = FALSE;
+
+	makeScreenCurrent (s);
+
+	glGenTextures (1, &tc->texture.name);
+	glBindTexture (GL_TEXTURE_2D, tc->texture.name);
+
+	glTexImage2D (GL_TEXTURE_2D, 0, GL_ALPHA, tc->size, tc->size, 0,
+	              GL_ALPHA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture (GL_TEXTURE_2D, 0);
+
+	tc->texture.filter = GL_LINEAR;
+	tc->texture.wrap   = GL_CLAMP_TO_EDGE;
+
+	return tc;
+}
+
+/* glyphs are packed into shelves from the top of the atlas */
+static Bool
+textAllocGlyph (CompTextCache *tc,
+                TextGlyph     *glyph)
+{
+	if (tc->shelfX + glyph->width > tc->size)
+	{
+		tc->shelfX      = 0;
+		tc->shelfY     += tc->shelfHeight;
+		tc->shelfHeight = 0;
+	}
+
+	if (glyph->width > tc->size || tc->shelfY + glyph->height > tc->size)
+		return FALSE;
+
+	glyph->x = tc->shelfX;
+	glyph->y = tc->shelfY;
+
+	tc->shelfX      += glyph->width;
+	tc->shelfHeight  = MAX (tc->shelfHeight, glyph->height);
+
+	return TRUE;
+}
+
+/* returns the glyph from the atlas, rasterizes it if it isn't there yet
+   and NULL when the atlas is full */
+static TextGlyph *
+textGetGlyph (CompTextCache *tc,
+              PangoFont     *font,
+              PangoGlyph    index)
+{
+	cairo_scaled_font_t  *scaledFont = NULL;
+	cairo_text_extents_t extents;
+	cairo_glyph_t        cairoGlyph;
+	cairo_surface_t      *surface;
+	cairo_t              *cr;
+	TextGlyph            *glyph;
+	unsigned int         hash;
+
+	hash = ((unsigned long) font / sizeof (void *) * 31 + index) %
+	       TEXT_GLYPH_HASH_SIZE;
+
+	for (glyph = tc->glyphs[hash]; glyph; glyph = glyph->next)
+		if (glyph->font == font && glyph->glyph == index)
+			return glyph;
+
+	glyph = calloc (1, sizeof (TextGlyph));
+	if (!glyph)
+		return NULL;
+
+	cairoGlyph.index = index;
+	cairoGlyph.x     = 0;
+	cairoGlyph.y     = 0;
+
+	if (font)
+	{
+		scaledFont = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+		if (!scaledFont)
+		{
+			free (glyph);
+			return NULL;
+		}
+
+		cairo_scaled_font_glyph_extents (scaledFont, &cairoGlyph, 1, &extents);
+
+		/* a pixel of padding on every side */
+		if (extents.width > 0 && extents.height > 0)
+		{
+			glyph->offX   = floor (extents.x_bearing) - 1;
+			glyph->offY   = floor (extents.y_bearing) - 1;
+			glyph->width  = ceil (extents.x_bearing + extents.width) -
+			                glyph->offX + 1;
+			glyph->height = ceil (extents.y_bearing + extents.height) -
+			                glyph->offY + 1;
+		}
+	}
+	else
+	{
+		glyph->offX   = -1;
+		glyph->offY   = -1;
+		glyph->width  = 2 * index + 2;
+		glyph->height = 2 * index + 2;
+	}
+
+	/* blanks take no space in the atlas */
+	if (glyph->width)
+	{
+		if (!textAllocGlyph (tc, glyph))
+		{
+			free (glyph);
+			return NULL;
+		}
+
+		surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+		                                      glyph->width, glyph->height);
+		cr = cairo_create (surface);
+
+		if (font)
+		{
+			cairoGlyph.x = -glyph->offX;
+			cairoGlyph.y = -glyph->offY;
+
+			cairo_set_scaled_font (cr, scaledFont);
+			cairo_show_glyphs (cr, &cairoGlyph, 1);
+		}
+		else
+		{
+			cairo_arc (cr, index + 1, index + 1, index, 0, 2 * PI);
+			cairo_fill (cr);
+		}
+
+		cairo_destroy (cr);
+		cairo_surface_flush (surface);
+
+		glBindTexture (GL_TEXTURE_2D, tc->texture.name);
+
+		glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei (GL_UNPACK_ROW_LENGTH,
+		               cairo_image_surface_get_stride (surface));
+
+		glTexSubImage2D (GL_TEXTURE_2D, 0, glyph->x, glyph->y,
+		                 glyph->width, glyph->height,
+		                 GL_ALPHA, GL_UNSIGNED_BYTE,
+		                 cairo_image_surface_get_data (surface));
+
+		glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+
+		glBindTexture (GL_TEXTURE_2D, 0);
+
+		cairo_surface_destroy (surface);
+	}
+
+	glyph->font  = font ? g_object_ref (font) : NULL;
+	glyph->glyph = index;
+	glyph->next  = tc->glyphs[hash];
+
+	tc->glyphs[hash] = glyph;
+
+	return glyph;
+}
+
+/* adds a quad clipped to the size of the text, the texture coordinates
+   are in atlas pixels */
+static Bool
+textAddQuad (CompTextCache  *tc,
+             TextCacheEntry *entry,
+             float          x1,
+             float          y1,
+             float          x2,
+             float          y2,
+             float          u1,
+             float          v1,
+             float          u2,
+             float          v2)
+{
+	float   width  = entry->data.width;
+	float   height = entry->data.height;
+	GLfloat *v;
+
+	if (x1 < 0)
+	{
+		u1 += (u2 - u1) * -x1 / (x2 - x1);
+		x1 = 0;
+	}
+	if (x2 > width)
+	{
+		u2 -= (u2 - u1) * (x2 - width) / (x2 - x1);
+		x2 = width;
+	}
+	if (y1 < 0)
+	{
+		v1 += (v2 - v1) * -y1 / (y2 - y1);
+		y1 = 0;
+	}
+	if (y2 > height)
+	{
+		v2 -= (v2 - v1) * (y2 - height) / (y2 - y1);
+		y2 = height;
+	}
+
+	if (x2 <= x1 || y2 <= y1)
+		return TRUE;
+
+	if (entry->vertexSize < (entry->nQuad + 1) * 16)
+	{
+		int newSize = MAX (64, entry->vertexSize * 2);
+
+		v = realloc (entry->vertices, sizeof (GLfloat) * newSize);
+		if (!v)
+			return FALSE;
+
+		entry->vertices   = v;
+		entry->vertexSize = newSize;
+	}
+
+	u1 /= tc->size;
+	u2 /= tc->size;
+	v1 /= tc->size;
+	v2 /= tc->size;
+
+	v = entry->vertices + entry->nQuad * 16;
+
+	*v++ = u1; *v++ = v1; *v++ = x1; *v++ = y1;
+	*v++ = u1; *v++ = v2; *v++ = x1; *v++ = y2;
+	*v++ = u2; *v++ = v2; *v++ = x2; *v++ = y2;
+	*v++ = u2; *v++ = v1; *v++ = x2; *v++ = y1;
+
+	entry->nQuad++;
+
+	return TRUE;
+}
+
+/* the rounded rectangle from the quarters of a disc, with its middle
+   stretched to the edges */
+static Bool
+textAddBackground (CompTextCache  *tc,
+                   TextCacheEntry *entry)
+{
+	const CompTextAttrib *attrib = &entry->attrib;
+	TextGlyph            *disc;
+	float                x[4], y[4], u[4], v[4];
+	int                  r, i, j;
+
+	r = MIN (attrib->bgHMargin, attrib->bgVMargin);
+	r = MIN (r, (int) MIN (entry->data.width, entry->data.height) / 2);
+	r = MAX (r, 1);
+
+	disc = textGetGlyph (tc, NULL, r);
+	if (!disc)
+		return FALSE;
+
+	x[0] = 0;
+	x[1] = r;
+	x[2] = entry->data.width - r;
+	x[3] = entry->data.width;
+
+	y[0] = 0;
+	y[1] = r;
+	y[2] = entry->data.height - r;
+	y[3] = entry->data.height;
+
+	u[0] = disc->x + 1;
+	u[1] = u[2] = u[0] + r;
+	u[3] = u[0] + 2 * r;
+
+	v[0] = disc->y + 1;
+	v[1] = v[2] = v[0] + r;
+	v[3] = v[0] + 2 * r;
+
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 3; j++)
+			if (!textAddQuad (tc, entry, x[i], y[j], x[i + 1], y[j + 1],
+			                  u[i], v[j], u[i + 1], v[j + 1]))
+				return FALSE;
+
+	entry->nBackgroundQuad = entry->nQuad;
+
+	return TRUE;
+}
+
+static Bool
+textLayoutEntry (CompTextCache  *tc,
+                 TextCacheEntry *entry)
+{
+	const CompTextAttrib *attrib = &entry->attrib;
+	PangoLayoutIter      *iter;
+	PangoLayoutRun       *run;
+	PangoGlyphInfo       *info;
+	PangoRectangle       logical;
+	TextGlyph            *glyph;
+	Bool                 status = TRUE;
+	int                  width, height, ox = 0, oy = 0;
+	int                  x, baseline, i;
+
+	textSetupLayout (tc->layout, tc->font, entry->text, attrib,
+	                 &width, &height);
+
+	entry->data.width      = width;
+	entry->data.height     = height;
+	entry->nQuad           = 0;
+	entry->nBackgroundQuad = 0;
+
+	if (attrib->flags & CompTextFlagWithBackground)
+	{
+		if (!textAddBackground (tc, entry))
+			return FALSE;
+
+		ox = attrib->bgHMargin;
+		oy = attrib->bgVMargin;
+	}
+
+	iter = pango_layout_get_iter (tc->layout);
+
+	do
+	{
+		run = pango_layout_iter_get_run_readonly (iter);
+		if (!run)
+			continue;
+
+		pango_layout_iter_get_run_extents (iter, NULL, &logical);
+		baseline = pango_layout_iter_get_baseline (iter);
+
+		x = logical.x;
+
+		for (i = 0; status && i < run->glyphs->num_glyphs; i++)
+		{
+			info = &run->glyphs->glyphs[i];
+
+			if (info->glyph != PANGO_GLYPH_EMPTY &&
+			    !(info->glyph & PANGO_GLYPH_UNKNOWN_FLAG))
+			{
+				glyph = textGetGlyph (tc, run->item->analysis.font,
+				                      info->glyph);
+				if (!glyph)
+				{
+					status = FALSE;
+					break;
+				}
+
+				if (glyph->width)
+				{
+					int gx, gy;
+
+					gx = ox + PANGO_PIXELS (x + info->geometry.x_offset) +
+					     glyph->offX;
+					gy = oy + PANGO_PIXELS (baseline + info->geometry.y_offset) +
+					     glyph->offY;
+
+					status = textAddQuad (tc, entry,
+					                      gx, gy,
+					                      gx + glyph->width,
+					                      gy + glyph->height,
+					                      glyph->x, glyph->y,
+					                      glyph->x + glyph->width,
+					                      glyph->y + glyph->height);
+				}
+			}
+
+			x += info->geometry.width;
+		}
+	} while (status && pango_layout_iter_next_run (iter));
+
+	pango_layout_iter_free (iter);
+
+	if (status)
+		entry->generation = tc->generation;
+
+	return status;
+}
+
+static Bool
+textUpdateEntry (CompTextCache  *tc,
+                 TextCacheEntry *entry)
+{
+	if (textLayoutEntry (tc, entry))
+		return TRUE;
+
+	/* the atlas is full, start over with an empty one */
+	textClearGlyphs (tc);
+
+	return textLayoutEntry (tc, entry);
+}
+
+static void
+textDestroyEntry (TextCacheEntry *entry)
+{
+	if (entry->vertices)
+		free (entry->vertices);
+	if (entry->attrib.family)
+		free (entry->attrib.family);
+	if (entry->text)
+		free (entry->text);
+
+	free (entry);
+}
+
+static void
+textUnlinkEntry (CompTextCache  *tc,
+                 TextCacheEntry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		tc->head = entry->next;
+
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		tc->tail = entry->prev;
+}
+
+static void
+textLinkEntry (CompTextCache  *tc,
+               TextCacheEntry *entry)
+{
+	entry->prev = NULL;
+	entry->next = tc->head;
+
+	if (tc->head)
+		tc->head->prev = entry;
+	else
+		tc->tail = entry;
+
+	tc->head = entry;
+}
+
+/* drops the least recently used strings nobody holds */
+static void
+textTrimCache (CompTextCache *tc)
+{
+	TextCacheEntry *entry, *prev;
+
+	for (entry = tc->tail; entry && tc->nEntry > TEXT_CACHE_SIZE; entry = prev)
+	{
+		prev = entry->prev;
+
+		if (entry->refCount)
+			continue;
+
+		textUnlinkEntry (tc, entry);
+		textDestroyEntry (entry);
+		tc->nEntry--;
+	}
+}
+
+CompTextData *
+textRenderText (CompScreen           *s,
+                const char           *text,
+                const CompTextAttrib *attrib)
+{
+	CompTextCache  *tc;
+	TextCacheEntry *entry;
+	unsigned int   hash;
+
+	if (!text || !strlen (text))
+		return NULL;
+
+	/* the caller takes the pixmap */
+	if (attrib->flags & CompTextFlagNoAutoBinding)
+		return textRenderTextToPixmap (s, text, attrib);
+
+	tc = textGetCache (s);
+	if (!tc)
+		return textRenderTextToPixmap (s, text, attrib);
+
+	hash = textHashKey (text, attrib);
+
+	for (entry = tc->head; entry; entry = entry->next)
+		if (textEntryMatches (entry, hash, text, attrib))
+			break;
+
+	if (entry)
+	{
+		textUnlinkEntry (tc, entry);
+		textLinkEntry (tc, entry);
+		entry->refCount++;
+
+		return &entry->data;
+	}
+
+	entry = calloc (1, sizeof (TextCacheEntry));
+	if (!entry)
+		return textRenderTextToPixmap (s, text, attrib);
+
+	entry->hash          = hash;
+	entry->text          = strdup (text);
+	entry->attrib        = *attrib;
+	entry->attrib.family = attrib->family ? strdup (attrib->family) : NULL;
+	entry->data.texture  = &tc->texture;
+	entry->data.pixmap   = None;
+
+	makeScreenCurrent (s);
+
+	if (!entry->text || (attrib->family && !entry->attrib.family) ||
+	    !textUpdateEntry (tc, entry))
+	{
+		textDestroyEntry (entry);
+		return textRenderTextToPixmap (s, text, attrib);
+	}
+
+	entry->refCount = 1;
+
+	textLinkEntry (tc, entry);
+	tc->nEntry++;
+
+	textTrimCache (tc);
+
+	return &entry->data;
+}
+
 CompTextData *
 textRenderWindowTitle (CompScreen           *s,
                        CompWindow           *w,
@@ -386,6 +1117,56 @@ textRenderWindowTitle (CompScreen           *s,
 	return retval;
 }
 
+/* draws a string from the glyph atlas */
+static void
+textDrawCachedText (CompScreen     *s,
+                    TextCacheEntry *entry,
+                    float          x,
+                    float          y,
+                    float          alpha)
+{
+	CompTextCache        *tc = s->textCache;
+	const CompTextAttrib *attrib = &entry->attrib;
+
+	if (entry->generation != tc->generation && !textUpdateEntry (tc, entry))
+		return;
+
+	if (!entry->nQuad)
+		return;
+
+	/* the atlas only has coverage, the colors are not premultiplied */
+	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	enableTexture (s, &tc->texture, COMP_TEXTURE_FILTER_GOOD);
+
+	glPushMatrix ();
+	glTranslatef (x, y - entry->data.height, 0.0f);
+
+	glTexCoordPointer (2, GL_FLOAT, sizeof (GLfloat) * 4, entry->vertices);
+	glVertexPointer (2, GL_FLOAT, sizeof (GLfloat) * 4, entry->vertices + 2);
+
+	if (entry->nBackgroundQuad)
+	{
+		glColor4f (attrib->bgColor[0] / 65535.0f,
+		           attrib->bgColor[1] / 65535.0f,
+		           attrib->bgColor[2] / 65535.0f,
+		           attrib->bgColor[3] / 65535.0f * alpha);
+		glDrawArrays (GL_QUADS, 0, entry->nBackgroundQuad * 4);
+	}
+
+	glColor4f (attrib->color[0] / 65535.0f,
+	           attrib->color[1] / 65535.0f,
+	           attrib->color[2] / 65535.0f,
+	           attrib->color[3] / 65535.0f * alpha);
+	glDrawArrays (GL_QUADS, entry->nBackgroundQuad * 4,
+	              (entry->nQuad - entry->nBackgroundQuad) * 4);
+
+	glPopMatrix ();
+
+	disableTexture (s, &tc->texture);
+}
+
 void
 textDrawText (CompScreen         *s,
               const CompTextData *data,
@@ -408,31 +1189,40 @@ textDrawText (CompScreen         *s,
 	if (!wasBlend)
 		glEnable (GL_BLEND);
 
-	glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	/* text from the cache has no pixmap */
+	if (!data->pixmap)
+	{
+		textDrawCachedText (s, (TextCacheEntry *) data, x, y, alpha);
+	}
+	else
+	{
+		glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+		glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		glColor4f (alpha, alpha, alpha, alpha);
 
-	glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-	glColor4f (alpha, alpha, alpha, alpha);
+		enableTexture (s, data->texture, COMP_TEXTURE_FILTER_GOOD);
 
-	enableTexture (s, data->texture, COMP_TEXTURE_FILTER_GOOD);
+		m      = &data->texture->matrix;
+		width  = data->width;
+		height = data->height;
 
-	m      = &data->texture->matrix;
-	width  = data->width;
-	height = data->height;
+		glBegin (GL_QUADS);
 
-	glBegin (GL_QUADS);
+		glTexCoord2f (COMP_TEX_COORD_X (m, 0), COMP_TEX_COORD_Y (m, 0));
+		glVertex2f (x, y - height);
+		glTexCoord2f (COMP_TEX_COORD_X (m, 0), COMP_TEX_COORD_Y (m, height));
+		glVertex2f (x, y);
+		glTexCoord2f (COMP_TEX_COORD_X (m, width), COMP_TEX_COORD_Y (m, height));
+		glVertex2f (x + width, y);
+		glTexCoord2f (COMP_TEX_COORD_X (m, width), COMP_TEX_COORD_Y (m, 0));
+		glVertex2f (x + width, y - height);
 
-	glTexCoord2f (COMP_TEX_COORD_X (m, 0), COMP_TEX_COORD_Y (m, 0));
-	glVertex2f (x, y - height);
-	glTexCoord2f (COMP_TEX_COORD_X (m, 0), COMP_TEX_COORD_Y (m, height));
-	glVertex2f (x, y);
-	glTexCoord2f (COMP_TEX_COORD_X (m, width), COMP_TEX_COORD_Y (m, height));
-	glVertex2f (x + width, y);
-	glTexCoord2f (COMP_TEX_COORD_X (m, width), COMP_TEX_COORD_Y (m, 0));
-	glVertex2f (x + width, y - height);
+		glEnd ();
 
-	glEnd ();
+		disableTexture (s, data->texture);
+	}
 
-	disableTexture (s, data->texture);
 	glColor4usv (defaultColor);
 
 	if (!wasBlend)
@@ -444,6 +1234,17 @@ void
 textFiniTextData (CompScreen   *s,
                   CompTextData *data)
 {
+	/* strings from the cache stay there until they are pushed out */
+	if (!data->pixmap)
+	{
+		TextCacheEntry *entry = (TextCacheEntry *) data;
+
+		entry->refCount--;
+		textTrimCache (s->textCache);
+
+		return;
+	}
+
 	if (data->texture)
 	{
 		finiTexture (s, data->texture);
@@ -455,6 +1256,40 @@ textFiniTextData (CompScreen   *s,
 	free (data);
 }
 
+void
+finiScreenText (CompScreen *s)
+{
+	CompTextCache  *tc = s->textCache;
+	TextCacheEntry *entry;
+
+	if (!tc)
+		return;
+
+	while (tc->head)
+	{
+		entry = tc->head;
+		tc->head = entry->next;
+
+		textDestroyEntry (entry);
+	}
+
+	textClearGlyphs (tc);
+	finiTexture (s, &tc->texture);
+
+	if (tc->font)
+		pango_font_description_free (tc->font);
+	if (tc->layout)
+		g_object_unref (tc->layout);
+	if (tc->cr)
+		cairo_destroy (tc->cr);
+	if (tc->surface)
+		cairo_surface_destroy (tc->surface);
+
+	free (tc);
+
+	s->textCache = NULL;
+}
+
 
 
 
@@ -101,20 +101,25 @@ imageToTexture (CompScreen   *screen,
                 unsigned int width,
                 unsigned int height,
                 GLenum       format,
-                GLenum       type)
+                GLenum       type,
+                Bool         flip)
 {
-	char *data;
-	int  i;
-	GLint internalFormat;
-
-	data = malloc (4 * width * height);
-	if (!data)
-		return FALSE;
+	const char *data = image;
+	char       *flipped = NULL;
+	GLint      internalFormat;
+
+	/* image buffers are uploaded as they are, top row first, and
+	   the texture matrix maps y down; image data keeps the bottom row
+	   first because some plugins draw it with fixed coordinates */
+	if (flip)
+	{
+		flipped = malloc (4 * width * height);
+		if (!flipped)
+			return FALSE;
 
-	for (i = 0; i < height; i++)
-		memcpy (&data[i * width * 4],
-		        &image[(height - i - 1) * width * 4],
-		        width * 4);
+		flipImageRows (flipped, image, width * 4, height);
+		data = flipped;
+	}
 
 	makeScreenCurrent (screen);
 	releasePixmapFromTexture (screen, texture);
@@ -124,16 +129,16 @@ imageToTexture (CompScreen   *screen,
 	{
 		texture->target = GL_TEXTURE_2D;
 		texture->matrix.xx = 1.0f / width;
-		texture->matrix.yy = -1.0f / height;
-		texture->matrix.y0 = 1.0f;
+		texture->matrix.yy = (flip ? -1.0f : 1.0f) / height;
+		texture->matrix.y0 = flip ? 1.0f : 0.0f;
 		texture->mipmap = TRUE;
 	}
 	else
 	{
 		texture->target = GL_TEXTURE_RECTANGLE_NV;
 		texture->matrix.xx = 1.0f;
-		texture->matrix.yy = -1.0f;
-		texture->matrix.y0 = height;
+		texture->matrix.yy = flip ? -1.0f : 1.0f;
+		texture->matrix.y0 = flip ? height : 0.0f;
 		texture->mipmap = FALSE;
 	}
 
@@ -167,7 +172,8 @@ imageToTexture (CompScreen   *screen,
 
 	glBindTexture (texture->target, 0);
 
-	free (data);
+	if (flipped)
+		free (flipped);
 
 	return TRUE;
 }
@@ -181,10 +187,10 @@ imageBufferToTexture (CompScreen   *screen,
 {
 #if IMAGE_BYTE_ORDER == MSBFirst
 	return imageToTexture (screen, texture, image, width, height,
-	                       GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV);
+	                       GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, FALSE);
 #else
 	return imageToTexture (screen, texture, image, width, height,
-	                       GL_BGRA, GL_UNSIGNED_BYTE);
+	                       GL_BGRA, GL_UNSIGNED_BYTE, FALSE);
 #endif
 }
 
@@ -197,7 +203,8 @@ imageDataToTexture (CompScreen   *screen,
                     GLenum       format,
                     GLenum       type)
 {
-	return imageToTexture (screen, texture, image, width, height, format, type);
+	return imageToTexture (screen, texture, image, width, height,
+	                       format, type, TRUE);
 }
 
 
@@ -439,6 +446,23 @@ enableTexture (CompScreen    *screen,
 			texture->filter = GL_NEAREST;
 		}
 	}
+	else if (filter == COMP_TEXTURE_FILTER_GOOD_UNMINIFIED &&
+	         display.textureFilter == GL_LINEAR_MIPMAP_LINEAR)
+	{
+		/* the same as mipmapping when magnified, without having to
+		   bring the mipmaps up to date */
+		if (texture->filter != GL_LINEAR)
+		{
+			glTexParameteri (texture->target,
+			                 GL_TEXTURE_MIN_FILTER,
+			                 GL_LINEAR);
+			glTexParameteri (texture->target,
+			                 GL_TEXTURE_MAG_FILTER,
+			                 GL_LINEAR);
+
+			texture->filter = GL_LINEAR;
+		}
+	}
 	else if (texture->filter != display.textureFilter)
 	{
 		if (display.textureFilter == GL_LINEAR_MIPMAP_LINEAR)
@@ -487,6 +511,8 @@ enableTexture (CompScreen    *screen,
 		{
 			(*screen->generateMipmap) (texture->target);
 			texture->oldMipmaps = FALSE;
+
+			screen->mipmapRebuilds++;
 		}
 	}
 }
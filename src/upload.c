@@ -0,0 +1,311 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include "../config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fusilli-core.h>
+
+/*
+ * Streaming texture uploads.
+ *
+ * Plugins that draw a texture on the CPU every frame write it into
+ * memory handed out by beginTextureUpload and endTextureUpload copies
+ * it into the existing storage of the texture with glTexSubImage2D,
+ * instead of allocating new storage with glTexImage2D each time.
+ *
+ * With pixel buffer objects that memory is one of a ring of buffers
+ * mapped into the address space, and the copy into the texture is done
+ * by the GPU when it gets to it. A fence placed after the copy tells
+ * whether the buffer is free again when its turn comes; if it isn't,
+ * or there are no fences, the buffer is orphaned so that the driver
+ * can hand out fresh memory instead of waiting. Without pixel buffer
+ * objects the pixels are kept in ordinary memory and uploaded from
+ * there.
+ */
+
+#define TEXTURE_UPLOAD_BUFFERS 3
+
+struct _CompTextureUpload {
+	unsigned int width;
+	unsigned int height;
+	GLsizeiptr   size;
+
+	GLuint buffers[TEXTURE_UPLOAD_BUFFERS];
+	GLsync fences[TEXTURE_UPLOAD_BUFFERS];
+	int    current;
+	void   *mapped;
+
+	void *staging;
+};
+
+/* width x height pixels of native A, R, G, B words, stride width * 4 */
+CompTextureUpload *
+createTextureUpload (CompScreen   *screen,
+                     unsigned int width,
+                     unsigned int height)
+{
+	CompTextureUpload *upload;
+	int               i;
+
+	upload = calloc (1, sizeof (CompTextureUpload));
+	if (!upload)
+		return NULL;
+
+	upload->width  = width;
+	upload->height = height;
+	upload->size   = (GLsizeiptr) width * height * 4;
+
+	if (!screen->pixelBufferObject)
+	{
+		upload->staging = malloc (upload->size);
+		if (!upload->staging)
+		{
+			free (upload);
+			return NULL;
+		}
+
+		return upload;
+	}
+
+	makeScreenCurrent (screen);
+
+	(*screen->genBuffers) (TEXTURE_UPLOAD_BUFFERS, upload->buffers);
+
+	for (i = 0; i < TEXTURE_UPLOAD_BUFFERS; i++)
+	{
+		(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, upload->buffers[i]);
+		(*screen->bufferData) (GL_PIXEL_UNPACK_BUFFER_ARB, upload->size,
+		                       NULL, GL_STREAM_DRAW_ARB);
+	}
+
+	(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+	return upload;
+}
+
+void
+destroyTextureUpload (CompScreen        *screen,
+                      CompTextureUpload *upload)
+{
+	int i;
+
+	if (!upload)
+		return;
+
+	if (upload->buffers[0])
+	{
+		makeScreenCurrent (screen);
+
+		if (upload->mapped)
+		{
+			(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB,
+			                       upload->buffers[upload->current]);
+			(*screen->unmapBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB);
+			(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		}
+
+		for (i = 0; i < TEXTURE_UPLOAD_BUFFERS; i++)
+			if (upload->fences[i])
+				(*screen->deleteSync) (upload->fences[i]);
+
+		(*screen->deleteBuffers) (TEXTURE_UPLOAD_BUFFERS, upload->buffers);
+	}
+
+	if (upload->staging)
+		free (upload->staging);
+
+	free (upload);
+}
+
+/* returns the memory to write the next image to, its old contents are
+   undefined; NULL only if there is no memory at all */
+void *
+beginTextureUpload (CompScreen        *screen,
+                    CompTextureUpload *upload)
+{
+	GLsync fence;
+	GLenum status;
+
+	if (upload->mapped)
+		return upload->mapped;
+
+	if (!upload->buffers[0])
+		return upload->staging;
+
+	upload->current = (upload->current + 1) % TEXTURE_UPLOAD_BUFFERS;
+
+	makeScreenCurrent (screen);
+
+	(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB,
+	                       upload->buffers[upload->current]);
+
+	fence = upload->fences[upload->current];
+	if (fence)
+	{
+		status = (*screen->clientWaitSync) (fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED &&
+		    status != GL_CONDITION_SATISFIED)
+			(*screen->bufferData) (GL_PIXEL_UNPACK_BUFFER_ARB, upload->size,
+			                       NULL, GL_STREAM_DRAW_ARB);
+
+		(*screen->deleteSync) (fence);
+		upload->fences[upload->current] = NULL;
+	}
+	else
+	{
+		(*screen->bufferData) (GL_PIXEL_UNPACK_BUFFER_ARB, upload->size,
+		                       NULL, GL_STREAM_DRAW_ARB);
+	}
+
+	upload->mapped = (*screen->mapBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB,
+	                                       GL_WRITE_ONLY_ARB);
+
+	(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+	if (upload->mapped)
+		return upload->mapped;
+
+	/* the driver couldn't map the buffer, upload from memory */
+	if (!upload->staging)
+		upload->staging = malloc (upload->size);
+
+	return upload->staging;
+}
+
+/* copies the given rectangle of the image written since
+   beginTextureUpload to the same rectangle of the texture */
+void
+endTextureUpload (CompScreen        *screen,
+                  CompTextureUpload *upload,
+                  GLenum            target,
+                  GLuint            texture,
+                  int               x,
+                  int               y,
+                  int               width,
+                  int               height)
+{
+	const char *pixels;
+	size_t     offset;
+	Bool       buffer = FALSE;
+
+	offset = ((size_t) y * upload->width + x) * 4;
+
+	makeScreenCurrent (screen);
+
+	if (upload->mapped)
+	{
+		upload->mapped = NULL;
+
+		(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB,
+		                       upload->buffers[upload->current]);
+
+		/* the contents are lost if the buffer was evicted meanwhile */
+		if (!(*screen->unmapBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB))
+		{
+			(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+			return;
+		}
+
+		pixels = (const char *) NULL + offset;
+		buffer = TRUE;
+	}
+	else if (upload->staging)
+	{
+		pixels = (const char *) upload->staging + offset;
+	}
+	else
+	{
+		return;
+	}
+
+	glBindTexture (target, texture);
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, upload->width);
+
+	glTexSubImage2D (target, 0, x, y, width, height, GL_BGRA,
+#if IMAGE_BYTE_ORDER == MSBFirst
+	                 GL_UNSIGNED_INT_8_8_8_8_REV,
+#else
+	                 GL_UNSIGNED_BYTE,
+#endif
+	                 pixels);
+
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+	glBindTexture (target, 0);
+
+	if (buffer)
+	{
+		if (screen->syncObject)
+			upload->fences[upload->current] =
+			    (*screen->fenceSync) (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		(*screen->bindBuffer) (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+	}
+}
+
+/* like imageBufferToTexture, but once the texture has the size of the
+   image it is streamed into the storage it has, through an upload that
+   is created as needed and freed with destroyTextureUpload */
+Bool
+streamImageToTexture (CompScreen        *screen,
+                      CompTexture       *texture,
+                      CompTextureUpload **upload,
+                      const char        *image,
+                      unsigned int      width,
+                      unsigned int      height)
+{
+	CompTextureUpload *u = *upload;
+	void              *data;
+
+	if (!u || u->width != width || u->height != height || !texture->name)
+	{
+		destroyTextureUpload (screen, u);
+		*upload = NULL;
+
+		if (!imageBufferToTexture (screen, texture, image, width, height))
+			return FALSE;
+
+		*upload = createTextureUpload (screen, width, height);
+
+		return TRUE;
+	}
+
+	data = beginTextureUpload (screen, u);
+	if (!data)
+		return imageBufferToTexture (screen, texture, image, width, height);
+
+	memcpy (data, image, u->size);
+
+	endTextureUpload (screen, u, texture->target, texture->name,
+	                  0, 0, width, height);
+
+	texture->oldMipmaps = TRUE;
+
+	return TRUE;
+}
@@ -1144,6 +1144,8 @@ updateFrameWindow (CompWindow *w)
 			                          CopyFromParent,
 			                          CWOverrideRedirect | CWEventMask, &attr);
 
+			addWindowToHash (&w->screen->frameHash, w->frame, w);
+
 			XGrabButton (display.display, AnyButton, AnyModifier, w->frame, TRUE,
 			             ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
 			             GrabModeSync, GrabModeSync, None, None);
@@ -1212,6 +1214,7 @@ updateFrameWindow (CompWindow *w)
 		{
 			XDeleteProperty (display.display, w->id, display.frameWindowAtom);
 			XDestroyWindow (display.display, w->frame);
+			removeWindowFromHash (&w->screen->frameHash, w->frame, w);
 			w->frame = None;
 		}
 	}
@@ -1262,6 +1265,8 @@ updateWindowOutputExtents (CompWindow *w)
 	{
 		w->output = output;
 
+		invalidateOutputWindows (w->screen);
+
 		(*w->screen->windowResizeNotify) (w, 0, 0, 0, 0);
 	}
 }
@@ -1363,6 +1368,8 @@ bindWindow (CompWindow *w)
 		w->width  = attr.width + attr.border_width * 2;
 		w->height = attr.height + attr.border_width * 2;
 
+		invalidateOutputWindows (w->screen);
+
 		XUngrabServer (dpy);
 	}
 
@@ -1383,6 +1390,8 @@ bindWindow (CompWindow *w)
 void
 releaseWindow (CompWindow *w)
 {
+	releaseWindowAtlas (w);
+
 	if (w->pixmap)
 	{
 		CompTexture *texture;
@@ -1438,6 +1447,9 @@ freeWindow (CompWindow *w)
 	if (w->indices)
 		free (w->indices);
 
+	finiWindowVertexBuffers (w);
+	finiWindowGeometryCache (w);
+
 	if (w->struts)
 		free (w->struts);
 
@@ -1961,6 +1973,10 @@ addWindow (CompScreen *screen,
 	w->unmanaging = FALSE;
 	w->bindFailed = FALSE;
 
+	w->atlasSlot    = NULL;
+	w->atlasDamaged = FALSE;
+	w->atlasHold    = 0;
+
 	w->destroyRefCnt = 1;
 	w->unmapRefCnt   = 1;
 
@@ -1971,6 +1987,9 @@ addWindow (CompScreen *screen,
 	w->sizeDamage  = 0;
 	w->nDamage     = 0;
 
+	w->nPendingDamage    = 0;
+	w->nextPendingDamage = NULL;
+
 	w->vertices     = 0;
 	w->vertexSize   = 0;
 	w->vertexStride = 0;
@@ -1980,6 +1999,18 @@ addWindow (CompScreen *screen,
 	w->indexCount   = 0;
 	w->texCoordSize = 2;
 
+	w->geometryGeneration      = 0;
+	w->geometryGenerationClock = 0;
+
+	memset (w->vertexBuffers, 0, sizeof (w->vertexBuffers));
+	w->vertexBufferClock = 0;
+
+	memset (w->geometryCache, 0, sizeof (w->geometryCache));
+	w->geometryCacheClock = 0;
+	w->noGeometryCache    = 0;
+
+	w->occlusionHooks = 0;
+
 	w->drawWindowGeometry = NULL;
 
 	w->struts = 0;
@@ -2283,6 +2314,8 @@ removeWindow (CompWindow *w)
 {
 	unhookWindowFromScreen (w->screen, w);
 
+	discardPendingWindowDamage (w);
+
 	if (!w->destroyed)
 	{
 		/* restore saved geometry and map if hidden */
@@ -2338,6 +2371,9 @@ removeWindow (CompWindow *w)
 void
 destroyWindow (CompWindow *w)
 {
+	/* the id may be reused by the server before w is freed */
+	removeWindowFromHash (&w->screen->windowHash, w->id, w);
+
 	w->id = 1;
 	w->mapNum = 0;
 
@@ -2605,6 +2641,9 @@ resizeWindow (CompWindow *w,
 		w->attrib.height       = height;
 		w->attrib.border_width = borderWidth;
 
+		/* don't copy windows that are being resized to the atlas */
+		w->atlasHold = ATLAS_RESIZE_HOLD;
+
 		if (!w->mapNum && w->unmapRefCnt > 0 &&
 		    w->attrib.map_state == IsViewable)
 		{
@@ -2626,6 +2665,8 @@ resizeWindow (CompWindow *w,
 		if (w->mapNum)
 			updateWindowRegion (w);
 
+		invalidateOutputWindows (w->screen);
+
 		(*w->screen->windowResizeNotify) (w, dx, dy, dwidth, dheight);
 
 		addWindowDamage (w);
@@ -2725,7 +2766,10 @@ initializeSyncCounter (CompWindow *w)
 		                         &values);
 
 		if (!compCheckForError (display.display))
+		{
+			addWindowToHash (&w->screen->syncAlarmHash, w->syncAlarm, w);
 			return TRUE;
+		}
 
 		XSyncDestroyAlarm (display.display, w->syncAlarm);
 		w->syncAlarm = None;
@@ -2854,6 +2898,8 @@ moveWindow (CompWindow *w,
 
 		w->invisible = WINDOW_INVISIBLE (w);
 
+		invalidateOutputWindows (w->screen);
+
 		(*w->screen->windowMoveNotify) (w, dx, dy, immediate);
 
 		if (damage)
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+
+/*
+ * Checks that every instruction set of the pixel kernels of src/pixel.c
+ * gives the same bytes as the scalar kernels, for pixel counts below and
+ * around the vector widths and for alpha 0 and 255, and that nothing
+ * past the last pixel is written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fusilli-core.h>
+
+/* pixels past the last one, that must stay untouched */
+#define GUARD_PIXELS 40
+
+#define GUARD_BYTE 0xa5
+
+typedef enum {
+	KernelPremultiply = 0,
+	KernelRgbToArgb,
+	KernelRgbaToRgb
+} Kernel;
+
+static const char *kernelNames[] = {
+	"premultiply", "rgb_to_argb", "rgba_to_rgb"
+};
+
+static const char *kernelsNames[] = {
+	"scalar", "sse2", "ssse3", "avx2"
+};
+
+/* 0-9 are below every vector width, 15-17 and 31-33 around the 4, 8
+   and 16 pixels that the SSE2, SSSE3 and AVX2 loops take at once */
+static const int pixelCounts[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 31, 32, 33, 67
+};
+
+#define MAX_PIXELS (67 + GUARD_PIXELS)
+
+typedef enum {
+	AlphaRandom = 0,
+	AlphaZero,
+	AlphaOpaque
+} Alpha;
+
+static const char *alphaNames[] = {
+	"random", "0", "255"
+};
+
+static int failures = 0;
+
+static void
+fillSource (unsigned char *src,
+            Alpha         alpha)
+{
+	int i;
+
+	for (i = 0; i < MAX_PIXELS * 4; i++)
+		src[i] = rand ();
+
+	if (alpha == AlphaRandom)
+		return;
+
+	for (i = 0; i < MAX_PIXELS; i++)
+		src[i * 4 + 3] = alpha == AlphaZero ? 0 : 255;
+}
+
+static void
+runKernel (Kernel              kernel,
+           const unsigned char *src,
+           unsigned char       *dst,
+           int                 n,
+           Alpha               alpha)
+{
+	memset (dst, GUARD_BYTE, MAX_PIXELS * 4);
+
+	switch (kernel) {
+	case KernelPremultiply:
+		memcpy (dst, src, n * 4);
+		premultiplyPixels (dst, n);
+		break;
+	case KernelRgbToArgb:
+		convertRgbToArgb (src, (unsigned int *) dst, n,
+		                  alpha == AlphaZero ? 0 :
+		                  alpha == AlphaOpaque ? 255 : src[3]);
+		break;
+	case KernelRgbaToRgb:
+		convertRgbaToRgb (src, dst, n);
+		break;
+	}
+}
+
+static void
+checkGuard (Kernel              kernel,
+            PixelKernels        kernels,
+            const unsigned char *dst,
+            int                 n)
+{
+	int bytes, i;
+
+	bytes = kernel == KernelRgbaToRgb ? n * 3 : n * 4;
+
+	for (i = bytes; i < MAX_PIXELS * 4; i++)
+	{
+		if (dst[i] != GUARD_BYTE)
+		{
+			fprintf (stderr, "%s: %s wrote past %d pixels\n",
+			         kernelNames[kernel], kernelsNames[kernels], n);
+			failures++;
+			return;
+		}
+	}
+}
+
+/* premultiplying must be exact, like the division it replaces */
+static void
+checkPremultiplyScalar (void)
+{
+	unsigned char pixel[4];
+	unsigned int  p, color, alpha;
+
+	setPixelKernels (PixelKernelsScalar);
+
+	for (alpha = 0; alpha < 256; alpha++)
+	{
+		for (color = 0; color < 256; color++)
+		{
+			pixel[0] = pixel[1] = pixel[2] = color;
+			pixel[3] = alpha;
+
+			premultiplyPixels (pixel, 1);
+			memcpy (&p, pixel, sizeof (p));
+
+			if ((p & 0xff) != color * alpha / 255 || p >> 24 != alpha)
+			{
+				fprintf (stderr, "premultiply: scalar gives %08x for "
+				         "color %u alpha %u\n", p, color, alpha);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+	unsigned char src[MAX_PIXELS * 4];
+	unsigned char dst[MAX_PIXELS * 4];
+	unsigned char expected[MAX_PIXELS * 4];
+	PixelKernels  best, kernels;
+	Kernel        kernel;
+	Alpha         alpha;
+	int           i, n;
+
+	srand (1);
+
+	checkPremultiplyScalar ();
+
+	best = setPixelKernels (PixelKernelsAVX2);
+
+	for (alpha = AlphaRandom; alpha <= AlphaOpaque; alpha++)
+	{
+		fillSource (src, alpha);
+
+		for (kernel = KernelPremultiply; kernel <= KernelRgbaToRgb; kernel++)
+		{
+			for (i = 0; i < sizeof (pixelCounts) / sizeof (pixelCounts[0]);
+			     i++)
+			{
+				n = pixelCounts[i];
+
+				setPixelKernels (PixelKernelsScalar);
+				runKernel (kernel, src, expected, n, alpha);
+				checkGuard (kernel, PixelKernelsScalar, expected, n);
+
+				for (kernels = PixelKernelsSSE2; kernels <= best; kernels++)
+				{
+					setPixelKernels (kernels);
+					runKernel (kernel, src, dst, n, alpha);
+
+					if (memcmp (dst, expected, sizeof (dst)))
+					{
+						fprintf (stderr, "%s: %s differs from scalar for "
+						         "%d pixels, alpha %s\n",
+						         kernelNames[kernel], kernelsNames[kernels],
+						         n, alphaNames[alpha]);
+						failures++;
+					}
+
+					checkGuard (kernel, kernels, dst, n);
+				}
+			}
+		}
+	}
+
+	printf ("checked scalar against %s\n", kernelsNames[best]);
+
+	return failures ? 1 : 0;
+}
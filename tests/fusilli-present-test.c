@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 Michail Bitzes
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Michail Bitzes not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Michail Bitzes makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * MICHAIL BITZES DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL MICHAIL BITZES BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Checks getFramePresentMode and pushFrameDamage of src/present.c on a
+ * screen that is only set up as far as they look at it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fusilli-core.h>
+
+#define SCREEN_WIDTH  800
+#define SCREEN_HEIGHT 600
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) \
+		{ \
+			fprintf (stderr, "%s:%d: %s failed\n", \
+			         __FILE__, __LINE__, #expr); \
+			failures++; \
+		} \
+	} while (0)
+
+static void
+setRegionBox (Region r,
+              short  x1,
+              short  y1,
+              short  x2,
+              short  y2)
+{
+	BoxRec box;
+
+	box.x1 = x1;
+	box.y1 = y1;
+	box.x2 = x2;
+	box.y2 = y2;
+
+	compEmptyRegion (r);
+	compUnionRectWithRegion (&box, r, r);
+}
+
+static Bool
+regionIsBox (Region r,
+             short  x1,
+             short  y1,
+             short  x2,
+             short  y2)
+{
+	return r->numRects   == 1  &&
+	       r->extents.x1 == x1 && r->extents.y1 == y1 &&
+	       r->extents.x2 == x2 && r->extents.y2 == y2;
+}
+
+static CompScreen *
+createTestScreen (Bool bufferAge)
+{
+	CompScreen *s;
+	int        i;
+
+	s = calloc (1, sizeof (CompScreen));
+	if (!s)
+		exit (1);
+
+	s->region.rects      = &s->region.extents;
+	s->region.numRects   = 1;
+	s->region.extents.x2 = SCREEN_WIDTH;
+	s->region.extents.y2 = SCREEN_HEIGHT;
+
+	s->bufferAge   = bufferAge;
+	s->frameDamage = XCreateRegion ();
+
+	for (i = 0; i < DAMAGE_HISTORY_SIZE; i++)
+		s->damageHistory[i] = XCreateRegion ();
+
+	return s;
+}
+
+static void
+destroyTestScreen (CompScreen *s)
+{
+	int i;
+
+	XDestroyRegion (s->frameDamage);
+
+	for (i = 0; i < DAMAGE_HISTORY_SIZE; i++)
+		XDestroyRegion (s->damageHistory[i]);
+
+	free (s);
+}
+
+/* a frame with only pending damage must be neither swapped nor copied
+   and must leave the damage history and the damage region alone */
+static void
+testPendingOnly (Bool bufferAge)
+{
+	CompScreen *s = createTestScreen (bufferAge);
+	Region     damage = XCreateRegion ();
+
+	setRegionBox (s->damageHistory[0], 10, 10, 20, 20);
+	setRegionBox (damage, 100, 100, 200, 200);
+
+	CHECK (getFramePresentMode (s, COMP_SCREEN_DAMAGE_PENDING_MASK, 2,
+	                            damage) == CompPresentNone);
+
+	CHECK (!s->frameDamage->numRects);
+	CHECK (regionIsBox (s->damageHistory[0], 10, 10, 20, 20));
+	CHECK (!s->damageHistory[1]->numRects);
+	CHECK (regionIsBox (damage, 100, 100, 200, 200));
+
+	XDestroyRegion (damage);
+	destroyTestScreen (s);
+}
+
+static void
+testFullDamage (void)
+{
+	CompScreen *s = createTestScreen (TRUE);
+	Region     damage = XCreateRegion ();
+
+	CHECK (getFramePresentMode (s, COMP_SCREEN_DAMAGE_ALL_MASK |
+	                            COMP_SCREEN_DAMAGE_PENDING_MASK, 0,
+	                            damage) == CompPresentSwap);
+	CHECK (regionIsBox (s->frameDamage, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+
+	pushFrameDamage (s);
+
+	CHECK (!s->frameDamage->numRects);
+	CHECK (regionIsBox (s->damageHistory[0],
+	                    0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+
+	XDestroyRegion (damage);
+	destroyTestScreen (s);
+}
+
+/* a back buffer two frames old also misses the damage of the last
+   frame */
+static void
+testRegionDamageWithAge (void)
+{
+	CompScreen *s = createTestScreen (TRUE);
+	Region     damage = XCreateRegion ();
+
+	setRegionBox (s->damageHistory[0], 0, 0, 10, 10);
+	setRegionBox (s->damageHistory[1], 50, 50, 60, 60);
+	setRegionBox (damage, 0, 0, 10, 20);
+
+	CHECK (getFramePresentMode (s, COMP_SCREEN_DAMAGE_REGION_MASK, 2,
+	                            damage) == CompPresentSwap);
+	CHECK (regionIsBox (damage, 0, 0, 10, 20));
+	CHECK (regionIsBox (s->frameDamage, 0, 0, 10, 20));
+
+	pushFrameDamage (s);
+
+	CHECK (regionIsBox (s->damageHistory[0], 0, 0, 10, 20));
+	CHECK (regionIsBox (s->damageHistory[1], 0, 0, 10, 10));
+	CHECK (regionIsBox (s->damageHistory[2], 50, 50, 60, 60));
+
+	XDestroyRegion (damage);
+	destroyTestScreen (s);
+}
+
+/* without a known age, the damage is copied and collected for the next
+   swap */
+static void
+testRegionDamageWithoutAge (Bool bufferAge)
+{
+	CompScreen *s = createTestScreen (bufferAge);
+	Region     damage = XCreateRegion ();
+
+	setRegionBox (damage, 30, 30, 40, 40);
+
+	CHECK (getFramePresentMode (s, COMP_SCREEN_DAMAGE_REGION_MASK, 0,
+	                            damage) == CompPresentCopy);
+	CHECK (regionIsBox (damage, 30, 30, 40, 40));
+
+	if (bufferAge)
+		CHECK (regionIsBox (s->frameDamage, 30, 30, 40, 40));
+	else
+		CHECK (!s->frameDamage->numRects);
+
+	XDestroyRegion (damage);
+	destroyTestScreen (s);
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+	testPendingOnly (TRUE);
+	testPendingOnly (FALSE);
+	testFullDamage ();
+	testRegionDamageWithAge ();
+	testRegionDamageWithoutAge (TRUE);
+	testRegionDamageWithoutAge (FALSE);
+
+	return failures ? 1 : 0;
+}